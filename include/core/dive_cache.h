@@ -0,0 +1,54 @@
+#ifndef DIVE_CACHE_H
+#define DIVE_CACHE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include "include/core/dive_data.h"
+
+class QFile;
+class QFileInfo;
+
+// Binary cache of parsed dives, so reopening a log that hasn't changed
+// costs a file map and a copy instead of a parse. One file per source log,
+// keyed by the source's path and content hash. The source's size and
+// modification time are recorded too, so an unchanged log is recognised
+// without hashing it.
+//
+// Layout (native byte order, recorded in the header; a cache written on a
+// machine with the other order, or by another application version, is
+// simply a miss):
+//   header     fixed 96 bytes: magic, format and application version, byte
+//              order, source size, modification time and hash, dive count,
+//              offset and size of the metadata block
+//   columns    per dive: the nine scalar sample columns as doubles, the
+//              pressure and PO2 channel columns, then the two per-sample
+//              channel counts as quint16, padded to 8 bytes
+//   metadata   QDataStream: per-dive fields, cylinders, gas switches and
+//              the offset, sample count and channel counts of its columns
+namespace dive_cache {
+
+// SHA-1 of the whole file. Leaves the file positioned at 0.
+QByteArray contentHash(QFile &file);
+
+// The content hash recorded for 'source' if its size and modification time
+// are still those it was cached with, so it needn't be hashed again; empty
+// if there is no usable entry or the file may have changed.
+QByteArray recordedHash(const QFileInfo &source);
+
+// Dives cached for 'sourcePath' with this content hash; empty if there is
+// no entry, it is stale, or it fails validation. Caller takes ownership.
+QList<DiveData *> load(const QString &sourcePath, const QByteArray &contentHash);
+
+// Replaces the cache entry for 'source', recording its size and
+// modification time as 'source' has them: stat it before reading the file,
+// so a change made while it was parsed is never taken for this content.
+// Failures only cost the next import its head start, so they are logged
+// and otherwise ignored.
+void store(const QFileInfo &source, const QByteArray &contentHash,
+           const QList<DiveData *> &dives);
+
+} // namespace dive_cache
+
+#endif // DIVE_CACHE_H
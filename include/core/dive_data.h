@@ -7,6 +7,8 @@
 #include <QPair>
 #include <QMap>
 #include <QString>
+#include <QMutex>
+#include <memory>
 
 
 struct DiveDataPoint {
@@ -72,6 +74,50 @@ struct DiveDataPoint {
     }
 };
 
+// Column-oriented sample store backing DiveData. Every scalar field of
+// DiveDataPoint lives in its own contiguous array indexed by sample, so a
+// scan over one quantity (time, depth, ceiling) streams through plain
+// doubles instead of hopping across heap-backed structs. Tank pressures and
+// PO2 sensors get one zero-padded column per channel plus a per-sample
+// channel count, so point() rebuilds the original DiveDataPoint exactly.
+// All columns always hold size() entries.
+struct DiveSampleColumns {
+    QVector<double> timestamp;
+    QVector<double> depth;
+    QVector<double> temperature;
+    QVector<double> ndl;
+    QVector<double> ceiling;
+    QVector<double> o2percent;
+    QVector<double> tts;
+    QVector<double> cns;
+    QVector<double> stopTime;
+    QVector<QVector<double>> pressures;   // [tank][sample]
+    QVector<quint16> tankCount;           // pressure channels per sample
+    QVector<QVector<double>> po2Sensors;  // [sensor][sample]
+    QVector<quint16> po2SensorCount;      // PO2 channels per sample
+
+    int size() const { return timestamp.size(); }
+    bool isEmpty() const { return timestamp.isEmpty(); }
+
+    void clear();
+    void reserve(int count);
+    void insert(int index, const DiveDataPoint &point);
+    void append(const DiveDataPoint &point) { insert(size(), point); }
+    // Reorders samples so that new sample i is old sample order[i]
+    void permute(const QVector<int> &order);
+
+    // Row view of one sample
+    DiveDataPoint point(int index) const;
+
+    // Same contracts as DiveDataPoint::getPressure() / getPO2Sensor()
+    double pressureAt(int index, int tank) const {
+        return (tank >= 0 && tank < tankCount[index]) ? pressures[tank][index] : 0.0;
+    }
+    double po2SensorAt(int index, int sensor) const {
+        return (sensor >= 0 && sensor < po2SensorCount[index]) ? po2Sensors[sensor][index] : 0.0;
+    }
+};
+
 // Represents a cylinder (tank) used in a dive
 struct CylinderInfo {
     int index;              // Index of this cylinder in the dive
@@ -133,6 +179,8 @@ public:
     QString diveSiteName() const { return m_diveSiteName; }
     QString diveSiteId() const { return m_diveSiteId; }
     DiveMode diveMode() const { return m_diveMode; }
+    // Mean depth as given by the log; < 0 if it provided none
+    double loggedMeanDepth() const { return m_meanDepth; }
 
     // Setters
     void setDiveName(const QString &name);
@@ -151,27 +199,54 @@ public:
     QVector<CylinderInfo> cylinders() const { return m_cylinders; }
     bool isCylinderActiveAtTime(int cylinderIndex, double timestamp) const;
     Q_INVOKABLE int activeCylinderAtTime(double timestamp) const;
+    // Start/end pressure ramp over the cylinder's first stint
     double interpolateCylinderPressure(int cylinderIndex, double timestamp) const;
-    double getLastInterpolatedPressure(int cylinderIndex) const;
+    // Ramp pressure with gas switches applied: start pressure until the
+    // cylinder is first breathed, the ramp while it is, and the pressure it
+    // was left at in between. A pure lookup into the precomputed curve, so
+    // results don't depend on call order or thread.
+    double cylinderPressureAt(int cylinderIndex, double timestamp) const;
 
     // Get a descriptive string for a cylinder
     QString cylinderDescription(int index) const;
     
     // Data management
     void addDataPoint(const DiveDataPoint &point);
+    // Bulk ingestion for parsers: appends the whole batch, sorts only if it
+    // arrives out of order, and emits one dataChanged/durationChanged pair
+    void appendDataPoints(const QVector<DiveDataPoint> &points);
     void clearData();
+    // Replaces all samples with a ready-made column store (the dive cache
+    // restores dives this way). Columns are sorted by time if they aren't.
+    void setSamples(DiveSampleColumns samples);
     
-    // Get data for a specific time point (interpolated if necessary)
+    // Get data for a specific time point (interpolated if necessary).
+    // O(log n); use DiveSampleCursor for monotonic sweeps.
     DiveDataPoint dataAtTime(double time) const;
+
+    // Index of the first sample at or after 'time' (size() if none)
+    int sampleIndexAt(double time) const;
+
+    // Batch form of dataAtTime(): sample k of the result equals
+    // dataAtTime(times[k]). Times are bracketed with a DiveSampleCursor
+    // and each channel is then interpolated in its own flat loop.
+    DiveSampleColumns resample(const QVector<double> &times) const;
     
-    // Get all data points
-    const QVector<DiveDataPoint>& allDataPoints() const { return m_dataPoints; }
+    // Column store of all samples, sorted by time. Renderers and scans
+    // should read this rather than allDataPoints().
+    const DiveSampleColumns& samples() const { return m_samples; }
+    int sampleCount() const { return m_samples.size(); }
+
+    // Row view of all samples, for callers that want DiveDataPoints. Built
+    // from the columns on first use and kept until the samples change.
+    const QVector<DiveDataPoint>& allDataPoints() const;
     
     // Get data within a time range
     QVector<DiveDataPoint> dataInRange(double startTime, double endTime) const;
 
     // Public method to add a gas switch
     void addGasSwitch(double timestamp, int cylinderIndex);
+    const QList<GasSwitch>& gasSwitches() const { return m_gasSwitches; }
     
 signals:
     void diveNameChanged();
@@ -185,6 +260,41 @@ signals:
     void diveModeChanged();
 
 private:
+    friend class DiveSampleCursor;
+
+    // Interpolates between samples index-1 and index; 'time' must lie
+    // strictly inside that segment
+    DiveDataPoint interpolateSegment(int index, double time) const;
+    // Tank pressure inside the segment [prev, next]; shared by
+    // interpolateSegment() and resample()
+    double segmentPressure(int prev, int next, double factor, int tank, double time) const;
+
+    // Per-sample running statistics, built lazily on first use and dropped
+    // whenever the dive changes, so per-frame lookups are O(log n) and
+    // aggregate property reads O(1). Handed out as an immutable shared
+    // block so concurrent readers never see it rebuilt underneath them.
+    struct DerivedStats {
+        QVector<double> prefixMaxDepth;      // max depth over samples [0, i]
+        double maxDepth = 0.0;
+        double meanDepth = 0.0;              // derived from samples only
+        double minTemperature = 0.0;
+
+        // Cylinder start/end-ramp fallback for dives without pressure samples
+        struct CylinderCurve {
+            double rampStart = 0.0;
+            double rampEnd = 0.0;
+            QVector<QPair<double, double>> active; // [from, to) stints, in time order
+        };
+        QVector<CylinderCurve> cylinderCurves;   // one per cylinder
+    };
+    std::shared_ptr<const DerivedStats> derivedStats() const;
+    QVector<DerivedStats::CylinderCurve> buildCylinderCurves() const;
+    static double rampPressure(const CylinderInfo &cylinder, double startTime, double endTime,
+                               double timestamp);
+    // Drops the derived stats and the allDataPoints() row view. Called
+    // whenever samples, cylinders or gas switches change.
+    void invalidateDerivedStats();
+
     QString m_diveName;
     QDateTime m_startTime;
     QString m_location;
@@ -193,10 +303,41 @@ private:
     QString m_diveSiteName;
     QString m_diveSiteId;
     DiveMode m_diveMode = UnknownMode;
-    QVector<DiveDataPoint> m_dataPoints;
+    DiveSampleColumns m_samples;
     QVector<CylinderInfo> m_cylinders;
     QList<GasSwitch> m_gasSwitches;
-    mutable QMap<int, double> m_lastInterpolatedPressures;
+    // Guards both lazily built caches below
+    mutable QMutex m_derivedMutex;
+    mutable std::shared_ptr<const DerivedStats> m_derived;
+    mutable QVector<DiveDataPoint> m_pointsView;
+    mutable bool m_pointsViewValid = false;
+};
+
+// Sequential reader for playback and export, where lookups arrive in
+// (mostly) increasing time order. It remembers the last bracketing segment
+// and walks forward from there, so a monotonic sweep costs amortised O(1)
+// per lookup; backward seeks and long jumps fall back to a binary search.
+// Results are identical to DiveData::dataAtTime(). Not thread-safe — give
+// each thread its own cursor.
+class DiveSampleCursor
+{
+public:
+    explicit DiveSampleCursor(const DiveData* dive);
+
+    // Rebind (or rewind) the cursor
+    void reset(const DiveData* dive);
+
+    DiveDataPoint dataAtTime(double time);
+
+    // Same contract as DiveData::sampleIndexAt()
+    int sampleIndexAt(double time);
+
+private:
+    // Forward steps tried before giving up and binary searching
+    static constexpr int kMaxLinearSteps = 8;
+
+    const DiveData* m_dive;
+    int m_index = 0;
 };
 
 #endif // DIVE_DATA_H
\ No newline at end of file
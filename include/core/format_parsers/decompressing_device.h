@@ -0,0 +1,80 @@
+#ifndef DECOMPRESSING_DEVICE_H
+#define DECOMPRESSING_DEVICE_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+#include <memory>
+
+// Read-only view of a gzip or zstd compressed device as its decompressed
+// content, decoded on the fly in bounded chunks so a compressed logbook is
+// never expanded on disk or in memory as a whole. Parsers seek (format
+// sniffing, indexed single-dive import), so the device is random access:
+// seeking forward decodes and discards, seeking backward restarts the
+// stream from the beginning of the source.
+//
+// Each codec is only available when the build found its library
+// (UNABARA_HAVE_ZLIB, UNABARA_HAVE_ZSTD).
+class DecompressingDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    enum Codec {
+        None,
+        Gzip,
+        Zstd,
+    };
+
+    // Compression of 'device' by its magic bytes. Restores the seek position.
+    static Codec detect(QIODevice *device);
+    static bool isSupported(Codec codec);
+    static QString codecName(Codec codec);
+
+    // Path of the file behind 'device', looking through a decompressing
+    // view; empty for devices that aren't files
+    static QString fileName(const QIODevice &device);
+
+    // 'source' must be open for reading and outlive this device
+    DecompressingDevice(QIODevice *source, Codec codec, QObject *parent = nullptr);
+    ~DecompressingDevice() override;
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return false; }
+    bool seek(qint64 pos) override;
+    bool atEnd() const override;
+    // Decompressed size, once the end of the stream has been reached; 0
+    // (unknown) before that
+    qint64 size() const override;
+
+    QIODevice *source() const { return m_source; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    class Stream;
+
+    bool restart();
+    // Positions the stream so the next byte decoded is at 'pos'
+    bool decodeTo(qint64 pos);
+    // Decompresses up to 'maxSize' bytes; -1 once the stream is found
+    // corrupt or truncated
+    qint64 decompress(char *data, qint64 maxSize);
+
+    QIODevice *m_source;
+    Codec m_codec;
+    std::unique_ptr<Stream> m_stream;
+    QByteArray m_input;        // compressed bytes read from the source
+    qint64 m_inputPos = 0;     // consumed prefix of m_input
+    qint64 m_decoded = 0;      // decompressed bytes produced so far
+    qint64 m_size = -1;        // total decompressed size, once known
+    bool m_betweenFrames = false; // a gzip member / zstd frame just ended
+    bool m_finished = false;
+    bool m_failed = false;
+};
+
+#endif // DECOMPRESSING_DEVICE_H
@@ -2,29 +2,44 @@
 #define FIT_DECODER_H
 
 #include <QByteArray>
+#include <QHash>
 #include <QList>
-#include <QMap>
 #include <QString>
 #include <QVector>
 
+#include <functional>
+
 class QIODevice;
 
-// One decoded FIT data message. Fields are keyed by the field definition
-// number from the wire format; each holds one or more decoded elements
-// (arrays keep their invalid elements as NaN, invalid scalars are omitted).
+// One field of a decoded message: 'count' elements starting at 'first' in
+// the decoder's value arena.
+struct FitField {
+    quint8 fieldNum = 0;
+    quint8 count = 0;
+    quint32 first = 0;
+};
+
+// One decoded FIT data message, as a view into the decoder's flat field and
+// value arenas (valid until the decoder decodes again, or, for a message
+// handed to a visitor, until the visitor returns). Fields are keyed by
+// the field definition number from the wire format; each holds one or more
+// decoded elements (arrays keep their invalid elements as NaN, invalid
+// scalars are omitted).
 struct FitMessage {
     quint16 globalId = 0;
-    QMap<quint8, QVector<double>> fields;
+    const FitField *fields = nullptr;
+    int fieldCount = 0;
+    const double *values = nullptr;
 
-    bool has(quint8 fieldNum) const { return fields.contains(fieldNum); }
+    bool has(quint8 fieldNum) const { return find(fieldNum) != nullptr; }
     double value(quint8 fieldNum, double fallback = 0.0) const
     {
         // Return the first *valid* element: array fields keep invalid
         // elements as NaN placeholders, and NaN must never escape (callers
         // cast to integer types, which is undefined behavior on NaN)
-        auto it = fields.constFind(fieldNum);
-        if (it != fields.constEnd()) {
-            for (double element : *it) {
+        if (const FitField *field = find(fieldNum)) {
+            for (int i = 0; i < field->count; ++i) {
+                const double element = values[field->first + i];
                 if (!qIsNaN(element)) {
                     return element;
                 }
@@ -32,50 +47,107 @@ struct FitMessage {
         }
         return fallback;
     }
+
+private:
+    const FitField *find(quint8 fieldNum) const
+    {
+        // Few fields per message: a scan beats any lookup structure. From
+        // the back, so a field repeated in one definition reads as its last
+        // occurrence.
+        for (int i = fieldCount - 1; i >= 0; --i) {
+            if (fields[i].fieldNum == fieldNum) {
+                return &fields[i];
+            }
+        }
+        return nullptr;
+    }
 };
 
+// Messages and fields a caller wants decoded: global message number -> field
+// numbers, where an empty list means every field of that message. Anything
+// else is skipped at the wire level without being converted or stored.
+using FitFieldFilter = QHash<quint16, QVector<quint8>>;
+
+// Called once per decoded data message, in file order.
+using FitMessageVisitor = std::function<void(const FitMessage &)>;
+
 // Wire-level decoder for the FIT container format (clean-room implementation).
-// Turns the byte stream into a flat list of FitMessage; knows nothing about
-// dive semantics — that lives in FitParser.
+// Turns the byte stream into messages, either streamed to a visitor or kept
+// in flat arrays of messages, fields and values; knows nothing about dive
+// semantics — that lives in FitParser.
 class FitDecoder
 {
 public:
-    // Decodes the device's full contents (from position 0). Returns false on a
-    // fatal structural error; messages() still holds everything decoded before
-    // the failure so callers can salvage truncated files.
+    // Restricts decoding to these messages and fields (default: everything).
+    // Takes effect on the next decode().
+    void setFilter(const FitFieldFilter &filter) { m_filter = filter; }
+
+    // Decodes the device's full contents (from position 0), memory-mapping
+    // it when it is a file and reading it in bounded chunks otherwise, and
+    // hands each message to 'visitor' without keeping it. Returns false on
+    // a fatal structural error; every message decoded before the failure
+    // has been visited, so callers can salvage truncated files.
+    bool decode(QIODevice *device, const FitMessageVisitor &visitor, QString &errorOut);
+
+    // As above, but keeps every message for messageCount()/message().
     bool decode(QIODevice *device, QString &errorOut);
 
-    const QList<FitMessage> &messages() const { return m_messages; }
+    int messageCount() const { return m_messages.size(); }
+    FitMessage message(int index) const
+    {
+        const MessageEntry &entry = m_messages.at(index);
+        return FitMessage{entry.globalId, m_fields.constData() + entry.firstField,
+                          entry.fieldCount, m_values.constData()};
+    }
 
     // Cheap format sniff: bytes 8-11 are the ASCII string ".FIT".
     // Restores the device's seek position.
     static bool sniff(QIODevice *device);
 
-    static quint16 crc16(const uchar *data, qint64 length);
+    // 'crc' continues a checksum over preceding data.
+    static quint16 crc16(const uchar *data, qint64 length, quint16 crc = 0);
 
 private:
+    class Input;
+
     struct FieldDef {
         quint8 fieldNum = 0;
         quint8 size = 0;
         quint8 baseType = 0;
+        bool keep = true;     // wanted by the filter
     };
 
     struct LocalDef {
         bool valid = false;
+        bool wanted = true;   // any of this message is wanted by the filter
         quint16 globalId = 0;
         bool bigEndian = false;
         QVector<FieldDef> fields;
         int devDataBytes = 0; // developer fields: decoded for size, skipped as data
     };
 
+    struct MessageEntry {
+        quint16 globalId = 0;
+        int fieldCount = 0;
+        quint32 firstField = 0;
+    };
+
+    bool decodeDevice(QIODevice *device, QString &errorOut);
+    bool decodeInput(Input &input, QString &errorOut);
+    bool decodeRecord(const uchar *&p, const uchar *end, qint64 offset, QString &errorOut);
     bool decodeDefinition(const uchar *&p, const uchar *end, quint8 recordHeader,
                           QString &errorOut);
+    // 'timestampOverride' >= 0 replaces field 253 (compressed-timestamp records)
     bool decodeData(const uchar *&p, const uchar *end, const LocalDef &def,
-                    QString &errorOut);
+                    qint64 timestampOverride, QString &errorOut);
 
+    FitFieldFilter m_filter;
+    const FitMessageVisitor *m_visitor = nullptr; // null: keep messages
     LocalDef m_locals[16];
     quint32 m_lastTimestamp = 0; // for compressed-timestamp record headers
-    QList<FitMessage> m_messages;
+    QVector<MessageEntry> m_messages;
+    QVector<FitField> m_fields;
+    QVector<double> m_values;
 };
 
 #endif // FIT_DECODER_H
@@ -3,6 +3,7 @@
 
 #include <QDateTime>
 #include <QMap>
+#include <QPair>
 #include <QString>
 #include <QVector>
 
@@ -19,15 +20,15 @@ public:
     FitParser();
     ~FitParser() override = default;
 
-    bool canParse(QFile &file) const override;
-    QList<DiveData *> parse(QFile &file, int specificDive, QString &errorOut) override;
-    QList<QString> listDives(QFile &file, QString &errorOut) override;
+    bool canParse(QIODevice &file) const override;
+    QList<DiveData *> parse(QIODevice &file, int specificDive, QString &errorOut) override;
+    QList<QString> listDives(QIODevice &file, QString &errorOut) override;
     QString formatName() const override { return QStringLiteral("Garmin FIT"); }
 
 private:
-    // Per-file metadata gathered before building samples. FIT files put
-    // summary messages (session, dive summary) after the sample records,
-    // so everything is decoded first and read in two passes.
+    // Per-file metadata. FIT files put summary messages (session, dive
+    // summary) after the sample records, so it is only complete once the
+    // whole file has been read.
     struct Metadata {
         int subSport = -1;              // 53-57, 63 are dive activities
         bool hasStart = false;
@@ -46,10 +47,55 @@ private:
         bool sawDiveData = false;       // any depth sample or dive-specific message
     };
 
-    bool decodeFile(QFile &file, FitDecoder &decoder, QString &errorOut) const;
-    Metadata collectMetadata(const QList<FitMessage> &messages) const;
+    // A record as logged: absolute FIT timestamp, NaN for absent fields.
+    // Samples can only be placed on the dive's timeline once the session
+    // message at the end of the file gives the start time.
+    struct RawSample {
+        quint32 timestamp = 0;
+        double depth = 0.0;             // mm
+        double temperature = 0.0;       // degrees C
+        double ndl = 0.0;               // s
+        double tts = 0.0;               // s
+        double ceiling = 0.0;           // next stop depth, mm
+        double stopTime = 0.0;          // next stop time, s
+        double cns = 0.0;               // percent
+    };
+
+    // A message that changes the state carried into later samples, placed
+    // by the number of samples recorded before it
+    struct RawEvent {
+        enum Kind { TankPressure, GasSwitch, Setpoint };
+        Kind kind = TankPressure;
+        int sampleIndex = 0;
+        qint64 timestamp = -1;          // FIT seconds, -1 when absent
+        quint32 sensor = 0;             // TankPressure: pod serial
+        double bar = 0.0;               // TankPressure: reading
+        int data = 0;                   // GasSwitch: gas slot; Setpoint: event code
+    };
+
+    // Everything a single streaming pass over the file collects
+    struct Scan {
+        bool keepSamples = false;       // listing only needs the metadata
+        Metadata meta;
+        QVector<RawSample> samples;
+        QVector<RawEvent> events;
+        int depthSamples = 0;
+
+        // Raw message state, resolved into 'meta' by finishMetadata()
+        QMap<int, CylinderInfo> gasesByIndex;
+        QMap<int, bool> gasIsDiluent;
+        QMap<quint32, QPair<double, double>> tankPressures; // sensor -> start/end bar
+        QVector<double> tankVolumes;    // liters, parallel to meta.tankSensors
+        QVector<quint32> updateSensors; // pods seen in tank_update messages
+        bool sawFirstRecord = false;
+        quint32 firstRecordTime = 0;
+    };
+
+    bool scanFile(QIODevice &file, Scan &scan, QString &errorOut) const;
+    static void visitMessage(const FitMessage &message, Scan &scan);
+    static void finishMetadata(Scan &scan);
     bool isDive(const Metadata &meta, QString &errorOut) const;
-    DiveData *buildDive(const QList<FitMessage> &messages, const Metadata &meta) const;
+    DiveData *buildDive(const Scan &scan) const;
 
     static QDateTime startDateTime(const Metadata &meta);
     static QString formatPosition(const Metadata &meta);
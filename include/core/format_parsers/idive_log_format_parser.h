@@ -1,29 +1,80 @@
 #ifndef IDIVE_LOG_FORMAT_PARSER_H
 #define IDIVE_LOG_FORMAT_PARSER_H
 
-#include <QFile>
+#include <QIODevice>
+#include <QByteArray>
 #include <QList>
+#include <QSet>
 #include <QString>
 #include "include/core/dive_data.h"
 
+#include <functional>
+
 class IDiveLogFormatParser
 {
 public:
     virtual ~IDiveLogFormatParser() = default;
 
+    // The device is the log's content, open for reading and seekable: the
+    // file itself, or a DecompressingDevice over a compressed log.
+
     // Cheap content sniff: peek at the file's first StartElement.
     // Implementations must restore the seek position on exit.
-    virtual bool canParse(QFile &file) const = 0;
+    virtual bool canParse(QIODevice &file) const = 0;
 
     // Parse all dives, or one if specificDive >= 0. errorOut is populated on failure.
     // Caller takes ownership of returned DiveData* objects.
-    virtual QList<DiveData *> parse(QFile &file, int specificDive, QString &errorOut) = 0;
+    virtual QList<DiveData *> parse(QIODevice &file, int specificDive, QString &errorOut) = 0;
+
+    // Re-import of a log that changed on disk. Hashes every dive without
+    // parsing it and parses only the dives whose hash is not in 'known'.
+    // On return, 'hashesOut' has one hash per dive in document order and
+    // 'divesOut' is aligned with it: the parsed dive, or null for a known
+    // one. Returns false if the format can't be split into dives, and the
+    // caller parses the whole log instead. errorOut is populated on failure.
+    // Caller takes ownership of returned DiveData* objects.
+    virtual bool parseChanged(QIODevice &file,
+                              const QSet<QByteArray> &known,
+                              QList<QByteArray> &hashesOut,
+                              QList<DiveData *> &divesOut,
+                              QString &errorOut)
+    {
+        Q_UNUSED(file);
+        Q_UNUSED(known);
+        Q_UNUSED(hashesOut);
+        Q_UNUSED(divesOut);
+        Q_UNUSED(errorOut);
+        return false;
+    }
 
     // Light-weight dive listing for the import-dialog picker.
-    virtual QList<QString> listDives(QFile &file, QString &errorOut) = 0;
+    virtual QList<QString> listDives(QIODevice &file, QString &errorOut) = 0;
 
     // Human-readable name, used in error messages and logs.
     virtual QString formatName() const = 0;
+
+    // Progress and cancellation for parsers that read the whole log before
+    // parsing any of it, which leaves the share of the device read saying
+    // nothing about the parse. Set by the caller around parse() and
+    // parseChanged(). divesParsed calls are serialized, but may come from
+    // any thread.
+    struct Observer {
+        std::function<void()> readingWholeLog; // before the up-front read
+        std::function<void(qsizetype parsed, qsizetype total)> divesParsed;
+        std::function<bool()> cancelled;
+    };
+    void setObserver(Observer observer) { m_observer = std::move(observer); }
+
+protected:
+    void notifyReadingWholeLog() const
+    {
+        if (m_observer.readingWholeLog) {
+            m_observer.readingWholeLog();
+        }
+    }
+    bool isCancelled() const { return m_observer.cancelled && m_observer.cancelled(); }
+
+    Observer m_observer;
 };
 
 #endif // IDIVE_LOG_FORMAT_PARSER_H
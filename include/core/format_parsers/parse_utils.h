@@ -18,6 +18,15 @@ double parseLocaleDouble(QStringView s);
 // Returns an invalid QDateTime on failure.
 QDateTime parseISO8601(QStringView s);
 
+// Subsurface-style "value unit" attributes ("12.3 m", "200.0 bar", "21.0%").
+// Finds the first unsigned number followed by whitespace and 'unit' (with
+// spaceRequired false, whitespace is optional), scanning in place without
+// allocating. Returns NaN if there is none.
+double scanUnitValue(QStringView s, QStringView unit, bool spaceRequired = true);
+
+// "mm:ss min" durations, as total seconds. Returns NaN if there is none.
+double scanMinutesSeconds(QStringView s);
+
 } // namespace parse_utils
 
 #endif // PARSE_UTILS_H
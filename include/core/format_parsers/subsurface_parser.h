@@ -6,15 +6,22 @@
 
 #include "include/core/format_parsers/idive_log_format_parser.h"
 
+class XmlDiveIndex;
+
 class SubsurfaceParser : public IDiveLogFormatParser
 {
 public:
     SubsurfaceParser();
     ~SubsurfaceParser() override = default;
 
-    bool canParse(QFile &file) const override;
-    QList<DiveData *> parse(QFile &file, int specificDive, QString &errorOut) override;
-    QList<QString> listDives(QFile &file, QString &errorOut) override;
+    bool canParse(QIODevice &file) const override;
+    QList<DiveData *> parse(QIODevice &file, int specificDive, QString &errorOut) override;
+    bool parseChanged(QIODevice &file,
+                      const QSet<QByteArray> &known,
+                      QList<QByteArray> &hashesOut,
+                      QList<DiveData *> &divesOut,
+                      QString &errorOut) override;
+    QList<QString> listDives(QIODevice &file, QString &errorOut) override;
     QString formatName() const override { return QStringLiteral("Subsurface XML"); }
 
 private:
@@ -30,10 +37,27 @@ private:
         QString description;
     };
 
+    // Picker entry for the dive element xml is positioned on; empty if the
+    // dive has no number. Reads only as far as the location.
+    static QString listEntry(QXmlStreamReader &xml, int &number);
+    // Loads or builds the byte-offset index; false if the file can't be
+    // indexed and the caller should stream the whole file instead
+    bool loadIndex(QIODevice &file, XmlDiveIndex &index);
+    QList<DiveData *> parseIndexedDive(QIODevice &file,
+                                       const XmlDiveIndex &index,
+                                       int diveNumber,
+                                       QString &errorOut);
+    // Parses every indexed dive of the in-memory document on the thread
+    // pool; dives come back in document order, owned by the calling thread
+    QList<DiveData *> parseDivesInParallel(const QByteArray &data,
+                                           const XmlDiveIndex &index,
+                                           QString &errorOut);
+
     DiveData *parseDiveElement(QXmlStreamReader &xml);
     void parseDiveComputerElement(QXmlStreamReader &xml, DiveData *dive, int &sampleCount);
     void parseSampleElement(QXmlStreamReader &xml,
                             DiveData *dive,
+                            QVector<DiveDataPoint> &samples,
                             double &lastTemperature,
                             double &lastNDL,
                             double &lastTTS,
@@ -7,15 +7,22 @@
 
 #include "include/core/format_parsers/idive_log_format_parser.h"
 
+class XmlDiveIndex;
+
 class UDDFParser : public IDiveLogFormatParser
 {
 public:
     UDDFParser();
     ~UDDFParser() override = default;
 
-    bool canParse(QFile &file) const override;
-    QList<DiveData *> parse(QFile &file, int specificDive, QString &errorOut) override;
-    QList<QString> listDives(QFile &file, QString &errorOut) override;
+    bool canParse(QIODevice &file) const override;
+    QList<DiveData *> parse(QIODevice &file, int specificDive, QString &errorOut) override;
+    bool parseChanged(QIODevice &file,
+                      const QSet<QByteArray> &known,
+                      QList<QByteArray> &hashesOut,
+                      QList<DiveData *> &divesOut,
+                      QString &errorOut) override;
+    QList<QString> listDives(QIODevice &file, QString &errorOut) override;
     QString formatName() const override { return QStringLiteral("UDDF"); }
 
 private:
@@ -32,6 +39,24 @@ private:
     };
 
     void resetState();
+
+    // Listing helpers, shared by the streaming scan and index building
+    static void listSiteName(QXmlStreamReader &xml, QMap<QString, QString> &siteNames);
+    static QString listEntry(QXmlStreamReader &xml,
+                             const QMap<QString, QString> &siteNames,
+                             int &number);
+    // Loads or builds the byte-offset index; false if the file can't be
+    // indexed and the caller should stream the whole file instead
+    bool loadIndex(QIODevice &file, XmlDiveIndex &index);
+    QList<DiveData *> parseIndexedDive(QIODevice &file,
+                                       const XmlDiveIndex &index,
+                                       int diveNumber,
+                                       QString &errorOut);
+    // Parses every indexed dive of the in-memory document on the thread
+    // pool; dives come back in document order, owned by the calling thread
+    QList<DiveData *> parseDivesInParallel(const QByteArray &data,
+                                           const XmlDiveIndex &index,
+                                           QString &errorOut);
     void parseGasDefinitions(QXmlStreamReader &xml);
     void parseDiveSiteContainer(QXmlStreamReader &xml);
     void parseDiveSiteEntry(QXmlStreamReader &xml);
@@ -47,6 +72,7 @@ private:
     void parseSamples(QXmlStreamReader &xml, DiveData *dive);
     void parseWaypoint(QXmlStreamReader &xml,
                        DiveData *dive,
+                       QVector<DiveDataPoint> &samples,
                        double &lastTemperature,
                        double &lastNDL,
                        double &lastTTS,
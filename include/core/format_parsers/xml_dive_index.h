@@ -0,0 +1,70 @@
+#ifndef XML_DIVE_INDEX_H
+#define XML_DIVE_INDEX_H
+
+#include <QByteArray>
+#include <QLatin1String>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+
+// Byte offsets of the pieces of an XML dive log: every dive element plus the
+// shared definitions (dive sites, gas mixes) that dives refer to. Lets the
+// picker list a logbook and import a single dive without re-reading
+// everything before it. Built by a byte-level tag scan on first use and
+// cached on disk, keyed by the log's size and modification time.
+class XmlDiveIndex
+{
+public:
+    struct Range {
+        qint64 begin = 0;
+        qint64 end = 0;
+    };
+
+    struct Dive {
+        Range range;
+        int number = -1;   // -1 if the dive has none
+        bool unnumbered = false; // no number given at all, not just an unusable one
+        QString label;     // picker entry; empty to leave the dive out of the list
+    };
+
+    // Finds the top-level ranges of 'diveElement' and 'sharedElements' in a
+    // complete document. Returns false if the bytes can't be indexed safely
+    // (UTF-16 input, unbalanced or truncated markup); callers then fall back
+    // to a streaming parse.
+    bool scan(const QByteArray &data,
+              QLatin1String diveElement,
+              const QList<QLatin1String> &sharedElements);
+
+    // The XML for one range as a standalone document: the log's prolog (XML
+    // declaration, DOCTYPE) followed by the element, so the encoding and any
+    // entity declarations still apply. Read namespace-unaware: the root
+    // element's xmlns declarations are not part of the fragment.
+    QByteArray fragment(const QByteArray &data, const Range &range) const;
+    QByteArray fragment(QIODevice &file, const Range &range) const;
+
+    // Content hash of each dive, in order: its bytes and the prolog, plus
+    // the shared definitions it refers to, so a renamed site or gas mix
+    // changes the dives that use it and no others. Definitions are the
+    // children of shared elements that carry 'idAttribute'; a dive refers
+    // to one with any of 'refAttributes' on any of its elements.
+    QList<QByteArray> diveHashes(const QByteArray &data,
+                                 QLatin1String idAttribute,
+                                 const QList<QLatin1String> &refAttributes) const;
+
+    // First dive with this number, or nullptr. With 'unnumberedMatches', an
+    // unnumbered dive before it matches any number, as it does when Subsurface
+    // logs are streamed.
+    const Dive *find(int number, bool unnumberedMatches = false) const;
+
+    // Cache round trip for the file at 'path', as indexed by 'format'. load()
+    // fails if there is no cache entry or the file changed since it was made.
+    bool load(const QString &path, const QString &format);
+    void save(const QString &path, const QString &format) const;
+
+    Range prolog;
+    QList<Range> shared;
+    QList<Dive> dives;
+};
+
+#endif // XML_DIVE_INDEX_H
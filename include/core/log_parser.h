@@ -2,46 +2,207 @@
 #define LOG_PARSER_H
 
 #include <QFile>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
 #include <QList>
 #include <QObject>
+#include <QPointer>
+#include <QSet>
 #include <QString>
+#include <QThread>
+#include <QTimer>
 
+#include <atomic>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "include/core/dive_data.h"
 #include "include/core/format_parsers/idive_log_format_parser.h"
 
+class DecompressingDevice;
+
 class LogParser : public QObject
 {
     Q_OBJECT
 
     Q_PROPERTY(QString lastError READ lastError NOTIFY errorOccurred)
     Q_PROPERTY(bool busy READ isBusy NOTIFY busyChanged)
+    Q_PROPERTY(int progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(QString watchedLogbook READ watchedLogbook NOTIFY watchedLogbookChanged)
+    Q_PROPERTY(bool refreshing READ isRefreshing NOTIFY refreshingChanged)
+    Q_PROPERTY(QString currentLogbook READ currentLogbook NOTIFY currentLogbookChanged)
+    Q_PROPERTY(bool refreshHeld READ isRefreshHeld WRITE setRefreshHeld NOTIFY refreshHeldChanged)
 
 public:
     explicit LogParser(QObject *parent = nullptr);
     ~LogParser() override;
 
+    // Synchronous import: parses on the calling thread and emits the
+    // completion signal before returning
     Q_INVOKABLE bool importFile(const QString &filePath);
     Q_INVOKABLE bool importDive(const QString &filePath, int diveNumber);
+
+    // Background import: parses on a worker thread, reports progress in
+    // file bytes read, and emits diveImported / multipleImported /
+    // errorOccurred (or importCancelled) on this object's thread when done.
+    // A running refresh of the watched logbook is cancelled to make way.
+    // Returns false only if an import is already running.
+    Q_INVOKABLE bool importFileAsync(const QString &filePath);
+    Q_INVOKABLE bool importDiveAsync(const QString &filePath, int diveNumber);
+    Q_INVOKABLE void cancelImport();
+
     Q_INVOKABLE QList<QString> getDiveList(const QString &filePath);
 
+    // Watched-logbook mode: imports the log like importFileAsync(), then
+    // re-imports it in the background whenever it changes on disk. Only
+    // dives whose content changed are parsed again; unchanged dives keep
+    // their DiveData object, so anything tied to those stays valid.
+    // Watching the current logbook doesn't import it again: its dives are
+    // taken over in the background, and only replaced (diveReplaced /
+    // logbookUpdated) if the log changed since it was imported.
+    // Background re-imports leave 'busy' alone and set 'refreshing'; their
+    // failures are reported through refreshFailed, not errorOccurred.
+    // Returns false only if an import is already running.
+    Q_INVOKABLE bool watchLogbook(const QString &filePath);
+    Q_INVOKABLE void stopWatching();
+
+    // Set while an export renders the current dives: refreshes of the
+    // watched logbook then neither start nor replace or remove any dive.
+    // A refresh that finishes meanwhile is kept, and a change on disk
+    // remembered; both are applied once the hold is released.
+    bool isRefreshHeld() const { return m_refreshHeld; }
+    void setRefreshHeld(bool held);
+
     QString lastError() const { return m_lastError; }
     bool isBusy() const { return m_busy; }
+    int progress() const { return m_progress; }
+    QString watchedLogbook() const { return m_watchedPath; }
+    bool isRefreshing() const { return m_refreshing; }
+    // The log the last successful import read, or empty
+    QString currentLogbook() const { return m_currentLogbook; }
 
 signals:
     void diveImported(DiveData* dive);
     void multipleImported(QList<DiveData*> dives);
     void errorOccurred(const QString &error);
+    void importCancelled();
     void busyChanged();
+    void progressChanged();
+    void watchedLogbookChanged();
+    void refreshingChanged();
+    void currentLogbookChanged();
+    void refreshHeldChanged();
+    // A background re-import of the watched logbook failed (e.g. it was
+    // read mid-save); the dives keep their last good state and watching
+    // goes on
+    void refreshFailed(const QString &error);
+
+    // After the watched logbook changed on disk, once per dive that is still
+    // the same dive (same start time, or failing that the same number) but
+    // whose content changed; emitted before logbookUpdated
+    void diveReplaced(DiveData *oldDive, DiveData *newDive);
+    // 'added' are the new and changed dives, owned by the receiver as with
+    // multipleImported. 'removed' are the dives replaced or gone from the
+    // log; the parser no longer refers to them and their owner deletes them.
+    void logbookUpdated(QList<DiveData *> added, QList<DiveData *> removed);
 
 private:
-    IDiveLogFormatParser *selectParser(QFile &file);
+    // Outcome of one parse, handed from the worker back to this thread
+    struct ImportResult {
+        QString filePath;
+        QList<DiveData *> dives;
+        QString error;
+        bool cancelled = false;
+        // Watched-logbook imports: one hash per dive of the log, and
+        // 'dives' aligned with it (null where the dive was known)
+        QList<QByteArray> hashes;
+        // Whole-log imports: the content hash of the file as read
+        QByteArray fileHash;
+    };
+
+    // An import asked for while a refresh was being cancelled
+    struct QueuedImport {
+        QString filePath;
+        int diveNumber = -1;
+        bool watched = false;
+        bool background = false;
+    };
+
+    // A refresh that finished while refreshes were held
+    struct HeldRefresh {
+        ImportResult result;
+        bool adopt = false;
+    };
+
+    // A dive of the watched logbook as last imported
+    struct WatchedDive {
+        QByteArray hash;
+        QPointer<DiveData> dive;
+    };
+
+    IDiveLogFormatParser *selectParser(QIODevice &file);
+    // The device parsers read 'file' through: the file itself, or a
+    // decompressing view of it (owned by 'decompressor') for gzip and zstd
+    // logs. Null, with errorOut set, if the file can't be read.
+    QIODevice *openLog(QFile &file,
+                       std::unique_ptr<DecompressingDevice> &decompressor,
+                       QString &errorOut);
+    // Claims the parser for an import: a user-visible one ('busy') or a
+    // background refresh of the watched logbook ('refreshing')
+    bool beginImport(bool background = false);
+    // Opens, sniffs and parses; safe to run on a worker thread while busy.
+    // Dives are moved to 'owner' before returning. With 'knownDives', only
+    // dives not among those hashes are parsed (see parseChanged()).
+    ImportResult runImport(const QString &filePath, int diveNumber, QThread *owner,
+                           const QSet<QByteArray> *knownDives = nullptr);
+    bool finishImport(ImportResult result, int diveNumber);
+    bool startAsync(const QString &filePath, int diveNumber, bool watched = false,
+                    bool background = false);
+    void launchAsync(const QString &filePath, int diveNumber, bool watched, bool background);
+    void startQueuedImport();
+    void setCurrentLogbook(const QString &filePath, const QList<DiveData *> &dives,
+                           const QByteArray &fileHash);
+    void setProgress(int percent);
+
+    void onWatchedPathChanged();
+    void refreshLogbook();
+    bool finishRefresh(ImportResult result);
+    // Hands a successful refresh's dives to the receiver
+    void applyRefresh(const ImportResult &result, bool adopt);
+    // Diffs a re-import of the watched logbook against the dives it had
+    void applyLogbookChanges(const ImportResult &result);
+    // First import of a watched logbook that is the current one: pairs the
+    // dives the receiver already has with the re-read ones
+    void adoptCurrentDives(const ImportResult &result);
 
     std::vector<std::unique_ptr<IDiveLogFormatParser>> m_parsers;
     QString m_lastError;
     bool m_busy;
+    bool m_refreshing = false;
+    int m_progress = 0;
+    std::atomic<bool> m_cancelRequested{false};
+    QFutureWatcher<ImportResult> m_watcher;
+    bool m_asyncPending = false;
+    int m_asyncDiveNumber = -1;
+
+    QFileSystemWatcher m_fileWatcher;
+    QTimer m_refreshTimer;           // coalesces the writes of one save
+    QString m_watchedPath;
+    QList<WatchedDive> m_watchedDives;
+    bool m_importWatched = false;    // the running import is of the watched logbook
+    bool m_importBackground = false; // ... and runs as a refresh, not a user import
+    bool m_adoptCurrent = false;     // ... and takes over the current logbook's dives
+    bool m_watchReady = false;       // the watched logbook's first import is done
+    bool m_refreshPending = false;   // it changed while another import ran
+    QueuedImport m_queuedImport;     // empty path if none
+    bool m_refreshHeld = false;
+    std::optional<HeldRefresh> m_heldRefresh;
+
+    // The log whose dives the receiver currently holds
+    QString m_currentLogbook;
+    QByteArray m_currentLogbookHash;
+    QList<QPointer<DiveData>> m_currentDives;
 };
 
 #endif // LOG_PARSER_H
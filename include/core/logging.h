@@ -0,0 +1,15 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QLoggingCategory>
+
+// Logging categories for the per-sample and per-frame paths. Debug output
+// is off by default; a disabled qCDebug() is a flag test that skips
+// formatting its arguments entirely. Enable with e.g.
+//   QT_LOGGING_RULES="unabara.parse.debug=true"
+Q_DECLARE_LOGGING_CATEGORY(lcParse)    // log import and format parsers
+Q_DECLARE_LOGGING_CATEGORY(lcRender)   // overlay generation and previews
+Q_DECLARE_LOGGING_CATEGORY(lcExport)   // image and video export
+Q_DECLARE_LOGGING_CATEGORY(lcTimeline) // timeline and range queries
+
+#endif // LOGGING_H
@@ -0,0 +1,121 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <QImage>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QVector>
+#include <functional>
+#include "include/core/dive_data.h"
+
+class IFrameGenerator;
+
+/**
+ * Renders an export's frames across the global QThreadPool and hands them to
+ * a sink strictly in frame order.
+ *
+ * Up to maxInFlight() frames are rendered (and optionally encoded) at once on
+ * worker threads; finished frames wait in a reorder buffer until every earlier
+ * frame has been delivered, so disk / encoder output stays sequential. The sink
+ * always runs on the calling (GUI) thread, which keeps pumping events while it
+ * waits for the next frame.
+ *
+ * Generators that don't report supportsConcurrentGenerate() are driven
+ * serially on the calling thread, with the same ordering and sink contract.
+ *
+ * Dive samples for the frames are interpolated ahead of rendering with
+ * DiveData::resample(), a block of frames at a time, and handed to
+ * IFrameGenerator::generateFromSample().
+ * The caller owns the beginExport()/endExport() pair around run().
+ */
+class FramePipeline
+{
+public:
+    // Post-render work done on the worker thread, so the sink only does I/O
+    enum class Encoding {
+        None,     // sink gets the QImage as rendered
+        Png,      // sink gets PNG bytes in Frame::data
+        RawBgra   // Frame::image converted to straight-alpha ARGB32; not
+                  // checked for repeats, as the conversion costs less
+                  // than the hash and compare
+    };
+
+    struct Frame {
+        int index = 0;
+        double time = 0.0;
+        QImage image;
+        QByteArray data;
+        // Frames of one run with the same id have identical pixels; a sink
+        // may store such a frame as a reference to the earlier one. -1 for
+        // a frame that failed to render. Unique per frame for RawBgra.
+        qint64 contentId = -1;
+    };
+
+    // Return false to stop the run (error or cancellation)
+    using Sink = std::function<bool(const Frame&)>;
+
+    FramePipeline(DiveData* dive, IFrameGenerator* generator);
+
+    void setEncoding(Encoding encoding) { m_encoding = encoding; }
+    Encoding encoding() const { return m_encoding; }
+
+    // Defaults to twice the pool's thread count
+    void setMaxInFlight(int frames);
+    int maxInFlight() const { return m_maxInFlight; }
+
+    // Renders `times` in order; returns false if the sink stopped the run.
+    // Frames already in flight are drained before returning. Ascending
+    // times (as frameTimes() produces) resample in a single merge pass.
+    bool run(const QVector<double> &times, const Sink &sink);
+
+    // Inclusive frame timeline [startTime, endTime] at `fps`
+    static QVector<double> frameTimes(double startTime, double endTime, double fps);
+
+    // Makes `path` a hard link to the already written `existing` frame,
+    // replacing any file at `path`. False where the file system can't link
+    // (e.g. FAT); the caller then writes the frame out in full.
+    static bool linkFrameFile(const QString &existing, const QString &path);
+
+    // An export's summary for the completion message: `frames` (what the
+    // exporter did with them), then the generator's exportSummary() if it
+    // has one, a line each. Also logged on one line.
+    static QString summary(const QString &frames, const IFrameGenerator *generator);
+
+private:
+    // Frames resampled per DiveData::resample() call: large enough to
+    // amortise the merge, small enough that a long export doesn't hold
+    // every frame's sample at once
+    static constexpr int kResampleBlock = 1024;
+
+    // Interpolated sample for frame `index`, resampling the next block
+    // when it runs past the current one. Calling thread only.
+    DiveDataPoint sampleFor(const QVector<double> &times, int index);
+    Frame renderFrame(int index, double time, const DiveDataPoint &sample) const;
+    void encode(Frame &frame) const;
+    bool runSerial(const QVector<double> &times, const Sink &sink);
+    bool runConcurrent(const QVector<double> &times, const Sink &sink);
+
+    DiveData* m_dive;
+    IFrameGenerator* m_generator;
+    Encoding m_encoding = Encoding::None;
+    int m_maxInFlight;
+    DiveSampleColumns m_block;
+    int m_blockStart = 0;
+
+    // Recently rendered distinct frames. Overlay values change slowly, so
+    // runs of consecutive frames come out pixel-identical (a surface
+    // interval, a long deco stop); a frame matching one of these reuses its
+    // encoding and content id instead of being encoded again.
+    struct RecentFrame {
+        size_t hash = 0;
+        QImage rendered;
+        Frame encoded;
+    };
+    static constexpr int kRecentFrames = 8;
+    mutable QMutex m_recentMutex;
+    mutable QList<RecentFrame> m_recent;
+    mutable qint64 m_nextContentId = 0;
+};
+
+#endif // FRAME_PIPELINE_H
@@ -16,6 +16,8 @@ class ImageExporter : public QObject
     Q_PROPERTY(double frameRate READ frameRate WRITE setFrameRate NOTIFY frameRateChanged)
     Q_PROPERTY(int progress READ progress NOTIFY progressChanged)
     Q_PROPERTY(bool busy READ isBusy NOTIFY busyChanged)
+    // What the last completed export did, for the completion message
+    Q_PROPERTY(QString summary READ summary NOTIFY summaryChanged)
     
 public:
     explicit ImageExporter(QObject *parent = nullptr);
@@ -25,6 +27,7 @@ public:
     double frameRate() const { return m_frameRate; }
     int progress() const { return m_progress; }
     bool isBusy() const { return m_busy; }
+    QString summary() const { return m_summary; }
     
     // Setters
     void setExportPath(const QString &path);
@@ -54,12 +57,14 @@ signals:
     void exportStarted();
     void exportFinished(bool success, const QString &path);
     void exportError(const QString &errorMessage);
+    void summaryChanged();
     
 private:
     QString m_exportPath;
     double m_frameRate;
     int m_progress;
     bool m_busy;
+    QString m_summary;
     
     // Helper methods
     QString generateUniqueDirectoryName(DiveData* dive,
@@ -21,6 +21,9 @@ class VideoExporter : public QObject
     Q_PROPERTY(int progress READ progress NOTIFY progressChanged)
     Q_PROPERTY(bool busy READ isBusy NOTIFY busyChanged)
     Q_PROPERTY(QSize customResolution READ customResolution WRITE setCustomResolution NOTIFY customResolutionChanged)
+    Q_PROPERTY(bool streamFrames READ streamFrames WRITE setStreamFrames NOTIFY streamFramesChanged)
+    // What the last completed export did, for the completion message
+    Q_PROPERTY(QString summary READ summary NOTIFY summaryChanged)
     
 public:
     explicit VideoExporter(QObject *parent = nullptr);
@@ -43,6 +46,12 @@ public:
     int progress() const { return m_progress; }
     bool isBusy() const { return m_busy; }
     QSize customResolution() const { return m_customResolution; }
+    // When true (default) frames are piped to FFmpeg's stdin as raw BGRA
+    // while they render; when false they go through a PNG temp directory,
+    // where repeats of the previous frame are hard links. Either way the
+    // video is constant-rate and FFmpeg encodes every frame.
+    bool streamFrames() const { return m_streamFrames; }
+    QString summary() const { return m_summary; }
     
     // Setters
     void setExportPath(const QString &path);
@@ -50,6 +59,7 @@ public:
     void setVideoBitrate(int bitrate);
     void setVideoCodec(const QString &codec);
     void setCustomResolution(const QSize &size);
+    void setStreamFrames(bool stream);
     
     // Export methods. Accepts `generator` as a QObject* — internally
     // dynamic_cast to IFrameGenerator, so both OverlayGenerator and
@@ -87,6 +97,8 @@ signals:
     void exportError(const QString &errorMessage);
     void statusUpdate(const QString &message);
     void customResolutionChanged();
+    void streamFramesChanged();
+    void summaryChanged();
     
 private slots:
     void processFFmpegOutput();
@@ -101,8 +113,15 @@ private:
     int m_progress;
     bool m_busy;
     QSize m_customResolution;
+    bool m_streamFrames;
+    // Set while frames are being piped into FFmpeg so progress comes from the
+    // encoder's frame counter instead of the two-phase 50/50 split.
+    bool m_streaming;
+    bool m_cancelRequested;
+    int m_totalFrames;
     QString m_lastOutputPath;
     QString m_pendingOutputPath;
+    QString m_summary;
     // Rolling tail of FFmpeg's stdout+stderr, retained so the actual error can
     // be logged if FFmpeg exits non-zero (the output is otherwise consumed only
     // for progress parsing and discarded).
@@ -120,6 +139,12 @@ private:
     bool generateFrames(DiveData* dive, IFrameGenerator* generator,
                         double startTime, double endTime);
     bool encodeFramesToVideo(const QString &outputPath);
+    // Streaming path: renders and encodes in one pass, no temp directory.
+    bool streamFramesToVideo(DiveData* dive, IFrameGenerator* generator,
+                             double startTime, double endTime,
+                             const QString &outputPath);
+    bool startFFmpeg(const QStringList &inputArgs, const QString &outputPath);
+    bool writeFrame(const QImage &frame);
     
     // Helper methods
     static QString ffmpegCommandName();
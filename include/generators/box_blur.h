@@ -0,0 +1,35 @@
+#ifndef BOX_BLUR_H
+#define BOX_BLUR_H
+
+class QImage;
+
+// Box blur for the Blurred shadow type: three separable box passes
+// approximate a gaussian. Images must be 32-bit premultiplied ARGB;
+// blurring all four channels of premultiplied data is alpha-correct.
+//
+// Each pass runs row-major both ways: the horizontal half slides a window
+// along each row, the vertical half keeps a running sum per column and
+// sweeps the rows top to bottom, so neither walks memory column by column.
+// On x86 the sums of all four channels of a pixel live in one register
+// (SSE2; AVX2 handles two pixels at once), picked at runtime from what the
+// CPU supports. Every kernel produces the same bytes as the scalar one.
+namespace box_blur {
+
+enum class Kernel {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+bool isSupported(Kernel kernel);
+// Fastest kernel this CPU runs
+Kernel bestKernel();
+
+// Blurs 'image' in place with the best kernel; radius < 1 is a no-op
+void blur(QImage &image, int radius);
+// Same with a given kernel, which must be supported
+void blur(QImage &image, int radius, Kernel kernel);
+
+} // namespace box_blur
+
+#endif // BOX_BLUR_H
@@ -4,6 +4,7 @@
 #include <QImage>
 
 class DiveData;
+struct DiveDataPoint;
 
 /**
  * Minimal abstract interface for anything that can render a single overlay frame
@@ -22,12 +23,35 @@ public:
     // Returns a transparent-background QImage sized for compositing.
     virtual QImage generate(DiveData* dive, double timePoint) = 0;
 
+    // Same as generate(), with the dive already interpolated at timePoint.
+    // The export pipeline resamples its frame range in batches with
+    // DiveData::resample() and calls this; generators that look the sample
+    // up themselves can rely on the default, which ignores it.
+    virtual QImage generateFromSample(DiveData* dive, double timePoint,
+                                      const DiveDataPoint& sample)
+    {
+        Q_UNUSED(sample);
+        return generate(dive, timePoint);
+    }
+
     // Optional hooks for generators that need to stage/restore state for
     // export passes (e.g. hide editor-only chrome). Default no-op.
     // Exporters MUST call beginExport() before the first generate() and
     // endExport() after the last, in a symmetric pair.
     virtual void beginExport() {}
     virtual void endExport() {}
+
+    // One line on the work the last export pass saved or did (e.g. cells
+    // redrawn), for the exporter's summary; empty if there's nothing to
+    // report. Valid from endExport() until the next beginExport().
+    virtual QString exportSummary() const { return QString(); }
+
+    // True when generate() may be called from several threads at once between
+    // beginExport() and endExport(). The export pipeline renders frames on a
+    // thread pool only for generators that opt in; others run serially on the
+    // GUI thread. Queried after beginExport(), so a generator may answer
+    // from state it froze there. Default false.
+    virtual bool supportsConcurrentGenerate() const { return false; }
 };
 
 #endif // I_FRAME_GENERATOR_H
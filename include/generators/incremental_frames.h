@@ -0,0 +1,53 @@
+#ifndef INCREMENTAL_FRAMES_H
+#define INCREMENTAL_FRAMES_H
+
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+class QThread;
+
+// What the incremental cell renderer remembers between frames of an export:
+// per rendering thread, the last frame it produced and each cell's text and
+// painted area in it. At 30 fps most cells show the same text for dozens of
+// frames, so a new frame starts from the thread's previous one and only the
+// cells whose text changed are repainted over the restored background.
+//
+// Export workers take frames roughly in order, so a thread's previous frame
+// is a close neighbour of its next one. Also counts the cells drawn, for the
+// export's summary.
+class IncrementalFrames
+{
+public:
+    struct Frame {
+        QImage image;           // empty until the thread's first frame
+        QVector<QString> texts; // display text per visible cell
+        QVector<QRect> extents; // area each cell painted
+    };
+
+    // The calling thread's previous frame. Only that thread touches it.
+    Frame &frameForCurrentThread();
+
+    // Tallies one rendered frame: 'redrawn' of its 'cells' were painted
+    void countFrame(int cells, int redrawn);
+
+    qint64 frames() const { return m_frames.load(std::memory_order_relaxed); }
+    qint64 cells() const { return m_cells.load(std::memory_order_relaxed); }
+    qint64 cellsRedrawn() const { return m_cellsRedrawn.load(std::memory_order_relaxed); }
+
+private:
+    QMutex m_mutex; // guards the frame table, not the frames
+    std::unordered_map<QThread *, std::unique_ptr<Frame>> m_frameByThread;
+
+    std::atomic<qint64> m_frames{0};
+    std::atomic<qint64> m_cells{0};
+    std::atomic<qint64> m_cellsRedrawn{0};
+};
+
+#endif // INCREMENTAL_FRAMES_H
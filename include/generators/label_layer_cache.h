@@ -0,0 +1,62 @@
+#ifndef LABEL_LAYER_CACHE_H
+#define LABEL_LAYER_CACHE_H
+
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QPoint>
+#include <QString>
+
+#include <functional>
+
+// Pre-rendered cell labels: the label line and its shadow, rasterised once
+// and blitted on every later frame. During an export the labels ("DEPTH",
+// "TEMP", ...) almost never change while the values under them do, so this
+// takes the label's half of the text and shadow work out of the frame loop.
+//
+// A label can't go into the background itself: the cell centers its lines
+// over the wider of label and value, so where the label lands moves with
+// the value. The layers are plain images, usable from any thread.
+class LabelLayerCache
+{
+public:
+    struct Key {
+        QFont font;
+        QString text;
+        QRgb color = 0;
+        bool shadowEnabled = false;
+        int shadowType = 0;
+        QRgb shadowColor = 0;
+        int shadowPixels = 0;
+        int subpixelX = 0; // fractional x position of the text, in 1/64 px
+
+        bool operator==(const Key &other) const
+        {
+            return text == other.text && color == other.color
+                   && shadowEnabled == other.shadowEnabled && shadowType == other.shadowType
+                   && shadowColor == other.shadowColor && shadowPixels == other.shadowPixels
+                   && subpixelX == other.subpixelX && font == other.font;
+        }
+    };
+
+    struct Layer {
+        QImage image;
+        QPoint textOrigin; // where the text's top-left (at whole pixels) sits in 'image'
+    };
+
+    // The layer for 'key', rendered with 'render' the first time it is asked for
+    Layer layer(const Key &key, const std::function<Layer()> &render);
+
+private:
+    friend size_t qHash(const Key &key, size_t seed)
+    {
+        return qHashMulti(seed, key.text, key.font, key.color, key.shadowEnabled, key.shadowType,
+                          key.shadowColor, key.shadowPixels, key.subpixelX);
+    }
+
+    QMutex m_mutex;
+    QHash<Key, Layer> m_layers;
+};
+
+#endif // LABEL_LAYER_CACHE_H
@@ -7,12 +7,17 @@
 #include <QFont>
 #include <QColor>
 #include <QVector>
+#include <QMutex>
+#include <memory>
 #include "include/core/dive_data.h"
 #include "include/core/config.h"
 #include "include/core/units.h"
 #include "include/core/cell_data.h"
 #include "include/core/overlay_template.h"
 #include "include/generators/i_frame_generator.h"
+#include "include/generators/incremental_frames.h"
+#include "include/generators/label_layer_cache.h"
+#include "include/generators/text_layout_cache.h"
 
 class OverlayGenerator : public QObject, public IFrameGenerator
 {
@@ -220,10 +225,48 @@ public:
     // Generate a preview image
     Q_INVOKABLE QImage generatePreview(DiveData* dive);
 
+    // Immutable copy of everything the cell-based renderer reads: decoded
+    // background, cells, global font/colours/shadow and the unit system.
+    // Rendering from a snapshot touches neither generator members nor
+    // Config, so any number of threads may render one concurrently while the
+    // editor keeps mutating the live generator.
+    struct RenderSnapshot {
+        QImage background; // template with background opacity applied
+        QVector<Unabara::CellData> cells;
+        QFont font;
+        QColor labelColor;
+        QColor valueColor;
+        bool shadowEnabled = false;
+        Unabara::ShadowType shadowType = Unabara::ShadowType::Offset;
+        QColor shadowColor;
+        int shadowSize = 0;
+        double shadowOpacity = 1.0;
+        bool showCellBackgrounds = false;
+        Units::UnitSystem unitSystem = Units::UnitSystem::Metric;
+        // False when the generator would take the legacy section-based path,
+        // which still renders from live state
+        bool cellBased = false;
+        // Shaped cell text; shared by every render from this snapshot
+        std::shared_ptr<TextLayoutCache> textLayouts = std::make_shared<TextLayoutCache>();
+        // Rasterised labels with their shadows, likewise shared
+        std::shared_ptr<LabelLayerCache> labelLayers = std::make_shared<LabelLayerCache>();
+        // Export snapshots only: each render thread's previous frame, which
+        // the next one starts from, repainting only the cells that changed
+        std::shared_ptr<IncrementalFrames> incremental;
+    };
+    RenderSnapshot captureSnapshot() const;
+    static QImage renderSnapshot(const RenderSnapshot& snapshot, DiveData* dive, double timePoint);
+    static QImage renderSnapshot(const RenderSnapshot& snapshot, DiveData* dive,
+                                 const DiveDataPoint& dataPoint);
+
     // IFrameGenerator
-    QImage generate(DiveData* dive, double timePoint) override { return generateOverlay(dive, timePoint); }
+    QImage generate(DiveData* dive, double timePoint) override;
+    QImage generateFromSample(DiveData* dive, double timePoint,
+                              const DiveDataPoint& sample) override;
     void beginExport() override;
     void endExport() override;
+    QString exportSummary() const override { return m_exportSummary; }
+    bool supportsConcurrentGenerate() const override;
     
 signals:
     void templateChanged();
@@ -330,14 +373,33 @@ private:
     QColor m_primaryColor;
     QColor m_secondaryColor;
 
-    // Export-pass state stash (saved by beginExport, restored by endExport)
-    bool m_savedShowCellBackgrounds = true;
+    // Export-pass state: captured by beginExport, dropped by endExport.
+    // Worker threads only ever read m_exportSnapshot between the two.
+    bool m_exporting = false;
+    RenderSnapshot m_exportSnapshot;
+    QString m_exportSummary; // what endExport() counted, until the next pass
+
+    // Decoded template with background opacity applied, premultiplied. Built
+    // once per (path, opacity, size) instead of per frame; captureSnapshot()
+    // runs on the QML image-provider thread too, hence the mutex.
+    QImage backgroundLayer() const;
+    void invalidateBackgroundCache();
+    mutable QMutex m_backgroundCacheMutex;
+    mutable QImage m_backgroundCache;
+    mutable QString m_backgroundCachePath;
+    mutable double m_backgroundCacheOpacity = -1.0;
+    mutable QSize m_backgroundCacheSize;
+
+    // Shaped cell text for previews; an export shapes into its own cache,
+    // dropped with the export snapshot
+    std::shared_ptr<TextLayoutCache> m_textLayouts = std::make_shared<TextLayoutCache>();
+    std::shared_ptr<LabelLayerCache> m_labelLayers = std::make_shared<LabelLayerCache>();
 
     // Seed a cell's label/value colors from the globals (isCustom = false)
     void seedCellColors(Unabara::CellData& cell) const;
 
     // Helper methods for drawing
-    int getScaledFontSize(const QFont& baseFont, double scale = 1.0) const;
+    static int getScaledFontSize(const QFont& baseFont, double scale = 1.0);
     QSizeF calculateCellSize(Unabara::CellType cellType, const QFont& font, const QSizeF& templateSize, const QString& sampleText = "") const;
     void updateTemplateDimensions();
     void drawDepth(QPainter &painter, double depth, const QRect &rect);
@@ -355,15 +417,24 @@ private:
     void drawCompositePO2(QPainter &painter, double po2Value, const QRect &rect);
 
     // Cell-based vs section-based rendering
-    void renderCellBasedOverlay(QPainter& painter, const QSize& imageSize,
-                                const DiveDataPoint& dataPoint, DiveData* dive);
+    struct CellPaint;
+    static CellPaint layoutCell(const RenderSnapshot& snapshot, const Unabara::CellData& cell,
+                                const QSize& imageSize, const DiveDataPoint& dataPoint,
+                                DiveData* dive);
+    static void paintCell(QPainter& painter, const RenderSnapshot& snapshot, const CellPaint& paint);
+    static QImage renderIncremental(const RenderSnapshot& snapshot, DiveData* dive,
+                                    const DiveDataPoint& dataPoint);
+    static void renderCellBasedOverlay(QPainter& painter, const QSize& imageSize,
+                                       const RenderSnapshot& snapshot,
+                                       const DiveDataPoint& dataPoint, DiveData* dive);
     void renderSectionBasedOverlay(QPainter& painter, const QSize& imageSize,
                                    const DiveDataPoint& dataPoint, DiveData* dive);
 
     // Generate display text for a cell (matches CellModel::formatValue for QML consistency)
-    QString generateCellDisplayText(Unabara::CellType cellType, const DiveDataPoint& dataPoint,
-                                    int tankIndex, DiveData* dive,
-                                    bool showLabel = true) const;
+    static QString generateCellDisplayText(Unabara::CellType cellType, const DiveDataPoint& dataPoint,
+                                           int tankIndex, DiveData* dive,
+                                           Units::UnitSystem unitSystem,
+                                           bool showLabel = true);
 };
 
 #endif // OVERLAY_GEN_H
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <atomic>
 
 #include "include/core/dive_data.h"
+#include "include/core/units.h"
 #include "include/generators/i_frame_generator.h"
 
 /**
@@ -102,6 +103,12 @@ public:
     // IFrameGenerator — for exports, pulse phase is timestamp-derived so each
     // frame in a sequence has a deterministic pulse state.
     Q_INVOKABLE QImage generate(DiveData* dive, double timePoint) override;
+    // Export frames render from the settings beginExport() froze, and the
+    // base cache is the only state they share (under its mutex), so the
+    // pool may render them while the user keeps editing
+    void beginExport() override;
+    void endExport() override;
+    bool supportsConcurrentGenerate() const override { return m_exporting; }
 
     // Like generate() but with an explicit pulse phase (0..1). Used by the live
     // preview to animate the indicator while the user is idle on the timeline.
@@ -129,22 +136,61 @@ signals:
     void gridShowLabelsChanged();
 
 private:
+    // Everything a frame is drawn from, the unit system included; copied so
+    // a render never reads members or Config another thread may be setting
+    struct RenderSettings {
+        QColor backgroundColor;
+        double backgroundOpacity = 0.0;
+        QColor curveColor;
+        int curveWidth = 1;
+        QColor indicatorColor;
+        IndicatorMode indicatorMode = Static;
+        int indicatorRadius = 1;
+        int pulsePeriodMs = 0;
+        int outputWidth = 0;
+        int outputHeight = 0;
+        QColor decoZoneColor;
+        double decoZoneOpacity = 0.0;
+        bool gridEnabled = false;
+        int gridDepthInterval = 1;
+        int gridTimeInterval = 1;
+        QColor gridColor;
+        double gridOpacity = 0.0;
+        int gridLineWidth = 1;
+        bool gridShowLabels = false;
+        Units::UnitSystem unitSystem = Units::UnitSystem::Metric;
+    };
+    RenderSettings captureSettings() const;
+
     // Everything below the indicator (background, grid, deco zone, depth
     // curve) is time-independent, so it is rendered once and cached. Each
-    // renderFrame() then just copies the cache and stamps the indicator —
+    // frame then just copies the cache and stamps the indicator —
     // constant-time per pulse tick instead of O(sample count).
-    QImage renderBase(DiveData* dive);
+    struct BaseCache {
+        QImage image;
+        quint64 builtGen = 0;
+        DiveData* dive = nullptr; // identity key only — never dereferenced
+        int points = -1;
+    };
+    QImage render(const RenderSettings& settings, BaseCache& cache, quint64 gen,
+                  DiveData* dive, double timePoint, double pulsePhase01);
+    static QImage renderBase(const RenderSettings& settings, DiveData* dive);
     void invalidateBaseCache();
 
-    // renderFrame() runs on the QML image-provider thread while setters run
-    // on the GUI thread: the mutex guards the cache, and the atomic
-    // generation counter lets setters invalidate without taking the lock.
+    // renderFrame() runs on the QML image-provider thread and export frames
+    // on the pool while setters run on the GUI thread: the mutex guards the
+    // caches, and the atomic generation counter lets setters invalidate the
+    // live one without taking the lock. The export's cache is built from
+    // its frozen settings and never invalidated mid-pass.
     QMutex m_baseCacheMutex;
-    QImage m_baseCache;
+    BaseCache m_baseCache;
+    BaseCache m_exportBaseCache;
     std::atomic<quint64> m_baseCacheGen { 1 };
-    quint64 m_baseCacheBuiltGen = 0;
-    DiveData* m_baseCacheDive = nullptr; // identity key only — never dereferenced
-    int m_baseCachePoints = -1;
+
+    // Export-pass state: captured by beginExport, dropped by endExport.
+    // Worker threads only ever read m_exportSettings between the two.
+    bool m_exporting = false;
+    RenderSettings m_exportSettings;
 
     QColor m_backgroundColor;
     double m_backgroundOpacity;
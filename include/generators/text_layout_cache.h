@@ -0,0 +1,72 @@
+#ifndef TEXT_LAYOUT_CACHE_H
+#define TEXT_LAYOUT_CACHE_H
+
+#include <QFont>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QTextLayout>
+
+#include <memory>
+#include <unordered_map>
+
+class QThread;
+
+// Shaped lines of overlay text. Shaping (font matching, glyph lookup and
+// positioning) is most of what drawing a cell costs, and most cell text
+// repeats from frame to frame: labels always, values often. Each distinct
+// (font, line) is shaped once and every later frame draws the cached glyphs.
+//
+// Font engines belong to the thread that created them, so each rendering
+// thread gets its own shard of the cache and only ever touches that one. A
+// shard goes when its thread finishes, before another thread can take over
+// the QThread's address and, with it, the shard.
+class TextLayoutCache
+{
+public:
+    struct Line {
+        QTextLayout layout; // one laid-out line at (0, 0), glyphs cached
+        qreal width = 0.0;  // natural width of the text
+        int height = 0;     // font height
+        int lineSpacing = 0;
+    };
+
+    // 'text' (no line breaks) shaped in 'font', for the calling thread
+    std::shared_ptr<const Line> line(const QFont &font, const QString &text);
+
+    // Drops every shard. Only while no other thread renders with the cache.
+    void clear();
+
+private:
+    struct Key {
+        QFont font;
+        QString text;
+        bool operator==(const Key &other) const
+        {
+            return text == other.text && font == other.font;
+        }
+    };
+    friend size_t qHash(const Key &key, size_t seed) { return qHashMulti(seed, key.text, key.font); }
+
+    // Per-thread entries; emptied when full rather than tracking recency,
+    // labels are back after a single re-shape
+    struct Shard {
+        QHash<Key, std::shared_ptr<const Line>> lines;
+        QMetaObject::Connection threadFinished; // drops the shard
+        ~Shard() { QObject::disconnect(threadFinished); }
+    };
+
+    // Shared with the threads' finished handlers, which may run as the
+    // cache itself goes away
+    struct Shards {
+        QMutex mutex; // guards the table, not the shards
+        std::unordered_map<QThread *, std::unique_ptr<Shard>> byThread;
+    };
+
+    Shard &shardForCurrentThread();
+
+    std::shared_ptr<Shards> m_shards = std::make_shared<Shards>();
+};
+
+#endif // TEXT_LAYOUT_CACHE_H
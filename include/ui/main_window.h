@@ -12,6 +12,9 @@ class MainWindow : public QObject
     
     Q_PROPERTY(DiveData* currentDive READ currentDive WRITE setCurrentDive NOTIFY currentDiveChanged)
     Q_PROPERTY(bool hasActiveDive READ hasActiveDive NOTIFY currentDiveChanged)
+    // Summaries of the last imported log's dives for the selection dialog;
+    // each entry's "index" is what selectDiveByIndex() takes
+    Q_PROPERTY(QVariantList diveList READ diveList NOTIFY diveListChanged)
     
 public:
     explicit MainWindow(QObject *parent = nullptr);
@@ -21,6 +24,7 @@ public:
     DiveData* currentDive() const { return m_currentDive; }
     void setCurrentDive(DiveData* dive);
     bool hasActiveDive() const { return m_currentDive != nullptr; }
+    QVariantList diveList() const;
     
     // File dialogs
     Q_INVOKABLE QString openFileDialog(const QString &title, const QString &filter);
@@ -40,6 +44,8 @@ public slots:
     void onDiveImported(DiveData* dive);
     void onMultipleDivesImported(QList<DiveData*> dives);
     void onDiveSelected(DiveData* dive);
+    void onDiveReplaced(DiveData* oldDive, DiveData* newDive);
+    void onLogbookUpdated(QList<DiveData*> added, QList<DiveData*> removed);
     
     Q_INVOKABLE void selectDiveByIndex(int index);
     
@@ -47,11 +53,15 @@ signals:
     void currentDiveChanged();
     void exportRequested(const QString &path);
     void multipleDivesFound(QVariantList dives);
+    void diveListChanged();
     
 private:
     DiveData* m_currentDive;
-    QList<DiveData*> m_availableDives;
-    QList<DiveData*> m_pendingDiveSelection;
+    QList<DiveData*> m_availableDives;   // every dive we own
+    // The last imported log's dives, in the order the selection dialog
+    // lists them. A dive removed from a watched log leaves a null behind,
+    // so indices QML holds stay valid.
+    QList<DiveData*> m_logbookDives;
 };
 
 #endif // MAIN_WINDOW_H
\ No newline at end of file
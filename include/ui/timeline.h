@@ -73,6 +73,9 @@ signals:
     
 private:
     DiveData* m_diveData;
+    // Playback moves forward a frame at a time; getCurrentDataPoint() reads
+    // through this rather than searching the whole dive every tick
+    mutable DiveSampleCursor m_cursor;
     double m_currentTime;
     double m_startTime;
     double m_endTime;
@@ -0,0 +1,366 @@
+#include "include/core/dive_cache.h"
+#include "include/core/logging.h"
+#include "version.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+
+namespace {
+
+constexpr char kMagic[8] = {'U', 'N', 'B', 'D', 'I', 'V', 'E', 'S'};
+constexpr quint32 kVersion = 2;
+constexpr quint32 kByteOrderMark = 0x01020304;
+constexpr int kHashSize = 20; // SHA-1
+constexpr int kAppVersionSize = 16;
+constexpr int kScalarColumns = 9;
+// Sanity bounds for counts read back from the metadata
+constexpr qint32 kMaxCylinders = 64;
+constexpr qint32 kMaxChannels = 0xFFFF;
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint64 metaOffset;
+    quint64 metaSize;
+    quint64 fileSize;
+    qint64 sourceSize;
+    qint64 sourceModified; // ms since the epoch
+    char sourceHash[kHashSize];
+    quint32 diveCount;
+    // A parser change can change what a log parses to; entries from any
+    // other build are misses
+    char appVersion[kAppVersionSize];
+};
+static_assert(sizeof(Header) == 96, "dive cache header layout changed");
+
+// UNABARA_VERSION_STR as stored in the header: truncated or zero-padded
+std::array<char, kAppVersionSize> appVersion()
+{
+    std::array<char, kAppVersionSize> version{};
+    std::strncpy(version.data(), UNABARA_VERSION_STR, version.size());
+    return version;
+}
+
+// Checks that don't need the source: written by this build, for this
+// machine, and no longer than the cache file itself
+bool headerUsable(const Header &header, qint64 cacheSize)
+{
+    return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion
+           && header.byteOrder == kByteOrderMark && header.fileSize == quint64(cacheSize)
+           && std::memcmp(header.appVersion, appVersion().data(), kAppVersionSize) == 0;
+}
+
+QString cacheFilePath(const QString &sourcePath)
+{
+    const QByteArray key = QFileInfo(sourcePath).absoluteFilePath().toUtf8();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + QStringLiteral("/dives/")
+           + QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex())
+           + QStringLiteral(".dives");
+}
+
+// The scalar sample columns, in file order
+template <typename Columns>
+auto scalarColumns(Columns &c) -> std::array<decltype(&c.timestamp), kScalarColumns>
+{
+    return {{ &c.timestamp, &c.depth, &c.temperature, &c.ndl, &c.ceiling,
+              &c.o2percent, &c.tts, &c.cns, &c.stopTime }};
+}
+
+// Bytes of one dive's column block, including the trailing padding
+qint64 columnBytes(qint64 samples, qint64 tanks, qint64 sensors)
+{
+    const qint64 raw = samples * (qint64(sizeof(double)) * (kScalarColumns + tanks + sensors)
+                                  + 2 * qint64(sizeof(quint16)));
+    return (raw + 7) & ~qint64(7);
+}
+
+template <typename T>
+void appendRaw(QByteArray &out, const QVector<T> &column)
+{
+    out.append(reinterpret_cast<const char *>(column.constData()),
+               column.size() * qsizetype(sizeof(T)));
+}
+
+template <typename T>
+void readRaw(const uchar *&p, int count, QVector<T> &column)
+{
+    column.resize(count);
+    std::memcpy(column.data(), p, count * sizeof(T));
+    p += count * sizeof(T);
+}
+
+void writeDive(QDataStream &out, QByteArray &columns, const DiveData &dive)
+{
+    const DiveSampleColumns &samples = dive.samples();
+    const quint64 offset = sizeof(Header) + columns.size();
+    for (const QVector<double> *column : scalarColumns(samples)) {
+        appendRaw(columns, *column);
+    }
+    for (const QVector<double> &column : samples.pressures) {
+        appendRaw(columns, column);
+    }
+    for (const QVector<double> &column : samples.po2Sensors) {
+        appendRaw(columns, column);
+    }
+    appendRaw(columns, samples.tankCount);
+    appendRaw(columns, samples.po2SensorCount);
+    columns.append(QByteArray((8 - columns.size() % 8) % 8, '\0'));
+
+    out << dive.diveName() << dive.startTime() << dive.location() << qint32(dive.diveNumber())
+        << dive.loggedMeanDepth() << dive.diveSiteName() << dive.diveSiteId()
+        << qint32(dive.diveMode());
+
+    out << qint32(dive.cylinderCount());
+    for (const CylinderInfo &cylinder : dive.cylinders()) {
+        out << cylinder.description << cylinder.size << cylinder.workPressure
+            << cylinder.o2Percent << cylinder.hePercent << cylinder.startPressure
+            << cylinder.endPressure;
+    }
+
+    out << qint32(dive.gasSwitches().size());
+    for (const GasSwitch &gasSwitch : dive.gasSwitches()) {
+        out << gasSwitch.timestamp << qint32(gasSwitch.cylinderIndex);
+    }
+
+    out << offset << qint32(samples.size()) << qint32(samples.pressures.size())
+        << qint32(samples.po2Sensors.size());
+}
+
+bool readDive(QDataStream &in, const uchar *base, qint64 fileSize, DiveData &dive)
+{
+    QString name;
+    QDateTime startTime;
+    QString location;
+    qint32 number = 0;
+    double meanDepth = -1.0;
+    QString siteName;
+    QString siteId;
+    qint32 mode = 0;
+    in >> name >> startTime >> location >> number >> meanDepth >> siteName >> siteId >> mode;
+
+    qint32 cylinderCount = 0;
+    in >> cylinderCount;
+    if (in.status() != QDataStream::Ok || cylinderCount < 0 || cylinderCount > kMaxCylinders) {
+        return false;
+    }
+
+    dive.setDiveName(name);
+    dive.setStartTime(startTime);
+    dive.setLocation(location);
+    dive.setDiveNumber(number);
+    dive.setMeanDepth(meanDepth);
+    dive.setDiveSiteName(siteName);
+    dive.setDiveSiteId(siteId);
+    dive.setDiveMode(static_cast<DiveData::DiveMode>(mode));
+
+    for (qint32 i = 0; i < cylinderCount; ++i) {
+        CylinderInfo cylinder;
+        in >> cylinder.description >> cylinder.size >> cylinder.workPressure
+           >> cylinder.o2Percent >> cylinder.hePercent >> cylinder.startPressure
+           >> cylinder.endPressure;
+        dive.addCylinder(cylinder);
+    }
+
+    qint32 switchCount = 0;
+    in >> switchCount;
+    if (in.status() != QDataStream::Ok || switchCount < 0) {
+        return false;
+    }
+    for (qint32 i = 0; i < switchCount && in.status() == QDataStream::Ok; ++i) {
+        double timestamp = 0.0;
+        qint32 cylinderIndex = 0;
+        in >> timestamp >> cylinderIndex;
+        dive.addGasSwitch(timestamp, cylinderIndex);
+    }
+
+    quint64 offset = 0;
+    qint32 count = 0;
+    qint32 tanks = 0;
+    qint32 sensors = 0;
+    in >> offset >> count >> tanks >> sensors;
+    if (in.status() != QDataStream::Ok || count < 0 || tanks < 0 || tanks > kMaxChannels
+        || sensors < 0 || sensors > kMaxChannels || offset % 8 != 0
+        || offset > quint64(fileSize)
+        || columnBytes(count, tanks, sensors) > fileSize - qint64(offset)) {
+        return false;
+    }
+
+    DiveSampleColumns samples;
+    const uchar *p = base + offset;
+    for (QVector<double> *column : scalarColumns(samples)) {
+        readRaw(p, count, *column);
+    }
+    samples.pressures.resize(tanks);
+    for (QVector<double> &column : samples.pressures) {
+        readRaw(p, count, column);
+    }
+    samples.po2Sensors.resize(sensors);
+    for (QVector<double> &column : samples.po2Sensors) {
+        readRaw(p, count, column);
+    }
+    readRaw(p, count, samples.tankCount);
+    readRaw(p, count, samples.po2SensorCount);
+
+    // Per-sample channel counts index the channel columns directly
+    const auto within = [](quint16 limit) { return [limit](quint16 n) { return n <= limit; }; };
+    if (!std::all_of(samples.tankCount.cbegin(), samples.tankCount.cend(), within(quint16(tanks)))
+        || !std::all_of(samples.po2SensorCount.cbegin(), samples.po2SensorCount.cend(),
+                        within(quint16(sensors)))) {
+        return false;
+    }
+
+    dive.setSamples(std::move(samples));
+    return true;
+}
+
+} // namespace
+
+namespace dive_cache {
+
+QByteArray contentHash(QFile &file)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const qint64 size = file.size();
+    if (uchar *data = size > 0 ? file.map(0, size) : nullptr) {
+        hash.addData(QByteArray::fromRawData(reinterpret_cast<const char *>(data), size));
+        file.unmap(data);
+    } else {
+        file.seek(0);
+        if (!hash.addData(&file)) {
+            file.seek(0);
+            return QByteArray();
+        }
+    }
+    file.seek(0);
+    return hash.result();
+}
+
+QByteArray recordedHash(const QFileInfo &source)
+{
+    // Queried first whatever the outcome: QFileInfo keeps them, so a later
+    // store() with the same 'source' records them as they were now
+    const qint64 size = source.size();
+    const qint64 modified = source.lastModified().toMSecsSinceEpoch();
+
+    QFile cache(cacheFilePath(source.filePath()));
+    Header header;
+    if (!source.exists() || !cache.open(QIODevice::ReadOnly)
+        || cache.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header))
+        || !headerUsable(header, cache.size()) || header.sourceSize != size
+        || header.sourceModified != modified) {
+        return QByteArray();
+    }
+    return QByteArray(header.sourceHash, kHashSize);
+}
+
+QList<DiveData *> load(const QString &sourcePath, const QByteArray &contentHash)
+{
+    QList<DiveData *> dives;
+    if (contentHash.size() != kHashSize) {
+        return dives;
+    }
+
+    QFile cache(cacheFilePath(sourcePath));
+    if (!cache.open(QIODevice::ReadOnly) || cache.size() < qint64(sizeof(Header))) {
+        return dives;
+    }
+    const qint64 size = cache.size();
+    uchar *base = cache.map(0, size);
+    if (!base) {
+        return dives;
+    }
+
+    Header header;
+    std::memcpy(&header, base, sizeof(header));
+    if (!headerUsable(header, size)
+        || std::memcmp(header.sourceHash, contentHash.constData(), kHashSize) != 0
+        || header.metaOffset > quint64(size) || header.metaSize > quint64(size) - header.metaOffset) {
+        cache.unmap(base);
+        return dives;
+    }
+
+    const QByteArray meta = QByteArray::fromRawData(
+        reinterpret_cast<const char *>(base + header.metaOffset), qsizetype(header.metaSize));
+    QDataStream in(meta);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    bool valid = true;
+    for (quint32 i = 0; valid && i < header.diveCount; ++i) {
+        auto dive = std::make_unique<DiveData>();
+        valid = readDive(in, base, size, *dive);
+        if (valid) {
+            dives.append(dive.release());
+        }
+    }
+    cache.unmap(base);
+
+    if (!valid || in.status() != QDataStream::Ok) {
+        qCDebug(lcParse) << "Discarding invalid dive cache for" << sourcePath;
+        qDeleteAll(dives);
+        dives.clear();
+    }
+    return dives;
+}
+
+void store(const QFileInfo &source, const QByteArray &contentHash,
+           const QList<DiveData *> &dives)
+{
+    if (contentHash.size() != kHashSize || dives.isEmpty()) {
+        return;
+    }
+
+    QByteArray columns;
+    QByteArray meta;
+    QDataStream out(&meta, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    for (const DiveData *dive : dives) {
+        writeDive(out, columns, *dive);
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.metaOffset = sizeof(Header) + columns.size();
+    header.metaSize = meta.size();
+    header.fileSize = header.metaOffset + header.metaSize;
+    header.sourceSize = source.size();
+    header.sourceModified = source.lastModified().toMSecsSinceEpoch();
+    std::memcpy(header.sourceHash, contentHash.constData(), kHashSize);
+    header.diveCount = dives.size();
+    std::memcpy(header.appVersion, appVersion().data(), kAppVersionSize);
+
+    const QString path = cacheFilePath(source.filePath());
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        qCDebug(lcParse) << "Could not create dive cache directory for" << path;
+        return;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(lcParse) << "Could not write dive cache" << path << "-" << file.errorString();
+        return;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(columns);
+    file.write(meta);
+    if (!file.commit()) {
+        qCDebug(lcParse) << "Could not write dive cache" << path << "-" << file.errorString();
+    }
+}
+
+} // namespace dive_cache
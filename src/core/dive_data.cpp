@@ -1,6 +1,112 @@
 #include "include/core/dive_data.h"
+#include "include/core/logging.h"
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// Inserts one sample's worth of channel values (tank pressures or PO2
+// sensors). A sample with more channels than seen so far adds columns,
+// zero-filled for the 'rows' samples already stored.
+void insertChannels(QVector<QVector<double>> &columns, QVector<quint16> &counts,
+                    int rows, int index, const QVector<double> &values)
+{
+    while (columns.size() < values.size()) {
+        columns.append(QVector<double>(rows, 0.0));
+    }
+    for (int c = 0; c < columns.size(); ++c) {
+        columns[c].insert(index, c < values.size() ? values[c] : 0.0);
+    }
+    counts.insert(index, static_cast<quint16>(values.size()));
+}
+
+template <typename T>
+void permuteColumn(QVector<T> &column, const QVector<int> &order)
+{
+    QVector<T> sorted;
+    sorted.reserve(order.size());
+    for (int from : order) {
+        sorted.append(column[from]);
+    }
+    column = std::move(sorted);
+}
+
+} // namespace
+
+void DiveSampleColumns::clear()
+{
+    *this = DiveSampleColumns();
+}
+
+void DiveSampleColumns::reserve(int count)
+{
+    for (QVector<double> *column : { &timestamp, &depth, &temperature, &ndl, &ceiling,
+                                     &o2percent, &tts, &cns, &stopTime }) {
+        column->reserve(count);
+    }
+    for (QVector<double> &column : pressures) {
+        column.reserve(count);
+    }
+    for (QVector<double> &column : po2Sensors) {
+        column.reserve(count);
+    }
+    tankCount.reserve(count);
+    po2SensorCount.reserve(count);
+}
+
+void DiveSampleColumns::insert(int index, const DiveDataPoint &point)
+{
+    const int rows = size();
+    timestamp.insert(index, point.timestamp);
+    depth.insert(index, point.depth);
+    temperature.insert(index, point.temperature);
+    ndl.insert(index, point.ndl);
+    ceiling.insert(index, point.ceiling);
+    o2percent.insert(index, point.o2percent);
+    tts.insert(index, point.tts);
+    cns.insert(index, point.cns);
+    stopTime.insert(index, point.stopTime);
+    insertChannels(pressures, tankCount, rows, index, point.pressures);
+    insertChannels(po2Sensors, po2SensorCount, rows, index, point.po2Sensors);
+}
+
+void DiveSampleColumns::permute(const QVector<int> &order)
+{
+    for (QVector<double> *column : { &timestamp, &depth, &temperature, &ndl, &ceiling,
+                                     &o2percent, &tts, &cns, &stopTime }) {
+        permuteColumn(*column, order);
+    }
+    for (QVector<double> &column : pressures) {
+        permuteColumn(column, order);
+    }
+    for (QVector<double> &column : po2Sensors) {
+        permuteColumn(column, order);
+    }
+    permuteColumn(tankCount, order);
+    permuteColumn(po2SensorCount, order);
+}
+
+DiveDataPoint DiveSampleColumns::point(int index) const
+{
+    DiveDataPoint p(timestamp[index], depth[index], temperature[index],
+                    ndl[index], ceiling[index], o2percent[index], tts[index]);
+    p.cns = cns[index];
+    p.stopTime = stopTime[index];
+
+    const int tanks = tankCount[index];
+    p.pressures.resize(tanks);
+    for (int t = 0; t < tanks; ++t) {
+        p.pressures[t] = pressures[t][index];
+    }
+    const int sensors = po2SensorCount[index];
+    p.po2Sensors.resize(sensors);
+    for (int s = 0; s < sensors; ++s) {
+        p.po2Sensors[s] = po2Sensors[s][index];
+    }
+    return p;
+}
 
 DiveData::DiveData(QObject *parent)
     : QObject(parent), m_diveNumber(0)
@@ -65,56 +171,55 @@ void DiveData::setDiveMode(DiveMode mode)
 
 int DiveData::durationSeconds() const
 {
-    if (m_dataPoints.isEmpty()) {
+    if (m_samples.isEmpty()) {
         return 0;
     }
     
     // Return the timestamp of the last data point, which represents
     // the total duration of the dive in seconds
-    return static_cast<int>(m_dataPoints.last().timestamp);
+    return static_cast<int>(m_samples.timestamp.last());
 }
 
 double DiveData::maxDepth() const
 {
-    if (m_dataPoints.isEmpty()) {
+    if (m_samples.isEmpty()) {
         return 0.0;
     }
     
-    double max = 0.0;
-    for (const auto &point : m_dataPoints) {
-        if (point.depth > max) {
-            max = point.depth;
-        }
-    }
-    
-    return max;
+    return derivedStats()->maxDepth;
 }
 
 double DiveData::maxDepthUntil(double time) const
 {
     // Running maximum: the deepest point reached up to 'time', like the MAX
     // field on a dive computer display during the dive.
-    double max = 0.0;
-    for (int i = 0; i < m_dataPoints.size(); ++i) {
-        const DiveDataPoint &point = m_dataPoints[i];
-        if (point.timestamp > time) {
-            // 'time' falls inside the previous segment — include the
-            // interpolated depth so a descent between samples still registers
-            if (i > 0) {
-                const DiveDataPoint &prev = m_dataPoints[i - 1];
-                double dt = point.timestamp - prev.timestamp;
-                if (dt > 0.0 && time > prev.timestamp) {
-                    double factor = (time - prev.timestamp) / dt;
-                    double depth = prev.depth + factor * (point.depth - prev.depth);
-                    if (depth > max) {
-                        max = depth;
-                    }
-                }
+    if (m_samples.isEmpty()) {
+        return 0.0;
+    }
+
+    const auto stats = derivedStats();
+    const QVector<double> &times = m_samples.timestamp;
+    const QVector<double> &depths = m_samples.depth;
+
+    // Samples at or before 'time'
+    auto it = std::upper_bound(times.cbegin(), times.cend(), time);
+    const int count = static_cast<int>(it - times.cbegin());
+    if (count == 0) {
+        return 0.0;
+    }
+
+    double max = stats->prefixMaxDepth[count - 1];
+
+    // 'time' falls inside the following segment — include the interpolated
+    // depth so a descent between samples still registers
+    if (count < times.size()) {
+        double dt = times[count] - times[count - 1];
+        if (dt > 0.0 && time > times[count - 1]) {
+            double factor = (time - times[count - 1]) / dt;
+            double depth = depths[count - 1] + factor * (depths[count] - depths[count - 1]);
+            if (depth > max) {
+                max = depth;
             }
-            break;
-        }
-        if (point.depth > max) {
-            max = point.depth;
         }
     }
 
@@ -128,27 +233,83 @@ double DiveData::meanDepth() const
         return m_meanDepth;
     }
 
-    if (m_dataPoints.isEmpty()) {
+    if (m_samples.isEmpty()) {
         return 0.0;
     }
 
     // Fall back to a time-weighted average of the depth samples (trapezoidal)
+    return derivedStats()->meanDepth;
+}
+
+std::shared_ptr<const DiveData::DerivedStats> DiveData::derivedStats() const
+{
+    QMutexLocker lock(&m_derivedMutex);
+    if (m_derived) {
+        return m_derived;
+    }
+
+    auto stats = std::make_shared<DerivedStats>();
+    const QVector<double> &times = m_samples.timestamp;
+    const QVector<double> &depths = m_samples.depth;
+    const QVector<double> &temperatures = m_samples.temperature;
+    const int count = times.size();
+    stats->prefixMaxDepth.resize(count);
+
+    double max = 0.0;
     double weightedSum = 0.0;
     double totalTime = 0.0;
-    for (int i = 1; i < m_dataPoints.size(); ++i) {
-        double dt = m_dataPoints[i].timestamp - m_dataPoints[i - 1].timestamp;
-        if (dt <= 0.0) {
-            continue;
+    double minTemp = count > 0 ? temperatures.first() : 0.0;
+    for (int i = 0; i < count; ++i) {
+        if (depths[i] > max) {
+            max = depths[i];
         }
-        weightedSum += dt * (m_dataPoints[i].depth + m_dataPoints[i - 1].depth) / 2.0;
-        totalTime += dt;
+        if (i > 0) {
+            double dt = times[i] - times[i - 1];
+            if (dt > 0.0) {
+                weightedSum += dt * (depths[i] + depths[i - 1]) / 2.0;
+                totalTime += dt;
+            }
+        }
+        if (temperatures[i] < minTemp && temperatures[i] > 0.0) {
+            minTemp = temperatures[i];
+        }
+        stats->prefixMaxDepth[i] = max;
     }
 
-    if (totalTime <= 0.0) {
-        return m_dataPoints.first().depth;
+    stats->maxDepth = max;
+    if (totalTime > 0.0) {
+        stats->meanDepth = weightedSum / totalTime;
+    } else if (count > 0) {
+        stats->meanDepth = depths.first();
     }
+    stats->minTemperature = minTemp;
+    stats->cylinderCurves = buildCylinderCurves();
+
+    m_derived = stats;
+    return m_derived;
+}
 
-    return weightedSum / totalTime;
+void DiveData::invalidateDerivedStats()
+{
+    QMutexLocker lock(&m_derivedMutex);
+    m_derived.reset();
+    m_pointsView.clear();
+    m_pointsViewValid = false;
+}
+
+const QVector<DiveDataPoint>& DiveData::allDataPoints() const
+{
+    QMutexLocker lock(&m_derivedMutex);
+    if (!m_pointsViewValid) {
+        const int count = m_samples.size();
+        m_pointsView.clear();
+        m_pointsView.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            m_pointsView.append(m_samples.point(i));
+        }
+        m_pointsViewValid = true;
+    }
+    return m_pointsView;
 }
 
 void DiveData::setMeanDepth(double depth)
@@ -161,18 +322,11 @@ void DiveData::setMeanDepth(double depth)
 
 double DiveData::minTemperature() const
 {
-    if (m_dataPoints.isEmpty()) {
+    if (m_samples.isEmpty()) {
         return 0.0;
     }
     
-    double min = m_dataPoints.first().temperature;
-    for (const auto &point : m_dataPoints) {
-        if (point.temperature < min && point.temperature > 0.0) {
-            min = point.temperature;
-        }
-    }
-    
-    return min;
+    return derivedStats()->minTemperature;
 }
 
 void DiveData::addCylinder(const CylinderInfo &cylinder)
@@ -180,6 +334,7 @@ void DiveData::addCylinder(const CylinderInfo &cylinder)
     CylinderInfo newCyl = cylinder;
     newCyl.index = m_cylinders.size(); // Set the index
     m_cylinders.append(newCyl);
+    invalidateDerivedStats();
     emit dataChanged();
 }
 
@@ -220,130 +375,150 @@ QString DiveData::cylinderDescription(int index) const
 
 void DiveData::addDataPoint(const DiveDataPoint &point)
 {
-    // Insert the point in the right position to maintain chronological order
-    auto it = std::lower_bound(m_dataPoints.begin(), m_dataPoints.end(), point,
-                               [](const DiveDataPoint &a, const DiveDataPoint &b) {
-                                   return a.timestamp < b.timestamp;
-                               });
-    
-    int index = it - m_dataPoints.begin();
-    m_dataPoints.insert(index, point);
+    // Insert the point in the right position to maintain chronological
+    // order; after any samples with the same timestamp, so equal times keep
+    // their arrival order the way appendDataPoints() does
+    const QVector<double> &times = m_samples.timestamp;
+    const auto after = std::upper_bound(times.cbegin(), times.cend(), point.timestamp);
+    m_samples.insert(static_cast<int>(after - times.cbegin()), point);
+    invalidateDerivedStats();
     
     emit dataChanged();
     emit durationChanged();
 }
 
+void DiveData::appendDataPoints(const QVector<DiveDataPoint> &points)
+{
+    if (points.isEmpty()) {
+        return;
+    }
+
+    const int seam = m_samples.size();
+    m_samples.reserve(seam + points.size());
+    for (const DiveDataPoint &point : points) {
+        m_samples.append(point);
+    }
+
+    // Parsers emit samples in time order, so this is normally one linear
+    // check. Stable so equal timestamps keep their arrival order.
+    const QVector<double> &times = m_samples.timestamp;
+    const int checkFrom = seam > 0 ? seam - 1 : 0;
+    if (!std::is_sorted(times.cbegin() + checkFrom, times.cend())) {
+        QVector<int> order(times.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&times](int a, int b) {
+            return times[a] < times[b];
+        });
+        m_samples.permute(order);
+    }
+    invalidateDerivedStats();
+
+    emit dataChanged();
+    emit durationChanged();
+}
+
 void DiveData::clearData()
 {
-    m_dataPoints.clear();
+    m_samples.clear();
+    invalidateDerivedStats();
+    emit dataChanged();
+    emit durationChanged();
+}
+
+void DiveData::setSamples(DiveSampleColumns samples)
+{
+    m_samples = std::move(samples);
+
+    const QVector<double> &times = m_samples.timestamp;
+    if (!std::is_sorted(times.cbegin(), times.cend())) {
+        QVector<int> order(times.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&times](int a, int b) {
+            return times[a] < times[b];
+        });
+        m_samples.permute(order);
+    }
+    invalidateDerivedStats();
+
     emit dataChanged();
     emit durationChanged();
 }
 
 DiveDataPoint DiveData::dataAtTime(double time) const
 {
-    if (m_dataPoints.isEmpty()) {
+    if (m_samples.isEmpty()) {
         return DiveDataPoint();
     }
     
     // If time is before the first data point, return the first point
-    if (time <= m_dataPoints.first().timestamp) {
-        return m_dataPoints.first();
+    if (time <= m_samples.timestamp.first()) {
+        return m_samples.point(0);
     }
     
     // If time is after the last data point, return the last point
-    if (time >= m_dataPoints.last().timestamp) {
-        return m_dataPoints.last();
-    }
-    
-    // Find the two data points surrounding the requested time
-    int index = 0;
-    while (index < m_dataPoints.size() && m_dataPoints[index].timestamp < time) {
-        index++;
+    if (time >= m_samples.timestamp.last()) {
+        return m_samples.point(m_samples.size() - 1);
     }
     
-    // Points surrounding the time
-    const DiveDataPoint &prev = m_dataPoints[index - 1];
-    const DiveDataPoint &next = m_dataPoints[index];
+    return interpolateSegment(sampleIndexAt(time), time);
+}
+
+int DiveData::sampleIndexAt(double time) const
+{
+    // First sample at or after 'time' (samples are kept sorted)
+    const QVector<double> &times = m_samples.timestamp;
+    auto it = std::lower_bound(times.cbegin(), times.cend(), time);
+    return static_cast<int>(it - times.cbegin());
+}
+
+DiveDataPoint DiveData::interpolateSegment(int index, double time) const
+{
+    // Samples surrounding the time
+    const DiveSampleColumns &s = m_samples;
+    const int prev = index - 1;
+    const int next = index;
     
     // Calculate interpolation factor (0.0 to 1.0)
-    double factor = (time - prev.timestamp) / (next.timestamp - prev.timestamp);
+    double factor = (time - s.timestamp[prev]) / (s.timestamp[next] - s.timestamp[prev]);
+    auto lerp = [prev, next, factor](const QVector<double> &column) {
+        return column[prev] + factor * (column[next] - column[prev]);
+    };
     
     // Linearly interpolate all values
     DiveDataPoint result;
     result.timestamp = time;
-    result.depth = prev.depth + factor * (next.depth - prev.depth);
-    result.temperature = prev.temperature + factor * (next.temperature - prev.temperature);
+    result.depth = lerp(s.depth);
+    result.temperature = lerp(s.temperature);
     // NDL: -1 means "not reported by the computer" — never blend across the
     // sentinel, or missing data would fabricate deco state
-    result.ndl = (prev.ndl < 0.0 || next.ndl < 0.0)
-        ? (factor >= 1.0 ? next.ndl : prev.ndl)
-        : prev.ndl + factor * (next.ndl - prev.ndl);
-    result.o2percent = prev.o2percent + factor * (next.o2percent - prev.o2percent);
-    result.tts = prev.tts + factor * (next.tts - prev.tts);
+    result.ndl = (s.ndl[prev] < 0.0 || s.ndl[next] < 0.0)
+        ? (factor >= 1.0 ? s.ndl[next] : s.ndl[prev])
+        : lerp(s.ndl);
+    result.o2percent = lerp(s.o2percent);
+    result.tts = lerp(s.tts);
 
     // CNS: only interpolate between two valid values (-1 means no data).
     // Across a no-data boundary, keep the surrounding sample's state instead
     // of blending with the -1 sentinel.
-    result.cns = (prev.cns < 0.0 || next.cns < 0.0)
-        ? (factor >= 1.0 ? next.cns : prev.cns)
-        : prev.cns + factor * (next.cns - prev.cns);
+    result.cns = (s.cns[prev] < 0.0 || s.cns[next] < 0.0)
+        ? (factor >= 1.0 ? s.cns[next] : s.cns[prev])
+        : lerp(s.cns);
 
     // Do NOT interpolate ceiling - use the value from the previous point
     // Ceiling is a state that persists until changed
-    result.ceiling = prev.ceiling;
+    result.ceiling = s.ceiling[prev];
 
     // Deco stop time is likewise a held state, not a continuous quantity
-    result.stopTime = prev.stopTime;
+    result.stopTime = s.stopTime[prev];
     
     // For in_deco state, we also shouldn't interpolate (though it's not part of DiveDataPoint directly)
     
     // Interpolate all tank pressures. Cover every known cylinder, not just
     // the channels present in the samples — a dive with no per-sample
     // pressures (manually entered log) still displays the start/end ramp.
-    int maxTanks = qMax(qMax(prev.tankCount(), next.tankCount()), cylinderCount());
+    int maxTanks = qMax(qMax<int>(s.tankCount[prev], s.tankCount[next]), cylinderCount());
     for (int i = 0; i < maxTanks; i++) {
-        double pressure = 0.0;
-
-        // Check if we have cylinder information
-        if (i < cylinderCount()) {
-            const CylinderInfo &cylinder = cylinderInfo(i);
-            double prevPressure = prev.getPressure(i);
-            double nextPressure = next.getPressure(i);
-
-            // Recorded samples take precedence: they carry the actual
-            // consumption curve (fast at depth, slow at the stop), which the
-            // synthetic start/end ramp cannot reproduce
-            if (prevPressure > 0.0 && nextPressure > 0.0) {
-                pressure = prevPressure + factor * (nextPressure - prevPressure);
-            }
-            // Without samples, fall back to the cylinder start/end ramp,
-            // which respects gas switches and handles missing data
-            else if (cylinder.startPressure > 0.0 && cylinder.endPressure > 0.0) {
-                if (isCylinderActiveAtTime(i, time)) {
-                    // Active cylinder: use cylinder-based interpolation
-                    pressure = interpolateCylinderPressure(i, time);
-                } else {
-                    // Inactive cylinder: use last interpolated value for continuity
-                    double lastInterpolated = getLastInterpolatedPressure(i);
-                    if (lastInterpolated > 0.0) {
-                        pressure = lastInterpolated;
-                    } else {
-                        // Fallback: use start pressure if cylinder was never used
-                        pressure = cylinder.startPressure;
-                    }
-                }
-            }
-        }
-        // No cylinder info - use sample-based interpolation
-        else {
-            double prevPressure = prev.getPressure(i);
-            double nextPressure = next.getPressure(i);
-            if (prevPressure > 0.0 && nextPressure > 0.0) {
-                pressure = prevPressure + factor * (nextPressure - prevPressure);
-            }
-        }
-
+        double pressure = segmentPressure(prev, next, factor, i, time);
         if (pressure > 0.0) {
             result.addPressure(pressure, i);
         }
@@ -351,10 +526,10 @@ DiveDataPoint DiveData::dataAtTime(double time) const
     
     // Interpolate all PO2 sensors (CCR data)
     // Get the maximum number of PO2 sensors between both points
-    int maxSensors = qMax(prev.po2SensorCount(), next.po2SensorCount());
+    int maxSensors = qMax<int>(s.po2SensorCount[prev], s.po2SensorCount[next]);
     for (int i = 0; i < maxSensors; i++) {
-        double prevPO2 = prev.getPO2Sensor(i);
-        double nextPO2 = next.getPO2Sensor(i);
+        double prevPO2 = s.po2SensorAt(prev, i);
+        double nextPO2 = s.po2SensorAt(next, i);
         
         // Only interpolate if both points have valid PO2 data
         if (prevPO2 > 0.0 && nextPO2 > 0.0) {
@@ -373,55 +548,272 @@ DiveDataPoint DiveData::dataAtTime(double time) const
     return result;
 }
 
+double DiveData::segmentPressure(int prev, int next, double factor, int tank, double time) const
+{
+    const double prevPressure = m_samples.pressureAt(prev, tank);
+    const double nextPressure = m_samples.pressureAt(next, tank);
+
+    // Check if we have cylinder information
+    if (tank < cylinderCount()) {
+        // Recorded samples take precedence: they carry the actual
+        // consumption curve (fast at depth, slow at the stop), which the
+        // synthetic start/end ramp cannot reproduce
+        if (prevPressure > 0.0 && nextPressure > 0.0) {
+            return prevPressure + factor * (nextPressure - prevPressure);
+        }
+        // Without samples, fall back to the cylinder start/end ramp,
+        // which respects gas switches and handles missing data
+        return cylinderPressureAt(tank, time);
+    }
+
+    // No cylinder info - use sample-based interpolation
+    if (prevPressure > 0.0 && nextPressure > 0.0) {
+        return prevPressure + factor * (nextPressure - prevPressure);
+    }
+    return 0.0;
+}
+
+DiveSampleColumns DiveData::resample(const QVector<double> &times) const
+{
+    const DiveSampleColumns &s = m_samples;
+    const int n = s.size();
+    const int count = times.size();
+
+    DiveSampleColumns out;
+    if (n == 0) {
+        // Mirror dataAtTime() on an empty dive
+        out.reserve(count);
+        for (int k = 0; k < count; ++k) {
+            out.append(DiveDataPoint());
+        }
+        return out;
+    }
+
+    // Pass 1: bracket every requested time. Clamped times (outside the
+    // recorded range) get lo == hi and factor 0, which makes every kernel
+    // below return that sample's value unchanged — the same as dataAtTime()
+    // returning the first / last point.
+    QVector<int> lo(count);
+    QVector<int> hi(count);
+    QVector<double> factor(count);
+    const double firstTime = s.timestamp.first();
+    const double lastTime = s.timestamp.last();
+    // Export asks for increasing times, so the cursor walks forward a step
+    // or two per frame; out-of-order requests fall back to a binary search
+    DiveSampleCursor cursor(this);
+    for (int k = 0; k < count; ++k) {
+        const double t = times[k];
+        if (t <= firstTime || t >= lastTime) {
+            lo[k] = hi[k] = (t <= firstTime) ? 0 : n - 1;
+            factor[k] = 0.0;
+            continue;
+        }
+        const int j = cursor.sampleIndexAt(t);
+        lo[k] = j - 1;
+        hi[k] = j;
+        factor[k] = (t - s.timestamp[j - 1]) / (s.timestamp[j] - s.timestamp[j - 1]);
+    }
+
+    // Pass 2: scalar channels, one flat loop per column. The arithmetic is
+    // exactly interpolateSegment()'s, so results match dataAtTime() bit for bit.
+    const int *plo = lo.constData();
+    const int *phi = hi.constData();
+    const double *pf = factor.constData();
+    auto lerp = [&](const QVector<double> &src, QVector<double> &dst) {
+        dst.resize(count);
+        const double *in = src.constData();
+        double *o = dst.data();
+        for (int k = 0; k < count; ++k) {
+            o[k] = in[plo[k]] + pf[k] * (in[phi[k]] - in[plo[k]]);
+        }
+    };
+    // Held states (ceiling, stop time) take the earlier sample
+    auto hold = [&](const QVector<double> &src, QVector<double> &dst) {
+        dst.resize(count);
+        const double *in = src.constData();
+        double *o = dst.data();
+        for (int k = 0; k < count; ++k) {
+            o[k] = in[plo[k]];
+        }
+    };
+    // -1 means "no data": never blend across it (NDL, CNS)
+    auto sentinelLerp = [&](const QVector<double> &src, QVector<double> &dst) {
+        dst.resize(count);
+        const double *in = src.constData();
+        double *o = dst.data();
+        for (int k = 0; k < count; ++k) {
+            const double a = in[plo[k]];
+            const double b = in[phi[k]];
+            o[k] = (a < 0.0 || b < 0.0) ? (pf[k] >= 1.0 ? b : a) : a + pf[k] * (b - a);
+        }
+    };
+
+    out.timestamp.resize(count);
+    for (int k = 0; k < count; ++k) {
+        out.timestamp[k] = (plo[k] == phi[k]) ? s.timestamp[plo[k]] : times[k];
+    }
+    lerp(s.depth, out.depth);
+    lerp(s.temperature, out.temperature);
+    sentinelLerp(s.ndl, out.ndl);
+    hold(s.ceiling, out.ceiling);
+    lerp(s.o2percent, out.o2percent);
+    lerp(s.tts, out.tts);
+    sentinelLerp(s.cns, out.cns);
+    hold(s.stopTime, out.stopTime);
+
+    // Pass 3: per-tank and per-sensor channels. Clamped samples copy their
+    // channels as recorded; interpolated ones report channels up to the
+    // last non-zero value, as DiveDataPoint::addPressure() would.
+    const int tanks = qMax(static_cast<int>(s.pressures.size()), cylinderCount());
+    out.pressures = QVector<QVector<double>>(tanks, QVector<double>(count, 0.0));
+    out.tankCount.resize(count);
+    for (int k = 0; k < count; ++k) {
+        out.tankCount[k] = (plo[k] == phi[k]) ? s.tankCount[plo[k]] : 0;
+    }
+    for (int i = 0; i < tanks; ++i) {
+        double *o = out.pressures[i].data();
+        for (int k = 0; k < count; ++k) {
+            if (plo[k] == phi[k]) {
+                o[k] = s.pressureAt(plo[k], i);
+                continue;
+            }
+            o[k] = segmentPressure(plo[k], phi[k], pf[k], i, times[k]);
+            if (o[k] > 0.0) {
+                out.tankCount[k] = static_cast<quint16>(i + 1);
+            }
+        }
+    }
+
+    const int sensors = s.po2Sensors.size();
+    out.po2Sensors = QVector<QVector<double>>(sensors, QVector<double>(count, 0.0));
+    out.po2SensorCount.resize(count);
+    for (int k = 0; k < count; ++k) {
+        out.po2SensorCount[k] = (plo[k] == phi[k]) ? s.po2SensorCount[plo[k]] : 0;
+    }
+    for (int i = 0; i < sensors; ++i) {
+        double *o = out.po2Sensors[i].data();
+        for (int k = 0; k < count; ++k) {
+            if (plo[k] == phi[k]) {
+                o[k] = s.po2SensorAt(plo[k], i);
+                continue;
+            }
+            // A sensor missing from one side holds the other side's value
+            const double a = s.po2SensorAt(plo[k], i);
+            const double b = s.po2SensorAt(phi[k], i);
+            if (a > 0.0 && b > 0.0) {
+                o[k] = a + pf[k] * (b - a);
+            } else {
+                o[k] = a > 0.0 ? a : b;
+            }
+            if (o[k] > 0.0) {
+                out.po2SensorCount[k] = static_cast<quint16>(i + 1);
+            }
+        }
+    }
+
+    return out;
+}
+
+DiveSampleCursor::DiveSampleCursor(const DiveData* dive)
+    : m_dive(dive)
+{
+}
+
+void DiveSampleCursor::reset(const DiveData* dive)
+{
+    m_dive = dive;
+    m_index = 0;
+}
+
+int DiveSampleCursor::sampleIndexAt(double time)
+{
+    const QVector<double> &times = m_dive->m_samples.timestamp;
+    const int count = times.size();
+    if (m_index > count) {
+        m_index = count; // samples were removed since the last lookup
+    }
+
+    // Still inside (or just past) the remembered segment: walk forward a few
+    // samples. Playback and export advance by a fraction of a sample interval
+    // per frame, so this almost always ends within one or two steps.
+    if (m_index == 0 || times[m_index - 1] < time) {
+        const int limit = qMin(count, m_index + kMaxLinearSteps);
+        while (m_index < limit && times[m_index] < time) {
+            ++m_index;
+        }
+        if (m_index == count || times[m_index] >= time) {
+            return m_index;
+        }
+    }
+
+    // Backward seek or long jump
+    m_index = m_dive->sampleIndexAt(time);
+    return m_index;
+}
+
+DiveDataPoint DiveSampleCursor::dataAtTime(double time)
+{
+    const DiveSampleColumns &samples = m_dive->m_samples;
+    if (samples.isEmpty()) {
+        return DiveDataPoint();
+    }
+    if (time <= samples.timestamp.first()) {
+        m_index = 0;
+        return samples.point(0);
+    }
+    if (time >= samples.timestamp.last()) {
+        m_index = samples.size() - 1;
+        return samples.point(m_index);
+    }
+    return m_dive->interpolateSegment(sampleIndexAt(time), time);
+}
+
 QVector<DiveDataPoint> DiveData::dataInRange(double startTime, double endTime) const
 {
     QVector<DiveDataPoint> result;
     
-    qDebug() << "DiveData::dataInRange - Requested data from" << startTime << "to" << endTime;
-    qDebug() << "DiveData::dataInRange - Total data points available:" << m_dataPoints.size();
+    qCDebug(lcTimeline) << "DiveData::dataInRange - Requested data from" << startTime << "to" << endTime;
+    qCDebug(lcTimeline) << "DiveData::dataInRange - Total data points available:" << m_samples.size();
     
+    const QVector<double> &times = m_samples.timestamp;
+    const int count = times.size();
+
     // Find the first point after or at startTime
-    auto startIt = std::lower_bound(m_dataPoints.begin(), m_dataPoints.end(), DiveDataPoint(startTime),
-                                    [](const DiveDataPoint &a, const DiveDataPoint &b) {
-                                        return a.timestamp < b.timestamp;
-                                    });
+    const int first = static_cast<int>(std::lower_bound(times.cbegin(), times.cend(), startTime) - times.cbegin());
     
     // Find the first point after endTime
-    auto endIt = std::upper_bound(m_dataPoints.begin(), m_dataPoints.end(), DiveDataPoint(endTime),
-                                  [](const DiveDataPoint &a, const DiveDataPoint &b) {
-                                      return a.timestamp < b.timestamp;
-                                  });
+    const int last = static_cast<int>(std::upper_bound(times.cbegin(), times.cend(), endTime) - times.cbegin());
     
     // Insert starting point at exact startTime (interpolated if necessary)
-    if (startIt != m_dataPoints.begin() && startIt != m_dataPoints.end() && startIt->timestamp != startTime) {
+    if (first != 0 && first != count && times[first] != startTime) {
         result.append(dataAtTime(startTime));
     }
     
     // Copy all points in range
-    for (auto it = startIt; it != endIt; ++it) {
-        result.append(*it);
+    for (int i = first; i < last; ++i) {
+        result.append(m_samples.point(i));
     }
     
     // Insert ending point at exact endTime (interpolated if necessary)
-    if (endIt != m_dataPoints.begin() && endIt != m_dataPoints.end() && (endIt - 1)->timestamp != endTime) {
+    if (last != 0 && last != count && times[last - 1] != endTime) {
         result.append(dataAtTime(endTime));
     }
     
-    qDebug() << "DiveData::dataInRange - Returning" << result.size() << "data points";
+    qCDebug(lcTimeline) << "DiveData::dataInRange - Returning" << result.size() << "data points";
     
     // Print some sample data for debugging
     if (!result.isEmpty()) {
-        qDebug() << "DiveData::dataInRange - First point:" 
+        qCDebug(lcTimeline) << "DiveData::dataInRange - First point:" 
                  << "time=" << result.first().timestamp 
                  << "depth=" << result.first().depth;
         
         if (result.size() > 1) {
-            qDebug() << "DiveData::dataInRange - Last point:" 
+            qCDebug(lcTimeline) << "DiveData::dataInRange - Last point:" 
                      << "time=" << result.last().timestamp 
                      << "depth=" << result.last().depth;
         }
     } else {
-        qDebug() << "DiveData::dataInRange - No data points in range";
+        qCDebug(lcTimeline) << "DiveData::dataInRange - No data points in range";
     }
     
     return result;
@@ -444,6 +836,7 @@ void DiveData::addGasSwitch(double timestamp, int cylinderIndex) {
                      [](const GasSwitch &a, const GasSwitch &b) {
                          return a.timestamp < b.timestamp;
                      });
+    invalidateDerivedStats();
 }
 
 int DiveData::activeCylinderAtTime(double timestamp) const {
@@ -474,113 +867,65 @@ bool DiveData::isCylinderActiveAtTime(int cylinderIndex, double timestamp) const
 
 double DiveData::interpolateCylinderPressure(int cylinderIndex, double timestamp) const
 {
-    qDebug() << "INTERPOLATION FUNCTION CALLED for cylinder" << cylinderIndex << "at time" << timestamp;
-
-    // if (cylinderIndex < 0 || cylinderIndex >= m_cylinders.size()) {
-    //     qDebug() << "Invalid cylinder index for interpolation:" << cylinderIndex;
-    //     return 0.0;
-    // }
-    
-    // const CylinderInfo &cylinder = m_cylinders[cylinderIndex];
-    
-    // // For debugging
-    // qDebug() << "Interpolating pressure for" << cylinder.description
-    //          << "with start pressure:" << cylinder.startPressure
-    //          << "end pressure:" << cylinder.endPressure
-    //          << "at time:" << timestamp << "/" << this->durationSeconds()
-    //          << "(" << (timestamp * 100.0 / std::max(1.0, static_cast<double>(this->durationSeconds()))) << "%)";
-    
-    // if (cylinder.startPressure <= 0.0 || cylinder.endPressure <= 0.0) {
-    //     qDebug() << "Cannot interpolate: missing start or end pressure";
-    //     return 0.0;
-    // }
-    
-    // double diveDuration = this->durationSeconds();
-    // if (diveDuration <= 0.0) {
-    //     qDebug() << "Cannot interpolate: dive duration is zero";
-    //     return cylinder.startPressure;
-    // }
-    
-    // // Calculate how far we are through the dive (0.0 to 1.0)
-    // double diveFraction = timestamp / diveDuration;
-    
-    // // Cap to range [0,1]
-    // diveFraction = std::max(0.0, std::min(1.0, diveFraction));
-    
-    // // Linear interpolation between start and end pressures
-    // double interpolatedPressure = cylinder.startPressure - 
-    //                              (diveFraction * (cylinder.startPressure - cylinder.endPressure));
-    
-    // qDebug() << "Interpolated pressure:" << interpolatedPressure
-    //          << "at fraction:" << diveFraction;
-    
-    // return interpolatedPressure;
     if (cylinderIndex < 0 || cylinderIndex >= m_cylinders.size()) {
-        qDebug() << "Invalid cylinder index for interpolation:" << cylinderIndex;
+        qCDebug(lcTimeline) << "Invalid cylinder index for interpolation:" << cylinderIndex;
         return 0.0;
     }
     
     const CylinderInfo &cylinder = m_cylinders[cylinderIndex];
-    
     if (cylinder.startPressure <= 0.0 || cylinder.endPressure <= 0.0) {
-        qDebug() << "Cannot interpolate: missing start or end pressure";
         return 0.0;
     }
-    
-    // Determine the time range when this cylinder was active
-    double startTime = 0.0;
-    double endTime = this->durationSeconds();
-    
-    // For multiple tanks, find when this cylinder became active
-    if (!m_gasSwitches.isEmpty()) {
-        bool foundActiveSwitch = false;
-        
-        // Find when this cylinder started being used
-        for (int i = 0; i < m_gasSwitches.size(); i++) {
-            if (m_gasSwitches[i].cylinderIndex == cylinderIndex) {
-                startTime = m_gasSwitches[i].timestamp;
-                foundActiveSwitch = true;
-                break;
-            }
-        }
-        
-        // Find when this cylinder stopped being used
-        if (foundActiveSwitch) {
-            for (int i = 0; i < m_gasSwitches.size(); i++) {
-                if (m_gasSwitches[i].timestamp > startTime && 
-                    m_gasSwitches[i].cylinderIndex != cylinderIndex) {
-                    endTime = m_gasSwitches[i].timestamp;
-                    break;
-                }
-            }
-        }
+
+    const auto stats = derivedStats();
+    const DerivedStats::CylinderCurve &curve = stats->cylinderCurves[cylinderIndex];
+    return rampPressure(cylinder, curve.rampStart, curve.rampEnd, timestamp);
+}
+
+double DiveData::cylinderPressureAt(int cylinderIndex, double timestamp) const
+{
+    if (cylinderIndex < 0 || cylinderIndex >= m_cylinders.size()) {
+        return 0.0;
     }
-    
-    qDebug() << "Interpolating pressure for" << cylinder.description
-             << "with start pressure:" << cylinder.startPressure
-             << "O2:" << cylinder.o2Percent
-             << "He:" << cylinder.hePercent
-             << "end pressure:" << cylinder.endPressure
-             << "from time" << startTime << "to" << endTime
-             << "at time:" << timestamp;
-    
+
+    const CylinderInfo &cylinder = m_cylinders[cylinderIndex];
+    if (cylinder.startPressure <= 0.0 || cylinder.endPressure <= 0.0) {
+        return 0.0;
+    }
+
+    const auto stats = derivedStats();
+    const DerivedStats::CylinderCurve &curve = stats->cylinderCurves[cylinderIndex];
+
+    // Last stint that started at or before 'timestamp'
+    auto it = std::upper_bound(curve.active.cbegin(), curve.active.cend(), timestamp,
+                               [](double t, const QPair<double, double> &stint) {
+                                   return t < stint.first;
+                               });
+    if (it == curve.active.cbegin()) {
+        // Not breathed yet: still full
+        return cylinder.startPressure;
+    }
+    --it;
+
+    // Inside the stint the ramp applies; after it the cylinder keeps the
+    // pressure it was left at
+    return rampPressure(cylinder, curve.rampStart, curve.rampEnd, qMin(timestamp, it->second));
+}
+
+double DiveData::rampPressure(const CylinderInfo &cylinder, double startTime, double endTime,
+                              double timestamp)
+{
     // If timestamp is outside the active period
     if (timestamp < startTime) {
-        qDebug() << "Timestamp before cylinder active period, returning start pressure:" 
-                 << cylinder.startPressure;
         return cylinder.startPressure;
     }
-    
     if (timestamp > endTime) {
-        qDebug() << "Timestamp after cylinder active period, returning end pressure:" 
-                 << cylinder.endPressure;
         return cylinder.endPressure;
     }
     
     // Calculate fraction within the active period (0.0 to 1.0)
     double usageRange = endTime - startTime;
     if (usageRange <= 0.0) {
-        qDebug() << "Zero usage range, returning start pressure:" << cylinder.startPressure;
         return cylinder.startPressure;
     }
     
@@ -590,19 +935,58 @@ double DiveData::interpolateCylinderPressure(int cylinderIndex, double timestamp
     usageFraction = std::max(0.0, std::min(1.0, usageFraction));
     
     // Linear interpolation between start and end pressures
-    double interpolatedPressure = cylinder.startPressure - 
-                                (usageFraction * (cylinder.startPressure - cylinder.endPressure));
-    
-    qDebug() << "Interpolated pressure:" << interpolatedPressure
-             << "at usage fraction:" << usageFraction;
-    
-    // Store the result for future reference
-    m_lastInterpolatedPressures[cylinderIndex] = interpolatedPressure;
-
-    return interpolatedPressure;
+    return cylinder.startPressure - 
+           (usageFraction * (cylinder.startPressure - cylinder.endPressure));
 }
 
-double DiveData::getLastInterpolatedPressure(int cylinderIndex) const
+QVector<DiveData::DerivedStats::CylinderCurve> DiveData::buildCylinderCurves() const
 {
-    return m_lastInterpolatedPressures.value(cylinderIndex, 0.0);
-}
\ No newline at end of file
+    QVector<DerivedStats::CylinderCurve> curves(m_cylinders.size());
+    const double duration = this->durationSeconds();
+
+    for (int c = 0; c < curves.size(); ++c) {
+        DerivedStats::CylinderCurve &curve = curves[c];
+
+        // Ramp window: from the first switch onto this cylinder to the next
+        // switch away from it, or the whole dive without switches
+        curve.rampStart = 0.0;
+        curve.rampEnd = duration;
+        bool foundActiveSwitch = false;
+        for (const GasSwitch &gasSwitch : m_gasSwitches) {
+            if (gasSwitch.cylinderIndex == c) {
+                curve.rampStart = gasSwitch.timestamp;
+                foundActiveSwitch = true;
+                break;
+            }
+        }
+        if (foundActiveSwitch) {
+            for (const GasSwitch &gasSwitch : m_gasSwitches) {
+                if (gasSwitch.timestamp > curve.rampStart && gasSwitch.cylinderIndex != c) {
+                    curve.rampEnd = gasSwitch.timestamp;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Stints, with the same resolution as activeCylinderAtTime(): the first
+    // cylinder from the start, each switch taking effect at its timestamp,
+    // the last of several simultaneous switches winning
+    int active = 0;
+    double since = -std::numeric_limits<double>::infinity();
+    for (const GasSwitch &gasSwitch : m_gasSwitches) {
+        if (gasSwitch.cylinderIndex == active) {
+            continue;
+        }
+        if (since < gasSwitch.timestamp && active < curves.size()) {
+            curves[active].active.append(qMakePair(since, gasSwitch.timestamp));
+        }
+        active = gasSwitch.cylinderIndex;
+        since = gasSwitch.timestamp;
+    }
+    if (active < curves.size()) {
+        curves[active].active.append(qMakePair(since, std::numeric_limits<double>::infinity()));
+    }
+
+    return curves;
+}
@@ -0,0 +1,348 @@
+#include "include/core/format_parsers/decompressing_device.h"
+#include "include/core/logging.h"
+
+#include <QFileDevice>
+
+#include <cstring>
+
+#ifdef UNABARA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef UNABARA_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+// Compressed bytes read from the source per refill
+constexpr qint64 kChunkSize = 64 * 1024;
+
+const uchar kGzipMagic[2] = {0x1F, 0x8B};
+const uchar kZstdMagic[4] = {0x28, 0xB5, 0x2F, 0xFD};
+
+} // namespace
+
+// Codec state behind a common step interface, so neither zlib.h nor zstd.h
+// leaks out of this file
+class DecompressingDevice::Stream
+{
+public:
+    explicit Stream(Codec codec)
+        : m_codec(codec)
+    {
+    }
+
+    ~Stream()
+    {
+#ifdef UNABARA_HAVE_ZLIB
+        if (m_zlibReady) {
+            inflateEnd(&m_zlib);
+        }
+#endif
+#ifdef UNABARA_HAVE_ZSTD
+        ZSTD_freeDStream(m_zstd);
+#endif
+    }
+
+    // Back to the start of a stream
+    bool reset()
+    {
+        switch (m_codec) {
+#ifdef UNABARA_HAVE_ZLIB
+            case Gzip:
+                if (m_zlibReady) {
+                    return inflateReset(&m_zlib) == Z_OK;
+                }
+                std::memset(&m_zlib, 0, sizeof(m_zlib));
+                // 16 + window bits: expect a gzip wrapper, not raw zlib
+                m_zlibReady = inflateInit2(&m_zlib, 16 + MAX_WBITS) == Z_OK;
+                return m_zlibReady;
+#endif
+#ifdef UNABARA_HAVE_ZSTD
+            case Zstd:
+                if (!m_zstd) {
+                    m_zstd = ZSTD_createDStream();
+                }
+                return m_zstd && !ZSTD_isError(ZSTD_initDStream(m_zstd));
+#endif
+            default:
+                return false;
+        }
+    }
+
+    // Decompresses from [in, inEnd) into [out, outEnd), advancing both.
+    // Returns false on corrupt data; 'frameEnd' is set when a gzip member
+    // or zstd frame has been decoded completely.
+    bool step(const uchar *&in, const uchar *inEnd, char *&out, char *outEnd, bool &frameEnd)
+    {
+        frameEnd = false;
+        switch (m_codec) {
+#ifdef UNABARA_HAVE_ZLIB
+            case Gzip: {
+                m_zlib.next_in = const_cast<Bytef *>(in);
+                m_zlib.avail_in = static_cast<uInt>(inEnd - in);
+                m_zlib.next_out = reinterpret_cast<Bytef *>(out);
+                m_zlib.avail_out = static_cast<uInt>(outEnd - out);
+                const int rc = ::inflate(&m_zlib, Z_NO_FLUSH);
+                in = m_zlib.next_in;
+                out = reinterpret_cast<char *>(m_zlib.next_out);
+                if (rc == Z_STREAM_END) {
+                    // Concatenated members decode as one stream
+                    frameEnd = true;
+                    return inflateReset(&m_zlib) == Z_OK;
+                }
+                return rc == Z_OK || rc == Z_BUF_ERROR;
+            }
+#endif
+#ifdef UNABARA_HAVE_ZSTD
+            case Zstd: {
+                ZSTD_inBuffer input = {in, static_cast<size_t>(inEnd - in), 0};
+                ZSTD_outBuffer output = {out, static_cast<size_t>(outEnd - out), 0};
+                const size_t rc = ZSTD_decompressStream(m_zstd, &output, &input);
+                if (ZSTD_isError(rc)) {
+                    return false;
+                }
+                in += input.pos;
+                out += output.pos;
+                frameEnd = (rc == 0);
+                return true;
+            }
+#endif
+            default:
+                Q_UNUSED(in);
+                Q_UNUSED(inEnd);
+                Q_UNUSED(out);
+                Q_UNUSED(outEnd);
+                return false;
+        }
+    }
+
+private:
+    Codec m_codec;
+#ifdef UNABARA_HAVE_ZLIB
+    z_stream m_zlib;
+    bool m_zlibReady = false;
+#endif
+#ifdef UNABARA_HAVE_ZSTD
+    ZSTD_DStream *m_zstd = nullptr;
+#endif
+};
+
+DecompressingDevice::Codec DecompressingDevice::detect(QIODevice *device)
+{
+    const qint64 originalPos = device->pos();
+    device->seek(0);
+
+    uchar magic[4];
+    const qint64 read = device->read(reinterpret_cast<char *>(magic), sizeof(magic));
+    device->seek(originalPos);
+
+    if (read >= 2 && std::memcmp(magic, kGzipMagic, sizeof(kGzipMagic)) == 0) {
+        return Gzip;
+    }
+    if (read == 4 && std::memcmp(magic, kZstdMagic, sizeof(kZstdMagic)) == 0) {
+        return Zstd;
+    }
+    return None;
+}
+
+bool DecompressingDevice::isSupported(Codec codec)
+{
+    switch (codec) {
+#ifdef UNABARA_HAVE_ZLIB
+        case Gzip:
+            return true;
+#endif
+#ifdef UNABARA_HAVE_ZSTD
+        case Zstd:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+QString DecompressingDevice::codecName(Codec codec)
+{
+    switch (codec) {
+        case Gzip:
+            return QStringLiteral("gzip");
+        case Zstd:
+            return QStringLiteral("zstd");
+        default:
+            return QString();
+    }
+}
+
+QString DecompressingDevice::fileName(const QIODevice &device)
+{
+    if (const auto *decompressing = qobject_cast<const DecompressingDevice *>(&device)) {
+        return fileName(*decompressing->source());
+    }
+    if (const auto *file = qobject_cast<const QFileDevice *>(&device)) {
+        return file->fileName();
+    }
+    return QString();
+}
+
+DecompressingDevice::DecompressingDevice(QIODevice *source, Codec codec, QObject *parent)
+    : QIODevice(parent)
+    , m_source(source)
+    , m_codec(codec)
+{
+    if (isSupported(codec)) {
+        m_stream = std::make_unique<Stream>(codec);
+    }
+}
+
+DecompressingDevice::~DecompressingDevice() = default;
+
+bool DecompressingDevice::open(OpenMode mode)
+{
+    if ((mode & WriteOnly) || !(mode & ReadOnly)) {
+        setErrorString(QStringLiteral("Compressed files can only be read"));
+        return false;
+    }
+    if (!m_stream) {
+        setErrorString(QStringLiteral("This build cannot read %1 compressed files")
+                           .arg(codecName(m_codec)));
+        return false;
+    }
+    if (!restart()) {
+        return false;
+    }
+    // Unbuffered: pos() must always be the decompressed offset seek() and
+    // readData() work from
+    return QIODevice::open(ReadOnly | Unbuffered);
+}
+
+void DecompressingDevice::close()
+{
+    QIODevice::close();
+    m_input.clear();
+}
+
+bool DecompressingDevice::restart()
+{
+    if (!m_source->seek(0) || !m_stream->reset()) {
+        setErrorString(QStringLiteral("Could not rewind the %1 stream").arg(codecName(m_codec)));
+        return false;
+    }
+    m_input.clear();
+    m_inputPos = 0;
+    m_decoded = 0;
+    m_betweenFrames = false;
+    m_finished = false;
+    m_failed = false;
+    return true;
+}
+
+bool DecompressingDevice::seek(qint64 pos)
+{
+    if (pos < 0 || !isOpen()) {
+        return false;
+    }
+    if (!decodeTo(pos)) {
+        // Past the end, or a broken stream: stay where we were
+        decodeTo(QIODevice::pos());
+        return false;
+    }
+    return QIODevice::seek(pos);
+}
+
+bool DecompressingDevice::decodeTo(qint64 pos)
+{
+    if (pos < m_decoded && !restart()) {
+        return false;
+    }
+
+    // Decode and discard up to the target
+    QByteArray skipped(qMin(pos - m_decoded, kChunkSize), Qt::Uninitialized);
+    while (m_decoded < pos) {
+        if (decompress(skipped.data(), qMin<qint64>(pos - m_decoded, skipped.size())) <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DecompressingDevice::atEnd() const
+{
+    return m_finished && pos() == m_size;
+}
+
+qint64 DecompressingDevice::size() const
+{
+    return m_size >= 0 ? m_size : 0;
+}
+
+qint64 DecompressingDevice::readData(char *data, qint64 maxSize)
+{
+    return decompress(data, maxSize);
+}
+
+qint64 DecompressingDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+qint64 DecompressingDevice::decompress(char *data, qint64 maxSize)
+{
+    if (m_failed) {
+        return -1;
+    }
+
+    char *out = data;
+    char *const outEnd = data + maxSize;
+    while (out < outEnd && !m_finished) {
+        if (m_inputPos == m_input.size()) {
+            m_input.resize(kChunkSize);
+            const qint64 read = m_source->read(m_input.data(), kChunkSize);
+            m_input.resize(qMax<qint64>(read, 0));
+            m_inputPos = 0;
+            if (read < 0) {
+                // Includes a cancelled import: the source refuses further reads
+                setErrorString(m_source->errorString());
+                m_failed = true;
+                break;
+            }
+            if (read == 0) {
+                if (m_betweenFrames) {
+                    m_finished = true;
+                    m_size = m_decoded + (out - data);
+                } else {
+                    setErrorString(QStringLiteral("Truncated %1 stream").arg(codecName(m_codec)));
+                    m_failed = true;
+                }
+                break;
+            }
+        }
+
+        const uchar *base = reinterpret_cast<const uchar *>(m_input.constData());
+        const uchar *in = base + m_inputPos;
+        const uchar *const inBefore = in;
+        char *const outBefore = out;
+        bool frameEnd = false;
+        if (!m_stream->step(in, base + m_input.size(), out, outEnd, frameEnd)
+            || (!frameEnd && in == inBefore && out == outBefore)) {
+            setErrorString(QStringLiteral("Corrupt %1 stream").arg(codecName(m_codec)));
+            m_failed = true;
+            break;
+        }
+        m_inputPos = in - base;
+        if (frameEnd) {
+            m_betweenFrames = true;
+        } else if (in != inBefore || out != outBefore) {
+            m_betweenFrames = false;
+        }
+    }
+
+    const qint64 produced = out - data;
+    m_decoded += produced;
+    if (m_failed) {
+        qCDebug(lcParse) << "Decompression failed:" << errorString();
+    }
+    return produced > 0 || !m_failed ? produced : -1;
+}
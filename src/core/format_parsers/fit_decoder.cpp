@@ -1,9 +1,11 @@
 #include "include/core/format_parsers/fit_decoder.h"
+#include "include/core/logging.h"
 
-#include <QDebug>
+#include <QFileDevice>
 #include <QIODevice>
 
 #include <cstring>
+#include <limits>
 
 namespace {
 
@@ -144,14 +146,13 @@ bool decodeElement(const uchar *p, quint8 baseNum, bool bigEndian, double &out)
 
 } // namespace
 
-quint16 FitDecoder::crc16(const uchar *data, qint64 length)
+quint16 FitDecoder::crc16(const uchar *data, qint64 length, quint16 crc)
 {
     static const quint16 table[16] = {
         0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
         0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400,
     };
 
-    quint16 crc = 0;
     for (qint64 i = 0; i < length; ++i) {
         quint16 tmp = table[crc & 0xF];
         crc = (crc >> 4) & 0x0FFF;
@@ -164,6 +165,57 @@ quint16 FitDecoder::crc16(const uchar *data, qint64 length)
     return crc;
 }
 
+// The bytes being decoded: a whole mapped file, or a window over a device
+// that is refilled as records are consumed, so memory stays bounded by the
+// largest possible record instead of growing with the file. Pointers into
+// the window are invalidated by require().
+class FitDecoder::Input
+{
+public:
+    Input(const uchar *data, qint64 size) : m_data(data), m_size(size) {}
+    explicit Input(QIODevice *device) : m_device(device) {}
+
+    const uchar *data() const { return m_data + m_pos; }
+    qint64 available() const { return m_size - m_pos; }
+    qint64 offset() const { return m_base + m_pos; } // from the start of the file
+    void advance(qint64 bytes) { m_pos += bytes; }
+
+    // Makes at least 'bytes' available, unless the input ends first
+    void require(qint64 bytes)
+    {
+        if (!m_device || available() >= bytes) {
+            return;
+        }
+        m_buffer.remove(0, m_pos);
+        m_base += m_pos;
+        m_pos = 0;
+
+        qint64 filled = m_buffer.size();
+        m_buffer.resize(qMax(bytes, kChunkSize));
+        while (filled < m_buffer.size()) {
+            const qint64 read = m_device->read(m_buffer.data() + filled, m_buffer.size() - filled);
+            if (read <= 0) {
+                m_device = nullptr; // end of input
+                break;
+            }
+            filled += read;
+        }
+        m_buffer.resize(filled);
+        m_data = reinterpret_cast<const uchar *>(m_buffer.constData());
+        m_size = filled;
+    }
+
+private:
+    static constexpr qint64 kChunkSize = 256 * 1024;
+
+    QIODevice *m_device = nullptr; // null once exhausted, or when mapped
+    QByteArray m_buffer;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0; // valid bytes at m_data
+    qint64 m_pos = 0;  // read position within m_data
+    qint64 m_base = 0; // file offset of m_data[0]
+};
+
 bool FitDecoder::sniff(QIODevice *device)
 {
     const qint64 originalPos = device->pos();
@@ -177,100 +229,160 @@ bool FitDecoder::sniff(QIODevice *device)
     return ok;
 }
 
+bool FitDecoder::decode(QIODevice *device, const FitMessageVisitor &visitor, QString &errorOut)
+{
+    m_visitor = &visitor;
+    const bool ok = decodeDevice(device, errorOut);
+    m_visitor = nullptr;
+    m_fields.clear();
+    m_values.clear();
+    return ok;
+}
+
 bool FitDecoder::decode(QIODevice *device, QString &errorOut)
+{
+    m_visitor = nullptr;
+    // A dive record is ~10 fields; reserve for the usual sample-dominated file
+    m_messages.reserve(static_cast<int>(qMax<qint64>(device->size(), 0) / 32));
+    return decodeDevice(device, errorOut);
+}
+
+bool FitDecoder::decodeDevice(QIODevice *device, QString &errorOut)
 {
     m_messages.clear();
+    m_fields.clear();
+    m_values.clear();
     for (LocalDef &local : m_locals) {
         local = LocalDef();
     }
     m_lastTimestamp = 0;
 
+    // Files are decoded straight from a mapping; anything else (or a file
+    // that can't be mapped) is read through a bounded window
+    QFileDevice *file = qobject_cast<QFileDevice *>(device);
+    const qint64 size = file ? file->size() : 0;
+    if (uchar *mapped = size > 0 ? file->map(0, size) : nullptr) {
+        Input input(mapped, size);
+        const bool ok = decodeInput(input, errorOut);
+        file->unmap(mapped);
+        return ok;
+    }
+
     device->seek(0);
-    const QByteArray content = device->readAll();
-    const uchar *base = reinterpret_cast<const uchar *>(content.constData());
-    const qint64 fileLen = content.size();
+    Input input(device);
+    return decodeInput(input, errorOut);
+}
 
-    if (fileLen < 14) {
-        errorOut = QStringLiteral("File too small to be a FIT file (%1 bytes)").arg(fileLen);
+bool FitDecoder::decodeInput(Input &input, QString &errorOut)
+{
+    // Largest possible record: header byte, 255 fields of up to 255 bytes,
+    // and as much developer data. Definitions are far smaller.
+    constexpr qint64 kMaxRecordBytes = 1 + 2 * 255 * 255;
+
+    input.require(kMaxRecordBytes);
+    if (input.available() < 14) {
+        errorOut = QStringLiteral("File too small to be a FIT file (%1 bytes)")
+                       .arg(input.available());
         return false;
     }
 
-    const quint8 headerSize = base[0];
-    quint32 dataSize = static_cast<quint32>(readUInt(base + 4, 4, false));
-    if (headerSize < 12 || headerSize > fileLen || std::memcmp(base + 8, ".FIT", 4) != 0) {
+    const uchar *header = input.data();
+    const quint8 headerSize = header[0];
+    const quint32 dataSize = static_cast<quint32>(readUInt(header + 4, 4, false));
+    if (headerSize < 12 || headerSize > input.available()
+        || std::memcmp(header + 8, ".FIT", 4) != 0) {
         errorOut = QStringLiteral("Invalid FIT file header");
         return false;
     }
+
+    qint64 dataEnd = static_cast<qint64>(headerSize) + dataSize;
     if (dataSize == 0) {
         // Crash-recovered files: the header is written before the data and
         // dataSize is only backfilled when the file is finalized. Decode to
         // the end of the file instead (the trailing CRC bytes, if any, will
         // fail as a record and be salvaged around).
-        qWarning() << "FIT header declares zero data size, decoding to end of file";
-        dataSize = static_cast<quint32>(fileLen - headerSize);
-    } else if (static_cast<qint64>(headerSize) + dataSize + 2 > fileLen) {
-        // Truncated file: decode what is there, the record loop will stop at
-        // the actual end of data. Warn but keep going (salvage).
-        qWarning() << "FIT file shorter than header declares:" << fileLen << "bytes,"
-                   << "expected" << (headerSize + dataSize + 2);
-    } else {
-        const quint16 expected =
-            static_cast<quint16>(readUInt(base + headerSize + dataSize, 2, false));
-        if (crc16(base, headerSize + dataSize) != expected) {
-            qWarning() << "FIT file CRC mismatch, importing anyway";
-        }
+        qCWarning(lcParse) << "FIT header declares zero data size, decoding to end of file";
+        dataEnd = std::numeric_limits<qint64>::max();
     }
 
-    const uchar *p = base + headerSize;
-    const uchar *end = base + qMin<qint64>(fileLen, static_cast<qint64>(headerSize) + dataSize);
+    // The CRC is accumulated record by record, since a streamed file is
+    // never in memory as a whole
+    quint16 crc = crc16(header, headerSize);
+    input.advance(headerSize);
 
-    while (p < end) {
-        const quint8 recordHeader = *p++;
+    while (input.offset() < dataEnd) {
+        input.require(kMaxRecordBytes);
+        if (input.available() == 0) {
+            break; // truncated on a record boundary
+        }
+        const qint64 offset = input.offset();
+        const uchar *start = input.data();
+        const uchar *p = start;
+        const uchar *end = start + qMin(input.available(), dataEnd - offset);
+        if (!decodeRecord(p, end, offset, errorOut)) {
+            return false;
+        }
+        crc = crc16(start, p - start, crc);
+        input.advance(p - start);
+    }
 
-        if (recordHeader & 0x80) {
-            // Compressed timestamp header: 2-bit local type, 5-bit time offset
-            // relative to the last full timestamp.
-            const quint8 localType = (recordHeader >> 5) & 0x3;
-            const quint8 offset = recordHeader & 0x1F;
-            quint32 timestamp = (m_lastTimestamp & ~0x1Fu) | offset;
-            if (timestamp < m_lastTimestamp) {
-                timestamp += 0x20;
-            }
-            m_lastTimestamp = timestamp;
-
-            const LocalDef &def = m_locals[localType];
-            if (!def.valid) {
-                errorOut = QStringLiteral("FIT data record for undefined local type %1 at byte %2")
-                               .arg(localType)
-                               .arg(p - 1 - base);
-                return false;
-            }
-            if (!decodeData(p, end, def, errorOut)) {
-                return false;
-            }
-            m_messages.last().fields[253] = {static_cast<double>(timestamp)};
-        } else if (recordHeader & 0x40) {
-            if (!decodeDefinition(p, end, recordHeader, errorOut)) {
-                return false;
-            }
-        } else {
-            const quint8 localType = recordHeader & 0xF;
-            const LocalDef &def = m_locals[localType];
-            if (!def.valid) {
-                errorOut = QStringLiteral("FIT data record for undefined local type %1 at byte %2")
-                               .arg(localType)
-                               .arg(p - 1 - base);
-                return false;
-            }
-            if (!decodeData(p, end, def, errorOut)) {
-                return false;
-            }
+    if (dataSize != 0) {
+        input.require(2);
+        if (input.offset() < dataEnd || input.available() < 2) {
+            // Truncated file: everything that was there has been decoded.
+            // Warn but keep going (salvage).
+            qCWarning(lcParse) << "FIT file shorter than header declares:"
+                       << input.offset() + input.available() << "bytes,"
+                       << "expected" << (dataEnd + 2);
+        } else if (crc != static_cast<quint16>(readUInt(input.data(), 2, false))) {
+            qCWarning(lcParse) << "FIT file CRC mismatch, importing anyway";
         }
     }
 
     return true;
 }
 
+bool FitDecoder::decodeRecord(const uchar *&p, const uchar *end, qint64 offset,
+                              QString &errorOut)
+{
+    const quint8 recordHeader = *p++;
+
+    if (recordHeader & 0x80) {
+        // Compressed timestamp header: 2-bit local type, 5-bit time offset
+        // relative to the last full timestamp.
+        const quint8 localType = (recordHeader >> 5) & 0x3;
+        const quint8 timeOffset = recordHeader & 0x1F;
+        quint32 timestamp = (m_lastTimestamp & ~0x1Fu) | timeOffset;
+        if (timestamp < m_lastTimestamp) {
+            timestamp += 0x20;
+        }
+        m_lastTimestamp = timestamp;
+
+        const LocalDef &def = m_locals[localType];
+        if (!def.valid) {
+            errorOut = QStringLiteral("FIT data record for undefined local type %1 at byte %2")
+                           .arg(localType)
+                           .arg(offset);
+            return false;
+        }
+        return decodeData(p, end, def, timestamp, errorOut);
+    }
+
+    if (recordHeader & 0x40) {
+        return decodeDefinition(p, end, recordHeader, errorOut);
+    }
+
+    const quint8 localType = recordHeader & 0xF;
+    const LocalDef &def = m_locals[localType];
+    if (!def.valid) {
+        errorOut = QStringLiteral("FIT data record for undefined local type %1 at byte %2")
+                       .arg(localType)
+                       .arg(offset);
+        return false;
+    }
+    return decodeData(p, end, def, -1, errorOut);
+}
+
 bool FitDecoder::decodeDefinition(const uchar *&p, const uchar *end, quint8 recordHeader,
                                   QString &errorOut)
 {
@@ -287,6 +399,11 @@ bool FitDecoder::decodeDefinition(const uchar *&p, const uchar *end, quint8 reco
     const quint8 fieldCount = p[4];
     p += 5;
 
+    // Resolve the filter once per definition, not once per record
+    const auto wanted = m_filter.constFind(def.globalId);
+    def.wanted = m_filter.isEmpty() || wanted != m_filter.constEnd();
+    const bool allFields = m_filter.isEmpty() || (def.wanted && wanted->isEmpty());
+
     if (end - p < fieldCount * 3) {
         errorOut = QStringLiteral("Truncated FIT field definitions");
         return false;
@@ -297,6 +414,7 @@ bool FitDecoder::decodeDefinition(const uchar *&p, const uchar *end, quint8 reco
         field.fieldNum = p[0];
         field.size = p[1];
         field.baseType = p[2];
+        field.keep = allFields || (def.wanted && wanted->contains(field.fieldNum));
         def.fields.append(field);
         p += 3;
     }
@@ -324,26 +442,36 @@ bool FitDecoder::decodeDefinition(const uchar *&p, const uchar *end, quint8 reco
 }
 
 bool FitDecoder::decodeData(const uchar *&p, const uchar *end, const LocalDef &def,
-                            QString &errorOut)
+                            qint64 timestampOverride, QString &errorOut)
 {
-    FitMessage message;
+    MessageEntry message;
     message.globalId = def.globalId;
+    message.firstField = static_cast<quint32>(m_fields.size());
+    const int valuesBefore = m_values.size();
 
     for (const FieldDef &field : def.fields) {
         if (end - p < field.size) {
             errorOut = QStringLiteral("Truncated FIT data record (message %1)").arg(def.globalId);
+            // Drop the half-decoded record so salvaged messages stay whole
+            m_fields.resize(message.firstField);
+            m_values.resize(valuesBefore);
             return false;
         }
 
         const quint8 baseNum = field.baseType & 0x1F;
         const int elementSize = baseTypeSize(baseNum);
-
-        // Strings and malformed/unknown field encodings are skipped whole;
-        // the definition's declared size keeps the stream in sync regardless.
-        if (baseNum != BaseString && elementSize > 0 && field.size % elementSize == 0) {
-            QVector<double> elements;
-            bool anyValid = false;
+        const bool isTimestamp = field.fieldNum == 253;
+
+        // Strings, unwanted fields and malformed/unknown field encodings are
+        // skipped whole; the definition's declared size keeps the stream in
+        // sync regardless. The timestamp is always read: compressed-timestamp
+        // records of any message depend on it.
+        const bool decodeIt = (def.wanted && field.keep) || isTimestamp;
+        if (decodeIt && baseNum != BaseString && elementSize > 0 && field.size % elementSize == 0
+            && !(isTimestamp && timestampOverride >= 0)) {
             const int count = field.size / elementSize;
+            const int first = m_values.size();
+            bool anyValid = false;
             for (int i = 0; i < count; ++i) {
                 double value = qQNaN();
                 if (decodeElement(p + i * elementSize, baseNum, def.bigEndian, value)) {
@@ -351,13 +479,16 @@ bool FitDecoder::decodeData(const uchar *&p, const uchar *end, const LocalDef &d
                 } else {
                     value = qQNaN();
                 }
-                elements.append(value);
+                m_values.append(value);
             }
-            if (anyValid) {
-                message.fields.insert(field.fieldNum, elements);
-                if (field.fieldNum == 253 && !qIsNaN(elements.first())) {
-                    m_lastTimestamp = static_cast<quint32>(elements.first());
-                }
+            if (anyValid && isTimestamp && !qIsNaN(m_values.at(first))) {
+                m_lastTimestamp = static_cast<quint32>(m_values.at(first));
+            }
+            if (anyValid && def.wanted && field.keep) {
+                m_fields.append(FitField{field.fieldNum, static_cast<quint8>(count),
+                                         static_cast<quint32>(first)});
+            } else {
+                m_values.resize(first);
             }
         }
 
@@ -366,10 +497,30 @@ bool FitDecoder::decodeData(const uchar *&p, const uchar *end, const LocalDef &d
 
     if (end - p < def.devDataBytes) {
         errorOut = QStringLiteral("Truncated FIT developer data (message %1)").arg(def.globalId);
+        m_fields.resize(message.firstField);
+        m_values.resize(valuesBefore);
         return false;
     }
     p += def.devDataBytes;
 
-    m_messages.append(message);
+    if (!def.wanted) {
+        return true;
+    }
+
+    if (timestampOverride >= 0) {
+        m_fields.append(FitField{253, 1, static_cast<quint32>(m_values.size())});
+        m_values.append(static_cast<double>(timestampOverride));
+    }
+
+    message.fieldCount = m_fields.size() - static_cast<int>(message.firstField);
+    if (m_visitor) {
+        // Streaming: the arenas only ever hold the message being visited
+        (*m_visitor)(FitMessage{message.globalId, m_fields.constData() + message.firstField,
+                                message.fieldCount, m_values.constData()});
+        m_fields.clear();
+        m_values.clear();
+    } else {
+        m_messages.append(message);
+    }
     return true;
 }
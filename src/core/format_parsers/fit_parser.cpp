@@ -1,11 +1,11 @@
 #include "include/core/format_parsers/fit_parser.h"
 
 #include <QDateTime>
-#include <QDebug>
 #include <QTimeZone>
 
 #include <algorithm>
 
+#include "include/core/logging.h"
 #include "include/core/units.h"
 
 namespace {
@@ -45,6 +45,27 @@ double semicirclesToDegrees(double semicircles)
     return semicircles * (180.0 / 2147483648.0);
 }
 
+// Everything visitMessage() reads; the decoder skips the rest of the file
+// (laps, HRV, device info, ...) without converting it
+const FitFieldFilter &wantedFields()
+{
+    static const FitFieldFilter filter = {
+        {MsgSport, {1}},
+        {MsgSession, {2, 3, 4, 6}},
+        {MsgRecord, {FieldTimestamp, 13, 92, 93, 94, 95, 96, 97}},
+        {MsgEvent, {FieldTimestamp, 0, 3}},
+        {MsgActivity, {FieldTimestamp, 5}},
+        {MsgSensorProfile, {0, 52, 74, 77}},
+        {MsgTimestampCorrelation, {FieldTimestamp, 3}},
+        {MsgDiveSettings, {23, 26}},
+        {MsgDiveGas, {FieldMessageIndex, 0, 1, 2, 3}},
+        {MsgDiveSummary, {2, 10}},
+        {MsgTankUpdate, {0, 1}},
+        {MsgTankSummary, {0, 1, 2}},
+    };
+    return filter;
+}
+
 } // namespace
 
 FitParser::FitParser() = default;
@@ -72,192 +93,232 @@ QString FitParser::formatPosition(const Metadata &meta)
                                         QString::number(meta.longitude, 'f', 6));
 }
 
-bool FitParser::canParse(QFile &file) const
+bool FitParser::canParse(QIODevice &file) const
 {
     return FitDecoder::sniff(&file);
 }
 
-bool FitParser::decodeFile(QFile &file, FitDecoder &decoder, QString &errorOut) const
+bool FitParser::scanFile(QIODevice &file, Scan &scan, QString &errorOut) const
 {
-    if (!decoder.decode(&file, errorOut)) {
+    FitDecoder decoder;
+    decoder.setFilter(wantedFields());
+    const bool ok = decoder.decode(
+        &file, [&scan](const FitMessage &message) { visitMessage(message, scan); }, errorOut);
+    if (!ok) {
         // Salvage: a truncated file (e.g. a crashed watch) is still worth
         // importing if a usable number of dive samples were decoded.
-        int depthSamples = 0;
-        for (const FitMessage &message : decoder.messages()) {
-            if (message.globalId == MsgRecord && message.has(92)) {
-                depthSamples++;
-            }
-        }
-        if (depthSamples < 2) {
+        if (scan.depthSamples < 2) {
             return false;
         }
-        qWarning() << "FIT decode error, importing" << depthSamples
+        qCWarning(lcParse) << "FIT decode error, importing" << scan.depthSamples
                    << "salvaged samples anyway:" << errorOut;
         errorOut.clear();
     }
+    finishMetadata(scan);
     return true;
 }
 
-FitParser::Metadata FitParser::collectMetadata(const QList<FitMessage> &messages) const
+void FitParser::visitMessage(const FitMessage &message, Scan &scan)
 {
-    Metadata meta;
-
-    QMap<int, CylinderInfo> gasesByIndex;
-    QMap<int, bool> gasIsDiluent;
-    QMap<quint32, QPair<double, double>> tankPressures; // sensor -> start/end bar
-    QVector<double> tankVolumes;                        // liters, parallel to tankSensors
-    QVector<quint32> updateSensors;                     // pods seen in tank_update messages
-    bool sawFirstRecord = false;
-    quint32 firstRecordTime = 0;
-
-    for (const FitMessage &message : messages) {
-        switch (message.globalId) {
-            case MsgSport:
-                if (message.has(1)) {
-                    meta.subSport = static_cast<int>(message.value(1));
-                }
-                break;
+    Metadata &meta = scan.meta;
 
-            case MsgSession:
-                if (message.has(2)) {
-                    meta.hasStart = true;
-                    meta.startFit = static_cast<quint32>(message.value(2));
-                }
-                if (message.has(3) && message.has(4)) {
-                    meta.hasPosition = true;
-                    meta.latitude = semicirclesToDegrees(message.value(3));
-                    meta.longitude = semicirclesToDegrees(message.value(4));
-                }
-                if (meta.subSport < 0 && message.has(6)) {
-                    meta.subSport = static_cast<int>(message.value(6));
-                }
-                break;
+    switch (message.globalId) {
+        case MsgSport:
+            if (message.has(1)) {
+                meta.subSport = static_cast<int>(message.value(1));
+            }
+            break;
 
-            case MsgActivity:
-            case MsgTimestampCorrelation:
-                // Field 5 (activity) / field 3 (timestamp correlation) hold the
-                // device's local wall-clock time for the message's timestamp.
-                {
-                    const quint8 localField = (message.globalId == MsgActivity) ? 5 : 3;
-                    if (message.has(localField) && message.has(FieldTimestamp)) {
-                        meta.timeOffset = static_cast<qint64>(message.value(localField))
-                                          - static_cast<qint64>(message.value(FieldTimestamp));
-                    }
+        case MsgSession:
+            if (message.has(2)) {
+                meta.hasStart = true;
+                meta.startFit = static_cast<quint32>(message.value(2));
+            }
+            if (message.has(3) && message.has(4)) {
+                meta.hasPosition = true;
+                meta.latitude = semicirclesToDegrees(message.value(3));
+                meta.longitude = semicirclesToDegrees(message.value(4));
+            }
+            if (meta.subSport < 0 && message.has(6)) {
+                meta.subSport = static_cast<int>(message.value(6));
+            }
+            break;
+
+        case MsgActivity:
+        case MsgTimestampCorrelation:
+            // Field 5 (activity) / field 3 (timestamp correlation) hold the
+            // device's local wall-clock time for the message's timestamp.
+            {
+                const quint8 localField = (message.globalId == MsgActivity) ? 5 : 3;
+                if (message.has(localField) && message.has(FieldTimestamp)) {
+                    meta.timeOffset = static_cast<qint64>(message.value(localField))
+                                      - static_cast<qint64>(message.value(FieldTimestamp));
                 }
-                break;
+            }
+            break;
 
-            case MsgDiveSettings:
-                meta.sawDiveData = true;
-                if (message.has(23)) {
-                    meta.setpointLowBar = message.value(23) / 100.0; // centibar
-                }
-                if (message.has(26)) {
-                    meta.setpointHighBar = message.value(26) / 100.0;
-                }
+        case MsgDiveSettings:
+            meta.sawDiveData = true;
+            if (message.has(23)) {
+                meta.setpointLowBar = message.value(23) / 100.0; // centibar
+            }
+            if (message.has(26)) {
+                meta.setpointHighBar = message.value(26) / 100.0;
+            }
+            break;
+
+        case MsgDiveGas: {
+            meta.sawDiveData = true;
+            // Fall back to sequential slots when the writer omits the
+            // message index — defaulting all to 0 would collapse the gases
+            const int gasIndex = message.has(FieldMessageIndex)
+                                     ? static_cast<int>(message.value(FieldMessageIndex))
+                                     : scan.gasesByIndex.size();
+            const int status = static_cast<int>(message.value(2, 1)); // 0 disabled, 1 enabled, 2 backup
+            if (status == 0) {
                 break;
+            }
+            CylinderInfo cylinder;
+            cylinder.o2Percent = message.value(1, 21.0);
+            cylinder.hePercent = message.value(0, 0.0);
+            cylinder.description = Units::formatGasMix(cylinder.o2Percent, cylinder.hePercent);
+            scan.gasesByIndex.insert(gasIndex, cylinder);
+            scan.gasIsDiluent.insert(gasIndex, static_cast<int>(message.value(3, 0)) == 1);
+            break;
+        }
 
-            case MsgDiveGas: {
-                meta.sawDiveData = true;
-                // Fall back to sequential slots when the writer omits the
-                // message index — defaulting all to 0 would collapse the gases
-                const int gasIndex = message.has(FieldMessageIndex)
-                                         ? static_cast<int>(message.value(FieldMessageIndex))
-                                         : gasesByIndex.size();
-                const int status = static_cast<int>(message.value(2, 1)); // 0 disabled, 1 enabled, 2 backup
-                if (status == 0) {
-                    break;
-                }
-                CylinderInfo cylinder;
-                cylinder.o2Percent = message.value(1, 21.0);
-                cylinder.hePercent = message.value(0, 0.0);
-                cylinder.description = Units::formatGasMix(cylinder.o2Percent, cylinder.hePercent);
-                gasesByIndex.insert(gasIndex, cylinder);
-                gasIsDiluent.insert(gasIndex, static_cast<int>(message.value(3, 0)) == 1);
+        case MsgSensorProfile: {
+            // Sensor type 28 is a tank pressure pod; a pod without a
+            // readable serial can never match a tank_update, so skip it
+            // rather than creating a phantom channel
+            if (static_cast<int>(message.value(52, -1)) != 28 || !message.has(0)) {
                 break;
             }
+            meta.tankSensors.append(static_cast<quint32>(message.value(0)));
+            double volumeLiters = 0.0;
+            if (message.has(77)) {
+                const double rawVolume = message.value(77) / 10.0;
+                const int units = static_cast<int>(message.value(74, 2)); // 0 PSI, 2 Bar
+                // Volume is L*10 for Bar pods, CuFt*10 for PSI pods
+                volumeLiters = (units == 0) ? rawVolume * 28.3168 : rawVolume;
+            }
+            scan.tankVolumes.append(volumeLiters);
+            break;
+        }
 
-            case MsgSensorProfile: {
-                // Sensor type 28 is a tank pressure pod; a pod without a
-                // readable serial can never match a tank_update, so skip it
-                // rather than creating a phantom channel
-                if (static_cast<int>(message.value(52, -1)) != 28 || !message.has(0)) {
-                    break;
+        case MsgTankUpdate:
+            if (message.has(0)) {
+                const quint32 sensor = static_cast<quint32>(message.value(0));
+                if (!scan.updateSensors.contains(sensor)) {
+                    scan.updateSensors.append(sensor);
                 }
-                meta.tankSensors.append(static_cast<quint32>(message.value(0)));
-                double volumeLiters = 0.0;
-                if (message.has(77)) {
-                    const double rawVolume = message.value(77) / 10.0;
-                    const int units = static_cast<int>(message.value(74, 2)); // 0 PSI, 2 Bar
-                    // Volume is L*10 for Bar pods, CuFt*10 for PSI pods
-                    volumeLiters = (units == 0) ? rawVolume * 28.3168 : rawVolume;
+                if (scan.keepSamples && message.has(1)) {
+                    RawEvent event;
+                    event.kind = RawEvent::TankPressure;
+                    event.sampleIndex = scan.samples.size();
+                    event.sensor = sensor;
+                    event.bar = message.value(1) / 100.0; // bar * 100
+                    scan.events.append(event);
                 }
-                tankVolumes.append(volumeLiters);
-                break;
             }
+            break;
 
-            case MsgTankUpdate:
-                if (message.has(0)) {
-                    const quint32 sensor = static_cast<quint32>(message.value(0));
-                    if (!updateSensors.contains(sensor)) {
-                        updateSensors.append(sensor);
-                    }
-                }
-                break;
+        case MsgTankSummary:
+            if (message.has(0)) {
+                scan.tankPressures.insert(static_cast<quint32>(message.value(0)),
+                                          qMakePair(message.value(1, 0.0) / 100.0,
+                                                    message.value(2, 0.0) / 100.0));
+            }
+            break;
 
-            case MsgTankSummary:
-                if (message.has(0)) {
-                    tankPressures.insert(static_cast<quint32>(message.value(0)),
-                                         qMakePair(message.value(1, 0.0) / 100.0,
-                                                   message.value(2, 0.0) / 100.0));
+        case MsgDiveSummary:
+            meta.sawDiveData = true;
+            if (message.has(10)) {
+                meta.diveNumber = static_cast<int>(message.value(10));
+            }
+            if (message.has(2)) {
+                meta.meanDepth = message.value(2) / 1000.0; // mm -> m
+            }
+            break;
+
+        case MsgEvent: {
+            const int event = static_cast<int>(message.value(0, -1));
+            const int data = static_cast<int>(message.value(3, 0));
+            // 57: gas switch, data is the FIT gas slot index. 56 with data
+            // 24-27: automatic/manual switch to the low or high setpoint.
+            const bool gasSwitch = event == 57;
+            const bool setpoint = event == 56 && data >= 24 && data <= 27;
+            if (scan.keepSamples && (gasSwitch || setpoint)) {
+                RawEvent raw;
+                raw.kind = gasSwitch ? RawEvent::GasSwitch : RawEvent::Setpoint;
+                raw.sampleIndex = scan.samples.size();
+                if (message.has(FieldTimestamp)) {
+                    raw.timestamp = static_cast<qint64>(message.value(FieldTimestamp));
                 }
-                break;
+                raw.data = data;
+                scan.events.append(raw);
+            }
+            break;
+        }
 
-            case MsgDiveSummary:
+        case MsgRecord: {
+            if (message.has(92)) {
                 meta.sawDiveData = true;
-                if (message.has(10)) {
-                    meta.diveNumber = static_cast<int>(message.value(10));
-                }
-                if (message.has(2)) {
-                    meta.meanDepth = message.value(2) / 1000.0; // mm -> m
-                }
-                break;
-
-            case MsgRecord:
-                if (!sawFirstRecord && message.has(FieldTimestamp)) {
-                    sawFirstRecord = true;
-                    firstRecordTime = static_cast<quint32>(message.value(FieldTimestamp));
-                }
-                if (message.has(92)) {
-                    meta.sawDiveData = true;
-                }
-                break;
-
-            default:
+                scan.depthSamples++;
+            }
+            if (!message.has(FieldTimestamp)) {
                 break;
+            }
+            const quint32 timestamp = static_cast<quint32>(message.value(FieldTimestamp));
+            if (!scan.sawFirstRecord) {
+                scan.sawFirstRecord = true;
+                scan.firstRecordTime = timestamp;
+            }
+            if (scan.keepSamples) {
+                RawSample sample;
+                sample.timestamp = timestamp;
+                sample.depth = message.value(92, qQNaN());
+                sample.temperature = message.value(13, qQNaN());
+                sample.ndl = message.value(96, qQNaN());
+                sample.tts = message.value(95, qQNaN());
+                sample.ceiling = message.value(93, qQNaN());
+                sample.stopTime = message.value(94, qQNaN());
+                sample.cns = message.value(97, qQNaN());
+                scan.samples.append(sample);
+            }
+            break;
         }
+
+        default:
+            break;
     }
+}
 
-    if (!meta.hasStart && sawFirstRecord) {
+void FitParser::finishMetadata(Scan &scan)
+{
+    Metadata &meta = scan.meta;
+
+    if (!meta.hasStart && scan.sawFirstRecord) {
         meta.hasStart = true;
-        meta.startFit = firstRecordTime;
+        meta.startFit = scan.firstRecordTime;
     }
 
     // Pods seen only in tank_update messages (paired mid-dive, or the
     // sensor_profile messages are absent) still get a channel here so the
     // padding loop below gives them a cylinder — otherwise their pressures
     // would land on channels no overlay cell can display
-    for (quint32 sensor : updateSensors) {
+    for (quint32 sensor : scan.updateSensors) {
         if (!meta.tankSensors.contains(sensor)) {
             meta.tankSensors.append(sensor);
-            tankVolumes.append(0.0);
+            scan.tankVolumes.append(0.0);
         }
     }
 
     // Cylinders in gas-slot order; the FIT gas index maps onto the cylinder index
-    for (auto it = gasesByIndex.constBegin(); it != gasesByIndex.constEnd(); ++it) {
+    for (auto it = scan.gasesByIndex.constBegin(); it != scan.gasesByIndex.constEnd(); ++it) {
         CylinderInfo cylinder = it.value();
         cylinder.index = meta.cylinders.size();
-        if (gasIsDiluent.value(it.key(), false)) {
+        if (scan.gasIsDiluent.value(it.key(), false)) {
             cylinder.description += QStringLiteral(" (diluent)");
         }
         meta.gasIndexToCylinder.insert(it.key(), cylinder.index);
@@ -273,17 +334,15 @@ FitParser::Metadata FitParser::collectMetadata(const QList<FitMessage> &messages
             cylinder.description = Units::formatGasMix(cylinder.o2Percent, cylinder.hePercent);
             meta.cylinders.append(cylinder);
         }
-        if (tankVolumes.value(channel, 0.0) > 0.0) {
-            meta.cylinders[channel].size = tankVolumes.at(channel);
+        if (scan.tankVolumes.value(channel, 0.0) > 0.0) {
+            meta.cylinders[channel].size = scan.tankVolumes.at(channel);
         }
-        const auto pressures = tankPressures.constFind(meta.tankSensors.at(channel));
-        if (pressures != tankPressures.constEnd()) {
+        const auto pressures = scan.tankPressures.constFind(meta.tankSensors.at(channel));
+        if (pressures != scan.tankPressures.constEnd()) {
             meta.cylinders[channel].startPressure = pressures->first;
             meta.cylinders[channel].endPressure = pressures->second;
         }
     }
-
-    return meta;
 }
 
 bool FitParser::isDive(const Metadata &meta, QString &errorOut) const
@@ -303,8 +362,9 @@ bool FitParser::isDive(const Metadata &meta, QString &errorOut) const
     return true;
 }
 
-DiveData *FitParser::buildDive(const QList<FitMessage> &messages, const Metadata &meta) const
+DiveData *FitParser::buildDive(const Scan &scan) const
 {
+    const Metadata &meta = scan.meta;
     DiveData *dive = new DiveData(nullptr);
 
     const bool isCcr = (meta.subSport == 63);
@@ -340,154 +400,141 @@ DiveData *FitParser::buildDive(const QList<FitMessage> &messages, const Metadata
     // The initial CCR setpoint at the start of the dive is the low setpoint
     double currentSetpoint = meta.setpointLowBar;
 
-    QVector<DiveDataPoint> points;
-
-    for (const FitMessage &message : messages) {
-        switch (message.globalId) {
-            case MsgTankUpdate: {
-                if (!message.has(0) || !message.has(1)) {
-                    break;
-                }
-                const quint32 sensor = static_cast<quint32>(message.value(0));
-                int channel = tankSensors.indexOf(sensor);
+    const auto applyEvent = [&](const RawEvent &event) {
+        switch (event.kind) {
+            case RawEvent::TankPressure: {
+                int channel = tankSensors.indexOf(event.sensor);
                 if (channel < 0) {
                     // Unpaired pod seen mid-dive: give it the next free channel
                     channel = tankSensors.size();
-                    tankSensors.append(sensor);
+                    tankSensors.append(event.sensor);
                 }
-                lastPressures[channel] = message.value(1) / 100.0; // bar * 100
+                lastPressures[channel] = event.bar;
                 break;
             }
 
-            case MsgEvent: {
-                const int event = static_cast<int>(message.value(0, -1));
-                const int data = static_cast<int>(message.value(3, 0));
-                if (event == 57) {
-                    // Gas switch; data is the FIT gas slot index
-                    const int cylinderIndex = meta.gasIndexToCylinder.value(data, 0);
-                    double relTime = 0.0;
-                    if (message.has(FieldTimestamp)) {
-                        const quint32 timestamp =
-                            static_cast<quint32>(message.value(FieldTimestamp));
-                        // Clamp pre-dive-start switch events to t=0 so the
-                        // starting gas is reflected from the first sample
-                        if (timestamp > meta.startFit) {
-                            relTime = timestamp - meta.startFit;
-                        }
-                    }
-                    dive->addGasSwitch(relTime, cylinderIndex);
-                    if (cylinderIndex < meta.cylinders.size()) {
-                        currentO2 = meta.cylinders.at(cylinderIndex).o2Percent;
-                    }
-                } else if (event == 56 && data >= 24 && data <= 27) {
-                    // Automatic/manual switch to low (24/26) or high (25/27)
-                    // setpoint. Hold the previous value when the target is
-                    // unknown (dive_settings missing or partial) rather than
-                    // blanking the PO2 cells for the rest of the dive.
-                    const double target =
-                        (data == 24 || data == 26) ? meta.setpointLowBar : meta.setpointHighBar;
-                    if (target > 0.0) {
-                        currentSetpoint = target;
-                    }
+            case RawEvent::GasSwitch: {
+                const int cylinderIndex = meta.gasIndexToCylinder.value(event.data, 0);
+                // Clamp pre-dive-start switch events to t=0 so the starting
+                // gas is reflected from the first sample
+                const double relTime =
+                    event.timestamp > qint64(meta.startFit) ? event.timestamp - meta.startFit : 0.0;
+                dive->addGasSwitch(relTime, cylinderIndex);
+                if (cylinderIndex < meta.cylinders.size()) {
+                    currentO2 = meta.cylinders.at(cylinderIndex).o2Percent;
                 }
                 break;
             }
 
-            case MsgRecord: {
-                if (!message.has(FieldTimestamp)) {
-                    break;
-                }
-                const quint32 timestamp = static_cast<quint32>(message.value(FieldTimestamp));
-                if (timestamp < meta.startFit) {
-                    break; // pre-dive surface samples
+            case RawEvent::Setpoint: {
+                // Low (24/26) or high (25/27) setpoint. Hold the previous
+                // value when the target is unknown (dive_settings missing or
+                // partial) rather than blanking the PO2 cells for the rest
+                // of the dive.
+                const double target = (event.data == 24 || event.data == 26)
+                                          ? meta.setpointLowBar
+                                          : meta.setpointHighBar;
+                if (target > 0.0) {
+                    currentSetpoint = target;
                 }
+                break;
+            }
+        }
+    };
 
-                DiveDataPoint point;
-                point.timestamp = static_cast<double>(timestamp - meta.startFit);
+    QVector<DiveDataPoint> points;
+    points.reserve(scan.samples.size());
+    int nextEvent = 0;
 
-                if (message.has(92)) {
-                    lastDepth = message.value(92) / 1000.0; // mm -> m
-                }
-                point.depth = lastDepth;
+    for (int i = 0; i < scan.samples.size(); ++i) {
+        while (nextEvent < scan.events.size() && scan.events.at(nextEvent).sampleIndex <= i) {
+            applyEvent(scan.events.at(nextEvent++));
+        }
 
-                if (message.has(13)) {
-                    lastTemperature = message.value(13); // degrees C
-                }
-                point.temperature = lastTemperature;
+        const RawSample &sample = scan.samples.at(i);
+        if (sample.timestamp < meta.startFit) {
+            continue; // pre-dive surface samples
+        }
 
-                if (message.has(96)) {
-                    lastNDL = message.value(96) / 60.0; // s -> min
-                }
-                point.ndl = lastNDL;
+        DiveDataPoint point;
+        point.timestamp = static_cast<double>(sample.timestamp - meta.startFit);
 
-                if (message.has(95)) {
-                    lastTTS = message.value(95) / 60.0; // s -> min
-                }
-                point.tts = lastTTS;
+        if (!qIsNaN(sample.depth)) {
+            lastDepth = sample.depth / 1000.0; // mm -> m
+        }
+        point.depth = lastDepth;
 
-                if (message.has(93)) {
-                    lastCeiling = message.value(93) / 1000.0; // next stop depth, mm -> m
-                }
-                point.ceiling = lastCeiling;
+        if (!qIsNaN(sample.temperature)) {
+            lastTemperature = sample.temperature; // degrees C
+        }
+        point.temperature = lastTemperature;
 
-                if (message.has(94)) {
-                    lastStopTime = message.value(94) / 60.0; // next stop time, s -> min
-                }
-                point.stopTime = lastStopTime;
+        if (!qIsNaN(sample.ndl)) {
+            lastNDL = sample.ndl / 60.0; // s -> min
+        }
+        point.ndl = lastNDL;
 
-                if (message.has(97)) {
-                    lastCNS = message.value(97); // percent
-                }
-                point.cns = lastCNS;
+        if (!qIsNaN(sample.tts)) {
+            lastTTS = sample.tts / 60.0; // s -> min
+        }
+        point.tts = lastTTS;
 
-                point.o2percent = currentO2;
+        if (!qIsNaN(sample.ceiling)) {
+            lastCeiling = sample.ceiling / 1000.0; // next stop depth, mm -> m
+        }
+        point.ceiling = lastCeiling;
 
-                for (auto it = lastPressures.constBegin(); it != lastPressures.constEnd(); ++it) {
-                    point.addPressure(it.value(), it.key());
-                }
+        if (!qIsNaN(sample.stopTime)) {
+            lastStopTime = sample.stopTime / 60.0; // next stop time, s -> min
+        }
+        point.stopTime = lastStopTime;
 
-                if (isCcr && currentSetpoint > 0.0) {
-                    // The Descent records the active setpoint, not sensor
-                    // readings; expose it through PO2 channel 0
-                    point.addPO2Sensor(currentSetpoint, 0);
-                }
+        if (!qIsNaN(sample.cns)) {
+            lastCNS = sample.cns; // percent
+        }
+        point.cns = lastCNS;
 
-                if (!points.isEmpty() && points.last().timestamp == point.timestamp) {
-                    points.last() = point; // compressed-timestamp duplicate: last wins
-                } else {
-                    points.append(point);
-                }
-                break;
-            }
+        point.o2percent = currentO2;
 
-            default:
-                break;
+        for (auto it = lastPressures.constBegin(); it != lastPressures.constEnd(); ++it) {
+            point.addPressure(it.value(), it.key());
+        }
+
+        if (isCcr && currentSetpoint > 0.0) {
+            // The Descent records the active setpoint, not sensor
+            // readings; expose it through PO2 channel 0
+            point.addPO2Sensor(currentSetpoint, 0);
+        }
+
+        if (!points.isEmpty() && points.last().timestamp == point.timestamp) {
+            points.last() = point; // compressed-timestamp duplicate: last wins
+        } else {
+            points.append(point);
         }
     }
 
-    for (const DiveDataPoint &point : points) {
-        dive->addDataPoint(point);
+    // Gas switches after the last sample still belong to the dive
+    while (nextEvent < scan.events.size()) {
+        applyEvent(scan.events.at(nextEvent++));
     }
 
+    dive->appendDataPoints(points);
+
     return dive;
 }
 
-QList<DiveData *> FitParser::parse(QFile &file, int specificDive, QString &errorOut)
+QList<DiveData *> FitParser::parse(QIODevice &file, int specificDive, QString &errorOut)
 {
     QList<DiveData *> result;
 
-    FitDecoder decoder;
-    if (!decodeFile(file, decoder, errorOut)) {
-        return result;
-    }
-
-    const Metadata meta = collectMetadata(decoder.messages());
-    if (!isDive(meta, errorOut)) {
+    Scan scan;
+    scan.keepSamples = true;
+    if (!scanFile(file, scan, errorOut) || !isDive(scan.meta, errorOut)) {
         return result;
     }
 
-    DiveData *dive = buildDive(decoder.messages(), meta);
-    if (dive->allDataPoints().isEmpty()) {
+    DiveData *dive = buildDive(scan);
+    if (dive->sampleCount() == 0) {
         delete dive;
         errorOut = QStringLiteral("FIT file contains no dive samples");
         return result;
@@ -504,19 +551,15 @@ QList<DiveData *> FitParser::parse(QFile &file, int specificDive, QString &error
     return result;
 }
 
-QList<QString> FitParser::listDives(QFile &file, QString &errorOut)
+QList<QString> FitParser::listDives(QIODevice &file, QString &errorOut)
 {
     QList<QString> result;
 
-    FitDecoder decoder;
-    if (!decodeFile(file, decoder, errorOut)) {
-        return result;
-    }
-
-    const Metadata meta = collectMetadata(decoder.messages());
-    if (!isDive(meta, errorOut)) {
+    Scan scan;
+    if (!scanFile(file, scan, errorOut) || !isDive(scan.meta, errorOut)) {
         return result;
     }
+    const Metadata &meta = scan.meta;
 
     QString entry =
         QStringLiteral("Dive #%1 - %2")
@@ -30,4 +30,86 @@ QDateTime parseISO8601(QStringView s)
     return dt;
 }
 
+namespace {
+
+bool isDigit(QChar c)
+{
+    return c >= QLatin1Char('0') && c <= QLatin1Char('9');
+}
+
+// Index just past the run of digits starting at 'i'
+qsizetype skipDigits(QStringView s, qsizetype i)
+{
+    while (i < s.size() && isDigit(s[i])) {
+        ++i;
+    }
+    return i;
+}
+
+// True if 'unit' follows position 'i', after whitespace (at least one
+// character of it when spaceRequired)
+bool followedByUnit(QStringView s, qsizetype i, QStringView unit, bool spaceRequired)
+{
+    const qsizetype afterNumber = i;
+    while (i < s.size() && s[i].isSpace()) {
+        ++i;
+    }
+    if (spaceRequired && i == afterNumber) {
+        return false;
+    }
+    return s.mid(i).startsWith(unit);
+}
+
+} // namespace
+
+double scanUnitValue(QStringView s, QStringView unit, bool spaceRequired)
+{
+    qsizetype i = 0;
+    while (i < s.size()) {
+        if (!isDigit(s[i])) {
+            ++i;
+            continue;
+        }
+
+        const qsizetype start = i;
+        i = skipDigits(s, i);
+        if (i < s.size() && s[i] == QLatin1Char('.')) {
+            i = skipDigits(s, i + 1);
+        }
+
+        if (followedByUnit(s, i, unit, spaceRequired)) {
+            // Digits and at most one '.', so this can't fail
+            return s.mid(start, i - start).toDouble();
+        }
+    }
+    return std::nan("");
+}
+
+double scanMinutesSeconds(QStringView s)
+{
+    qsizetype i = 0;
+    while (i < s.size()) {
+        if (!isDigit(s[i])) {
+            ++i;
+            continue;
+        }
+
+        int minutes = 0;
+        while (i < s.size() && isDigit(s[i])) {
+            minutes = minutes * 10 + s[i].digitValue();
+            ++i;
+        }
+        if (i + 1 < s.size() && s[i] == QLatin1Char(':') && isDigit(s[i + 1])) {
+            int seconds = 0;
+            for (++i; i < s.size() && isDigit(s[i]); ++i) {
+                seconds = seconds * 10 + s[i].digitValue();
+            }
+            if (followedByUnit(s, i, u"min", true)) {
+                return minutes * 60 + seconds;
+            }
+        }
+    }
+    return std::nan("");
+}
+
 } // namespace parse_utils
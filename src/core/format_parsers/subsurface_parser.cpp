@@ -1,15 +1,41 @@
 #include "include/core/format_parsers/subsurface_parser.h"
+#include "include/core/format_parsers/decompressing_device.h"
+#include "include/core/format_parsers/parse_utils.h"
+#include "include/core/format_parsers/xml_dive_index.h"
+#include "include/core/logging.h"
 
 #include <QDateTime>
-#include <QDebug>
-#include <QRegularExpression>
+#include <QMutex>
+#include <QThread>
 #include <QXmlStreamReader>
+#include <QtConcurrent>
 
 #include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Per-channel sample attributes, spelled out so the per-sample loops don't
+// format key strings
+constexpr int kMaxPressureAttributes = 10;
+const QLatin1String kPressureAttributes[kMaxPressureAttributes] = {
+    QLatin1String("pressure0"), QLatin1String("pressure1"), QLatin1String("pressure2"),
+    QLatin1String("pressure3"), QLatin1String("pressure4"), QLatin1String("pressure5"),
+    QLatin1String("pressure6"), QLatin1String("pressure7"), QLatin1String("pressure8"),
+    QLatin1String("pressure9")
+};
+
+constexpr int kMaxSensorAttributes = 4;
+const QLatin1String kSensorAttributes[kMaxSensorAttributes] = {
+    QLatin1String("sensor1"), QLatin1String("sensor2"), QLatin1String("sensor3"),
+    QLatin1String("sensor4")
+};
+
+} // namespace
 
 SubsurfaceParser::SubsurfaceParser() = default;
 
-bool SubsurfaceParser::canParse(QFile &file) const
+bool SubsurfaceParser::canParse(QIODevice &file) const
 {
     const qint64 originalPos = file.pos();
     file.seek(0);
@@ -36,12 +62,28 @@ void SubsurfaceParser::resetDiveState()
     m_currentDiveHasCcrCues = false;
 }
 
-QList<DiveData *> SubsurfaceParser::parse(QFile &file, int specificDive, QString &errorOut)
+QList<DiveData *> SubsurfaceParser::parse(QIODevice &file, int specificDive, QString &errorOut)
 {
+    XmlDiveIndex index;
+    if (specificDive != -1) {
+        if (loadIndex(file, index)) {
+            return parseIndexedDive(file, index, specificDive, errorOut);
+        }
+    } else {
+        // Split first, then parse the dives on the thread pool
+        file.seek(0);
+        notifyReadingWholeLog();
+        const QByteArray data = file.readAll();
+        if (file.atEnd()
+            && index.scan(data, QLatin1String("dive"), {QLatin1String("divesites")})) {
+            return parseDivesInParallel(data, index, errorOut);
+        }
+    }
+
     QList<DiveData *> result;
 
     file.seek(0);
-    qDebug() << "Starting to parse Subsurface XML file";
+    qCDebug(lcParse) << "Starting to parse Subsurface XML file";
     QXmlStreamReader xml(&file);
 
     m_diveSites.clear();
@@ -50,10 +92,10 @@ QList<DiveData *> SubsurfaceParser::parse(QFile &file, int specificDive, QString
         QXmlStreamReader::TokenType token = xml.readNext();
 
         if (token == QXmlStreamReader::StartElement && xml.name() == QStringLiteral("divesites")) {
-            qDebug() << "Found divesites element";
+            qCDebug(lcParse) << "Found divesites element";
             parseDiveSites(xml);
         } else if (token == QXmlStreamReader::StartElement && xml.name() == QStringLiteral("dive")) {
-            qDebug() << "Found dive element";
+            qCDebug(lcParse) << "Found dive element";
 
             if (specificDive != -1) {
                 QXmlStreamAttributes attrs = xml.attributes();
@@ -68,7 +110,7 @@ QList<DiveData *> SubsurfaceParser::parse(QFile &file, int specificDive, QString
 
             DiveData *dive = parseDiveElement(xml);
             if (dive) {
-                qDebug() << "Successfully parsed dive:" << dive->diveName();
+                qCDebug(lcParse) << "Successfully parsed dive:" << dive->diveName();
                 result.append(dive);
 
                 if (specificDive != -1) {
@@ -80,20 +122,77 @@ QList<DiveData *> SubsurfaceParser::parse(QFile &file, int specificDive, QString
 
     if (xml.hasError()) {
         errorOut = QStringLiteral("XML parsing error: %1").arg(xml.errorString());
-        qDebug() << "XML parsing error:" << xml.errorString();
+        qCDebug(lcParse) << "XML parsing error:" << xml.errorString();
         qDeleteAll(result);
         result.clear();
         return result;
     }
 
-    qDebug() << "Finished parsing XML file, found" << result.size() << "dives";
+    qCDebug(lcParse) << "Finished parsing XML file, found" << result.size() << "dives";
     return result;
 }
 
-QList<QString> SubsurfaceParser::listDives(QFile &file, QString &errorOut)
+bool SubsurfaceParser::parseChanged(QIODevice &file,
+                                    const QSet<QByteArray> &known,
+                                    QList<QByteArray> &hashesOut,
+                                    QList<DiveData *> &divesOut,
+                                    QString &errorOut)
+{
+    file.seek(0);
+    notifyReadingWholeLog();
+    const QByteArray data = file.readAll();
+    XmlDiveIndex index;
+    if (!file.atEnd()
+        || !index.scan(data, QLatin1String("dive"), {QLatin1String("divesites")})) {
+        return false;
+    }
+
+    hashesOut = index.diveHashes(data, QLatin1String("uuid"), {QLatin1String("divesiteid")});
+    XmlDiveIndex changed = index;
+    changed.dives.clear();
+    for (qsizetype i = 0; i < hashesOut.size(); ++i) {
+        if (!known.contains(hashesOut[i])) {
+            changed.dives.append(index.dives[i]);
+        }
+    }
+
+    QList<DiveData *> parsed;
+    if (!changed.dives.isEmpty()) {
+        parsed = parseDivesInParallel(data, changed, errorOut);
+        if (!errorOut.isEmpty()) {
+            return true;
+        }
+    }
+    // A dive range that yielded no dive would misalign the result; let the
+    // caller parse the whole log instead
+    if (parsed.size() != changed.dives.size()) {
+        qDeleteAll(parsed);
+        return false;
+    }
+
+    divesOut.clear();
+    auto next = parsed.cbegin();
+    for (const QByteArray &hash : std::as_const(hashesOut)) {
+        divesOut.append(known.contains(hash) ? nullptr : *next++);
+    }
+    qCDebug(lcParse) << "Re-parsed" << parsed.size() << "of" << hashesOut.size() << "dives";
+    return true;
+}
+
+QList<QString> SubsurfaceParser::listDives(QIODevice &file, QString &errorOut)
 {
     QList<QString> result;
 
+    XmlDiveIndex index;
+    if (loadIndex(file, index)) {
+        for (const XmlDiveIndex::Dive &dive : std::as_const(index.dives)) {
+            if (!dive.label.isEmpty()) {
+                result.append(dive.label);
+            }
+        }
+        return result;
+    }
+
     file.seek(0);
     QXmlStreamReader xml(&file);
 
@@ -101,50 +200,226 @@ QList<QString> SubsurfaceParser::listDives(QFile &file, QString &errorOut)
         QXmlStreamReader::TokenType token = xml.readNext();
 
         if (token == QXmlStreamReader::StartElement && xml.name() == QStringLiteral("dive")) {
-            QString diveDate;
-            QString diveTime;
-            QString diveLocation;
+            int number = -1;
+            const QString entry = listEntry(xml, number);
+            if (!entry.isEmpty()) {
+                result.append(entry);
+            }
+        }
+    }
 
-            QXmlStreamAttributes attrs = xml.attributes();
-            if (attrs.hasAttribute("number")) {
-                QString number = attrs.value("number").toString();
+    if (xml.hasError()) {
+        errorOut = QStringLiteral("XML parsing error: %1").arg(xml.errorString());
+        result.clear();
+    }
 
-                if (attrs.hasAttribute("date")) {
-                    diveDate = attrs.value("date").toString();
-                }
-                if (attrs.hasAttribute("time")) {
-                    diveTime = attrs.value("time").toString();
-                }
+    return result;
+}
 
-                while (!xml.atEnd() && !(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == QStringLiteral("dive"))) {
-                    if (xml.tokenType() == QXmlStreamReader::StartElement && xml.name() == QStringLiteral("location")) {
-                        diveLocation = xml.readElementText();
-                        break;
-                    }
-                    xml.readNext();
-                }
+QString SubsurfaceParser::listEntry(QXmlStreamReader &xml, int &number)
+{
+    QString diveDate;
+    QString diveTime;
+    QString diveLocation;
 
-                QString entry = QStringLiteral("Dive #%1").arg(number);
-                if (!diveDate.isEmpty()) {
-                    entry += " - " + diveDate;
-                }
-                if (!diveTime.isEmpty()) {
-                    entry += " " + diveTime;
-                }
-                if (!diveLocation.isEmpty()) {
-                    entry += " at " + diveLocation;
-                }
+    QXmlStreamAttributes attrs = xml.attributes();
+    if (!attrs.hasAttribute("number")) {
+        return QString();
+    }
 
-                result.append(entry);
-            }
+    QString diveNumber = attrs.value("number").toString();
+    bool ok;
+    number = diveNumber.toInt(&ok);
+    if (!ok) {
+        number = -1;
+    }
+
+    if (attrs.hasAttribute("date")) {
+        diveDate = attrs.value("date").toString();
+    }
+    if (attrs.hasAttribute("time")) {
+        diveTime = attrs.value("time").toString();
+    }
+
+    while (!xml.atEnd() && !(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == QStringLiteral("dive"))) {
+        if (xml.tokenType() == QXmlStreamReader::StartElement && xml.name() == QStringLiteral("location")) {
+            diveLocation = xml.readElementText();
+            break;
+        }
+        xml.readNext();
+    }
+
+    QString entry = QStringLiteral("Dive #%1").arg(diveNumber);
+    if (!diveDate.isEmpty()) {
+        entry += " - " + diveDate;
+    }
+    if (!diveTime.isEmpty()) {
+        entry += " " + diveTime;
+    }
+    if (!diveLocation.isEmpty()) {
+        entry += " at " + diveLocation;
+    }
+    return entry;
+}
+
+bool SubsurfaceParser::loadIndex(QIODevice &file, XmlDiveIndex &index)
+{
+    // Logs read from anything but a file (or a compressed file) are
+    // indexed every time
+    const QString path = DecompressingDevice::fileName(file);
+    if (!path.isEmpty() && index.load(path, formatName())) {
+        return true;
+    }
+
+    file.seek(0);
+    const QByteArray data = file.readAll();
+    if (!file.atEnd()
+        || !index.scan(data, QLatin1String("dive"), {QLatin1String("divesites")})) {
+        return false;
+    }
+
+    // Picker entries come from each dive's start tag and location, so the
+    // samples are never tokenized
+    for (XmlDiveIndex::Dive &dive : index.dives) {
+        QXmlStreamReader xml(index.fragment(data, dive.range));
+        xml.setNamespaceProcessing(false);
+        if (xml.readNextStartElement()) {
+            dive.unnumbered = !xml.attributes().hasAttribute(QLatin1String("number"));
+            dive.label = listEntry(xml, dive.number);
+        }
+        if (xml.hasError()) {
+            qCDebug(lcParse) << "Not indexing" << path << "-" << xml.errorString();
+            return false;
+        }
+    }
+
+    if (!path.isEmpty()) {
+        index.save(path, formatName());
+    }
+    qCDebug(lcParse) << "Indexed" << index.dives.size() << "dives in" << path;
+    return true;
+}
+
+QList<DiveData *> SubsurfaceParser::parseIndexedDive(QIODevice &file,
+                                                     const XmlDiveIndex &index,
+                                                     int diveNumber,
+                                                     QString &errorOut)
+{
+    QList<DiveData *> result;
+
+    // Like the streaming parse, which only skips dives numbered otherwise
+    const XmlDiveIndex::Dive *entry = index.find(diveNumber, true);
+    if (!entry) {
+        return result;
+    }
+
+    m_diveSites.clear();
+    for (const XmlDiveIndex::Range &range : index.shared) {
+        QXmlStreamReader xml(index.fragment(file, range));
+        xml.setNamespaceProcessing(false);
+        if (xml.readNextStartElement()) {
+            parseDiveSites(xml);
+        }
+    }
+
+    QXmlStreamReader xml(index.fragment(file, entry->range));
+    xml.setNamespaceProcessing(false);
+    if (xml.readNextStartElement()) {
+        DiveData *dive = parseDiveElement(xml);
+        if (dive) {
+            qCDebug(lcParse) << "Successfully parsed indexed dive:" << dive->diveName();
+            result.append(dive);
         }
     }
 
     if (xml.hasError()) {
         errorOut = QStringLiteral("XML parsing error: %1").arg(xml.errorString());
+        qCDebug(lcParse) << "XML parsing error:" << xml.errorString();
+        qDeleteAll(result);
+        result.clear();
+    }
+
+    return result;
+}
+
+QList<DiveData *> SubsurfaceParser::parseDivesInParallel(const QByteArray &data,
+                                                         const XmlDiveIndex &index,
+                                                         QString &errorOut)
+{
+    m_diveSites.clear();
+    for (const XmlDiveIndex::Range &range : index.shared) {
+        QXmlStreamReader xml(index.fragment(data, range));
+        xml.setNamespaceProcessing(false);
+        if (xml.readNextStartElement()) {
+            parseDiveSites(xml);
+        }
+    }
+
+    struct ParsedDive {
+        DiveData *dive = nullptr;
+        QString error;
+    };
+
+    // Each dive gets its own copy of the parser: the site table is shared
+    // read-only, the per-dive state is not shared at all
+    QThread *owner = QThread::currentThread();
+    QMutex progressMutex;
+    qsizetype parsedCount = 0;
+    auto parseOne = [&](const XmlDiveIndex::Dive &entry) {
+        ParsedDive parsed;
+        // Dives not started yet are skipped once the caller cancels
+        if (isCancelled()) {
+            return parsed;
+        }
+        SubsurfaceParser parser(*this);
+        QXmlStreamReader xml(index.fragment(data, entry.range));
+        xml.setNamespaceProcessing(false);
+        if (xml.readNextStartElement()) {
+            parsed.dive = parser.parseDiveElement(xml);
+        }
+        if (xml.hasError()) {
+            parsed.error = xml.errorString();
+            delete parsed.dive;
+            parsed.dive = nullptr;
+        }
+        if (parsed.dive) {
+            parsed.dive->moveToThread(owner);
+        }
+        if (m_observer.divesParsed) {
+            QMutexLocker locker(&progressMutex);
+            m_observer.divesParsed(++parsedCount, index.dives.size());
+        }
+        return parsed;
+    };
+    const QList<ParsedDive> parsed =
+        QtConcurrent::blockingMapped<QList<ParsedDive>>(index.dives, parseOne);
+
+    if (isCancelled()) {
+        for (const ParsedDive &entry : parsed) {
+            delete entry.dive;
+        }
+        errorOut = QStringLiteral("Parse cancelled");
+        return {};
+    }
+
+    QList<DiveData *> result;
+    result.reserve(parsed.size());
+    for (const ParsedDive &entry : parsed) {
+        if (!entry.error.isEmpty() && errorOut.isEmpty()) {
+            errorOut = QStringLiteral("XML parsing error: %1").arg(entry.error);
+            qCDebug(lcParse) << "XML parsing error:" << entry.error;
+        }
+        if (entry.dive) {
+            result.append(entry.dive);
+        }
+    }
+    if (!errorOut.isEmpty()) {
+        qDeleteAll(result);
         result.clear();
+        return result;
     }
 
+    qCDebug(lcParse) << "Finished parsing XML file, found" << result.size() << "dives";
     return result;
 }
 
@@ -191,7 +466,7 @@ DiveData *SubsurfaceParser::parseDiveElement(QXmlStreamReader &xml)
         dive->setStartTime(diveDateTime);
     }
 
-    qDebug() << "Parsing dive element for" << dive->diveName();
+    qCDebug(lcParse) << "Parsing dive element for" << dive->diveName();
 
     int sampleCount = 0;
 
@@ -215,7 +490,7 @@ DiveData *SubsurfaceParser::parseDiveElement(QXmlStreamReader &xml)
         }
     }
 
-    if (dive->allDataPoints().isEmpty() && dive->cylinderCount() > 0) {
+    if (dive->sampleCount() == 0 && dive->cylinderCount() > 0) {
         DiveDataPoint initialPoint;
         initialPoint.timestamp = 0.0;
 
@@ -235,7 +510,7 @@ DiveData *SubsurfaceParser::parseDiveElement(QXmlStreamReader &xml)
         dive->setDiveMode(m_currentDiveHasCcrCues ? DiveData::ClosedCircuit : DiveData::OpenCircuit);
     }
 
-    qDebug() << "Finished parsing dive element. Total data points:" << dive->allDataPoints().size()
+    qCDebug(lcParse) << "Finished parsing dive element. Total data points:" << dive->sampleCount()
              << "diveMode:" << dive->diveMode();
     return dive;
 }
@@ -246,22 +521,20 @@ void SubsurfaceParser::parseCylinderElement(QXmlStreamReader &xml, DiveData *div
     CylinderInfo cylinder;
 
     if (attrs.hasAttribute("size")) {
-        QString sizeStr = attrs.value("size").toString();
-        QRegularExpression sizeRe("(\\d+\\.?\\d*)\\s+l");
-        QRegularExpressionMatch match = sizeRe.match(sizeStr);
+        const QStringView sizeStr = attrs.value("size");
+        const double value = parse_utils::scanUnitValue(sizeStr, u"l");
 
-        if (match.hasMatch()) {
-            cylinder.size = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            cylinder.size = value;
         }
     }
 
     if (attrs.hasAttribute("workpressure")) {
-        QString pressureStr = attrs.value("workpressure").toString();
-        QRegularExpression pressureRe("(\\d+\\.?\\d*)\\s+bar");
-        QRegularExpressionMatch match = pressureRe.match(pressureStr);
+        const QStringView pressureStr = attrs.value("workpressure");
+        const double value = parse_utils::scanUnitValue(pressureStr, u"bar");
 
-        if (match.hasMatch()) {
-            cylinder.workPressure = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            cylinder.workPressure = value;
         }
     }
 
@@ -270,42 +543,38 @@ void SubsurfaceParser::parseCylinderElement(QXmlStreamReader &xml, DiveData *div
     }
 
     if (attrs.hasAttribute("o2")) {
-        QString o2Str = attrs.value("o2").toString();
-        QRegularExpression o2Re("(\\d+\\.?\\d*)\\s*%");
-        QRegularExpressionMatch match = o2Re.match(o2Str);
+        const QStringView o2Str = attrs.value("o2");
+        const double value = parse_utils::scanUnitValue(o2Str, u"%", false);
 
-        if (match.hasMatch()) {
-            cylinder.o2Percent = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            cylinder.o2Percent = value;
         }
     }
 
     if (attrs.hasAttribute("he")) {
-        QString heStr = attrs.value("he").toString();
-        QRegularExpression heRe("(\\d+\\.?\\d*)\\s*%");
-        QRegularExpressionMatch match = heRe.match(heStr);
+        const QStringView heStr = attrs.value("he");
+        const double value = parse_utils::scanUnitValue(heStr, u"%", false);
 
-        if (match.hasMatch()) {
-            cylinder.hePercent = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            cylinder.hePercent = value;
         }
     }
 
     if (attrs.hasAttribute("start")) {
-        QString startStr = attrs.value("start").toString();
-        QRegularExpression startRe("(\\d+\\.?\\d*)\\s+bar");
-        QRegularExpressionMatch match = startRe.match(startStr);
+        const QStringView startStr = attrs.value("start");
+        const double value = parse_utils::scanUnitValue(startStr, u"bar");
 
-        if (match.hasMatch()) {
-            cylinder.startPressure = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            cylinder.startPressure = value;
         }
     }
 
     if (attrs.hasAttribute("end")) {
-        QString endStr = attrs.value("end").toString();
-        QRegularExpression endRe("(\\d+\\.?\\d*)\\s+bar");
-        QRegularExpressionMatch match = endRe.match(endStr);
+        const QStringView endStr = attrs.value("end");
+        const double value = parse_utils::scanUnitValue(endStr, u"bar");
 
-        if (match.hasMatch()) {
-            cylinder.endPressure = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            cylinder.endPressure = value;
         }
     }
 
@@ -330,7 +599,7 @@ void SubsurfaceParser::parseCylinderElement(QXmlStreamReader &xml, DiveData *div
         m_initialCylinderPressures[cylinderIndex] = initialPressure;
     }
 
-    qDebug() << "Parsed cylinder:" << cylinder.description
+    qCDebug(lcParse) << "Parsed cylinder:" << cylinder.description
              << "Index:" << cylinderIndex
              << "Size:" << cylinder.size << "l"
              << "Gas mix:" << cylinder.o2Percent << "% O2"
@@ -345,7 +614,7 @@ void SubsurfaceParser::parseCylinderElement(QXmlStreamReader &xml, DiveData *div
 
 void SubsurfaceParser::parseDiveComputerElement(QXmlStreamReader &xml, DiveData *dive, int &sampleCount)
 {
-    qDebug() << "Parsing divecomputer element";
+    qCDebug(lcParse) << "Parsing divecomputer element";
 
     double lastTemperature = 0.0;
     double lastNDL = -1.0; // -1 = no NDL reported yet (not the same as 0 = deco)
@@ -354,6 +623,8 @@ void SubsurfaceParser::parseDiveComputerElement(QXmlStreamReader &xml, DiveData
 
     QMap<int, double> lastPressures;
     QMap<int, double> lastPO2Sensors;
+    // Collected here and handed to the dive in one batch at the end
+    QVector<DiveDataPoint> samples;
     for (int i = 0; i < dive->cylinderCount(); i++) {
         double initialPressure = m_initialCylinderPressures.value(i, 0.0);
         if (initialPressure > 0.0) {
@@ -372,21 +643,20 @@ void SubsurfaceParser::parseDiveComputerElement(QXmlStreamReader &xml, DiveData
             QString elementName = xml.name().toString();
 
             if (elementName == "sample") {
-                parseSampleElement(xml, dive, lastTemperature, lastNDL, lastTTS, lastCNS, lastPressures, lastPO2Sensors);
+                parseSampleElement(xml, dive, samples, lastTemperature, lastNDL, lastTTS, lastCNS, lastPressures, lastPO2Sensors);
                 sampleCount++;
 
                 if (sampleCount % 10 == 0) {
-                    qDebug() << "Parsed" << sampleCount << "samples";
+                    qCDebug(lcParse) << "Parsed" << sampleCount << "samples";
                 }
             } else if (elementName == "depth") {
                 QXmlStreamAttributes attrs = xml.attributes();
                 if (attrs.hasAttribute("mean")) {
-                    QString meanStr = attrs.value("mean").toString();
-                    QRegularExpression depthRe("(\\d+\\.?\\d*)\\s+m");
-                    QRegularExpressionMatch match = depthRe.match(meanStr);
+                    const QStringView meanStr = attrs.value("mean");
+                    const double value = parse_utils::scanUnitValue(meanStr, u"m");
 
-                    if (match.hasMatch()) {
-                        dive->setMeanDepth(match.captured(1).toDouble());
+                    if (!std::isnan(value)) {
+                        dive->setMeanDepth(value);
                     }
                 }
                 while (!(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == QStringLiteral("depth"))) {
@@ -396,12 +666,11 @@ void SubsurfaceParser::parseDiveComputerElement(QXmlStreamReader &xml, DiveData
             } else if (elementName == "temperature") {
                 QXmlStreamAttributes attrs = xml.attributes();
                 if (attrs.hasAttribute("water")) {
-                    QString tempStr = attrs.value("water").toString();
-                    QRegularExpression tempRe("(\\d+\\.?\\d*)\\s+C");
-                    QRegularExpressionMatch match = tempRe.match(tempStr);
+                    const QStringView tempStr = attrs.value("water");
+                    const double value = parse_utils::scanUnitValue(tempStr, u"C");
 
-                    if (match.hasMatch()) {
-                        lastTemperature = match.captured(1).toDouble();
+                    if (!std::isnan(value)) {
+                        lastTemperature = value;
                     }
                 }
                 while (!(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == QStringLiteral("temperature"))) {
@@ -413,16 +682,13 @@ void SubsurfaceParser::parseDiveComputerElement(QXmlStreamReader &xml, DiveData
 
                 if (eventAttrs.hasAttribute("name") && eventAttrs.value("name") == QStringLiteral("gaschange")) {
                     if (eventAttrs.hasAttribute("time") && eventAttrs.hasAttribute("cylinder")) {
-                        QString timeStr = eventAttrs.value("time").toString();
+                        const QStringView timeStr = eventAttrs.value("time");
                         double timestamp = 0.0;
 
-                        QRegularExpression timeRe("(\\d+):(\\d+)\\s+min");
-                        QRegularExpressionMatch match = timeRe.match(timeStr);
+                        const double seconds = parse_utils::scanMinutesSeconds(timeStr);
 
-                        if (match.hasMatch()) {
-                            int minutes = match.captured(1).toInt();
-                            int seconds = match.captured(2).toInt();
-                            timestamp = minutes * 60 + seconds;
+                        if (!std::isnan(seconds)) {
+                            timestamp = seconds;
                         } else {
                             bool ok;
                             timestamp = timeStr.toDouble(&ok);
@@ -433,7 +699,7 @@ void SubsurfaceParser::parseDiveComputerElement(QXmlStreamReader &xml, DiveData
 
                         dive->addGasSwitch(timestamp, cylinderIndex);
 
-                        qDebug() << "Parsed gas switch at time" << timestamp
+                        qCDebug(lcParse) << "Parsed gas switch at time" << timestamp
                                  << "to cylinder" << cylinderIndex;
                     }
                 }
@@ -446,16 +712,19 @@ void SubsurfaceParser::parseDiveComputerElement(QXmlStreamReader &xml, DiveData
         }
     }
 
+    dive->appendDataPoints(samples);
+
     std::sort(m_gasSwitches.begin(), m_gasSwitches.end(),
               [](const GasSwitch &a, const GasSwitch &b) {
                   return a.timestamp < b.timestamp;
               });
 
-    qDebug() << "Finished parsing divecomputer element with" << sampleCount << "samples";
+    qCDebug(lcParse) << "Finished parsing divecomputer element with" << sampleCount << "samples";
 }
 
 void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
                                           DiveData *dive,
+                                          QVector<DiveDataPoint> &samples,
                                           double &lastTemperature,
                                           double &lastNDL,
                                           double &lastTTS,
@@ -470,14 +739,11 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
     bool inDeco = false;
 
     if (attrs.hasAttribute("time")) {
-        QString timeStr = attrs.value("time").toString();
-        QRegularExpression timeRe("(\\d+):(\\d+)\\s+min");
-        QRegularExpressionMatch match = timeRe.match(timeStr);
-
-        if (match.hasMatch()) {
-            int minutes = match.captured(1).toInt();
-            int seconds = match.captured(2).toInt();
-            point.timestamp = minutes * 60 + seconds;
+        const QStringView timeStr = attrs.value("time");
+        const double seconds = parse_utils::scanMinutesSeconds(timeStr);
+
+        if (!std::isnan(seconds)) {
+            point.timestamp = seconds;
             hasData = true;
         } else {
             bool ok;
@@ -490,12 +756,11 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
     }
 
     if (attrs.hasAttribute("depth")) {
-        QString depthStr = attrs.value("depth").toString();
-        QRegularExpression depthRe("(\\d+\\.?\\d*)\\s+m");
-        QRegularExpressionMatch match = depthRe.match(depthStr);
+        const QStringView depthStr = attrs.value("depth");
+        const double value = parse_utils::scanUnitValue(depthStr, u"m");
 
-        if (match.hasMatch()) {
-            point.depth = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            point.depth = value;
             hasData = true;
         } else {
             bool ok;
@@ -508,12 +773,11 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
     }
 
     if (attrs.hasAttribute("temp")) {
-        QString tempStr = attrs.value("temp").toString();
-        QRegularExpression tempRe("(\\d+\\.?\\d*)\\s+C");
-        QRegularExpressionMatch match = tempRe.match(tempStr);
+        const QStringView tempStr = attrs.value("temp");
+        const double value = parse_utils::scanUnitValue(tempStr, u"C");
 
-        if (match.hasMatch()) {
-            point.temperature = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            point.temperature = value;
             lastTemperature = point.temperature;
             hasData = true;
         } else {
@@ -532,12 +796,11 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
     }
 
     if (attrs.hasAttribute("pressure")) {
-        QString pressureStr = attrs.value("pressure").toString();
-        QRegularExpression pressureRe("(\\d+\\.?\\d*)\\s+bar");
-        QRegularExpressionMatch match = pressureRe.match(pressureStr);
+        const QStringView pressureStr = attrs.value("pressure");
+        const double value = parse_utils::scanUnitValue(pressureStr, u"bar");
 
-        if (match.hasMatch()) {
-            double pressure = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            double pressure = value;
             point.addPressure(pressure, 0);
             hasData = true;
         } else {
@@ -550,16 +813,15 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
         }
     }
 
-    for (int i = 0; i < 10; i++) {
-        QString pressureAttr = QString("pressure%1").arg(i);
+    for (int i = 0; i < kMaxPressureAttributes; i++) {
+        const QLatin1String pressureAttr = kPressureAttributes[i];
 
         if (attrs.hasAttribute(pressureAttr)) {
-            QString pressureStr = attrs.value(pressureAttr).toString();
-            QRegularExpression pressureRe("(\\d+\\.?\\d*)\\s+bar");
-            QRegularExpressionMatch match = pressureRe.match(pressureStr);
+            const QStringView pressureStr = attrs.value(pressureAttr);
+            const double value = parse_utils::scanUnitValue(pressureStr, u"bar");
 
-            if (match.hasMatch()) {
-                double pressure = match.captured(1).toDouble();
+            if (!std::isnan(value)) {
+                double pressure = value;
                 point.addPressure(pressure, i);
                 lastPressures[i] = pressure;
                 hasData = true;
@@ -575,16 +837,15 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
         }
     }
 
-    for (int i = 1; i <= 4; i++) {
-        QString sensorAttr = QString("sensor%1").arg(i);
+    for (int i = 1; i <= kMaxSensorAttributes; i++) {
+        const QLatin1String sensorAttr = kSensorAttributes[i - 1];
 
         if (attrs.hasAttribute(sensorAttr)) {
-            QString sensorStr = attrs.value(sensorAttr).toString();
-            QRegularExpression sensorRe("(\\d+\\.?\\d*)\\s+bar");
-            QRegularExpressionMatch match = sensorRe.match(sensorStr);
+            const QStringView sensorStr = attrs.value(sensorAttr);
+            const double value = parse_utils::scanUnitValue(sensorStr, u"bar");
 
-            if (match.hasMatch()) {
-                double sensorValue = match.captured(1).toDouble();
+            if (!std::isnan(value)) {
+                double sensorValue = value;
                 point.addPO2Sensor(sensorValue, i - 1);
                 lastPO2Sensors[i - 1] = sensorValue;
                 m_currentDiveHasCcrCues = true;
@@ -606,7 +867,8 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
         int sensorIndex = it.key();
         double lastValue = it.value();
 
-        bool sensorSet = attrs.hasAttribute(QString("sensor%1").arg(sensorIndex + 1));
+        bool sensorSet = sensorIndex < kMaxSensorAttributes
+            && attrs.hasAttribute(kSensorAttributes[sensorIndex]);
 
         if (!sensorSet && lastValue > 0.0) {
             point.addPO2Sensor(lastValue, sensorIndex);
@@ -618,7 +880,7 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
         if (i == 0) {
             pressureSet = attrs.hasAttribute("pressure") || attrs.hasAttribute("pressure0");
         } else {
-            pressureSet = attrs.hasAttribute(QString("pressure%1").arg(i));
+            pressureSet = i < kMaxPressureAttributes && attrs.hasAttribute(kPressureAttributes[i]);
         }
 
         if (!pressureSet && lastPressures.contains(i)) {
@@ -632,14 +894,11 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
     }
 
     if (attrs.hasAttribute("tts")) {
-        QString ttsStr = attrs.value("tts").toString();
-        QRegularExpression ttsRe("(\\d+):(\\d+)\\s+min");
-        QRegularExpressionMatch match = ttsRe.match(ttsStr);
-
-        if (match.hasMatch()) {
-            int minutes = match.captured(1).toInt();
-            int seconds = match.captured(2).toInt();
-            point.tts = minutes + seconds / 60.0;
+        const QStringView ttsStr = attrs.value("tts");
+        const double seconds = parse_utils::scanMinutesSeconds(ttsStr);
+
+        if (!std::isnan(seconds)) {
+            point.tts = seconds / 60.0;
             lastTTS = point.tts;
             hasData = true;
         } else {
@@ -658,14 +917,11 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
     }
 
     if (attrs.hasAttribute("ndl")) {
-        QString ndlStr = attrs.value("ndl").toString();
-        QRegularExpression ndlRe("(\\d+):(\\d+)\\s+min");
-        QRegularExpressionMatch match = ndlRe.match(ndlStr);
-
-        if (match.hasMatch()) {
-            int minutes = match.captured(1).toInt();
-            int seconds = match.captured(2).toInt();
-            point.ndl = minutes + seconds / 60.0;
+        const QStringView ndlStr = attrs.value("ndl");
+        const double seconds = parse_utils::scanMinutesSeconds(ndlStr);
+
+        if (!std::isnan(seconds)) {
+            point.ndl = seconds / 60.0;
             lastNDL = point.ndl;
             hasData = true;
         } else {
@@ -684,12 +940,11 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
     }
 
     if (attrs.hasAttribute("cns")) {
-        QString cnsStr = attrs.value("cns").toString();
-        QRegularExpression cnsRe("(\\d+\\.?\\d*)\\s*%");
-        QRegularExpressionMatch match = cnsRe.match(cnsStr);
+        const QStringView cnsStr = attrs.value("cns");
+        const double value = parse_utils::scanUnitValue(cnsStr, u"%", false);
 
-        if (match.hasMatch()) {
-            point.cns = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            point.cns = value;
             lastCNS = point.cns;
             hasData = true;
         } else {
@@ -720,21 +975,20 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
     }
 
     if (attrs.hasAttribute("stopdepth")) {
-        QString stopDepthStr = attrs.value("stopdepth").toString();
-        QRegularExpression stopDepthRe("(\\d+\\.?\\d*)\\s+m");
-        QRegularExpressionMatch match = stopDepthRe.match(stopDepthStr);
+        const QStringView stopDepthStr = attrs.value("stopdepth");
+        const double value = parse_utils::scanUnitValue(stopDepthStr, u"m");
 
-        if (match.hasMatch()) {
-            point.ceiling = match.captured(1).toDouble();
+        if (!std::isnan(value)) {
+            point.ceiling = value;
             m_lastCeiling = point.ceiling;
-            qDebug() << "Parsed stopdepth:" << point.ceiling << "m for time:" << point.timestamp;
+            qCDebug(lcParse) << "Parsed stopdepth:" << point.ceiling << "m for time:" << point.timestamp;
         } else {
             bool ok;
             double stopDepth = stopDepthStr.toDouble(&ok);
             if (ok) {
                 point.ceiling = stopDepth;
                 m_lastCeiling = point.ceiling;
-                qDebug() << "Parsed stopdepth (numeric):" << point.ceiling << "m for time:" << point.timestamp;
+                qCDebug(lcParse) << "Parsed stopdepth (numeric):" << point.ceiling << "m for time:" << point.timestamp;
             }
         }
     } else {
@@ -744,14 +998,11 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
     // Subsurface samples are delta-encoded: stoptime can appear with or
     // without stopdepth, so it carries forward independently of the ceiling
     if (attrs.hasAttribute("stoptime")) {
-        QString stopTimeStr = attrs.value("stoptime").toString();
-        QRegularExpression stopTimeRe("(\\d+):(\\d+)\\s+min");
-        QRegularExpressionMatch match = stopTimeRe.match(stopTimeStr);
-
-        if (match.hasMatch()) {
-            int minutes = match.captured(1).toInt();
-            int seconds = match.captured(2).toInt();
-            point.stopTime = minutes + seconds / 60.0;
+        const QStringView stopTimeStr = attrs.value("stoptime");
+        const double seconds = parse_utils::scanMinutesSeconds(stopTimeStr);
+
+        if (!std::isnan(seconds)) {
+            point.stopTime = seconds / 60.0;
             m_lastStopTime = point.stopTime;
             hasData = true;
         } else {
@@ -767,12 +1018,14 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
         point.stopTime = m_lastStopTime;
     }
 
-    if (hasData) {
+    // Only count and trace samples when the category is enabled: the tank
+    // and sensor loops below would otherwise run for every sample
+    if (hasData && lcParse().isDebugEnabled()) {
         static int sampleCount = 0;
         sampleCount++;
 
         if (sampleCount <= 5 || sampleCount % 20 == 0) {
-            qDebug() << "Sample #" << sampleCount
+            qCDebug(lcParse) << "Sample #" << sampleCount
                      << "time=" << point.timestamp
                      << "depth=" << point.depth
                      << "temp=" << point.temperature << "(lastTemp=" << lastTemperature << ")"
@@ -780,19 +1033,21 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
                      << "tts=" << point.tts << "(lastTTS=" << lastTTS << ")"
                      << "in_deco=" << inDeco;
             for (int i = 0; i < point.tankCount(); i++) {
-                qDebug() << "  Tank" << i << "pressure=" << point.getPressure(i)
+                qCDebug(lcParse) << "  Tank" << i << "pressure=" << point.getPressure(i)
                          << "(last=" << lastPressures.value(i, 0.0) << ")";
             }
             for (int i = 0; i < point.po2SensorCount(); i++) {
-                qDebug() << "  Sensor" << (i + 1) << "PO2=" << point.getPO2Sensor(i)
+                qCDebug(lcParse) << "  Sensor" << (i + 1) << "PO2=" << point.getPO2Sensor(i)
                          << "(last=" << lastPO2Sensors.value(i, 0.0) << ")";
             }
             if (point.po2SensorCount() > 0) {
-                qDebug() << "  Composite PO2=" << point.getCompositePO2();
+                qCDebug(lcParse) << "  Composite PO2=" << point.getCompositePO2();
             }
         }
+    }
 
-        dive->addDataPoint(point);
+    if (hasData) {
+        samples.append(point);
     }
 
     while (!(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == QStringLiteral("sample"))) {
@@ -803,7 +1058,7 @@ void SubsurfaceParser::parseSampleElement(QXmlStreamReader &xml,
 
 void SubsurfaceParser::parseDiveSites(QXmlStreamReader &xml)
 {
-    qDebug() << "Parsing divesites element";
+    qCDebug(lcParse) << "Parsing divesites element";
 
     while (!xml.atEnd()) {
         xml.readNext();
@@ -834,7 +1089,7 @@ void SubsurfaceParser::parseDiveSites(QXmlStreamReader &xml)
 
             if (!site.uuid.isEmpty()) {
                 m_diveSites[site.uuid] = site;
-                qDebug() << "Parsed dive site:" << site.name << "UUID:" << site.uuid;
+                qCDebug(lcParse) << "Parsed dive site:" << site.name << "UUID:" << site.uuid;
             }
 
             while (!(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == QStringLiteral("site"))) {
@@ -844,5 +1099,5 @@ void SubsurfaceParser::parseDiveSites(QXmlStreamReader &xml)
         }
     }
 
-    qDebug() << "Finished parsing divesites, found" << m_diveSites.size() << "sites";
+    qCDebug(lcParse) << "Finished parsing divesites, found" << m_diveSites.size() << "sites";
 }
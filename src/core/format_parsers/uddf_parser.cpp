@@ -1,16 +1,21 @@
 #include "include/core/format_parsers/uddf_parser.h"
 
-#include <QDebug>
+#include <QMutex>
 #include <QSet>
 #include <QStringList>
+#include <QThread>
+#include <QtConcurrent>
 
 #include <cmath>
 
+#include "include/core/format_parsers/decompressing_device.h"
 #include "include/core/format_parsers/parse_utils.h"
+#include "include/core/logging.h"
+#include "include/core/format_parsers/xml_dive_index.h"
 
 UDDFParser::UDDFParser() = default;
 
-bool UDDFParser::canParse(QFile &file) const
+bool UDDFParser::canParse(QIODevice &file) const
 {
     const qint64 originalPos = file.pos();
     file.seek(0);
@@ -37,8 +42,25 @@ void UDDFParser::resetState()
     m_currentDiveOcSeen = false;
 }
 
-QList<DiveData *> UDDFParser::parse(QFile &file, int specificDive, QString &errorOut)
+QList<DiveData *> UDDFParser::parse(QIODevice &file, int specificDive, QString &errorOut)
 {
+    XmlDiveIndex index;
+    if (specificDive != -1) {
+        if (loadIndex(file, index)) {
+            return parseIndexedDive(file, index, specificDive, errorOut);
+        }
+    } else {
+        // Split first, then parse the dives on the thread pool
+        file.seek(0);
+        notifyReadingWholeLog();
+        const QByteArray data = file.readAll();
+        if (file.atEnd()
+            && index.scan(data, QLatin1String("dive"),
+                          {QLatin1String("gasdefinitions"), QLatin1String("divesite")})) {
+            return parseDivesInParallel(data, index, errorOut);
+        }
+    }
+
     QList<DiveData *> result;
 
     file.seek(0);
@@ -67,20 +89,76 @@ QList<DiveData *> UDDFParser::parse(QFile &file, int specificDive, QString &erro
 
     if (xml.hasError()) {
         errorOut = QStringLiteral("UDDF parsing error: %1").arg(xml.errorString());
-        qDebug() << "UDDF parsing error:" << xml.errorString();
+        qCDebug(lcParse) << "UDDF parsing error:" << xml.errorString();
         qDeleteAll(result);
         result.clear();
         return result;
     }
 
-    qDebug() << "Finished parsing UDDF file, found" << result.size() << "dives";
+    qCDebug(lcParse) << "Finished parsing UDDF file, found" << result.size() << "dives";
     return result;
 }
 
-QList<QString> UDDFParser::listDives(QFile &file, QString &errorOut)
+bool UDDFParser::parseChanged(QIODevice &file,
+                              const QSet<QByteArray> &known,
+                              QList<QByteArray> &hashesOut,
+                              QList<DiveData *> &divesOut,
+                              QString &errorOut)
+{
+    file.seek(0);
+    notifyReadingWholeLog();
+    const QByteArray data = file.readAll();
+    XmlDiveIndex index;
+    if (!file.atEnd()
+        || !index.scan(data, QLatin1String("dive"),
+                       {QLatin1String("gasdefinitions"), QLatin1String("divesite")})) {
+        return false;
+    }
+
+    hashesOut = index.diveHashes(data, QLatin1String("id"), {QLatin1String("ref")});
+    XmlDiveIndex changed = index;
+    changed.dives.clear();
+    for (qsizetype i = 0; i < hashesOut.size(); ++i) {
+        if (!known.contains(hashesOut[i])) {
+            changed.dives.append(index.dives[i]);
+        }
+    }
+
+    QList<DiveData *> parsed;
+    if (!changed.dives.isEmpty()) {
+        parsed = parseDivesInParallel(data, changed, errorOut);
+        if (!errorOut.isEmpty()) {
+            return true;
+        }
+    }
+    // A dive range that yielded no dive would misalign the result; let the
+    // caller parse the whole log instead
+    if (parsed.size() != changed.dives.size()) {
+        qDeleteAll(parsed);
+        return false;
+    }
+
+    divesOut.clear();
+    auto next = parsed.cbegin();
+    for (const QByteArray &hash : std::as_const(hashesOut)) {
+        divesOut.append(known.contains(hash) ? nullptr : *next++);
+    }
+    qCDebug(lcParse) << "Re-parsed" << parsed.size() << "of" << hashesOut.size() << "dives";
+    return true;
+}
+
+QList<QString> UDDFParser::listDives(QIODevice &file, QString &errorOut)
 {
     QList<QString> result;
 
+    XmlDiveIndex index;
+    if (loadIndex(file, index)) {
+        for (const XmlDiveIndex::Dive &dive : std::as_const(index.dives)) {
+            result.append(dive.label);
+        }
+        return result;
+    }
+
     file.seek(0);
     QXmlStreamReader xml(&file);
 
@@ -92,84 +170,282 @@ QList<QString> UDDFParser::listDives(QFile &file, QString &errorOut)
         }
 
         if (xml.name() == QStringLiteral("site")) {
-            QString siteId = xml.attributes().value(QStringLiteral("id")).toString();
-            QString siteName;
-            while (!xml.atEnd()) {
-                xml.readNext();
-                if (xml.tokenType() == QXmlStreamReader::EndElement
-                    && xml.name() == QStringLiteral("site")) {
-                    break;
-                }
-                if (xml.tokenType() == QXmlStreamReader::StartElement
-                    && xml.name() == QStringLiteral("name")
-                    && siteName.isEmpty()) {
-                    siteName = xml.readElementText();
-                }
-            }
-            if (!siteId.isEmpty()) {
-                siteNames.insert(siteId, siteName);
-            }
+            listSiteName(xml, siteNames);
         } else if (xml.name() == QStringLiteral("dive")) {
-            QString diveNumber;
-            QString datetime;
-            QString siteRef;
+            int number = -1;
+            result.append(listEntry(xml, siteNames, number));
+        }
+    }
 
-            while (!xml.atEnd()) {
-                xml.readNext();
-                if (xml.tokenType() == QXmlStreamReader::EndElement
-                    && xml.name() == QStringLiteral("dive")) {
-                    break;
-                }
-                if (xml.tokenType() == QXmlStreamReader::StartElement) {
-                    if (xml.name() == QStringLiteral("divenumber")) {
-                        diveNumber = xml.readElementText();
-                    } else if (xml.name() == QStringLiteral("datetime")) {
-                        datetime = xml.readElementText();
-                    } else if (xml.name() == QStringLiteral("link") && siteRef.isEmpty()) {
-                        const QString ref = xml.attributes().value(QStringLiteral("ref")).toString();
-                        if (siteNames.contains(ref)) {
-                            siteRef = ref;
-                        }
-                    } else if (xml.name() == QStringLiteral("samples")
-                               || xml.name() == QStringLiteral("informationafterdive")) {
-                        // We have everything we need — skip the rest of the dive cheaply.
-                        xml.skipCurrentElement();
-                    }
-                }
-            }
+    if (xml.hasError()) {
+        errorOut = QStringLiteral("UDDF parsing error: %1").arg(xml.errorString());
+        result.clear();
+    }
 
-            QString entry;
-            if (!diveNumber.isEmpty()) {
-                entry = QStringLiteral("Dive #%1").arg(diveNumber);
-            } else {
-                entry = QStringLiteral("Dive");
-            }
-            if (!datetime.isEmpty()) {
-                const QDateTime dt = parse_utils::parseISO8601(datetime);
-                if (dt.isValid()) {
-                    entry += " - " + dt.toString(QStringLiteral("yyyy-MM-dd hh:mm:ss"));
-                } else {
-                    entry += " - " + datetime;
+    return result;
+}
+
+void UDDFParser::listSiteName(QXmlStreamReader &xml, QMap<QString, QString> &siteNames)
+{
+    QString siteId = xml.attributes().value(QStringLiteral("id")).toString();
+    QString siteName;
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (xml.tokenType() == QXmlStreamReader::EndElement
+            && xml.name() == QStringLiteral("site")) {
+            break;
+        }
+        if (xml.tokenType() == QXmlStreamReader::StartElement
+            && xml.name() == QStringLiteral("name")
+            && siteName.isEmpty()) {
+            siteName = xml.readElementText();
+        }
+    }
+    if (!siteId.isEmpty()) {
+        siteNames.insert(siteId, siteName);
+    }
+}
+
+QString UDDFParser::listEntry(QXmlStreamReader &xml,
+                              const QMap<QString, QString> &siteNames,
+                              int &number)
+{
+    QString diveNumber;
+    QString datetime;
+    QString siteRef;
+
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (xml.tokenType() == QXmlStreamReader::EndElement
+            && xml.name() == QStringLiteral("dive")) {
+            break;
+        }
+        if (xml.tokenType() == QXmlStreamReader::StartElement) {
+            if (xml.name() == QStringLiteral("divenumber")) {
+                diveNumber = xml.readElementText();
+            } else if (xml.name() == QStringLiteral("datetime")) {
+                datetime = xml.readElementText();
+            } else if (xml.name() == QStringLiteral("link") && siteRef.isEmpty()) {
+                const QString ref = xml.attributes().value(QStringLiteral("ref")).toString();
+                if (siteNames.contains(ref)) {
+                    siteRef = ref;
                 }
+            } else if (xml.name() == QStringLiteral("samples")
+                       || xml.name() == QStringLiteral("informationafterdive")) {
+                // We have everything we need — stop before the samples.
+                break;
             }
-            if (!siteRef.isEmpty()) {
-                const QString name = siteNames.value(siteRef);
-                if (!name.isEmpty()) {
-                    entry += " at " + name;
-                }
+        }
+    }
+
+    bool ok = false;
+    number = diveNumber.toInt(&ok);
+    if (!ok) {
+        number = -1;
+    }
+
+    QString entry;
+    if (!diveNumber.isEmpty()) {
+        entry = QStringLiteral("Dive #%1").arg(diveNumber);
+    } else {
+        entry = QStringLiteral("Dive");
+    }
+    if (!datetime.isEmpty()) {
+        const QDateTime dt = parse_utils::parseISO8601(datetime);
+        if (dt.isValid()) {
+            entry += " - " + dt.toString(QStringLiteral("yyyy-MM-dd hh:mm:ss"));
+        } else {
+            entry += " - " + datetime;
+        }
+    }
+    if (!siteRef.isEmpty()) {
+        const QString name = siteNames.value(siteRef);
+        if (!name.isEmpty()) {
+            entry += " at " + name;
+        }
+    }
+    return entry;
+}
+
+bool UDDFParser::loadIndex(QIODevice &file, XmlDiveIndex &index)
+{
+    // Logs read from anything but a file (or a compressed file) are
+    // indexed every time
+    const QString path = DecompressingDevice::fileName(file);
+    if (!path.isEmpty() && index.load(path, formatName())) {
+        return true;
+    }
+
+    file.seek(0);
+    const QByteArray data = file.readAll();
+    if (!file.atEnd()
+        || !index.scan(data, QLatin1String("dive"),
+                       {QLatin1String("gasdefinitions"), QLatin1String("divesite")})) {
+        return false;
+    }
+
+    QMap<QString, QString> siteNames;
+    for (const XmlDiveIndex::Range &range : std::as_const(index.shared)) {
+        QXmlStreamReader xml(index.fragment(data, range));
+        xml.setNamespaceProcessing(false);
+        while (!xml.atEnd() && !xml.hasError()) {
+            if (xml.readNext() == QXmlStreamReader::StartElement
+                && xml.name() == QStringLiteral("site")) {
+                listSiteName(xml, siteNames);
             }
-            result.append(entry);
+        }
+    }
+
+    for (XmlDiveIndex::Dive &dive : index.dives) {
+        QXmlStreamReader xml(index.fragment(data, dive.range));
+        xml.setNamespaceProcessing(false);
+        if (xml.readNextStartElement()) {
+            dive.label = listEntry(xml, siteNames, dive.number);
+        }
+        if (xml.hasError()) {
+            qCDebug(lcParse) << "Not indexing" << path << "-" << xml.errorString();
+            return false;
+        }
+    }
+
+    if (!path.isEmpty()) {
+        index.save(path, formatName());
+    }
+    qCDebug(lcParse) << "Indexed" << index.dives.size() << "UDDF dives in" << path;
+    return true;
+}
+
+QList<DiveData *> UDDFParser::parseIndexedDive(QIODevice &file,
+                                               const XmlDiveIndex &index,
+                                               int diveNumber,
+                                               QString &errorOut)
+{
+    QList<DiveData *> result;
+
+    const XmlDiveIndex::Dive *entry = index.find(diveNumber);
+    if (!entry) {
+        return result;
+    }
+
+    resetState();
+    for (const XmlDiveIndex::Range &range : index.shared) {
+        QXmlStreamReader xml(index.fragment(file, range));
+        xml.setNamespaceProcessing(false);
+        if (!xml.readNextStartElement()) {
+            continue;
+        }
+        if (xml.name() == QStringLiteral("gasdefinitions")) {
+            parseGasDefinitions(xml);
+        } else {
+            parseDiveSiteContainer(xml);
+        }
+    }
+
+    QXmlStreamReader xml(index.fragment(file, entry->range));
+    xml.setNamespaceProcessing(false);
+    if (xml.readNextStartElement()) {
+        DiveData *dive = parseDiveElement(xml);
+        if (dive) {
+            result.append(dive);
         }
     }
 
     if (xml.hasError()) {
         errorOut = QStringLiteral("UDDF parsing error: %1").arg(xml.errorString());
+        qCDebug(lcParse) << "UDDF parsing error:" << xml.errorString();
+        qDeleteAll(result);
         result.clear();
     }
 
     return result;
 }
 
+QList<DiveData *> UDDFParser::parseDivesInParallel(const QByteArray &data,
+                                                   const XmlDiveIndex &index,
+                                                   QString &errorOut)
+{
+    resetState();
+    for (const XmlDiveIndex::Range &range : index.shared) {
+        QXmlStreamReader xml(index.fragment(data, range));
+        xml.setNamespaceProcessing(false);
+        if (!xml.readNextStartElement()) {
+            continue;
+        }
+        if (xml.name() == QStringLiteral("gasdefinitions")) {
+            parseGasDefinitions(xml);
+        } else {
+            parseDiveSiteContainer(xml);
+        }
+    }
+
+    struct ParsedDive {
+        DiveData *dive = nullptr;
+        QString error;
+    };
+
+    // Each dive gets its own copy of the parser: the mix and site tables are
+    // shared read-only, the per-dive state is not shared at all
+    QThread *owner = QThread::currentThread();
+    QMutex progressMutex;
+    qsizetype parsedCount = 0;
+    auto parseOne = [&](const XmlDiveIndex::Dive &entry) {
+        ParsedDive parsed;
+        // Dives not started yet are skipped once the caller cancels
+        if (isCancelled()) {
+            return parsed;
+        }
+        UDDFParser parser(*this);
+        QXmlStreamReader xml(index.fragment(data, entry.range));
+        xml.setNamespaceProcessing(false);
+        if (xml.readNextStartElement()) {
+            parsed.dive = parser.parseDiveElement(xml);
+        }
+        if (xml.hasError()) {
+            parsed.error = xml.errorString();
+            delete parsed.dive;
+            parsed.dive = nullptr;
+        }
+        if (parsed.dive) {
+            parsed.dive->moveToThread(owner);
+        }
+        if (m_observer.divesParsed) {
+            QMutexLocker locker(&progressMutex);
+            m_observer.divesParsed(++parsedCount, index.dives.size());
+        }
+        return parsed;
+    };
+    const QList<ParsedDive> parsed =
+        QtConcurrent::blockingMapped<QList<ParsedDive>>(index.dives, parseOne);
+
+    if (isCancelled()) {
+        for (const ParsedDive &entry : parsed) {
+            delete entry.dive;
+        }
+        errorOut = QStringLiteral("Parse cancelled");
+        return {};
+    }
+
+    QList<DiveData *> result;
+    result.reserve(parsed.size());
+    for (const ParsedDive &entry : parsed) {
+        if (!entry.error.isEmpty() && errorOut.isEmpty()) {
+            errorOut = QStringLiteral("UDDF parsing error: %1").arg(entry.error);
+            qCDebug(lcParse) << "UDDF parsing error:" << entry.error;
+        }
+        if (entry.dive) {
+            result.append(entry.dive);
+        }
+    }
+    if (!errorOut.isEmpty()) {
+        qDeleteAll(result);
+        result.clear();
+        return result;
+    }
+
+    qCDebug(lcParse) << "Finished parsing UDDF file, found" << result.size() << "dives";
+    return result;
+}
+
 void UDDFParser::parseGasDefinitions(QXmlStreamReader &xml)
 {
     while (!xml.atEnd()) {
@@ -214,7 +490,7 @@ void UDDFParser::parseGasDefinitions(QXmlStreamReader &xml)
 
         if (!mixId.isEmpty()) {
             m_mixes.insert(mixId, mix);
-            qDebug() << "Parsed UDDF mix" << mixId
+            qCDebug(lcParse) << "Parsed UDDF mix" << mixId
                      << "O2:" << mix.o2Percent << "% He:" << mix.hePercent << "%";
         }
     }
@@ -268,7 +544,7 @@ void UDDFParser::parseDiveSiteEntry(QXmlStreamReader &xml)
 
     if (!site.id.isEmpty()) {
         m_diveSites.insert(site.id, site);
-        qDebug() << "Parsed UDDF dive site" << site.id << ":" << site.name;
+        qCDebug(lcParse) << "Parsed UDDF dive site" << site.id << ":" << site.name;
     }
 }
 
@@ -357,7 +633,7 @@ DiveData *UDDFParser::parseDiveElement(QXmlStreamReader &xml)
     // header-only UDDF), seed a single point at t=0 with each cylinder's
     // initial pressure so downstream rendering doesn't see a totally empty
     // profile. Mirrors the SSRF parser's identical safeguard.
-    if (dive->allDataPoints().isEmpty() && dive->cylinderCount() > 0) {
+    if (dive->sampleCount() == 0 && dive->cylinderCount() > 0) {
         DiveDataPoint initialPoint;
         initialPoint.timestamp = 0.0;
 
@@ -385,8 +661,8 @@ DiveData *UDDFParser::parseDiveElement(QXmlStreamReader &xml)
         }
     }
 
-    qDebug() << "Finished parsing UDDF dive" << dive->diveName()
-             << "data points:" << dive->allDataPoints().size()
+    qCDebug(lcParse) << "Finished parsing UDDF dive" << dive->diveName()
+             << "data points:" << dive->sampleCount()
              << "cylinders:" << dive->cylinderCount()
              << "diveMode:" << dive->diveMode();
     return dive;
@@ -515,7 +791,7 @@ void UDDFParser::parseTankData(QXmlStreamReader &xml, DiveData *dive)
         m_mixToFirstTank.insert(mixRef, newIndex);
     }
 
-    qDebug() << "Parsed UDDF tank index" << newIndex
+    qCDebug(lcParse) << "Parsed UDDF tank index" << newIndex
              << "mix:" << mixRef
              << "size:" << cylinder.size << "L"
              << "start:" << cylinder.startPressure << "bar"
@@ -541,6 +817,8 @@ void UDDFParser::parseSamples(QXmlStreamReader &xml, DiveData *dive)
     // waypoints reuse the same index even if sensors appear in a different
     // order or some are omitted.
     QMap<QString, int> po2SensorRefToIndex;
+    // Collected here and handed to the dive in one batch at the end
+    QVector<DiveDataPoint> samples;
 
     // Pre-seed lastPressures from each cylinder's start (or work) pressure,
     // so the first waypoints carry sensible values even before any
@@ -567,15 +845,18 @@ void UDDFParser::parseSamples(QXmlStreamReader &xml, DiveData *dive)
         }
         if (xml.tokenType() == QXmlStreamReader::StartElement
             && xml.name() == QStringLiteral("waypoint")) {
-            parseWaypoint(xml, dive, lastTemperature, lastNDL, lastTTS, lastCeiling,
+            parseWaypoint(xml, dive, samples, lastTemperature, lastNDL, lastTTS, lastCeiling,
                           lastStopTime, lastCNS, lastPressures, lastPO2Sensors,
                           po2SensorRefToIndex);
         }
     }
+
+    dive->appendDataPoints(samples);
 }
 
 void UDDFParser::parseWaypoint(QXmlStreamReader &xml,
                                DiveData *dive,
+                               QVector<DiveDataPoint> &samples,
                                double &lastTemperature,
                                double &lastNDL,
                                double &lastTTS,
@@ -804,7 +1085,7 @@ void UDDFParser::parseWaypoint(QXmlStreamReader &xml,
         if (tankIdx >= 0) {
             dive->addGasSwitch(point.timestamp, tankIdx);
         } else {
-            qDebug() << "UDDF switchmix references unknown mix:" << ref;
+            qCDebug(lcParse) << "UDDF switchmix references unknown mix:" << ref;
         }
     }
 
@@ -826,7 +1107,7 @@ void UDDFParser::parseWaypoint(QXmlStreamReader &xml,
     }
 
     if (hasTimestamp) {
-        dive->addDataPoint(point);
+        samples.append(point);
     }
 }
 
@@ -0,0 +1,471 @@
+#include "include/core/format_parsers/xml_dive_index.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr quint32 kCacheMagic = 0x55444958; // "UDIX"
+constexpr qint32 kCacheVersion = 2;
+
+bool startsAt(const QByteArray &data, qsizetype pos, const char *text)
+{
+    const qsizetype length = static_cast<qsizetype>(std::strlen(text));
+    return pos + length <= data.size() && std::memcmp(data.constData() + pos, text, length) == 0;
+}
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isNameChar(char c)
+{
+    return !isSpace(c) && c != '>' && c != '/';
+}
+
+// End of a markup token starting at 'from': the matching '>' outside quoted
+// attribute values (and, for DOCTYPE, outside the internal subset), or -1
+qsizetype tagEnd(const QByteArray &data, qsizetype from)
+{
+    const char *p = data.constData();
+    char quote = 0;
+    int brackets = 0;
+    for (qsizetype i = from; i < data.size(); ++i) {
+        const char c = p[i];
+        if (quote) {
+            if (c == quote) {
+                quote = 0;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '[') {
+            ++brackets;
+        } else if (c == ']') {
+            --brackets;
+        } else if (c == '>' && brackets <= 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// One start, end or empty-element tag: [begin, end) spans it from '<' to
+// past '>', [nameBegin, nameEnd) is the element name
+struct Tag {
+    qsizetype begin = 0;
+    qsizetype nameBegin = 0;
+    qsizetype nameEnd = 0;
+    qsizetype end = 0;
+    bool closing = false;
+    bool selfClosing = false;
+};
+
+// Calls visit(tag) for each tag in data[from, to), skipping comments, CDATA
+// sections, processing instructions and declarations, until visit returns
+// false. Returns false on markup that is never terminated.
+template <typename Visit>
+bool forEachTag(const QByteArray &data, qsizetype from, qsizetype to, Visit visit)
+{
+    const char *p = data.constData();
+    qsizetype pos = from;
+    while (pos < to) {
+        const qsizetype lt = data.indexOf('<', pos);
+        if (lt < 0 || lt >= to) {
+            return true;
+        }
+
+        if (startsAt(data, lt, "<!--")) {
+            const qsizetype end = data.indexOf("-->", lt + 4);
+            if (end < 0) {
+                return false;
+            }
+            pos = end + 3;
+            continue;
+        }
+        if (startsAt(data, lt, "<![CDATA[")) {
+            const qsizetype end = data.indexOf("]]>", lt + 9);
+            if (end < 0) {
+                return false;
+            }
+            pos = end + 3;
+            continue;
+        }
+        if (startsAt(data, lt, "<?")) {
+            const qsizetype end = data.indexOf("?>", lt + 2);
+            if (end < 0) {
+                return false;
+            }
+            pos = end + 2;
+            continue;
+        }
+        if (startsAt(data, lt, "<!")) {
+            const qsizetype end = tagEnd(data, lt + 2);
+            if (end < 0) {
+                return false;
+            }
+            pos = end + 1;
+            continue;
+        }
+
+        Tag tag;
+        tag.begin = lt;
+        tag.closing = lt + 1 < data.size() && p[lt + 1] == '/';
+        tag.nameBegin = lt + (tag.closing ? 2 : 1);
+        tag.nameEnd = tag.nameBegin;
+        while (tag.nameEnd < data.size() && isNameChar(p[tag.nameEnd])) {
+            ++tag.nameEnd;
+        }
+        const qsizetype gt = tagEnd(data, tag.nameEnd);
+        if (gt < 0) {
+            return false;
+        }
+        tag.end = gt + 1;
+        tag.selfClosing = !tag.closing && p[gt - 1] == '/';
+        pos = tag.end;
+
+        if (!visit(tag)) {
+            return true;
+        }
+    }
+    return true;
+}
+
+// Value of the attribute 'name' on a start tag, or empty if it has none
+QByteArray attributeValue(const QByteArray &data, const Tag &tag, QLatin1String name)
+{
+    const char *p = data.constData();
+    const qsizetype end = tag.end - 1;
+    qsizetype i = tag.nameEnd;
+    while (i < end) {
+        while (i < end && isSpace(p[i])) {
+            ++i;
+        }
+        const qsizetype nameBegin = i;
+        while (i < end && p[i] != '=' && isNameChar(p[i])) {
+            ++i;
+        }
+        const qsizetype nameEnd = i;
+        while (i < end && isSpace(p[i])) {
+            ++i;
+        }
+        if (i >= end || p[i] != '=') {
+            // The '/' of an empty-element tag, or stray text
+            i = qMax(i, nameEnd + 1);
+            continue;
+        }
+        ++i;
+        while (i < end && isSpace(p[i])) {
+            ++i;
+        }
+        if (i >= end || (p[i] != '"' && p[i] != '\'')) {
+            return QByteArray();
+        }
+        const char quote = p[i++];
+        const qsizetype valueBegin = i;
+        while (i < end && p[i] != quote) {
+            ++i;
+        }
+        if (nameEnd - nameBegin == name.size()
+            && std::memcmp(p + nameBegin, name.data(), name.size()) == 0) {
+            return data.mid(valueBegin, i - valueBegin);
+        }
+        ++i;
+    }
+    return QByteArray();
+}
+
+QString cacheFilePath(const QString &path, const QString &format)
+{
+    const QByteArray key = (QFileInfo(path).absoluteFilePath() + QLatin1Char('\n') + format).toUtf8();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + QStringLiteral("/dive-index/")
+           + QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex())
+           + QStringLiteral(".idx");
+}
+
+} // namespace
+
+bool XmlDiveIndex::scan(const QByteArray &data,
+                        QLatin1String diveElement,
+                        const QList<QLatin1String> &sharedElements)
+{
+    prolog = Range();
+    shared.clear();
+    dives.clear();
+
+    // Offsets are found byte-wise, which needs an ASCII-compatible encoding
+    if (data.startsWith("\xFF\xFE") || data.startsWith("\xFE\xFF") || data.left(4).contains('\0')) {
+        return false;
+    }
+
+    const char *p = data.constData();
+    int depth = 0;
+    bool rootOpened = false;
+    bool rootClosed = false;
+    bool malformed = false;
+
+    // The dive or shared element currently being measured
+    qsizetype openBegin = -1;
+    int openDepth = -1;
+    bool openIsDive = false;
+
+    auto record = [this](bool isDive, qsizetype begin, qsizetype end) {
+        const Range range{begin, end};
+        if (isDive) {
+            Dive dive;
+            dive.range = range;
+            dives.append(dive);
+        } else {
+            shared.append(range);
+        }
+    };
+
+    const bool terminated = forEachTag(data, 0, data.size(), [&](const Tag &tag) {
+        if (tag.closing) {
+            if (--depth < 0) {
+                malformed = true;
+                return false;
+            }
+            if (openBegin >= 0 && depth == openDepth) {
+                record(openIsDive, openBegin, tag.end);
+                openBegin = -1;
+            }
+            rootClosed = (depth == 0);
+            return !rootClosed;
+        }
+
+        if (!rootOpened) {
+            rootOpened = true;
+            prolog = Range{0, tag.begin};
+        } else if (openBegin < 0) {
+            auto matches = [&](QLatin1String name) {
+                return tag.nameEnd - tag.nameBegin == name.size()
+                       && std::memcmp(p + tag.nameBegin, name.data(), name.size()) == 0;
+            };
+            bool isShared = false;
+            for (const QLatin1String &name : sharedElements) {
+                isShared = isShared || matches(name);
+            }
+            const bool isDive = matches(diveElement);
+            if (isDive || isShared) {
+                if (tag.selfClosing) {
+                    record(isDive, tag.begin, tag.end);
+                } else {
+                    openBegin = tag.begin;
+                    openDepth = depth;
+                    openIsDive = isDive;
+                }
+            }
+        }
+
+        if (!tag.selfClosing) {
+            ++depth;
+        } else if (depth == 0) {
+            rootClosed = true;
+        }
+        return !rootClosed;
+    });
+
+    // A truncated read (or cancelled import) must not produce an index
+    return terminated && !malformed && rootClosed && openBegin < 0;
+}
+
+QByteArray XmlDiveIndex::fragment(const QByteArray &data, const Range &range) const
+{
+    return data.mid(prolog.begin, prolog.end - prolog.begin)
+           + data.mid(range.begin, range.end - range.begin);
+}
+
+QByteArray XmlDiveIndex::fragment(QIODevice &file, const Range &range) const
+{
+    QByteArray out;
+    if (file.seek(prolog.begin)) {
+        out += file.read(prolog.end - prolog.begin);
+    }
+    if (file.seek(range.begin)) {
+        out += file.read(range.end - range.begin);
+    }
+    return out;
+}
+
+QList<QByteArray> XmlDiveIndex::diveHashes(const QByteArray &data,
+                                           QLatin1String idAttribute,
+                                           const QList<QLatin1String> &refAttributes) const
+{
+    const QByteArrayView bytes(data);
+    auto slice = [&bytes](const Range &range) {
+        return bytes.sliced(range.begin, range.end - range.begin);
+    };
+
+    // Each definition by id: the children of the shared elements that
+    // carry one
+    QHash<QByteArray, Range> definitions;
+    for (const Range &range : shared) {
+        int depth = 0;
+        Range child{-1, -1};
+        QByteArray childId;
+        forEachTag(data, range.begin, range.end, [&](const Tag &tag) {
+            if (tag.closing) {
+                if (--depth == 1 && child.begin >= 0) {
+                    child.end = tag.end;
+                    definitions.insert(childId, child);
+                    child.begin = -1;
+                }
+                return true;
+            }
+            if (depth == 1) {
+                const QByteArray id = attributeValue(data, tag, idAttribute);
+                if (!id.isEmpty() && tag.selfClosing) {
+                    definitions.insert(id, Range{tag.begin, tag.end});
+                } else if (!id.isEmpty()) {
+                    child.begin = tag.begin;
+                    childId = id;
+                }
+            }
+            if (!tag.selfClosing) {
+                ++depth;
+            }
+            return true;
+        });
+    }
+
+    QList<QByteArray> hashes;
+    hashes.reserve(dives.size());
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QList<QByteArray> refs;
+    for (const Dive &dive : dives) {
+        refs.clear();
+        forEachTag(data, dive.range.begin, dive.range.end, [&](const Tag &tag) {
+            if (!tag.closing) {
+                for (const QLatin1String &attribute : refAttributes) {
+                    const QByteArray ref = attributeValue(data, tag, attribute);
+                    if (!ref.isEmpty()) {
+                        refs.append(ref);
+                    }
+                }
+            }
+            return true;
+        });
+        std::sort(refs.begin(), refs.end());
+        refs.erase(std::unique(refs.begin(), refs.end()), refs.end());
+
+        hash.reset();
+        hash.addData(slice(prolog));
+        hash.addData(slice(dive.range));
+        for (const QByteArray &ref : std::as_const(refs)) {
+            const auto definition = definitions.constFind(ref);
+            if (definition != definitions.cend()) {
+                hash.addData(slice(*definition));
+            }
+        }
+        hashes.append(hash.result());
+    }
+    return hashes;
+}
+
+const XmlDiveIndex::Dive *XmlDiveIndex::find(int number, bool unnumberedMatches) const
+{
+    for (const Dive &dive : dives) {
+        if (dive.number == number || (unnumberedMatches && dive.unnumbered)) {
+            return &dive;
+        }
+    }
+    return nullptr;
+}
+
+bool XmlDiveIndex::load(const QString &path, const QString &format)
+{
+    const QFileInfo info(path);
+    QFile cache(cacheFilePath(path, format));
+    if (!info.exists() || !cache.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&cache);
+    quint32 magic = 0;
+    qint32 version = 0;
+    qint64 size = -1;
+    qint64 modified = 0;
+    in >> magic >> version >> size >> modified;
+    if (magic != kCacheMagic || version != kCacheVersion || size != info.size()
+        || modified != info.lastModified().toMSecsSinceEpoch()) {
+        return false;
+    }
+
+    auto readRange = [&in, size](Range &range) {
+        in >> range.begin >> range.end;
+        return range.begin >= 0 && range.begin <= range.end && range.end <= size;
+    };
+
+    Range cachedProlog;
+    QList<Range> cachedShared;
+    QList<Dive> cachedDives;
+    qint32 count = 0;
+
+    bool valid = readRange(cachedProlog);
+    in >> count;
+    for (qint32 i = 0; valid && i < count && in.status() == QDataStream::Ok; ++i) {
+        Range range;
+        valid = readRange(range);
+        cachedShared.append(range);
+    }
+    in >> count;
+    for (qint32 i = 0; valid && i < count && in.status() == QDataStream::Ok; ++i) {
+        Dive dive;
+        valid = readRange(dive.range);
+        qint32 number = -1;
+        in >> number >> dive.unnumbered >> dive.label;
+        dive.number = number;
+        cachedDives.append(dive);
+    }
+    if (!valid || in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    prolog = cachedProlog;
+    shared = cachedShared;
+    dives = cachedDives;
+    return true;
+}
+
+void XmlDiveIndex::save(const QString &path, const QString &format) const
+{
+    const QFileInfo info(path);
+    const QString cachePath = cacheFilePath(path, format);
+    if (!QDir().mkpath(QFileInfo(cachePath).absolutePath())) {
+        return;
+    }
+
+    // Written to the side and renamed, so a concurrent reader never sees
+    // half an index
+    QSaveFile cache(cachePath);
+    if (!cache.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream out(&cache);
+    out << kCacheMagic << kCacheVersion << qint64(info.size())
+        << qint64(info.lastModified().toMSecsSinceEpoch());
+    out << prolog.begin << prolog.end;
+    out << qint32(shared.size());
+    for (const Range &range : shared) {
+        out << range.begin << range.end;
+    }
+    out << qint32(dives.size());
+    for (const Dive &dive : dives) {
+        out << dive.range.begin << dive.range.end << qint32(dive.number) << dive.unnumbered
+            << dive.label;
+    }
+    cache.commit();
+}
@@ -1,12 +1,100 @@
 #include "include/core/log_parser.h"
 
-#include <QDebug>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QtConcurrent>
 
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "include/core/dive_cache.h"
+#include "include/core/format_parsers/decompressing_device.h"
 #include "include/core/format_parsers/fit_parser.h"
 #include "include/core/format_parsers/subsurface_parser.h"
 #include "include/core/format_parsers/uddf_parser.h"
+#include "include/core/logging.h"
+
+namespace {
+
+// QFile that reports how far into the file the parser has read, and fails
+// further reads once the import is cancelled. Parsers only ever see a
+// QFile; a failed read ends their parse the way a truncated file would.
+class ImportFile : public QFile
+{
+public:
+    using ProgressFn = std::function<void(qint64 done, qint64 total)>;
+
+    ImportFile(const QString &path, const std::atomic<bool> &cancel, ProgressFn progress)
+        : QFile(path)
+        , m_cancel(cancel)
+        , m_progress(std::move(progress))
+    {
+    }
+
+    bool seek(qint64 pos) override
+    {
+        m_offset = pos;
+        return QFile::seek(pos);
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        if (m_cancel.load(std::memory_order_relaxed)) {
+            setErrorString(QStringLiteral("Import cancelled"));
+            return -1;
+        }
+        const qint64 read = QFile::readData(data, maxSize);
+        if (read > 0) {
+            m_offset += read;
+            if (m_progress) {
+                m_progress(m_offset, size());
+            }
+        }
+        return read;
+    }
+
+private:
+    const std::atomic<bool> &m_cancel;
+    ProgressFn m_progress;
+    qint64 m_offset = 0;
+};
+
+// Quiet period after a change to the watched logbook before re-reading it,
+// so a save that writes in several steps is picked up once, complete
+constexpr int kRefreshDelayMs = 500;
+
+// Progress shown for reading a log that is parsed only once all of it is
+// in memory; parsing its dives makes up the rest
+constexpr int kWholeLogReadPercent = 10;
+
+// The dive among 'candidates' that 'dive' is a re-read of: the one with the
+// same start time or, failing that, the same number. Taken out of
+// 'candidates' so each old dive is replaced at most once.
+DiveData *takePreviousVersion(const DiveData *dive, QList<DiveData *> &candidates)
+{
+    auto it = candidates.end();
+    if (dive->startTime().isValid()) {
+        it = std::find_if(candidates.begin(), candidates.end(), [dive](const DiveData *old) {
+            return old->startTime() == dive->startTime();
+        });
+    }
+    if (it == candidates.end() && dive->diveNumber() > 0) {
+        it = std::find_if(candidates.begin(), candidates.end(), [dive](const DiveData *old) {
+            return old->diveNumber() == dive->diveNumber();
+        });
+    }
+    if (it == candidates.end()) {
+        return nullptr;
+    }
+    DiveData *old = *it;
+    candidates.erase(it);
+    return old;
+}
+
+} // namespace
 
 LogParser::LogParser(QObject *parent)
     : QObject(parent)
@@ -15,11 +103,33 @@ LogParser::LogParser(QObject *parent)
     m_parsers.push_back(std::make_unique<SubsurfaceParser>());
     m_parsers.push_back(std::make_unique<UDDFParser>());
     m_parsers.push_back(std::make_unique<FitParser>());
+
+    connect(&m_watcher, &QFutureWatcher<ImportResult>::finished, this, [this]() {
+        m_asyncPending = false;
+        finishImport(m_watcher.result(), m_asyncDiveNumber);
+    });
+
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(kRefreshDelayMs);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &LogParser::refreshLogbook);
+    connect(&m_fileWatcher, &QFileSystemWatcher::fileChanged, this, &LogParser::onWatchedPathChanged);
+    connect(&m_fileWatcher, &QFileSystemWatcher::directoryChanged, this, &LogParser::onWatchedPathChanged);
 }
 
-LogParser::~LogParser() = default;
+LogParser::~LogParser()
+{
+    // The worker uses our parsers; never let it outlive them
+    if (m_asyncPending) {
+        m_cancelRequested = true;
+        m_watcher.waitForFinished();
+        qDeleteAll(m_watcher.result().dives);
+    }
+    if (m_heldRefresh) {
+        qDeleteAll(m_heldRefresh->result.dives);
+    }
+}
 
-IDiveLogFormatParser *LogParser::selectParser(QFile &file)
+IDiveLogFormatParser *LogParser::selectParser(QIODevice &file)
 {
     for (const auto &parser : m_parsers) {
         if (parser->canParse(file)) {
@@ -29,71 +139,144 @@ IDiveLogFormatParser *LogParser::selectParser(QFile &file)
     return nullptr;
 }
 
+QIODevice *LogParser::openLog(QFile &file,
+                              std::unique_ptr<DecompressingDevice> &decompressor,
+                              QString &errorOut)
+{
+    // Compressed logs are decoded as they are read, never unpacked to disk
+    const DecompressingDevice::Codec codec = DecompressingDevice::detect(&file);
+    if (codec == DecompressingDevice::None) {
+        return &file;
+    }
+
+    qCDebug(lcParse) << "Reading" << DecompressingDevice::codecName(codec) << "compressed log";
+    decompressor = std::make_unique<DecompressingDevice>(&file, codec);
+    if (!decompressor->open(QIODevice::ReadOnly)) {
+        errorOut = tr("Could not read compressed file: %1 - Error: %2")
+                       .arg(QFileInfo(file.fileName()).fileName(), decompressor->errorString());
+        return nullptr;
+    }
+    return decompressor.get();
+}
+
 bool LogParser::importFile(const QString &filePath)
 {
-    qDebug() << "LogParser::importFile called with path:" << filePath;
+    qCDebug(lcParse) << "LogParser::importFile called with path:" << filePath;
 
-    if (m_busy) {
-        m_lastError = tr("Already processing a file");
-        emit errorOccurred(m_lastError);
+    if (!beginImport()) {
         return false;
     }
+    return finishImport(runImport(filePath, -1, thread()), -1);
+}
 
-    m_busy = true;
-    emit busyChanged();
+bool LogParser::importDive(const QString &filePath, int diveNumber)
+{
+    if (!beginImport()) {
+        return false;
+    }
+    return finishImport(runImport(filePath, diveNumber, thread()), diveNumber);
+}
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        m_lastError = tr("Could not open file: %1 - Error: %2").arg(filePath).arg(file.errorString());
-        qDebug() << "File open error:" << m_lastError;
-        emit errorOccurred(m_lastError);
+bool LogParser::importFileAsync(const QString &filePath)
+{
+    qCDebug(lcParse) << "LogParser::importFileAsync called with path:" << filePath;
+    return startAsync(filePath, -1);
+}
+
+bool LogParser::importDiveAsync(const QString &filePath, int diveNumber)
+{
+    return startAsync(filePath, diveNumber);
+}
+
+void LogParser::cancelImport()
+{
+    if (m_busy && !m_queuedImport.filePath.isEmpty()) {
+        // Still waiting for a refresh to wind down; it never started
+        m_queuedImport = QueuedImport();
         m_busy = false;
         emit busyChanged();
-        return false;
+        emit importCancelled();
+        return;
+    }
+    if (m_busy || m_refreshing) {
+        m_cancelRequested = true;
     }
+}
 
-    IDiveLogFormatParser *parser = selectParser(file);
-    if (!parser) {
-        m_lastError = tr("Unsupported file format: %1").arg(QFileInfo(filePath).fileName());
-        qDebug() << "Unsupported file format:" << filePath;
+bool LogParser::beginImport(bool background)
+{
+    if (m_busy || m_refreshing) {
+        m_lastError = tr("Already processing a file");
         emit errorOccurred(m_lastError);
-        file.close();
-        m_busy = false;
-        emit busyChanged();
         return false;
     }
 
-    qDebug() << "Selected parser:" << parser->formatName();
-    QString parserError;
-    QList<DiveData *> dives = parser->parse(file, -1, parserError);
-    file.close();
-
-    bool success = parserError.isEmpty();
-    if (!success) {
-        m_lastError = parserError;
-        emit errorOccurred(m_lastError);
-        qDeleteAll(dives);
-        dives.clear();
-    } else if (dives.size() == 1) {
-        qDebug() << "Emitting diveImported signal for dive:" << dives.first()->diveName();
-        emit diveImported(dives.first());
-    } else if (dives.size() > 1) {
-        qDebug() << "Emitting multipleImported signal with" << dives.size() << "dives";
-        emit multipleImported(dives);
+    m_cancelRequested = false;
+    if (background) {
+        m_refreshing = true;
+        emit refreshingChanged();
     } else {
-        m_lastError = tr("No dives found in file");
-        qDebug() << "No dives found in file";
-        emit errorOccurred(m_lastError);
-        success = false;
+        m_busy = true;
+        emit busyChanged();
+        setProgress(0);
     }
+    return true;
+}
 
-    m_busy = false;
-    emit busyChanged();
+bool LogParser::startAsync(const QString &filePath, int diveNumber, bool watched, bool background)
+{
+    if (m_refreshing && !m_busy) {
+        // A refresh of the watched logbook gives way: cancel it and start
+        // this import once it has wound down (see finishRefresh())
+        m_queuedImport = {filePath, diveNumber, watched, background};
+        m_cancelRequested = true;
+        if (!background) {
+            m_busy = true;
+            emit busyChanged();
+            setProgress(0);
+        }
+        return true;
+    }
+    if (!beginImport(background)) {
+        return false;
+    }
+    launchAsync(filePath, diveNumber, watched, background);
+    return true;
+}
 
-    return success;
+void LogParser::launchAsync(const QString &filePath, int diveNumber, bool watched, bool background)
+{
+    QSet<QByteArray> known;
+    for (const WatchedDive &dive : std::as_const(m_watchedDives)) {
+        if (dive.dive) {
+            known.insert(dive.hash);
+        }
+    }
+
+    m_asyncPending = true;
+    m_asyncDiveNumber = diveNumber;
+    m_importWatched = watched;
+    m_importBackground = background;
+    m_adoptCurrent = watched && background && !m_watchReady;
+    QThread *owner = thread();
+    m_watcher.setFuture(QtConcurrent::run([this, filePath, diveNumber, owner, watched, known]() {
+        return runImport(filePath, diveNumber, owner, watched ? &known : nullptr);
+    }));
 }
 
-bool LogParser::importDive(const QString &filePath, int diveNumber)
+void LogParser::startQueuedImport()
+{
+    const QueuedImport queued = std::exchange(m_queuedImport, QueuedImport());
+    m_cancelRequested = false;
+    if (queued.background) {
+        m_refreshing = true;
+        emit refreshingChanged();
+    }
+    // A user-visible import has been 'busy' since it was queued
+    launchAsync(queued.filePath, queued.diveNumber, queued.watched, queued.background);
+}
+
+bool LogParser::watchLogbook(const QString &filePath)
 {
     if (m_busy) {
         m_lastError = tr("Already processing a file");
@@ -101,86 +284,526 @@ bool LogParser::importDive(const QString &filePath, int diveNumber)
         return false;
     }
 
-    m_busy = true;
-    emit busyChanged();
+    stopWatching();
+    m_watchedPath = filePath;
+    // The directory too: editors that save by replacing the file leave the
+    // watcher with a path that no longer exists
+    m_fileWatcher.addPath(filePath);
+    m_fileWatcher.addPath(QFileInfo(filePath).absolutePath());
+    emit watchedLogbookChanged();
 
-    QFile file(filePath);
+    // The current logbook's dives are already with the receiver; take them
+    // over in the background rather than importing them a second time
+    const bool adopt = !m_currentLogbook.isEmpty()
+                       && QFileInfo(filePath) == QFileInfo(m_currentLogbook)
+                       && std::any_of(m_currentDives.cbegin(), m_currentDives.cend(),
+                                      [](const QPointer<DiveData> &dive) { return !dive.isNull(); });
+
+    qCDebug(lcParse) << "Watching logbook" << filePath << (adopt ? "(current)" : "");
+    return startAsync(filePath, -1, true, adopt);
+}
+
+void LogParser::stopWatching()
+{
+    if (m_watchedPath.isEmpty()) {
+        return;
+    }
+    if (m_importWatched) {
+        m_cancelRequested = true;
+    }
+    if (m_queuedImport.background) {
+        m_queuedImport = QueuedImport();
+    }
+    if (m_heldRefresh) {
+        qDeleteAll(m_heldRefresh->result.dives);
+        m_heldRefresh.reset();
+    }
+
+    const QStringList paths = m_fileWatcher.files() + m_fileWatcher.directories();
+    if (!paths.isEmpty()) {
+        m_fileWatcher.removePaths(paths);
+    }
+    m_refreshTimer.stop();
+    m_watchedPath.clear();
+    m_watchedDives.clear();
+    m_watchReady = false;
+    m_refreshPending = false;
+    emit watchedLogbookChanged();
+}
+
+void LogParser::setRefreshHeld(bool held)
+{
+    if (m_refreshHeld == held) {
+        return;
+    }
+    m_refreshHeld = held;
+    emit refreshHeldChanged();
+    if (held) {
+        return;
+    }
+
+    if (m_heldRefresh) {
+        const HeldRefresh refresh = std::move(*m_heldRefresh);
+        m_heldRefresh.reset();
+        qCDebug(lcParse) << "Applying the watched logbook refresh held during the export";
+        applyRefresh(refresh.result, refresh.adopt);
+        if (refresh.adopt && !m_watchReady) {
+            stopWatching();
+            return;
+        }
+    }
+    if (m_refreshPending && !m_busy && !m_refreshing) {
+        m_refreshPending = false;
+        m_refreshTimer.start();
+    }
+}
+
+void LogParser::onWatchedPathChanged()
+{
+    if (m_watchedPath.isEmpty()) {
+        return;
+    }
+    if (!m_fileWatcher.files().contains(m_watchedPath) && QFile::exists(m_watchedPath)) {
+        m_fileWatcher.addPath(m_watchedPath);
+    }
+    m_refreshTimer.start();
+}
+
+void LogParser::refreshLogbook()
+{
+    // Mid-save the file can briefly be missing; the directory change that
+    // brings it back restarts the timer
+    if (m_watchedPath.isEmpty() || !QFile::exists(m_watchedPath)) {
+        return;
+    }
+    // A change during a running import (the watched log's first one
+    // included) or an export is picked up once that is done
+    if (m_busy || m_refreshing || m_refreshHeld) {
+        m_refreshPending = true;
+        return;
+    }
+    if (!m_watchReady) {
+        return;
+    }
+    qCDebug(lcParse) << "Watched logbook changed, re-importing" << m_watchedPath;
+    startAsync(m_watchedPath, -1, true, true);
+}
+
+LogParser::ImportResult LogParser::runImport(const QString &filePath, int diveNumber, QThread *owner,
+                                             const QSet<QByteArray> *knownDives)
+{
+    ImportResult result;
+    result.filePath = filePath;
+
+    // Percent done, forwarded to our own thread and only when it changes:
+    // the share of the file read so far or, for parsers that read all of it
+    // before parsing, mostly the share of its dives parsed
+    int lastPercent = -1;
+    auto publish = [this, &lastPercent](int percent) {
+        if (percent == lastPercent) {
+            return;
+        }
+        lastPercent = percent;
+        if (QThread::currentThread() == thread()) {
+            setProgress(percent);
+        } else {
+            // Dropped if a synchronous import has finished in the meantime
+            QMetaObject::invokeMethod(this, [this, percent]() {
+                if (m_busy) {
+                    setProgress(percent);
+                }
+            }, Qt::QueuedConnection);
+        }
+    };
+    bool wholeLog = false;
+    auto reportProgress = [&publish, &wholeLog](qint64 done, qint64 total) {
+        const qint64 share = wholeLog ? kWholeLogReadPercent : 100;
+        publish(total > 0 ? static_cast<int>(qMin<qint64>(share, done * share / total)) : 0);
+    };
+
+    ImportFile file(filePath, m_cancelRequested, reportProgress);
     if (!file.open(QIODevice::ReadOnly)) {
-        m_lastError = tr("Could not open file: %1").arg(file.errorString());
-        emit errorOccurred(m_lastError);
-        m_busy = false;
-        emit busyChanged();
-        return false;
+        result.error = tr("Could not open file: %1 - Error: %2").arg(filePath).arg(file.errorString());
+        qCDebug(lcParse) << "File open error:" << result.error;
+        return result;
+    }
+
+    // A log that hasn't changed since it was last imported comes straight
+    // from the dive cache. Not for the watched logbook: diffing its
+    // re-imports needs per-dive hashes the cache doesn't have. An unchanged
+    // size and modification time vouch for the content without reading it;
+    // otherwise only whole-log imports hash it, the ones that are cached or
+    // diffed, and a single dive is parsed straight from the log.
+    const QFileInfo source(filePath);
+    QByteArray hash = dive_cache::recordedHash(source);
+    const bool hashed = hash.isEmpty() && diveNumber < 0;
+    if (hashed) {
+        hash = dive_cache::contentHash(file);
+    }
+    if (diveNumber < 0) {
+        result.fileHash = hash;
+    }
+    QList<DiveData *> cached = knownDives ? QList<DiveData *>() : dive_cache::load(filePath, hash);
+    if (!cached.isEmpty()) {
+        qCDebug(lcParse) << "Loaded" << cached.size() << "dives from the dive cache";
+        if (hashed) {
+            // Same content under a new time stamp (copied, touched): record
+            // it, so the next import needn't hash the file again
+            dive_cache::store(source, hash, cached);
+        }
+        for (DiveData *dive : std::as_const(cached)) {
+            if (diveNumber < 0 || (result.dives.isEmpty() && dive->diveNumber() == diveNumber)) {
+                result.dives.append(dive);
+            } else {
+                delete dive;
+            }
+        }
+        for (DiveData *dive : std::as_const(result.dives)) {
+            dive->moveToThread(owner);
+        }
+        return result;
+    }
+
+    std::unique_ptr<DecompressingDevice> decompressor;
+    QIODevice *log = openLog(file, decompressor, result.error);
+    if (!log) {
+        return result;
     }
 
-    IDiveLogFormatParser *parser = selectParser(file);
+    IDiveLogFormatParser *parser = selectParser(*log);
     if (!parser) {
-        m_lastError = tr("Unsupported file format: %1").arg(QFileInfo(filePath).fileName());
-        emit errorOccurred(m_lastError);
-        file.close();
-        m_busy = false;
-        emit busyChanged();
-        return false;
+        result.cancelled = m_cancelRequested;
+        result.error = tr("Unsupported file format: %1").arg(QFileInfo(filePath).fileName());
+        qCDebug(lcParse) << "Unsupported file format:" << filePath;
+        return result;
     }
 
+    qCDebug(lcParse) << "Selected parser:" << parser->formatName();
+    IDiveLogFormatParser::Observer observer;
+    observer.readingWholeLog = [&wholeLog]() { wholeLog = true; };
+    observer.divesParsed = [&publish](qsizetype parsed, qsizetype total) {
+        publish(kWholeLogReadPercent + static_cast<int>((100 - kWholeLogReadPercent) * parsed / total));
+    };
+    observer.cancelled = [this]() { return m_cancelRequested.load(std::memory_order_relaxed); };
+    parser->setObserver(observer);
+
     QString parserError;
-    QList<DiveData *> dives = parser->parse(file, diveNumber, parserError);
+    if (!knownDives
+        || !parser->parseChanged(*log, *knownDives, result.hashes, result.dives, parserError)) {
+        result.hashes.clear();
+        result.dives = parser->parse(*log, diveNumber, parserError);
+        if (knownDives) {
+            // No per-dive hashes for this format: the file's hash stands in
+            // for all its dives, so they are only kept if nothing changed
+            for (qsizetype i = 0; i < result.dives.size(); ++i) {
+                result.hashes.append(hash + QByteArray::number(i));
+            }
+        }
+    }
+    parser->setObserver({});
+    decompressor.reset();
     file.close();
 
-    bool success = parserError.isEmpty();
-    if (!success) {
-        m_lastError = parserError;
+    if (m_cancelRequested || !parserError.isEmpty()) {
+        result.cancelled = m_cancelRequested;
+        result.error = parserError;
+        qDeleteAll(result.dives);
+        result.dives.clear();
+        return result;
+    }
+
+    // Only complete imports are cached, so a cache hit is always the whole log
+    if (diveNumber < 0 && !knownDives && !result.dives.isEmpty()) {
+        dive_cache::store(source, hash, result.dives);
+    }
+
+    // Created on this (possibly worker) thread; hand them to the thread
+    // that will own them before anyone else can touch them
+    for (DiveData *dive : std::as_const(result.dives)) {
+        if (dive) {
+            dive->moveToThread(owner);
+        }
+    }
+    return result;
+}
+
+bool LogParser::finishImport(ImportResult result, int diveNumber)
+{
+    if (m_importBackground) {
+        return finishRefresh(std::move(result));
+    }
+
+    const bool watched = m_importWatched;
+    m_importWatched = false;
+    const bool failed = result.cancelled || m_cancelRequested || !result.error.isEmpty();
+    if (watched && !failed) {
+        // First import of the watched logbook: remember what each dive was
+        for (qsizetype i = 0; i < result.hashes.size(); ++i) {
+            m_watchedDives.append({result.hashes[i], result.dives.value(i)});
+        }
+        result.dives.removeAll(nullptr);
+        m_watchReady = !result.dives.isEmpty();
+    }
+
+    bool success = false;
+    if (result.cancelled || m_cancelRequested) {
+        // Cancelled after the parse already finished: discard it all the same
+        qDeleteAll(result.dives);
+        qCDebug(lcParse) << "Import cancelled";
+        emit importCancelled();
+    } else if (!result.error.isEmpty()) {
+        m_lastError = result.error;
         emit errorOccurred(m_lastError);
-        qDeleteAll(dives);
-        dives.clear();
-    } else if (!dives.isEmpty()) {
-        emit diveImported(dives.first());
+    } else if (diveNumber >= 0) {
+        if (!result.dives.isEmpty()) {
+            setCurrentLogbook(result.filePath, {result.dives.first()}, result.fileHash);
+            emit diveImported(result.dives.first());
+            success = true;
+        } else {
+            m_lastError = tr("Dive number %1 not found in file").arg(diveNumber);
+            emit errorOccurred(m_lastError);
+        }
+    } else if (result.dives.size() == 1) {
+        qCDebug(lcParse) << "Emitting diveImported signal for dive:" << result.dives.first()->diveName();
+        setCurrentLogbook(result.filePath, result.dives, result.fileHash);
+        emit diveImported(result.dives.first());
+        success = true;
+    } else if (result.dives.size() > 1) {
+        qCDebug(lcParse) << "Emitting multipleImported signal with" << result.dives.size() << "dives";
+        setCurrentLogbook(result.filePath, result.dives, result.fileHash);
+        emit multipleImported(result.dives);
+        success = true;
     } else {
-        m_lastError = tr("Dive number %1 not found in file").arg(diveNumber);
+        m_lastError = tr("No dives found in file");
+        qCDebug(lcParse) << "No dives found in file";
         emit errorOccurred(m_lastError);
-        success = false;
     }
 
+    if (success) {
+        setProgress(100);
+    }
+    m_cancelRequested = false;
     m_busy = false;
     emit busyChanged();
 
+    if (watched && !m_watchReady) {
+        // The logbook never imported; there is nothing to keep up to date
+        stopWatching();
+    } else if (m_refreshPending) {
+        m_refreshPending = false;
+        m_refreshTimer.start();
+    }
+
     return success;
 }
 
-QList<QString> LogParser::getDiveList(const QString &filePath)
+bool LogParser::finishRefresh(ImportResult result)
 {
-    QList<QString> result;
+    const bool adopt = m_adoptCurrent;
+    m_importWatched = false;
+    m_importBackground = false;
+    m_adoptCurrent = false;
 
-    if (m_busy) {
-        m_lastError = tr("Already processing a file");
-        emit errorOccurred(m_lastError);
-        return result;
+    bool success = false;
+    if (result.cancelled || m_cancelRequested) {
+        qDeleteAll(result.dives);
+        qCDebug(lcParse) << "Watched logbook refresh cancelled";
+    } else if (!result.error.isEmpty()) {
+        // Typically a read mid-save; the next change triggers another try
+        qCWarning(lcParse) << "Could not re-read the watched logbook:" << result.error;
+        emit refreshFailed(result.error);
+    } else if (m_refreshHeld) {
+        // An export is rendering the current dives; replacing or deleting
+        // them now would pull them out from under it
+        qCDebug(lcParse) << "Watched logbook refresh held until the export is done";
+        m_heldRefresh = HeldRefresh{std::move(result), adopt};
+        success = true;
+    } else {
+        applyRefresh(result, adopt);
+        success = true;
     }
 
-    m_busy = true;
-    emit busyChanged();
+    m_cancelRequested = false;
+    m_refreshing = false;
+    emit refreshingChanged();
+
+    if (!m_queuedImport.filePath.isEmpty()) {
+        startQueuedImport();
+    } else if (adopt && !m_watchReady && !m_heldRefresh) {
+        // Nothing was taken over; there is nothing to keep up to date
+        stopWatching();
+    } else if (m_refreshPending) {
+        m_refreshPending = false;
+        m_refreshTimer.start();
+    }
+    return success;
+}
+
+void LogParser::applyRefresh(const ImportResult &result, bool adopt)
+{
+    if (adopt) {
+        adoptCurrentDives(result);
+    } else {
+        applyLogbookChanges(result);
+    }
+    QList<DiveData *> dives;
+    for (const WatchedDive &watched : std::as_const(m_watchedDives)) {
+        dives.append(watched.dive);
+    }
+    setCurrentLogbook(m_watchedPath, dives, result.fileHash);
+}
+
+void LogParser::applyLogbookChanges(const ImportResult &result)
+{
+    QHash<QByteArray, DiveData *> previous;
+    for (const WatchedDive &watched : std::as_const(m_watchedDives)) {
+        if (watched.dive) {
+            previous.insert(watched.hash, watched.dive);
+        }
+    }
+
+    // Known dives keep their object; everything else is new or changed
+    QList<WatchedDive> current;
+    QList<DiveData *> added;
+    for (qsizetype i = 0; i < result.hashes.size(); ++i) {
+        DiveData *parsed = result.dives.value(i);
+        if (DiveData *kept = previous.take(result.hashes[i])) {
+            // Only formats without per-dive hashes parse known dives again
+            delete parsed;
+            current.append({result.hashes[i], kept});
+        } else if (parsed) {
+            current.append({result.hashes[i], parsed});
+            added.append(parsed);
+        }
+    }
+
+    // Whatever wasn't matched is no longer in the log as it was
+    QList<DiveData *> removed;
+    for (const WatchedDive &watched : std::as_const(m_watchedDives)) {
+        if (watched.dive && previous.value(watched.hash) == watched.dive) {
+            removed.append(watched.dive);
+        }
+    }
+    m_watchedDives = current;
+
+    qCDebug(lcParse) << "Watched logbook:" << added.size() << "dives new or changed,"
+                     << removed.size() << "removed";
+    if (added.isEmpty() && removed.isEmpty()) {
+        return;
+    }
+
+    QList<DiveData *> candidates = removed;
+    for (DiveData *dive : std::as_const(added)) {
+        if (DiveData *old = takePreviousVersion(dive, candidates)) {
+            emit diveReplaced(old, dive);
+        }
+    }
+    emit logbookUpdated(added, removed);
+}
+
+void LogParser::adoptCurrentDives(const ImportResult &result)
+{
+    QList<DiveData *> candidates;
+    for (const QPointer<DiveData> &dive : std::as_const(m_currentDives)) {
+        if (dive) {
+            candidates.append(dive);
+        }
+    }
+
+    // Unchanged since it was imported: the receiver's dives are these very
+    // dives, and keep their objects. Otherwise each re-read dive replaces
+    // the one it is a newer version of.
+    const bool unchanged = !result.fileHash.isEmpty() && result.fileHash == m_currentLogbookHash;
+    QList<DiveData *> added;
+    QList<DiveData *> removed;
+    QList<QPair<DiveData *, DiveData *>> replaced;
+    for (qsizetype i = 0; i < result.hashes.size(); ++i) {
+        DiveData *parsed = result.dives.value(i);
+        if (!parsed) {
+            continue;
+        }
+        DiveData *old = takePreviousVersion(parsed, candidates);
+        if (old && unchanged) {
+            delete parsed;
+            m_watchedDives.append({result.hashes[i], old});
+            continue;
+        }
+        m_watchedDives.append({result.hashes[i], parsed});
+        added.append(parsed);
+        if (old) {
+            removed.append(old);
+            replaced.append({old, parsed});
+        }
+    }
+    // Current dives with no counterpart in the log are gone from it
+    removed.append(candidates);
+    m_watchReady = !m_watchedDives.isEmpty();
+
+    qCDebug(lcParse) << "Watching the current logbook:" << m_watchedDives.size() - added.size()
+                     << "dives taken over," << added.size() << "re-read," << removed.size() << "removed";
+    for (const auto &[oldDive, newDive] : std::as_const(replaced)) {
+        emit diveReplaced(oldDive, newDive);
+    }
+    if (!added.isEmpty() || !removed.isEmpty()) {
+        emit logbookUpdated(added, removed);
+    }
+}
+
+void LogParser::setCurrentLogbook(const QString &filePath, const QList<DiveData *> &dives,
+                                  const QByteArray &fileHash)
+{
+    m_currentDives.clear();
+    for (DiveData *dive : dives) {
+        if (dive) {
+            m_currentDives.append(dive);
+        }
+    }
+    m_currentLogbookHash = fileHash;
+    if (m_currentLogbook != filePath) {
+        m_currentLogbook = filePath;
+        emit currentLogbookChanged();
+    }
+}
+
+void LogParser::setProgress(int percent)
+{
+    if (m_progress != percent) {
+        m_progress = percent;
+        emit progressChanged();
+    }
+}
+
+QList<QString> LogParser::getDiveList(const QString &filePath)
+{
+    // Listing is quick and leaves the parsers' import state alone, so it
+    // neither waits for nor shows up as a running import
+    QList<QString> result;
 
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly)) {
         m_lastError = tr("Could not open file: %1").arg(file.errorString());
         emit errorOccurred(m_lastError);
-        m_busy = false;
-        emit busyChanged();
         return result;
     }
 
-    IDiveLogFormatParser *parser = selectParser(file);
+    std::unique_ptr<DecompressingDevice> decompressor;
+    QIODevice *log = openLog(file, decompressor, m_lastError);
+    if (!log) {
+        emit errorOccurred(m_lastError);
+        return result;
+    }
+
+    IDiveLogFormatParser *parser = selectParser(*log);
     if (!parser) {
         m_lastError = tr("Unsupported file format: %1").arg(QFileInfo(filePath).fileName());
         emit errorOccurred(m_lastError);
         file.close();
-        m_busy = false;
-        emit busyChanged();
         return result;
     }
 
     QString parserError;
-    result = parser->listDives(file, parserError);
+    result = parser->listDives(*log, parserError);
+    decompressor.reset();
     file.close();
 
     if (!parserError.isEmpty()) {
@@ -189,8 +812,5 @@ QList<QString> LogParser::getDiveList(const QString &filePath)
         result.clear();
     }
 
-    m_busy = false;
-    emit busyChanged();
-
     return result;
 }
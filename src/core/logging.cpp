@@ -0,0 +1,8 @@
+#include "include/core/logging.h"
+
+// Info and above by default: warnings still reach the console, debug
+// messages cost nothing unless a logging rule turns them on
+Q_LOGGING_CATEGORY(lcParse, "unabara.parse", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcRender, "unabara.render", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcExport, "unabara.export", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcTimeline, "unabara.timeline", QtInfoMsg)
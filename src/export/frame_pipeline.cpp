@@ -0,0 +1,244 @@
+#include "include/export/frame_pipeline.h"
+#include "include/core/logging.h"
+#include "include/generators/i_frame_generator.h"
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#include <QEventLoop>
+#include <QCoreApplication>
+#include <QBuffer>
+#include <QFile>
+#include <QQueue>
+#include <QThreadPool>
+#include <QtMath>
+#include <filesystem>
+
+FramePipeline::FramePipeline(DiveData* dive, IFrameGenerator* generator)
+    : m_dive(dive)
+    , m_generator(generator)
+    , m_maxInFlight(qMax(2, QThreadPool::globalInstance()->maxThreadCount() * 2))
+{
+}
+
+namespace {
+
+// Pixel content only: scanline padding is excluded
+size_t imageHash(const QImage &image)
+{
+    const qsizetype lineBytes = (qsizetype(image.width()) * image.depth() + 7) / 8;
+    size_t hash = qHashMulti(0, image.width(), image.height(), int(image.format()));
+    for (int y = 0; y < image.height(); ++y) {
+        hash = qHashBits(image.constScanLine(y), lineBytes, hash);
+    }
+    return hash;
+}
+
+} // namespace
+
+void FramePipeline::setMaxInFlight(int frames)
+{
+    m_maxInFlight = qMax(1, frames);
+}
+
+QVector<double> FramePipeline::frameTimes(double startTime, double endTime, double fps)
+{
+    QVector<double> times;
+    if (fps <= 0.0 || endTime < startTime) {
+        return times;
+    }
+
+    // Inclusive of both ends, matching the historical `time <= endTime` loop.
+    // Indexing instead of accumulating 1/fps keeps late frames from drifting;
+    // the epsilon absorbs representation error in e.g. 10.0 * 29.97.
+    const int count = qFloor((endTime - startTime) * fps + 1e-6) + 1;
+    times.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        times.append(startTime + i / fps);
+    }
+    return times;
+}
+
+bool FramePipeline::run(const QVector<double> &times, const Sink &sink)
+{
+    m_block = DiveSampleColumns();
+    m_blockStart = 0;
+    m_recent.clear();
+
+    if (m_generator->supportsConcurrentGenerate() && m_maxInFlight > 1) {
+        return runConcurrent(times, sink);
+    }
+    return runSerial(times, sink);
+}
+
+DiveDataPoint FramePipeline::sampleFor(const QVector<double> &times, int index)
+{
+    if (!m_dive) {
+        return DiveDataPoint();
+    }
+    if (index < m_blockStart || index >= m_blockStart + m_block.size()) {
+        m_blockStart = index;
+        m_block = m_dive->resample(times.mid(index, kResampleBlock));
+    }
+    return m_block.point(index - m_blockStart);
+}
+
+FramePipeline::Frame FramePipeline::renderFrame(int index, double time,
+                                                const DiveDataPoint &sample) const
+{
+    Frame frame;
+    frame.index = index;
+    frame.time = time;
+    frame.image = m_generator->generateFromSample(m_dive, time, sample);
+
+    if (frame.image.isNull()) {
+        return frame;
+    }
+
+    if (m_encoding == Encoding::RawBgra) {
+        encode(frame);
+        QMutexLocker lock(&m_recentMutex);
+        frame.contentId = m_nextContentId++;
+        return frame;
+    }
+
+    // Hashed so a frame is compared in full only against likely matches
+    const QImage rendered = frame.image;
+    const size_t hash = imageHash(rendered);
+    {
+        QMutexLocker lock(&m_recentMutex);
+        for (const RecentFrame &recent : std::as_const(m_recent)) {
+            if (recent.hash == hash && recent.rendered == rendered) {
+                frame.image = recent.encoded.image;
+                frame.data = recent.encoded.data;
+                frame.contentId = recent.encoded.contentId;
+                return frame;
+            }
+        }
+    }
+
+    encode(frame);
+
+    // Two workers may encode the same new content at once; the later one
+    // takes the earlier one's id, so consecutive repeats always share it
+    QMutexLocker lock(&m_recentMutex);
+    for (const RecentFrame &recent : std::as_const(m_recent)) {
+        if (recent.hash == hash && recent.rendered == rendered) {
+            frame.image = recent.encoded.image;
+            frame.data = recent.encoded.data;
+            frame.contentId = recent.encoded.contentId;
+            return frame;
+        }
+    }
+    frame.contentId = m_nextContentId++;
+    if (m_recent.size() == kRecentFrames) {
+        m_recent.removeFirst();
+    }
+    m_recent.append({hash, rendered, frame});
+    return frame;
+}
+
+void FramePipeline::encode(Frame &frame) const
+{
+    switch (m_encoding) {
+    case Encoding::None:
+        break;
+    case Encoding::Png: {
+        QBuffer buffer(&frame.data);
+        buffer.open(QIODevice::WriteOnly);
+        frame.image.save(&buffer, "PNG");
+        frame.image = QImage(); // the sink only needs the bytes
+        break;
+    }
+    case Encoding::RawBgra:
+        if (frame.image.format() != QImage::Format_ARGB32) {
+            frame.image = frame.image.convertToFormat(QImage::Format_ARGB32);
+        }
+        break;
+    }
+}
+
+bool FramePipeline::linkFrameFile(const QString &existing, const QString &path)
+{
+    QFile::remove(path);
+    std::error_code error;
+    std::filesystem::create_hard_link(QFile(existing).filesystemFileName(),
+                                      QFile(path).filesystemFileName(), error);
+    return !error;
+}
+
+QString FramePipeline::summary(const QString &frames, const IFrameGenerator *generator)
+{
+    QStringList parts{frames};
+    if (const QString rendering = generator->exportSummary(); !rendering.isEmpty()) {
+        parts.append(rendering);
+    }
+    qCInfo(lcExport).noquote() << parts.join(QStringLiteral("; "));
+    return parts.join(QStringLiteral("\n"));
+}
+
+bool FramePipeline::runSerial(const QVector<double> &times, const Sink &sink)
+{
+    for (int i = 0; i < times.size(); ++i) {
+        if (!sink(renderFrame(i, times[i], sampleFor(times, i)))) {
+            return false;
+        }
+
+        // Process events to keep UI responsive
+        QCoreApplication::processEvents();
+    }
+    return true;
+}
+
+bool FramePipeline::runConcurrent(const QVector<double> &times, const Sink &sink)
+{
+    // The queue is the reorder buffer: futures are enqueued in frame order and
+    // only the head is ever consumed, so a fast frame N+1 simply waits in its
+    // finished future until frame N has been handed to the sink.
+    QQueue<QFuture<Frame>> inFlight;
+    int next = 0;
+    bool ok = true;
+
+    auto submit = [&]() {
+        while (next < times.size() && inFlight.size() < m_maxInFlight) {
+            const int index = next++;
+            const double time = times[index];
+            const DiveDataPoint sample = sampleFor(times, index);
+            inFlight.enqueue(QtConcurrent::run([this, index, time, sample]() {
+                return renderFrame(index, time, sample);
+            }));
+        }
+    };
+
+    submit();
+    while (!inFlight.isEmpty()) {
+        QFuture<Frame> head = inFlight.head();
+
+        if (!head.isFinished()) {
+            // Wait inside a local event loop rather than blocking, so the UI
+            // (progress bar, cancel button) keeps running during the render.
+            QFutureWatcher<Frame> watcher;
+            QEventLoop loop;
+            QObject::connect(&watcher, &QFutureWatcher<Frame>::finished, &loop, &QEventLoop::quit);
+            watcher.setFuture(head);
+            if (!head.isFinished()) {
+                loop.exec();
+            }
+        }
+
+        inFlight.dequeue();
+        if (!sink(head.result())) {
+            ok = false;
+            break;
+        }
+
+        submit();
+        QCoreApplication::processEvents();
+    }
+
+    // Workers still reference the generator and dive; never return (and let
+    // the caller call endExport()) while any of them is running.
+    for (QFuture<Frame> &future : inFlight) {
+        future.waitForFinished();
+    }
+
+    return ok;
+}
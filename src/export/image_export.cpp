@@ -1,12 +1,14 @@
 #include "include/export/image_export.h"
+#include "include/core/logging.h"
+#include "include/export/frame_pipeline.h"
 #include <QDir>
 #include <QDateTime>
 #include <QStandardPaths>
 #include <QRegularExpression>
 #include <QCoreApplication>
 #include <QThread>
-#include <QDebug>
 #include <QFileInfo>
+#include <QFile>
 
 ImageExporter::ImageExporter(QObject *parent)
     : QObject(parent)
@@ -82,22 +84,26 @@ bool ImageExporter::exportImageRange(DiveData* dive, QObject* generator,
     // editor-only cell backgrounds).
     gen->beginExport();
 
-    // Calculate the number of frames to generate
-    double timeStep = 1.0 / m_frameRate;
-    int totalFrames = qRound((endTime - startTime) * m_frameRate);
+    // Frames render on the thread pool (when the generator allows it) and are
+    // PNG-encoded there too; this thread only writes the bytes, in order.
+    const QVector<double> times = FramePipeline::frameTimes(startTime, endTime, m_frameRate);
+    const int totalFrames = times.size();
     int processedFrames = 0;
 
-    qDebug() << "Exporting images from" << startTime << "to" << endTime
+    qCDebug(lcExport) << "Exporting images from" << startTime << "to" << endTime
              << "at" << m_frameRate << "fps (" << totalFrames << "frames)";
 
-    // Generate and save images
-    for (double time = startTime; time <= endTime; time += timeStep) {
-        // Generate the frame for this time point
-        QImage overlay = gen->generate(dive, time);
+    FramePipeline pipeline(dive, gen);
+    pipeline.setEncoding(FramePipeline::Encoding::Png);
 
-        if (overlay.isNull()) {
-            qWarning() << "Failed to generate frame at time:" << time;
-            continue;
+    qint64 previousContentId = -1;
+    QString previousPath;
+    int linkedFrames = 0;
+
+    bool saved = pipeline.run(times, [&](const FramePipeline::Frame &frame) {
+        if (frame.data.isEmpty()) {
+            qCWarning(lcExport) << "Failed to generate frame at time:" << frame.time;
+            return true;
         }
 
         // Create a filename with the frame number
@@ -105,25 +111,44 @@ bool ImageExporter::exportImageRange(DiveData* dive, QObject* generator,
         QString filename = QString("frame_%1.png").arg(frameNumberStr);
         QString filePath = QDir(m_exportPath).filePath(filename);
 
-        // Save the image
-        if (!overlay.save(filePath, "PNG")) {
-            gen->endExport();
-            emit exportError(tr("Failed to save image: %1").arg(filePath));
-            m_busy = false;
-            emit busyChanged();
-            return false;
+        // A frame identical to the one before becomes a hard link to it
+        // rather than another copy of the same PNG
+        if (frame.contentId == previousContentId && FramePipeline::linkFrameFile(previousPath, filePath)) {
+            linkedFrames++;
+        } else {
+            // An earlier export into this directory may have left a link
+            // here; writing through it would change its sibling frames too
+            QFile::remove(filePath);
+            QFile file(filePath);
+            if (!file.open(QIODevice::WriteOnly) || file.write(frame.data) != frame.data.size()) {
+                emit exportError(tr("Failed to save image: %1").arg(filePath));
+                return false;
+            }
         }
+        previousContentId = frame.contentId;
+        previousPath = filePath;
 
         // Update progress
         processedFrames++;
         m_progress = (processedFrames * 100) / totalFrames;
         emit progressChanged();
+        return true;
+    });
 
-        // Process events to keep UI responsive
-        QCoreApplication::processEvents();
+    if (!saved) {
+        gen->endExport();
+        m_busy = false;
+        emit busyChanged();
+        return false;
     }
 
     gen->endExport();
+    m_summary = FramePipeline::summary(
+        tr("Exported %1 images, %2 of them linked to an identical previous frame")
+            .arg(processedFrames)
+            .arg(linkedFrames),
+        gen);
+    emit summaryChanged();
 
     // Export completed successfully
     m_progress = 100;
@@ -150,7 +175,7 @@ QString ImageExporter::createDefaultExportDir(DiveData* dive,
 
     QDir dir;
     if (!dir.mkpath(path)) {
-        qWarning() << "Failed to create directory:" << path;
+        qCWarning(lcExport) << "Failed to create directory:" << path;
         return QString();
     }
 
@@ -1,14 +1,23 @@
 #include "include/export/video_export.h"
+#include "include/core/logging.h"
+#include "include/export/frame_pipeline.h"
 #include <QDateTime>
 #include <QStandardPaths>
 #include <QRegularExpression>
 #include <QCoreApplication>
 #include <QFileInfo>
-#include <QDebug>
+#include <QFile>
 #include <QTimer>
 #include <QJsonDocument>
 #include <QJsonObject>
 
+namespace {
+// Upper bound on frame data queued in the QProcess write buffer before the
+// renderer waits for FFmpeg to drain it. A few frames is enough to keep the
+// encoder fed without letting a slow codec pile up gigabytes in memory.
+constexpr qint64 kMaxPendingFrameBytes = 64 * 1024 * 1024;
+}
+
 VideoExporter::VideoExporter(QObject *parent)
     : QObject(parent)
     , m_frameRate(30.0)  // Default 30 frames per second for video
@@ -16,6 +25,10 @@ VideoExporter::VideoExporter(QObject *parent)
     , m_videoCodec("vp9") // Default VP9 codec (supports transparency for compositing)
     , m_progress(0)
     , m_busy(false)
+    , m_streamFrames(true)
+    , m_streaming(false)
+    , m_cancelRequested(false)
+    , m_totalFrames(0)
     , m_ffmpegProcess(nullptr)
 {
     // Set default export path to Videos/Unabara folder
@@ -27,7 +40,7 @@ VideoExporter::VideoExporter(QObject *parent)
     
     // Create the temporary directory
     if (!m_tempDir.isValid()) {
-        qWarning() << "Failed to create temporary directory for frame storage";
+        qCWarning(lcExport) << "Failed to create temporary directory for frame storage";
     }
 
     m_progressTimer = new QTimer(this);
@@ -89,6 +102,14 @@ void VideoExporter::setCustomResolution(const QSize &size)
     }
 }
 
+void VideoExporter::setStreamFrames(bool stream)
+{
+    if (m_streamFrames != stream) {
+        m_streamFrames = stream;
+        emit streamFramesChanged();
+    }
+}
+
 bool VideoExporter::isFFmpegAvailable()
 {
     QString ffmpegPath = findFFmpegPath();
@@ -182,8 +203,8 @@ QString VideoExporter::getFileExtensionForCodec(const QString &codec)
 bool VideoExporter::exportVideo(DiveData* dive, QObject* generator,
                               double startTime, double endTime)
 {
-    qDebug() << "======== EXPORT VIDEO CALLED ========";
-    qDebug() << "Parameters:" << startTime << "to" << endTime;
+    qCDebug(lcExport) << "======== EXPORT VIDEO CALLED ========";
+    qCDebug(lcExport) << "Parameters:" << startTime << "to" << endTime;
 
     m_exportStartTime = startTime;
     m_exportEndTime = endTime;
@@ -231,7 +252,23 @@ bool VideoExporter::exportVideo(DiveData* dive, QObject* generator,
         outputPath = generateUniqueFileName(dive, extension);
     }
     m_lastOutputPath = outputPath;
-    
+    m_cancelRequested = false;
+
+    if (m_streamFrames) {
+        // Render and encode in one pass: frames are piped to FFmpeg's stdin
+        // as they are generated. FFmpeg's exit is reported asynchronously by
+        // onFFmpegFinished(), exactly as for the temp-directory path.
+        if (!streamFramesToVideo(dive, gen, startTime, endTime, outputPath)) {
+            if (m_cancelRequested) {
+                emit exportError(tr("Export cancelled by user"));
+            }
+            m_busy = false;
+            emit busyChanged();
+            return false;
+        }
+        return true;
+    }
+
     // Create a new temporary directory for this export
     // Make sure we create a fresh temporary directory for each export attempt
     cleanupTempFiles();
@@ -247,6 +284,9 @@ bool VideoExporter::exportVideo(DiveData* dive, QObject* generator,
     // First generate all the frames
     bool framesGenerated = generateFrames(dive, gen, startTime, endTime);
     if (!framesGenerated) {
+        if (m_cancelRequested) {
+            emit exportError(tr("Export cancelled by user"));
+        }
         cleanupTempFiles();
         m_busy = false;
         emit busyChanged();
@@ -269,8 +309,16 @@ bool VideoExporter::exportVideo(DiveData* dive, QObject* generator,
 
 void VideoExporter::cancelExport()
 {
-    if (m_busy && m_ffmpegProcess) {
-        // Terminate the FFmpeg process gracefully first
+    if (!m_busy || m_cancelRequested) {
+        return;
+    }
+    // Picked up by the frame loops, which run processEvents() between
+    // frames; they report the cancellation and reset 'busy' as they unwind
+    m_cancelRequested = true;
+
+    if (m_ffmpegProcess && m_ffmpegProcess->state() != QProcess::NotRunning) {
+        // Once FFmpeg runs, its exit ends the export: onFFmpegFinished()
+        // reports the cancellation. Terminate gracefully first.
         m_ffmpegProcess->terminate();
         
         // Wait a bit for graceful termination
@@ -278,14 +326,6 @@ void VideoExporter::cancelExport()
             // If it doesn't terminate gracefully, force kill it
             m_ffmpegProcess->kill();
         }
-        
-        emit exportError(tr("Export cancelled by user"));
-        
-        // Clean up any temporary files
-        cleanupTempFiles();
-        
-        m_busy = false;
-        emit busyChanged();
     }
 }
 
@@ -299,11 +339,11 @@ void VideoExporter::cleanupTempFiles()
         QDir dir(tempPath);
         int count = dir.entryList(QDir::Files).count();
         
-        qDebug() << "Cleaning up" << count << "temporary files from" << tempPath;
+        qCDebug(lcExport) << "Cleaning up" << count << "temporary files from" << tempPath;
         
         // Ensure the QTemporaryDir is properly cleaned up
         if (!m_tempDir.remove()) {
-            qWarning() << "Failed to clean up some temporary files. They will be removed when the application exits.";
+            qCWarning(lcExport) << "Failed to clean up some temporary files. They will be removed when the application exits.";
         }
     }
 }
@@ -311,12 +351,12 @@ void VideoExporter::cleanupTempFiles()
 bool VideoExporter::generateFrames(DiveData* dive, IFrameGenerator* generator,
                                  double startTime, double endTime)
 {
-    // Calculate the number of frames to generate
-    double timeStep = 1.0 / m_frameRate;
-    int totalFrames = qRound((endTime - startTime) * m_frameRate);
+    // Calculate the frame timeline
+    const QVector<double> times = FramePipeline::frameTimes(startTime, endTime, m_frameRate);
+    const int totalFrames = times.size();
     int processedFrames = 0;
 
-    qDebug() << "Generating frames from" << startTime << "to" << endTime
+    qCDebug(lcExport) << "Generating frames from" << startTime << "to" << endTime
              << "at" << m_frameRate << "fps (" << totalFrames << "frames)";
 
     // Stage any export-only generator state (e.g. overlay's editor-only
@@ -332,14 +372,22 @@ bool VideoExporter::generateFrames(DiveData* dive, IFrameGenerator* generator,
 
     QString tempDirPath = m_tempDir.path();
 
-    // Generate and save frames
-    for (double time = startTime; time <= endTime; time += timeStep) {
-        // Generate the frame for this time point
-        QImage overlay = generator->generate(dive, time);
+    // Render (and PNG-encode) on the thread pool; save in frame order here
+    FramePipeline pipeline(dive, generator);
+    pipeline.setEncoding(FramePipeline::Encoding::Png);
+
+    qint64 previousContentId = -1;
+    QString previousPath;
+    int linkedFrames = 0;
+
+    bool saved = pipeline.run(times, [&](const FramePipeline::Frame &frame) {
+        if (m_cancelRequested) {
+            return false;
+        }
 
-        if (overlay.isNull()) {
-            qWarning() << "Failed to generate frame at time:" << time;
-            continue;
+        if (frame.data.isEmpty()) {
+            qCWarning(lcExport) << "Failed to generate frame at time:" << frame.time;
+            return true;
         }
 
         // Create a filename with the frame number
@@ -347,27 +395,197 @@ bool VideoExporter::generateFrames(DiveData* dive, IFrameGenerator* generator,
         QString filename = QString("frame_%1.png").arg(frameNumberStr);
         QString filePath = QDir(tempDirPath).filePath(filename);
 
-        // Save the image
-        if (!overlay.save(filePath, "PNG")) {
-            generator->endExport();
-            emit exportError(tr("Failed to save frame: %1").arg(filePath));
-            return false;
+        // A frame identical to the one before becomes a hard link to it
+        // rather than another copy of the same PNG
+        if (frame.contentId == previousContentId && FramePipeline::linkFrameFile(previousPath, filePath)) {
+            linkedFrames++;
+        } else {
+            QFile file(filePath);
+            if (!file.open(QIODevice::WriteOnly) || file.write(frame.data) != frame.data.size()) {
+                emit exportError(tr("Failed to save frame: %1").arg(filePath));
+                return false;
+            }
         }
+        previousContentId = frame.contentId;
+        previousPath = filePath;
 
         // Update progress
         processedFrames++;
         m_progress = (processedFrames * 50) / totalFrames; // Frame generation is 50% of total progress
         emit progressChanged();
+        return true;
+    });
+
+    generator->endExport();
+    m_totalFrames = processedFrames;
+    m_summary = FramePipeline::summary(
+        tr("Generated %1 frames, %2 of them linked to an identical previous frame")
+            .arg(processedFrames)
+            .arg(linkedFrames),
+        generator);
+    emit summaryChanged();
+    return saved;
+}
+
+bool VideoExporter::encodeFramesToVideo(const QString &outputPath)
+{
+    QStringList inputArgs;
+    inputArgs << "-framerate" << QString::number(m_frameRate)
+              << "-i" << QString("%1/frame_%06d.png").arg(m_tempDir.path());
+
+    return startFFmpeg(inputArgs, outputPath);
+}
 
-        // Process events to keep UI responsive
+bool VideoExporter::streamFramesToVideo(DiveData* dive, IFrameGenerator* generator,
+                                        double startTime, double endTime,
+                                        const QString &outputPath)
+{
+    const QVector<double> times = FramePipeline::frameTimes(startTime, endTime, m_frameRate);
+    m_totalFrames = times.size();
+    m_progress = 0;
+    emit progressChanged();
+
+    qCDebug(lcExport) << "Streaming frames from" << startTime << "to" << endTime
+             << "at" << m_frameRate << "fps (" << m_totalFrames << "frames)";
+
+    // QImage::Format_ARGB32 stores each pixel as a native-endian 0xAARRGGBB
+    // word, i.e. B,G,R,A bytes on little-endian hosts.
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const QString pixelFormat = "bgra";
+#else
+    const QString pixelFormat = "argb";
+#endif
+
+    generator->beginExport();
+
+    // Frames render on the thread pool and are converted to ARGB32 there; the
+    // sink below receives them in order and feeds FFmpeg. The rawvideo demuxer
+    // needs the frame size up front, so FFmpeg is launched from the first
+    // frame and every later frame is forced to that size.
+    //
+    // Every frame is piped, repeats of the previous one included: the output
+    // stays constant-rate, because the overlay is cut into other footage and
+    // editors mishandle variable frame rates, so the encoder emits every
+    // frame whatever the input. Nor are repeats looked for; converting a
+    // frame costs less than hashing and comparing it. Only the frame
+    // directory (streamFrames off) saves on them, by linking instead of
+    // writing.
+    FramePipeline pipeline(dive, generator);
+    pipeline.setEncoding(FramePipeline::Encoding::RawBgra);
+
+    QSize frameSize;
+    bool started = false;
+    bool writeFailed = false;
+    int streamedFrames = 0;
+
+    pipeline.run(times, [&](const FramePipeline::Frame &frame) {
+        if (!started) {
+            // Cancelled before the first frame came back: don't launch FFmpeg
+            // just to have it encode an empty stream
+            if (m_cancelRequested) {
+                return false;
+            }
+            if (frame.image.isNull()) {
+                emit exportError(tr("Failed to generate frame at time: %1").arg(frame.time));
+                return false;
+            }
+            frameSize = frame.image.size();
+
+            QStringList inputArgs;
+            inputArgs << "-f" << "rawvideo"
+                      << "-pix_fmt" << pixelFormat
+                      << "-s" << QString("%1x%2").arg(frameSize.width()).arg(frameSize.height())
+                      << "-framerate" << QString::number(m_frameRate)
+                      << "-i" << "-";
+
+            m_streaming = true;
+            if (!startFFmpeg(inputArgs, outputPath)) {
+                m_streaming = false;
+                return false;
+            }
+            started = true;
+            emit statusUpdate(tr("Rendering and encoding video..."));
+        }
+
+        // Cancellation or an FFmpeg failure is reported by cancelExport() /
+        // onFFmpegFinished(); just stop feeding frames.
+        if (m_cancelRequested || m_ffmpegProcess->state() != QProcess::Running) {
+            return false;
+        }
+
+        QImage image = frame.image;
+        if (image.isNull()) {
+            // A gap would shift every later frame in time; send a blank
+            // frame instead so the output keeps its duration.
+            qCWarning(lcExport) << "Failed to generate frame at time:" << frame.time;
+            image = QImage(frameSize, QImage::Format_ARGB32);
+            image.fill(Qt::transparent);
+        } else if (image.size() != frameSize) {
+            image = image.scaled(frameSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+
+        if (!writeFrame(image)) {
+            writeFailed = true;
+            return false;
+        }
+        streamedFrames++;
+
+        if (frame.index % 10 == 0) {
+            emit statusUpdate(tr("Rendering frame %1 of %2").arg(frame.index + 1).arg(m_totalFrames));
+        }
+        return true;
+    });
+
+    generator->endExport();
+
+    if (!started) {
+        return false;
+    }
+    m_summary = FramePipeline::summary(tr("Streamed %1 frames to the encoder").arg(streamedFrames),
+                                       generator);
+    emit summaryChanged();
+
+    // EOF on stdin tells FFmpeg the stream is complete; it then flushes the
+    // encoder and exits, which lands in onFFmpegFinished().
+    if (m_ffmpegProcess->state() == QProcess::Running) {
+        m_ffmpegProcess->closeWriteChannel();
+    }
+
+    if (writeFailed && !m_cancelRequested && m_ffmpegProcess->state() == QProcess::Running) {
+        m_ffmpegProcess->kill();
+    }
+
+    return true;
+}
+
+bool VideoExporter::writeFrame(const QImage &frame)
+{
+    // Straight (non-premultiplied) alpha is what FFmpeg expects for bgra
+    const QImage pixels = frame.format() == QImage::Format_ARGB32
+        ? frame
+        : frame.convertToFormat(QImage::Format_ARGB32);
+
+    // 32bpp scanlines carry no padding, so the whole buffer is one write
+    const char* data = reinterpret_cast<const char*>(pixels.constBits());
+    if (m_ffmpegProcess->write(data, pixels.sizeInBytes()) != pixels.sizeInBytes()) {
+        qCWarning(lcExport) << "Failed to write frame to FFmpeg:" << m_ffmpegProcess->errorString();
+        return false;
+    }
+
+    // Backpressure: block (in short slices, so the UI stays alive) until FFmpeg
+    // has drained the pipe below the high-water mark.
+    while (m_ffmpegProcess->bytesToWrite() > kMaxPendingFrameBytes) {
+        if (m_ffmpegProcess->state() != QProcess::Running || m_cancelRequested) {
+            return true;
+        }
+        m_ffmpegProcess->waitForBytesWritten(50);
         QCoreApplication::processEvents();
     }
 
-    generator->endExport();
     return true;
 }
 
-bool VideoExporter::encodeFramesToVideo(const QString &outputPath)
+bool VideoExporter::startFFmpeg(const QStringList &inputArgs, const QString &outputPath)
 {
     // Create a QProcess for FFmpeg if it doesn't exist
     if (!m_ffmpegProcess) {
@@ -391,9 +609,8 @@ bool VideoExporter::encodeFramesToVideo(const QString &outputPath)
     QStringList args;
     args << "-y"
          << "-progress" << "-" // Output progress info to stdout
-         << "-stats" // Show stats
-         << "-framerate" << QString::number(m_frameRate) 
-         << "-i" << QString("%1/frame_%06d.png").arg(m_tempDir.path());
+         << "-stats"; // Show stats
+    args.append(inputArgs);
     
     // Add scale filter if custom resolution is set
     if (m_customResolution.isValid() && m_customResolution.width() > 0 && m_customResolution.height() > 0) {
@@ -413,11 +630,11 @@ bool VideoExporter::encodeFramesToVideo(const QString &outputPath)
     for (const QString &arg : args) {
         cmdLog += " " + (arg.contains(" ") ? "\"" + arg + "\"" : arg);
     }
-    qInfo() << "FFmpeg command:" << cmdLog;
+    qCInfo(lcExport) << "FFmpeg command:" << cmdLog;
     
     // Start progress timer for animation
     m_progressTimer->start(500);
-    qDebug() << "Started progress timer";
+    qCDebug(lcExport) << "Started progress timer";
 
     // Reset the captured-output buffer for this encode run.
     m_ffmpegOutputTail.clear();
@@ -427,7 +644,8 @@ bool VideoExporter::encodeFramesToVideo(const QString &outputPath)
     
     // Wait for the process to start
     if (!m_ffmpegProcess->waitForStarted(5000)) {
-        qInfo() << tr("Failed to start FFmpeg: %1").arg(m_ffmpegProcess->errorString());
+        m_progressTimer->stop();
+        qCInfo(lcExport) << tr("Failed to start FFmpeg: %1").arg(m_ffmpegProcess->errorString());
         emit exportError(tr("Failed to start FFmpeg: %1").arg(m_ffmpegProcess->errorString()));
         return false;
     }
@@ -462,8 +680,9 @@ QStringList VideoExporter::createFFmpegArgs(const QString &outputPath)
 
 void VideoExporter::updateEncodingProgress()
 {
-    // If FFmpeg isn't running, there's nothing to update
-    if (!m_ffmpegProcess || m_ffmpegProcess->state() != QProcess::Running) {
+    // If FFmpeg isn't running, there's nothing to update. While streaming the
+    // encoder's own frame counter drives progress, so no synthetic ticks.
+    if (!m_ffmpegProcess || m_ffmpegProcess->state() != QProcess::Running || m_streaming) {
         return;
     }
     
@@ -480,7 +699,7 @@ void VideoExporter::updateEncodingProgress()
             lastProgress = m_progress;
             unchangedCount = 0;
             emit progressChanged();
-            qDebug() << "Incrementing progress to show activity:" << m_progress << "%";
+            qCDebug(lcExport) << "Incrementing progress to show activity:" << m_progress << "%";
         }
     } else if (lastProgress != m_progress) {
         lastProgress = m_progress;
@@ -524,9 +743,17 @@ void VideoExporter::processFFmpegOutput()
         
         if (frameMatch.hasMatch()) {
             int currentFrame = frameMatch.captured(1).toInt();
-            int totalFrames = QDir(m_tempDir.path()).entryList(QStringList() << "*.png").count();
+            int totalFrames = m_totalFrames;
             
-            if (totalFrames > 0) {
+            if (m_streaming && totalFrames > 0) {
+                // Rendering and encoding overlap, so the encoder's position is
+                // the whole story. Hold 100 for onFFmpegFinished().
+                int newProgress = qMin((currentFrame * 100) / totalFrames, 99);
+                if (newProgress != m_progress) {
+                    m_progress = newProgress;
+                    emit progressChanged();
+                }
+            } else if (totalFrames > 0) {
                 // Calculate progress (50% for generation, 50% for encoding)
                 int encodingProgress = (currentFrame * 50) / totalFrames;
                 int newProgress = 50 + qMin(encodingProgress, 50);
@@ -535,7 +762,7 @@ void VideoExporter::processFFmpegOutput()
                     m_progress = newProgress;
                     emit progressChanged();
                     emit statusUpdate(tr("Encoding frame %1 of %2").arg(currentFrame).arg(totalFrames));
-                    // qDebug() << "Progress:" << m_progress << "% (Frame:" << currentFrame << "/" << totalFrames << ")";
+                    // qCDebug(lcExport) << "Progress:" << m_progress << "% (Frame:" << currentFrame << "/" << totalFrames << ")";
                 }
             }
         }
@@ -545,16 +772,20 @@ void VideoExporter::processFFmpegOutput()
 void VideoExporter::onFFmpegFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
     m_progressTimer->stop();
+    m_streaming = false;
     
     bool success = false;
     
-    if (exitStatus == QProcess::CrashExit) {
-        qWarning().noquote() << "FFmpeg crashed. Captured output tail:\n" << m_ffmpegOutputTail;
+    if (m_cancelRequested) {
+        // Terminated by cancelExport(), or out of frames because of it
+        emit exportError(tr("Export cancelled by user"));
+    } else if (exitStatus == QProcess::CrashExit) {
+        qCWarning(lcExport).noquote() << "FFmpeg crashed. Captured output tail:\n" << m_ffmpegOutputTail;
         emit exportError(tr("FFmpeg process crashed"));
     } else if (exitCode != 0) {
         // Surface FFmpeg's actual error (e.g. a codec/container mismatch) instead
         // of just the numeric exit code, which is otherwise undiagnosable.
-        qWarning().noquote() << "FFmpeg exited with code" << exitCode
+        qCWarning(lcExport).noquote() << "FFmpeg exited with code" << exitCode
                              << "- captured output tail:\n" << m_ffmpegOutputTail;
         emit exportError(tr("FFmpeg exited with error code: %1").arg(exitCode));
     } else {
@@ -638,12 +869,12 @@ QSize VideoExporter::getDefaultOverlaySize()
     QImage defaultOverlay(":/images/DC_Faces/unabara_round_ocean.png");
     if (!defaultOverlay.isNull()) {
         QSize size = defaultOverlay.size();
-        qDebug() << "Using default overlay size:" << size;
+        qCDebug(lcExport) << "Using default overlay size:" << size;
         return size;
     }
     
     // If default overlay can't be loaded for some reason, fall back to 16:9 HD
-    qWarning() << "Could not load default overlay image, using fallback size 1280x720";
+    qCWarning(lcExport) << "Could not load default overlay image, using fallback size 1280x720";
     return QSize(1280, 720);
 }
 
@@ -678,11 +909,11 @@ double VideoExporter::extractVideoTimecode(const QString &videoPath)
         int minutes = match.captured(2).toInt();
         int seconds = match.captured(3).toInt();
         double result = hours * 3600.0 + minutes * 60.0 + seconds;
-        qDebug() << "Extracted video timecode:" << match.captured(0) << "=" << result << "seconds";
+        qCDebug(lcExport) << "Extracted video timecode:" << match.captured(0) << "=" << result << "seconds";
         return result;
     }
 
-    qDebug() << "No timecode found in video:" << videoPath;
+    qCDebug(lcExport) << "No timecode found in video:" << videoPath;
     return -1.0;
 }
 
@@ -712,21 +943,21 @@ double VideoExporter::extractVideoCreationTime(const QString &videoPath)
 
     process.start(ffprobePath, args);
     if (!process.waitForFinished(5000)) {
-        qWarning() << "extractVideoCreationTime: ffprobe timed out for" << videoPath;
+        qCWarning(lcExport) << "extractVideoCreationTime: ffprobe timed out for" << videoPath;
         process.kill();
         return -1.0;
     }
 
     QByteArray output = process.readAllStandardOutput();
     if (output.isEmpty()) {
-        qDebug() << "extractVideoCreationTime: no output from ffprobe for" << videoPath;
+        qCDebug(lcExport) << "extractVideoCreationTime: no output from ffprobe for" << videoPath;
         return -1.0;
     }
 
     QJsonParseError parseError;
     QJsonDocument doc = QJsonDocument::fromJson(output, &parseError);
     if (parseError.error != QJsonParseError::NoError) {
-        qWarning() << "extractVideoCreationTime: JSON parse error:" << parseError.errorString();
+        qCWarning(lcExport) << "extractVideoCreationTime: JSON parse error:" << parseError.errorString();
         return -1.0;
     }
 
@@ -736,7 +967,7 @@ double VideoExporter::extractVideoCreationTime(const QString &videoPath)
         .value("creation_time").toString();
 
     if (creationTimeStr.isEmpty()) {
-        qDebug() << "extractVideoCreationTime: no creation_time tag in" << videoPath;
+        qCDebug(lcExport) << "extractVideoCreationTime: no creation_time tag in" << videoPath;
         return -1.0;
     }
 
@@ -745,27 +976,27 @@ double VideoExporter::extractVideoCreationTime(const QString &videoPath)
         dt = QDateTime::fromString(creationTimeStr, Qt::ISODate);
 
     if (!dt.isValid()) {
-        qWarning() << "extractVideoCreationTime: could not parse datetime:" << creationTimeStr;
+        qCWarning(lcExport) << "extractVideoCreationTime: could not parse datetime:" << creationTimeStr;
         return -1.0;
     }
 
-    qDebug() << "extractVideoCreationTime:" << creationTimeStr << "=" << dt.toSecsSinceEpoch();
+    qCDebug(lcExport) << "extractVideoCreationTime:" << creationTimeStr << "=" << dt.toSecsSinceEpoch();
     return static_cast<double>(dt.toSecsSinceEpoch());
 }
 
 QSize VideoExporter::detectVideoResolution(const QString &videoPath)
 {
     if (videoPath.isEmpty()) {
-        qWarning() << "Empty video path provided to detectVideoResolution";
+        qCWarning(lcExport) << "Empty video path provided to detectVideoResolution";
         return getDefaultOverlaySize();
     }
 
-    qDebug() << "Detecting resolution for video:" << videoPath;
+    qCDebug(lcExport) << "Detecting resolution for video:" << videoPath;
 
     // Use FFmpeg to detect video resolution
     QString ffmpegPath = findFFmpegPath();
     if (ffmpegPath.isEmpty()) {
-        qWarning() << "FFmpeg not found, cannot detect video resolution";
+        qCWarning(lcExport) << "FFmpeg not found, cannot detect video resolution";
         return getDefaultOverlaySize();
     }
 
@@ -776,14 +1007,14 @@ QSize VideoExporter::detectVideoResolution(const QString &videoPath)
     QStringList args;
     args << "-i" << videoPath;
     
-    qDebug() << "Running FFmpeg info command:" << ffmpegPath << args.join(" ");
+    qCDebug(lcExport) << "Running FFmpeg info command:" << ffmpegPath << args.join(" ");
     
     process.start(ffmpegPath, args);
     process.waitForFinished(5000);
     
     QString output = process.readAllStandardOutput();
-    qDebug() << "FFmpeg info output length:" << output.length();
-    qDebug() << "FFmpeg info output sample:" << output.left(200);
+    qCDebug(lcExport) << "FFmpeg info output length:" << output.length();
+    qCDebug(lcExport) << "FFmpeg info output sample:" << output.left(200);
     
     // Look for Stream information that contains resolution
     QRegularExpression videoStreamRegex("Stream\\s+#\\d+:\\d+(?:\\[0x[0-9a-f]+\\])?[^,]*:\\s+Video[^,]*,\\s+([^,]*,\\s+)?([0-9]+x[0-9]+)");
@@ -799,7 +1030,7 @@ QSize VideoExporter::detectVideoResolution(const QString &videoPath)
             int height = match.captured(2).toInt();
             
             if (width > 0 && height > 0) {
-                qDebug() << "Detected video resolution:" << width << "x" << height;
+                qCDebug(lcExport) << "Detected video resolution:" << width << "x" << height;
                 return QSize(width, height);
             }
         }
@@ -816,17 +1047,17 @@ QSize VideoExporter::detectVideoResolution(const QString &videoPath)
                 << "-show_streams" 
                 << videoPath;
     
-    qDebug() << "Running ffprobe command:" << ffprobePath << ffprobeArgs.join(" ");
+    qCDebug(lcExport) << "Running ffprobe command:" << ffprobePath << ffprobeArgs.join(" ");
     
     process.start(ffprobePath, ffprobeArgs);
     if (!process.waitForFinished(5000)) {
-        qWarning() << "ffprobe process timed out";
+        qCWarning(lcExport) << "ffprobe process timed out";
         process.kill();
         return getDefaultOverlaySize();
     }
     
     QString ffprobeOutput = process.readAllStandardOutput();
-    qDebug() << "ffprobe output length:" << ffprobeOutput.length();
+    qCDebug(lcExport) << "ffprobe output length:" << ffprobeOutput.length();
     
     if (!ffprobeOutput.isEmpty()) {
         // Look for width and height in the JSON output
@@ -841,7 +1072,7 @@ QSize VideoExporter::detectVideoResolution(const QString &videoPath)
             int height = heightMatch.captured(1).toInt();
             
             if (width > 0 && height > 0) {
-                qDebug() << "Detected video resolution (ffprobe):" << width << "x" << height;
+                qCDebug(lcExport) << "Detected video resolution (ffprobe):" << width << "x" << height;
                 return QSize(width, height);
             }
         }
@@ -855,17 +1086,17 @@ QSize VideoExporter::detectVideoResolution(const QString &videoPath)
               << "-show_entries" << "stream=width,height" 
               << "-of" << "default=noprint_wrappers=1";
     
-    qDebug() << "Running simple ffmpeg resolution command:" << ffmpegPath << simpleArgs.join(" ");
+    qCDebug(lcExport) << "Running simple ffmpeg resolution command:" << ffmpegPath << simpleArgs.join(" ");
     
     process.start(ffmpegPath, simpleArgs);
     if (!process.waitForFinished(5000)) {
-        qWarning() << "Simple ffmpeg process timed out";
+        qCWarning(lcExport) << "Simple ffmpeg process timed out";
         process.kill();
         return getDefaultOverlaySize();
     }
     
     QString simpleOutput = process.readAllStandardOutput();
-    qDebug() << "Simple ffmpeg output:" << simpleOutput;
+    qCDebug(lcExport) << "Simple ffmpeg output:" << simpleOutput;
     
     QRegularExpression widthRegex("width=(\\d+)");
     QRegularExpression heightRegex("height=(\\d+)");
@@ -878,12 +1109,12 @@ QSize VideoExporter::detectVideoResolution(const QString &videoPath)
         int height = heightMatch.captured(1).toInt();
         
         if (width > 0 && height > 0) {
-            qDebug() << "Detected video resolution (simple):" << width << "x" << height;
+            qCDebug(lcExport) << "Detected video resolution (simple):" << width << "x" << height;
             return QSize(width, height);
         }
     }
     
-    qWarning() << "All resolution detection methods failed, using default overlay size";
+    qCWarning(lcExport) << "All resolution detection methods failed, using default overlay size";
     return getDefaultOverlaySize();
 }
 
@@ -0,0 +1,387 @@
+#include "include/generators/box_blur.h"
+
+#include <QImage>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define UNABARA_BLUR_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+// GCC and Clang only emit an instruction set inside functions that ask for
+// it; MSVC compiles any intrinsic anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define UNABARA_TARGET_SSE2 __attribute__((target("sse2")))
+#define UNABARA_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define UNABARA_TARGET_SSE2
+#define UNABARA_TARGET_AVX2
+#endif
+#endif
+
+namespace {
+
+// Rows of 'width' 32-bit pixels, 'stride' pixels apart
+struct Plane {
+    quint32 *bits;
+    qsizetype stride;
+    int width;
+    int height;
+
+    quint32 *row(int y) const { return bits + y * stride; }
+    // Rows past the top and bottom edges repeat the edge row
+    const quint32 *clampedRow(int y) const { return row(std::clamp(y, 0, height - 1)); }
+};
+
+// Signature shared by every kernel's horizontal and vertical half-pass:
+// blurs 'src' into 'dst', which never overlap
+using HalfPass = void (*)(const Plane &src, const Plane &dst, int radius);
+
+// 'row' with 'radius' copies of its edge pixels on either side, plus one on
+// the right the sliding window reads after its last step. Replaces the
+// per-tap clamping at the row ends.
+void padRow(const quint32 *row, int width, int radius, quint32 *padded)
+{
+    std::fill(padded, padded + radius, row[0]);
+    std::memcpy(padded + radius, row, width * sizeof(quint32));
+    std::fill(padded + radius + width, padded + width + 2 * radius + 1, row[width - 1]);
+}
+
+const uchar *bytes(const quint32 *pixels)
+{
+    return reinterpret_cast<const uchar *>(pixels);
+}
+
+// --- Scalar: one channel byte at a time ---
+
+void horizontalScalar(const Plane &src, const Plane &dst, int radius)
+{
+    const int window = 2 * radius + 1;
+    std::vector<quint32> padded(src.width + window);
+    for (int y = 0; y < src.height; ++y) {
+        padRow(src.row(y), src.width, radius, padded.data());
+        const uchar *in = bytes(padded.data());
+        uchar *out = reinterpret_cast<uchar *>(dst.row(y));
+
+        int sums[4] = {0, 0, 0, 0};
+        for (int i = 0; i < window * 4; ++i) {
+            sums[i & 3] += in[i];
+        }
+        for (int x = 0; x < src.width; ++x) {
+            for (int c = 0; c < 4; ++c) {
+                out[x * 4 + c] = uchar(sums[c] / window);
+                sums[c] += in[(x + window) * 4 + c] - in[x * 4 + c];
+            }
+        }
+    }
+}
+
+// Running sums per column, updated a whole row at a time
+void verticalScalar(const Plane &src, const Plane &dst, int radius)
+{
+    const int window = 2 * radius + 1;
+    const int rowBytes = src.width * 4;
+    std::vector<int> sums(rowBytes, 0);
+    for (int k = -radius; k <= radius; ++k) {
+        const uchar *in = bytes(src.clampedRow(k));
+        for (int i = 0; i < rowBytes; ++i) {
+            sums[i] += in[i];
+        }
+    }
+    for (int y = 0; y < src.height; ++y) {
+        uchar *out = reinterpret_cast<uchar *>(dst.row(y));
+        const uchar *entering = bytes(src.clampedRow(y + radius + 1));
+        const uchar *leaving = bytes(src.clampedRow(y - radius));
+        for (int i = 0; i < rowBytes; ++i) {
+            out[i] = uchar(sums[i] / window);
+            sums[i] += entering[i] - leaving[i];
+        }
+    }
+}
+
+#ifdef UNABARA_BLUR_X86
+
+// --- SSE2: a pixel's four channel sums in one register ---
+
+UNABARA_TARGET_SSE2 inline __m128i widen(quint32 pixel)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(int(pixel)), zero), zero);
+}
+
+// Channel sums divided by the window, truncated like the scalar integer
+// division. (sum + 0.5) / window is at least 0.5 / window away from the
+// next integer, far more than float rounding can move it for 8-bit sums.
+UNABARA_TARGET_SSE2 inline quint32 narrow(__m128i sums, __m128 inverseWindow)
+{
+    const __m128 quotient =
+        _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(sums), _mm_set1_ps(0.5f)), inverseWindow);
+    __m128i v = _mm_cvttps_epi32(quotient);
+    v = _mm_packs_epi32(v, v);
+    v = _mm_packus_epi16(v, v);
+    return quint32(_mm_cvtsi128_si32(v));
+}
+
+UNABARA_TARGET_SSE2 void horizontalRowSse2(const quint32 *padded, quint32 *out, int width,
+                                           int window, __m128 inverseWindow)
+{
+    __m128i sums = _mm_setzero_si128();
+    for (int i = 0; i < window; ++i) {
+        sums = _mm_add_epi32(sums, widen(padded[i]));
+    }
+    for (int x = 0; x < width; ++x) {
+        out[x] = narrow(sums, inverseWindow);
+        sums = _mm_add_epi32(sums, _mm_sub_epi32(widen(padded[x + window]), widen(padded[x])));
+    }
+}
+
+UNABARA_TARGET_SSE2 void horizontalSse2(const Plane &src, const Plane &dst, int radius)
+{
+    const int window = 2 * radius + 1;
+    const __m128 inverseWindow = _mm_set1_ps(1.0f / window);
+    std::vector<quint32> padded(src.width + window);
+    for (int y = 0; y < src.height; ++y) {
+        padRow(src.row(y), src.width, radius, padded.data());
+        horizontalRowSse2(padded.data(), dst.row(y), src.width, window, inverseWindow);
+    }
+}
+
+// Sums for pixel 'x' of a row of per-channel column sums
+UNABARA_TARGET_SSE2 inline __m128i *columnSums(qint32 *sums, int x)
+{
+    return reinterpret_cast<__m128i *>(sums + 4 * x);
+}
+
+UNABARA_TARGET_SSE2 void verticalSse2(const Plane &src, const Plane &dst, int radius)
+{
+    const int window = 2 * radius + 1;
+    const __m128 inverseWindow = _mm_set1_ps(1.0f / window);
+    std::vector<qint32> sums(size_t(src.width) * 4, 0);
+    for (int k = -radius; k <= radius; ++k) {
+        const quint32 *in = src.clampedRow(k);
+        for (int x = 0; x < src.width; ++x) {
+            __m128i *sum = columnSums(sums.data(), x);
+            _mm_storeu_si128(sum, _mm_add_epi32(_mm_loadu_si128(sum), widen(in[x])));
+        }
+    }
+    for (int y = 0; y < src.height; ++y) {
+        quint32 *out = dst.row(y);
+        const quint32 *entering = src.clampedRow(y + radius + 1);
+        const quint32 *leaving = src.clampedRow(y - radius);
+        for (int x = 0; x < src.width; ++x) {
+            __m128i *sum = columnSums(sums.data(), x);
+            const __m128i current = _mm_loadu_si128(sum);
+            out[x] = narrow(current, inverseWindow);
+            _mm_storeu_si128(sum, _mm_add_epi32(current, _mm_sub_epi32(widen(entering[x]),
+                                                                       widen(leaving[x]))));
+        }
+    }
+}
+
+// --- AVX2: two pixels' channel sums per register, one per 128-bit lane ---
+
+UNABARA_TARGET_AVX2 inline __m256i widenPair(quint32 low, quint32 high)
+{
+    return _mm256_cvtepu8_epi32(
+        _mm_unpacklo_epi32(_mm_cvtsi32_si128(int(low)), _mm_cvtsi32_si128(int(high))));
+}
+
+UNABARA_TARGET_AVX2 inline __m256i widenPair(const quint32 *pixels)
+{
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pixels)));
+}
+
+// As narrow(), for both lanes: the low lane's pixel lands in bits 0-31 of
+// the result, the high lane's in bits 32-63
+UNABARA_TARGET_AVX2 inline __m128i narrowPair(__m256i sums, __m256 inverseWindow)
+{
+    const __m256 quotient = _mm256_mul_ps(
+        _mm256_add_ps(_mm256_cvtepi32_ps(sums), _mm256_set1_ps(0.5f)), inverseWindow);
+    __m256i v = _mm256_cvttps_epi32(quotient);
+    v = _mm256_packs_epi32(v, v); // packs within each lane
+    v = _mm256_packus_epi16(v, v);
+    return _mm_unpacklo_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+// Slides one window along two rows at once; a leftover row goes through SSE2
+UNABARA_TARGET_AVX2 void horizontalAvx2(const Plane &src, const Plane &dst, int radius)
+{
+    const int window = 2 * radius + 1;
+    const __m256 inverseWindow = _mm256_set1_ps(1.0f / window);
+    std::vector<quint32> first(src.width + window);
+    std::vector<quint32> second(src.width + window);
+    const quint32 *a = first.data();
+    const quint32 *b = second.data();
+
+    int y = 0;
+    for (; y + 1 < src.height; y += 2) {
+        padRow(src.row(y), src.width, radius, first.data());
+        padRow(src.row(y + 1), src.width, radius, second.data());
+        quint32 *outA = dst.row(y);
+        quint32 *outB = dst.row(y + 1);
+
+        __m256i sums = _mm256_setzero_si256();
+        for (int i = 0; i < window; ++i) {
+            sums = _mm256_add_epi32(sums, widenPair(a[i], b[i]));
+        }
+        for (int x = 0; x < src.width; ++x) {
+            const __m128i both = narrowPair(sums, inverseWindow);
+            outA[x] = quint32(_mm_cvtsi128_si32(both));
+            outB[x] = quint32(_mm_cvtsi128_si32(_mm_srli_si128(both, 4)));
+            sums = _mm256_add_epi32(sums, _mm256_sub_epi32(widenPair(a[x + window], b[x + window]),
+                                                           widenPair(a[x], b[x])));
+        }
+    }
+    if (y < src.height) {
+        padRow(src.row(y), src.width, radius, first.data());
+        horizontalRowSse2(a, dst.row(y), src.width, window, _mm_set1_ps(1.0f / window));
+    }
+}
+
+UNABARA_TARGET_AVX2 void verticalAvx2(const Plane &src, const Plane &dst, int radius)
+{
+    const int window = 2 * radius + 1;
+    const __m256 inverseWindow = _mm256_set1_ps(1.0f / window);
+    const __m128 inverseWindowSse = _mm_set1_ps(1.0f / window);
+    const int pairs = src.width & ~1;
+    std::vector<qint32> sums(size_t(src.width) * 4, 0);
+
+    for (int k = -radius; k <= radius; ++k) {
+        const quint32 *in = src.clampedRow(k);
+        int x = 0;
+        for (; x < pairs; x += 2) {
+            auto *sum = reinterpret_cast<__m256i *>(sums.data() + 4 * x);
+            _mm256_storeu_si256(sum, _mm256_add_epi32(_mm256_loadu_si256(sum), widenPair(in + x)));
+        }
+        if (x < src.width) {
+            __m128i *sum = columnSums(sums.data(), x);
+            _mm_storeu_si128(sum, _mm_add_epi32(_mm_loadu_si128(sum), widen(in[x])));
+        }
+    }
+    for (int y = 0; y < src.height; ++y) {
+        quint32 *out = dst.row(y);
+        const quint32 *entering = src.clampedRow(y + radius + 1);
+        const quint32 *leaving = src.clampedRow(y - radius);
+        int x = 0;
+        for (; x < pairs; x += 2) {
+            auto *sum = reinterpret_cast<__m256i *>(sums.data() + 4 * x);
+            const __m256i current = _mm256_loadu_si256(sum);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x),
+                             narrowPair(current, inverseWindow));
+            _mm256_storeu_si256(sum, _mm256_add_epi32(current,
+                                                      _mm256_sub_epi32(widenPair(entering + x),
+                                                                       widenPair(leaving + x))));
+        }
+        if (x < src.width) {
+            __m128i *sum = columnSums(sums.data(), x);
+            const __m128i current = _mm_loadu_si128(sum);
+            out[x] = narrow(current, inverseWindowSse);
+            _mm_storeu_si128(sum, _mm_add_epi32(current, _mm_sub_epi32(widen(entering[x]),
+                                                                       widen(leaving[x]))));
+        }
+    }
+}
+
+#ifdef _MSC_VER
+bool cpuHasSse2()
+{
+    int info[4];
+    __cpuid(info, 1);
+    return info[3] & (1 << 26);
+}
+
+bool cpuHasAvx2()
+{
+    int info[4];
+    __cpuid(info, 1);
+    // The OS must also save the YMM registers across context switches
+    const bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28))
+                            && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5));
+}
+#else
+bool cpuHasSse2()
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+bool cpuHasAvx2()
+{
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#endif // UNABARA_BLUR_X86
+
+} // namespace
+
+namespace box_blur {
+
+bool isSupported(Kernel kernel)
+{
+    switch (kernel) {
+    case Kernel::Scalar:
+        return true;
+#ifdef UNABARA_BLUR_X86
+    case Kernel::Sse2:
+        return cpuHasSse2();
+    case Kernel::Avx2:
+        return cpuHasAvx2();
+#endif
+    default:
+        return false;
+    }
+}
+
+Kernel bestKernel()
+{
+    static const Kernel best = isSupported(Kernel::Avx2)   ? Kernel::Avx2
+                               : isSupported(Kernel::Sse2) ? Kernel::Sse2
+                                                           : Kernel::Scalar;
+    return best;
+}
+
+void blur(QImage &image, int radius)
+{
+    blur(image, radius, bestKernel());
+}
+
+void blur(QImage &image, int radius, Kernel kernel)
+{
+    if (radius < 1 || image.isNull()) {
+        return;
+    }
+    Q_ASSERT(image.depth() == 32);
+    Q_ASSERT(isSupported(kernel));
+
+    HalfPass horizontal = horizontalScalar;
+    HalfPass vertical = verticalScalar;
+#ifdef UNABARA_BLUR_X86
+    if (kernel == Kernel::Sse2) {
+        horizontal = horizontalSse2;
+        vertical = verticalSse2;
+    } else if (kernel == Kernel::Avx2) {
+        horizontal = horizontalAvx2;
+        vertical = verticalAvx2;
+    }
+#endif
+
+    // Each pass blurs the rows into scratch and the columns back
+    const int width = image.width();
+    const int height = image.height();
+    std::vector<quint32> scratch(size_t(width) * height);
+    const Plane target{reinterpret_cast<quint32 *>(image.bits()), image.bytesPerLine() / 4,
+                       width, height};
+    const Plane rows{scratch.data(), width, width, height};
+    for (int pass = 0; pass < 3; ++pass) {
+        horizontal(target, rows, radius);
+        vertical(rows, target, radius);
+    }
+}
+
+} // namespace box_blur
@@ -0,0 +1,20 @@
+#include "include/generators/incremental_frames.h"
+
+#include <QThread>
+
+IncrementalFrames::Frame &IncrementalFrames::frameForCurrentThread()
+{
+    QMutexLocker lock(&m_mutex);
+    std::unique_ptr<Frame> &frame = m_frameByThread[QThread::currentThread()];
+    if (!frame) {
+        frame = std::make_unique<Frame>();
+    }
+    return *frame;
+}
+
+void IncrementalFrames::countFrame(int cells, int redrawn)
+{
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    m_cells.fetch_add(cells, std::memory_order_relaxed);
+    m_cellsRedrawn.fetch_add(redrawn, std::memory_order_relaxed);
+}
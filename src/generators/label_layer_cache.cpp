@@ -0,0 +1,30 @@
+#include "include/generators/label_layer_cache.h"
+
+namespace {
+
+// Labels times the fonts, colors and positions they show up with; even
+// labels that flip during a dive (NDL/TTS, tank names) add only a few
+constexpr qsizetype kMaxLayers = 256;
+
+} // namespace
+
+LabelLayerCache::Layer LabelLayerCache::layer(const Key &key, const std::function<Layer()> &render)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        if (auto it = m_layers.constFind(key); it != m_layers.cend()) {
+            return it.value();
+        }
+    }
+
+    // Rendered unlocked: two threads may both render a new label, and the
+    // results are identical
+    const Layer layer = render();
+
+    QMutexLocker lock(&m_mutex);
+    if (m_layers.size() >= kMaxLayers) {
+        m_layers.clear();
+    }
+    m_layers.insert(key, layer);
+    return layer;
+}
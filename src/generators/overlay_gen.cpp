@@ -1,14 +1,18 @@
 #include "include/generators/overlay_gen.h"
+#include "include/core/logging.h"
+#include "include/generators/box_blur.h"
 #include <QPainter>
 #include <QtMath>
 #include <QFontMetrics>
 #include <QDateTime>
-#include <QDebug>
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QRegion>
+#include <QVarLengthArray>
+#include <vector>
 
 OverlayGenerator::OverlayGenerator(QObject *parent)
     : QObject(parent)
@@ -78,6 +82,10 @@ OverlayGenerator::OverlayGenerator(QObject *parent)
         emit backgroundOpacityChanged();
     });
 
+    // The cached background layer depends on the template image and opacity
+    connect(this, &OverlayGenerator::templateChanged, this, [this]() { invalidateBackgroundCache(); });
+    connect(this, &OverlayGenerator::backgroundOpacityChanged, this, [this]() { invalidateBackgroundCache(); });
+
     // Initialize default cell layout
     initializeDefaultCellLayout();
 
@@ -116,11 +124,11 @@ void OverlayGenerator::updateTemplateDimensions()
         // Use default dimensions if template can't be loaded
         m_templateWidth = 640;
         m_templateHeight = 120;
-        qWarning() << "Could not load template for dimensions, using defaults:" << m_templatePath;
+        qCWarning(lcRender) << "Could not load template for dimensions, using defaults:" << m_templatePath;
     } else {
         m_templateWidth = templateImage.width();
         m_templateHeight = templateImage.height();
-        qDebug() << "Template dimensions:" << m_templateWidth << "x" << m_templateHeight;
+        qCDebug(lcRender) << "Template dimensions:" << m_templateWidth << "x" << m_templateHeight;
     }
 }
 
@@ -601,15 +609,58 @@ void OverlayGenerator::setShowCellBackgrounds(bool show)
 
 void OverlayGenerator::beginExport()
 {
+    // Freeze the render state for the whole pass: edits made while the
+    // export runs don't leak into half of its frames, and workers can render
+    // from the snapshot without touching this object.
+    m_exportSnapshot = captureSnapshot();
     // Cell backgrounds are an editor-only affordance — never render them
-    // into export frames. Stash the user's current value and force off.
-    m_savedShowCellBackgrounds = m_showCellBackgrounds;
-    m_showCellBackgrounds = false;
+    // into export frames.
+    m_exportSnapshot.showCellBackgrounds = false;
+    // Labels are shaped once for the whole export; values as they first appear
+    m_exportSnapshot.textLayouts = std::make_shared<TextLayoutCache>();
+    // Same for the rasterised labels: each is drawn with its shadow once,
+    // then blitted on every frame it appears in
+    m_exportSnapshot.labelLayers = std::make_shared<LabelLayerCache>();
+    // Frames after each thread's first repaint only the cells that changed
+    m_exportSnapshot.incremental = std::make_shared<IncrementalFrames>();
+    m_exportSummary.clear();
+    m_exporting = true;
 }
 
 void OverlayGenerator::endExport()
 {
-    m_showCellBackgrounds = m_savedShowCellBackgrounds;
+    if (const auto& incremental = m_exportSnapshot.incremental; incremental && incremental->frames() > 0) {
+        m_exportSummary = tr("Redrew %1 of %2 cells over %3 frames")
+                              .arg(incremental->cellsRedrawn())
+                              .arg(incremental->cells())
+                              .arg(incremental->frames());
+    }
+    m_exporting = false;
+    m_exportSnapshot = RenderSnapshot();
+}
+
+bool OverlayGenerator::supportsConcurrentGenerate() const
+{
+    // The legacy section-based path renders from live members
+    return m_exporting && m_exportSnapshot.cellBased;
+}
+
+QImage OverlayGenerator::generate(DiveData* dive, double timePoint)
+{
+    if (m_exporting && m_exportSnapshot.cellBased) {
+        return renderSnapshot(m_exportSnapshot, dive, timePoint);
+    }
+    // Legacy section-based layout (never draws cell backgrounds)
+    return generateOverlay(dive, timePoint);
+}
+
+QImage OverlayGenerator::generateFromSample(DiveData* dive, double timePoint,
+                                            const DiveDataPoint& sample)
+{
+    if (m_exporting && m_exportSnapshot.cellBased) {
+        return renderSnapshot(m_exportSnapshot, dive, sample);
+    }
+    return generateOverlay(dive, timePoint);
 }
 
 QStringList OverlayGenerator::getAvailableTemplates()
@@ -801,7 +852,7 @@ void OverlayGenerator::setCellPosition(const QString& cellId, const QPointF& pos
         cell->setPosition(pos);
         emit cellLayoutChanged();
     } else {
-        qWarning() << "setCellPosition: Cell not found:" << cellId;
+        qCWarning(lcRender) << "setCellPosition: Cell not found:" << cellId;
     }
 }
 
@@ -839,7 +890,7 @@ void OverlayGenerator::setCellFont(const QString& cellId, const QFont& font)
         cell->setFont(font, true);  // true = custom font
         emit cellLayoutChanged();
     } else {
-        qWarning() << "setCellFont: Cell not found:" << cellId;
+        qCWarning(lcRender) << "setCellFont: Cell not found:" << cellId;
     }
 }
 
@@ -850,7 +901,7 @@ void OverlayGenerator::setCellLabelColor(const QString& cellId, const QColor& co
         cell->setLabelColor(color, true);  // true = custom color
         emit cellLayoutChanged();
     } else {
-        qWarning() << "setCellLabelColor: Cell not found:" << cellId;
+        qCWarning(lcRender) << "setCellLabelColor: Cell not found:" << cellId;
     }
 }
 
@@ -861,7 +912,7 @@ void OverlayGenerator::setCellValueColor(const QString& cellId, const QColor& co
         cell->setValueColor(color, true);  // true = custom color
         emit cellLayoutChanged();
     } else {
-        qWarning() << "setCellValueColor: Cell not found:" << cellId;
+        qCWarning(lcRender) << "setCellValueColor: Cell not found:" << cellId;
     }
 }
 
@@ -872,7 +923,7 @@ void OverlayGenerator::setCellShowLabel(const QString& cellId, bool show)
         cell->setShowLabel(show, true);  // true = per-cell override
         emit cellsChanged();
     } else {
-        qWarning() << "setCellShowLabel: Cell not found:" << cellId;
+        qCWarning(lcRender) << "setCellShowLabel: Cell not found:" << cellId;
     }
 }
 
@@ -937,7 +988,7 @@ void OverlayGenerator::setCellVisible(const QString& cellId, bool visible)
         cell->setVisible(visible);
         emit cellLayoutChanged();
     } else {
-        qWarning() << "setCellVisible: Cell not found:" << cellId;
+        qCWarning(lcRender) << "setCellVisible: Cell not found:" << cellId;
     }
 }
 
@@ -976,7 +1027,7 @@ void OverlayGenerator::setCellTypeVisible(const QString& cellId, bool visible)
         {"composite_po2", Unabara::CellType::CompositePO2},
     };
     if (!idToType.contains(cellId)) {
-        qWarning() << "setCellTypeVisible: Unknown cell id:" << cellId;
+        qCWarning(lcRender) << "setCellTypeVisible: Unknown cell id:" << cellId;
         return;
     }
 
@@ -1245,7 +1296,7 @@ Unabara::OverlayTemplate OverlayGenerator::exportTemplate() const
 
 bool OverlayGenerator::saveTemplateToFile(const QString& filePath)
 {
-    qDebug() << "Saving template to file:" << filePath;
+    qCDebug(lcRender) << "Saving template to file:" << filePath;
 
     // Export current state to template
     Unabara::OverlayTemplate templ = exportTemplate();
@@ -1259,11 +1310,11 @@ bool OverlayGenerator::saveTemplateToFile(const QString& filePath)
     bool success = templ.saveToFile(filePath);
 
     if (success) {
-        qDebug() << "Template saved successfully";
+        qCDebug(lcRender) << "Template saved successfully";
         Config::instance()->setActiveTemplatePath(filePath);
         emit templateSaved(filePath);
     } else {
-        qWarning() << "Failed to save template";
+        qCWarning(lcRender) << "Failed to save template";
     }
 
     return success;
@@ -1271,16 +1322,16 @@ bool OverlayGenerator::saveTemplateToFile(const QString& filePath)
 
 bool OverlayGenerator::loadTemplateFromFile(const QString& filePath)
 {
-    qDebug() << "Loading template from file:" << filePath;
+    qCDebug(lcRender) << "Loading template from file:" << filePath;
 
     QString errorMessage;
     Unabara::OverlayTemplate templ = Unabara::OverlayTemplate::loadFromFile(filePath, &errorMessage);
 
     // Check if load was successful (template has cells)
     if (templ.cellCount() == 0) {
-        qWarning() << "Failed to load template or template is empty";
+        qCWarning(lcRender) << "Failed to load template or template is empty";
         if (!errorMessage.isEmpty()) {
-            qWarning() << "Error:" << errorMessage;
+            qCWarning(lcRender) << "Error:" << errorMessage;
         }
         return false;
     }
@@ -1288,9 +1339,9 @@ bool OverlayGenerator::loadTemplateFromFile(const QString& filePath)
     // Load template into generator
     loadTemplate(templ);
 
-    qDebug() << "Template loaded successfully";
-    qDebug() << "  Name:" << templ.templateName();
-    qDebug() << "  Cells:" << templ.cellCount();
+    qCDebug(lcRender) << "Template loaded successfully";
+    qCDebug(lcRender) << "  Name:" << templ.templateName();
+    qCDebug(lcRender) << "  Cells:" << templ.cellCount();
 
     Config::instance()->setActiveTemplatePath(filePath);
     emit templateLoaded(filePath);
@@ -1605,7 +1656,7 @@ void OverlayGenerator::initializeDefaultCellLayout(DiveData* dive)
         }
     }
 
-    qDebug() << "Initialized" << m_cells.size() << "cells for default layout (sections:" << numSections << ")";
+    qCDebug(lcRender) << "Initialized" << m_cells.size() << "cells for default layout (sections:" << numSections << ")";
 
     emit cellsChanged();
 }
@@ -1618,64 +1669,138 @@ void OverlayGenerator::migrateLegacySettings()
     initializeDefaultCellLayout();
     m_useCellBasedLayout = true;
 
-    qDebug() << "Migrated legacy settings to cell-based layout";
+    qCDebug(lcRender) << "Migrated legacy settings to cell-based layout";
     emit cellLayoutChanged();
 }
 
 
-QImage OverlayGenerator::generateOverlay(DiveData* dive, double timePoint)
+QImage OverlayGenerator::backgroundLayer() const
 {
-    if (!dive) {
-        qWarning() << "No dive data provided for overlay generation";
-        return QImage();
+    QMutexLocker lock(&m_backgroundCacheMutex);
+
+    const QSize templateSize(m_templateWidth, m_templateHeight);
+    if (!m_backgroundCache.isNull()
+        && m_backgroundCachePath == m_templatePath
+        && m_backgroundCacheOpacity == m_backgroundOpacity
+        && m_backgroundCacheSize == templateSize) {
+        return m_backgroundCache; // implicitly shared; frames detach on paint
     }
-    
-    // qDebug() << "Generating overlay for time point:" << timePoint;
-    
+
     // Load the template image
     QImage templateImage(m_templatePath);
     if (templateImage.isNull()) {
-        qWarning() << "Failed to load template image:" << m_templatePath;
+        qCWarning(lcRender) << "Failed to load template image:" << m_templatePath;
         // Create a default black background if template can't be loaded
         templateImage = QImage(640, 120, QImage::Format_ARGB32);
         templateImage.fill(QColor(0, 0, 0, 180));
     }
-    
-    // Create the result image and apply background opacity
-    QImage result = templateImage.copy();
+
+    // Premultiplied is QPainter's native raster format: each frame's copy
+    // then paints without a per-frame conversion.
+    templateImage = templateImage.convertToFormat(QImage::Format_ARGB32_Premultiplied);
 
     // Apply background opacity if needed
     if (m_backgroundOpacity < 1.0) {
-        QPainter opacityPainter(&result);
+        QPainter opacityPainter(&templateImage);
         opacityPainter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
         QColor opacityColor(255, 255, 255, static_cast<int>(m_backgroundOpacity * 255));
-        opacityPainter.fillRect(result.rect(), opacityColor);
+        opacityPainter.fillRect(templateImage.rect(), opacityColor);
         opacityPainter.end();
     }
-    
-    // Get the data for the current time point
-    DiveDataPoint dataPoint = dive->dataAtTime(timePoint);
-    
-    // qDebug() << "Data point for overlay - depth:" << dataPoint.depth 
-    //          << "temp:" << dataPoint.temperature
-    //          << "time:" << dataPoint.timestamp
-    //          << "ndl:" << dataPoint.ndl
-    //          << "tts:" << dataPoint.tts;
-    
+
+    m_backgroundCache = templateImage;
+    m_backgroundCachePath = m_templatePath;
+    m_backgroundCacheOpacity = m_backgroundOpacity;
+    m_backgroundCacheSize = templateSize;
+    return m_backgroundCache;
+}
+
+void OverlayGenerator::invalidateBackgroundCache()
+{
+    QMutexLocker lock(&m_backgroundCacheMutex);
+    m_backgroundCache = QImage();
+}
+
+OverlayGenerator::RenderSnapshot OverlayGenerator::captureSnapshot() const
+{
+    RenderSnapshot snapshot;
+    snapshot.background = backgroundLayer();
+    snapshot.cells = m_cells;
+    snapshot.font = m_font;
+    snapshot.labelColor = m_labelColor;
+    snapshot.valueColor = m_valueColor;
+    snapshot.shadowEnabled = m_shadowEnabled;
+    snapshot.shadowType = m_shadowType;
+    snapshot.shadowColor = m_shadowColor;
+    snapshot.shadowSize = m_shadowSize;
+    snapshot.shadowOpacity = m_shadowOpacity;
+    snapshot.showCellBackgrounds = m_showCellBackgrounds;
+    snapshot.unitSystem = Config::instance()->unitSystem();
+    snapshot.cellBased = m_useCellBasedLayout && !m_cells.isEmpty();
+    snapshot.textLayouts = m_textLayouts;
+    snapshot.labelLayers = m_labelLayers;
+    return snapshot;
+}
+
+QImage OverlayGenerator::renderSnapshot(const RenderSnapshot& snapshot, DiveData* dive, double timePoint)
+{
+    if (!dive) {
+        qCWarning(lcRender) << "No dive data provided for overlay generation";
+        return QImage();
+    }
+
+    return renderSnapshot(snapshot, dive, dive->dataAtTime(timePoint));
+}
+
+QImage OverlayGenerator::renderSnapshot(const RenderSnapshot& snapshot, DiveData* dive,
+                                        const DiveDataPoint& dataPoint)
+{
+    if (!dive) {
+        qCWarning(lcRender) << "No dive data provided for overlay generation";
+        return QImage();
+    }
+
+    if (snapshot.incremental) {
+        return renderIncremental(snapshot, dive, dataPoint);
+    }
+
+    // Detaches from the snapshot's shared background on first paint
+    QImage result = snapshot.background;
+
     // Set up the painter
     QPainter painter(&result);
     painter.setRenderHint(QPainter::Antialiasing);
     painter.setRenderHint(QPainter::TextAntialiasing);
 
+    renderCellBasedOverlay(painter, result.size(), snapshot, dataPoint, dive);
+
+    painter.end();
+    return result;
+}
+
+QImage OverlayGenerator::generateOverlay(DiveData* dive, double timePoint)
+{
+    if (!dive) {
+        qCWarning(lcRender) << "No dive data provided for overlay generation";
+        return QImage();
+    }
+
+    RenderSnapshot snapshot = captureSnapshot();
+
     // Check if we should use cell-based layout (from loaded template)
-    if (m_useCellBasedLayout && !m_cells.isEmpty()) {
+    if (snapshot.cellBased) {
         // Use cell-based rendering with custom positions from template
-        renderCellBasedOverlay(painter, result.size(), dataPoint, dive);
-    } else {
-        // Use legacy section-based automatic layout
-        renderSectionBasedOverlay(painter, result.size(), dataPoint, dive);
+        return renderSnapshot(snapshot, dive, timePoint);
     }
 
+    // Use legacy section-based automatic layout
+    QImage result = snapshot.background;
+    DiveDataPoint dataPoint = dive->dataAtTime(timePoint);
+
+    QPainter painter(&result);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    renderSectionBasedOverlay(painter, result.size(), dataPoint, dive);
     painter.end();
     return result;
 }
@@ -1684,9 +1809,9 @@ QImage OverlayGenerator::generateOverlay(DiveData* dive, double timePoint)
 QString OverlayGenerator::generateCellDisplayText(Unabara::CellType cellType,
                                                    const DiveDataPoint& dataPoint,
                                                    int tankIndex, DiveData* dive,
-                                                   bool showLabel) const
+                                                   Units::UnitSystem unitSystem,
+                                                   bool showLabel)
 {
-    Units::UnitSystem unitSystem = Config::instance()->unitSystem();
     // ndl == 0 is a reported deco state; ndl < 0 means the computer never
     // reported NDL (must NOT read as deco — shows "NDL ---" instead).
     bool inDeco = (dataPoint.ndl == 0.0);
@@ -1865,192 +1990,335 @@ QString OverlayGenerator::generateCellDisplayText(Unabara::CellType cellType,
 
 namespace {
 
-// One separable sliding-window box blur pass over a premultiplied ARGB32 image.
-// Blurring all 4 channels of premultiplied data is alpha-correct.
-void boxBlurPass(QImage& img, int radius)
-{
-    const int w = img.width();
-    const int h = img.height();
-    const int window = 2 * radius + 1;
-    QVector<QRgb> line(qMax(w, h));
-
-    // Horizontal pass
-    for (int y = 0; y < h; ++y) {
-        QRgb* row = reinterpret_cast<QRgb*>(img.scanLine(y));
-        int sumA = 0, sumR = 0, sumG = 0, sumB = 0;
-        for (int x = -radius; x <= radius; ++x) {
-            QRgb p = row[qBound(0, x, w - 1)];
-            sumA += qAlpha(p); sumR += qRed(p); sumG += qGreen(p); sumB += qBlue(p);
+// Rasterises a cell's label line and its shadow into a layer of their own,
+// the text 'subpixelX' right of the layer's textOrigin. The shadow passes
+// mirror the ones renderCellBasedOverlay draws for the value lines.
+LabelLayerCache::Layer renderLabelLayer(const TextLayoutCache::Line& label, qreal subpixelX,
+                                        const QColor& color, bool shadowEnabled,
+                                        Unabara::ShadowType shadowType,
+                                        const QColor& shadowColor, int spx)
+{
+    // Room for glyph overhang, plus however far the shadow reaches
+    int margin = 2;
+    if (shadowEnabled) {
+        margin += shadowType == Unabara::ShadowType::Blurred ? spx * 4 : spx;
+    }
+
+    LabelLayerCache::Layer layer;
+    layer.textOrigin = QPoint(margin, margin);
+    layer.image = QImage(qCeil(label.width) + 1 + 2 * margin, label.height + 2 * margin,
+                         QImage::Format_ARGB32_Premultiplied);
+    layer.image.fill(Qt::transparent);
+
+    const QPointF origin(margin + subpixelX, margin);
+    QPainter p(&layer.image);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setRenderHint(QPainter::TextAntialiasing);
+
+    if (shadowEnabled) {
+        p.setPen(shadowColor);
+        switch (shadowType) {
+        case Unabara::ShadowType::Offset:
+            label.layout.draw(&p, origin + QPointF(spx, spx));
+            break;
+        case Unabara::ShadowType::Outline: {
+            static const QPoint dirs[8] = {{-1,-1},{0,-1},{1,-1},{-1,0},{1,0},{-1,1},{0,1},{1,1}};
+            for (const QPoint& d : dirs) {
+                label.layout.draw(&p, origin + d * spx);
+            }
+            break;
+        }
+        case Unabara::ShadowType::Blurred: {
+            QImage shadowImg(layer.image.size(), QImage::Format_ARGB32_Premultiplied);
+            shadowImg.fill(Qt::transparent);
+            {
+                QPainter sp(&shadowImg);
+                sp.setPen(shadowColor);
+                label.layout.draw(&sp, origin);
+            }
+            box_blur::blur(shadowImg, spx);
+            p.drawImage(QPoint(spx, spx), shadowImg);
+            break;
         }
-        for (int x = 0; x < w; ++x) {
-            line[x] = qRgba(sumR / window, sumG / window, sumB / window, sumA / window);
-            QRgb pOut = row[qBound(0, x - radius, w - 1)];
-            QRgb pIn = row[qBound(0, x + radius + 1, w - 1)];
-            sumA += qAlpha(pIn) - qAlpha(pOut);
-            sumR += qRed(pIn) - qRed(pOut);
-            sumG += qGreen(pIn) - qGreen(pOut);
-            sumB += qBlue(pIn) - qBlue(pOut);
         }
-        memcpy(row, line.constData(), w * sizeof(QRgb));
     }
 
-    // Vertical pass
-    const qsizetype stride = img.bytesPerLine() / sizeof(QRgb);
-    QRgb* bits = reinterpret_cast<QRgb*>(img.bits());
-    for (int x = 0; x < w; ++x) {
-        int sumA = 0, sumR = 0, sumG = 0, sumB = 0;
-        for (int y = -radius; y <= radius; ++y) {
-            QRgb p = bits[qBound(0, y, h - 1) * stride + x];
-            sumA += qAlpha(p); sumR += qRed(p); sumG += qGreen(p); sumB += qBlue(p);
+    p.setPen(color);
+    label.layout.draw(&p, origin);
+    return layer;
+}
+
+} // anonymous namespace
+
+// One visible cell laid out for one frame: everything paintCell() draws,
+// worked out before any of it is drawn so the incremental path knows where
+// a cell will paint.
+struct OverlayGenerator::CellPaint {
+    QString displayText;
+    QFont renderFont;
+    QColor labelColor;
+    QColor valueColor;
+    bool shadowEnabled = false;
+    Unabara::ShadowType shadowType = Unabara::ShadowType::Offset;
+    QColor shadowColor; // opacity applied
+    int spx = 1;        // shadow size in pixels
+    QVarLengthArray<std::shared_ptr<const TextLayoutCache::Line>, 4> lines;
+    QRect box;          // cell including its 4 px padding
+    QRect textRect;     // box minus the padding
+    QRect extent;       // all pixels painting the cell may touch
+};
+
+OverlayGenerator::CellPaint OverlayGenerator::layoutCell(const RenderSnapshot& snapshot,
+                                                         const Unabara::CellData& cell,
+                                                         const QSize& imageSize,
+                                                         const DiveDataPoint& dataPoint,
+                                                         DiveData* dive)
+{
+    CellPaint paint;
+
+    // Get effective font and colors (same as before)
+    QFont effectiveFont = cell.hasCustomFont() ? cell.font() : snapshot.font;
+    paint.labelColor = cell.hasCustomLabelColor() ? cell.labelColor() : snapshot.labelColor;
+    paint.valueColor = cell.hasCustomValueColor() ? cell.valueColor() : snapshot.valueColor;
+
+    // Effective shadow settings (single hasCustomShadow flag covers the group)
+    const bool customShadow = cell.hasCustomShadow();
+    paint.shadowEnabled = customShadow ? cell.shadowEnabled() : snapshot.shadowEnabled;
+    paint.shadowType = customShadow ? cell.shadowType() : snapshot.shadowType;
+    paint.shadowColor = customShadow ? cell.shadowColor() : snapshot.shadowColor;
+    const int shadowSize = customShadow ? cell.shadowSize() : snapshot.shadowSize;
+    const double shadowOpacity = customShadow ? cell.shadowOpacity() : snapshot.shadowOpacity;
+
+    // Same 1.8 scale factor as fonts
+    paint.spx = qMax(1, qRound(shadowSize * 1.8));
+    if (paint.shadowEnabled) {
+        paint.shadowColor.setAlphaF(paint.shadowColor.alphaF() * shadowOpacity);
+    }
+
+    // Generate displayText (same format as QML CellModel)
+    paint.displayText = generateCellDisplayText(cell.cellType(), dataPoint,
+                                                cell.tankIndex(), dive,
+                                                snapshot.unitSystem,
+                                                cell.showLabel());
+
+    // Scale font for template resolution (match calculateCellSize behavior)
+    // QML renders at preview size, but C++ renders at full template resolution
+    // then scales down, so we need scaled fonts to match
+    paint.renderFont = effectiveFont;
+    paint.renderFont.setPixelSize(getScaledFontSize(effectiveFont, 1.8));
+
+    // Shape each line once (cached across frames), then size the cell
+    // from the shaped lines the way QML's text metrics do
+    TextLayoutCache& textLayouts = *snapshot.textLayouts;
+    qreal textWidth = 0.0;
+    for (const QString& text : paint.displayText.split(QLatin1Char('\n'))) {
+        paint.lines.append(textLayouts.line(paint.renderFont, text));
+        textWidth = qMax(textWidth, paint.lines.last()->width);
+    }
+    const int lineSpacing = paint.lines.first()->lineSpacing;
+    const QSize textSize(qCeil(textWidth),
+                         static_cast<int>(paint.lines.size() - 1) * lineSpacing
+                             + paint.lines.last()->height);
+
+    // Convert normalized position (0-1) to pixel position
+    const int pixelX = static_cast<int>(cell.position().x() * imageSize.width());
+    const int pixelY = static_cast<int>(cell.position().y() * imageSize.height());
+
+    // Add padding (QML uses +8 for width and height)
+    paint.box = QRect(pixelX, pixelY, textSize.width() + 8, textSize.height() + 8);
+    paint.textRect = paint.box.adjusted(4, 4, -4, -4);
+
+    // Glyphs may overhang their advance a little; shadows reach further
+    int reach = qMax(2, lineSpacing / 4);
+    if (paint.shadowEnabled) {
+        reach += paint.shadowType == Unabara::ShadowType::Blurred ? paint.spx * 4 : paint.spx;
+    }
+    paint.extent = paint.box.adjusted(-reach, -reach, reach, reach);
+    return paint;
+}
+
+void OverlayGenerator::paintCell(QPainter& painter, const RenderSnapshot& snapshot,
+                                 const CellPaint& paint)
+{
+    const auto& lines = paint.lines;
+    const QRect& cellRect = paint.textRect;
+    const int pixelX = paint.box.x();
+    const int pixelY = paint.box.y();
+    const int cellWidth = paint.box.width();
+    const int cellHeight = paint.box.height();
+    const int lineSpacing = lines.first()->lineSpacing;
+    const int spx = paint.spx;
+
+    // Draws lines [from, to), each centered (QML's Text.AlignHCenter) in a
+    // cellRect-sized box at 'topLeft'. The lines are positioned the same
+    // way for every pass, so shadow, label and value stay aligned.
+    auto drawLines = [&](QPainter& p, const QPoint& topLeft, qsizetype from, qsizetype to) {
+        for (qsizetype i = from; i < to; ++i) {
+            const qreal x = topLeft.x() + (cellRect.width() - lines[i]->width) / 2.0;
+            lines[i]->layout.draw(&p, QPointF(x, topLeft.y() + i * lineSpacing));
+        }
+    };
+
+    // Draw semi-transparent background (like QML's "#80000000" Rectangle)
+    // Only in editor mode, not for export/preview
+    if (snapshot.showCellBackgrounds) {
+        painter.fillRect(paint.box, QColor(0, 0, 0, 128));
+    }
+
+    // A multi-line cell's first line is its label, which comes
+    // pre-rasterised with its shadow from the label layer; only the
+    // value lines are drawn (and shadowed) here on every frame
+    const qsizetype firstValue = lines.size() > 1 ? 1 : 0;
+    const int valueTop = static_cast<int>(firstValue) * lineSpacing;
+
+    // Draw the value shadow first, if enabled
+    if (paint.shadowEnabled && !paint.displayText.isEmpty()) {
+        switch (paint.shadowType) {
+        case Unabara::ShadowType::Offset:
+            painter.setPen(paint.shadowColor);
+            drawLines(painter, cellRect.topLeft() + QPoint(spx, spx), firstValue, lines.size());
+            break;
+        case Unabara::ShadowType::Outline: {
+            static const QPoint dirs[8] = {{-1,-1},{0,-1},{1,-1},{-1,0},{1,0},{-1,1},{0,1},{1,1}};
+            painter.setPen(paint.shadowColor);
+            for (const QPoint& d : dirs) {
+                drawLines(painter, cellRect.topLeft() + d * spx, firstValue, lines.size());
+            }
+            break;
         }
-        for (int y = 0; y < h; ++y) {
-            line[y] = qRgba(sumR / window, sumG / window, sumB / window, sumA / window);
-            QRgb pOut = bits[qBound(0, y - radius, h - 1) * stride + x];
-            QRgb pIn = bits[qBound(0, y + radius + 1, h - 1) * stride + x];
-            sumA += qAlpha(pIn) - qAlpha(pOut);
-            sumR += qRed(pIn) - qRed(pOut);
-            sumG += qGreen(pIn) - qGreen(pOut);
-            sumB += qBlue(pIn) - qBlue(pOut);
+        case Unabara::ShadowType::Blurred: {
+            // Render the value into its own image, blur it, composite offset
+            const int margin = spx * 3;  // room for the blur to spread
+            QImage shadowImg(cellWidth + 2 * margin, cellHeight - valueTop + 2 * margin,
+                             QImage::Format_ARGB32_Premultiplied);
+            shadowImg.fill(Qt::transparent);
+            {
+                QPainter sp(&shadowImg);
+                sp.setPen(paint.shadowColor);
+                drawLines(sp, QPoint(margin + 4, margin + 4 - valueTop), firstValue, lines.size());
+            }
+            box_blur::blur(shadowImg, spx);
+            painter.drawImage(QPoint(pixelX - margin + spx, pixelY + valueTop - margin + spx),
+                              shadowImg);
+            break;
         }
-        for (int y = 0; y < h; ++y) {
-            bits[y * stride + x] = line[y];
         }
     }
-}
 
-// Three box blur passes approximate a gaussian blur.
-void boxBlur(QImage& img, int radius)
-{
-    if (radius < 1) return;
-    for (int i = 0; i < 3; ++i) {
-        boxBlurPass(img, radius);
+    // Blit the label layer. The layer is keyed on the label's fractional
+    // x position too, so its glyphs land exactly where drawing them
+    // directly would have put them.
+    if (firstValue > 0) {
+        const TextLayoutCache::Line& label = *lines.first();
+        const qreal x = cellRect.left() + (cellRect.width() - label.width) / 2.0;
+        const int wholeX = qFloor(x);
+
+        LabelLayerCache::Key key;
+        key.font = paint.renderFont;
+        key.text = label.layout.text();
+        key.color = paint.labelColor.rgba();
+        key.shadowEnabled = paint.shadowEnabled;
+        key.shadowType = static_cast<int>(paint.shadowType);
+        key.shadowColor = paint.shadowEnabled ? paint.shadowColor.rgba() : 0;
+        key.shadowPixels = paint.shadowEnabled ? spx : 0;
+        key.subpixelX = qRound((x - wholeX) * 64);
+
+        const LabelLayerCache::Layer layer = snapshot.labelLayers->layer(key, [&] {
+            return renderLabelLayer(label, key.subpixelX / 64.0, paint.labelColor,
+                                    paint.shadowEnabled, paint.shadowType, paint.shadowColor, spx);
+        });
+        painter.drawImage(QPoint(wholeX, cellRect.top()) - layer.textOrigin, layer.image);
     }
-}
 
-} // anonymous namespace
+    // Draw the value text
+    painter.setPen(paint.valueColor);
+    drawLines(painter, cellRect.topLeft(), firstValue, lines.size());
+}
 
 void OverlayGenerator::renderCellBasedOverlay(QPainter& painter, const QSize& imageSize,
+                                              const RenderSnapshot& snapshot,
                                               const DiveDataPoint& dataPoint, DiveData* dive)
 {
-    int width = imageSize.width();
-    int height = imageSize.height();
+    for (const auto& cell : snapshot.cells) {
+        if (!cell.visible()) continue;
+        paintCell(painter, snapshot, layoutCell(snapshot, cell, imageSize, dataPoint, dive));
+    }
+}
 
-    // qDebug() << "Rendering cell-based overlay with" << m_cells.size() << "cells (QML-style)";
+QImage OverlayGenerator::renderIncremental(const RenderSnapshot& snapshot, DiveData* dive,
+                                           const DiveDataPoint& dataPoint)
+{
+    IncrementalFrames::Frame& previous = snapshot.incremental->frameForCurrentThread();
+    const QSize imageSize = snapshot.background.size();
 
-    for (const auto& cell : m_cells) {
-        if (!cell.visible()) continue;
+    std::vector<CellPaint> cells;
+    cells.reserve(snapshot.cells.size());
+    for (const auto& cell : snapshot.cells) {
+        if (cell.visible()) {
+            cells.push_back(layoutCell(snapshot, cell, imageSize, dataPoint, dive));
+        }
+    }
+    const int count = static_cast<int>(cells.size());
 
-        // Get effective font and colors (same as before)
-        QFont effectiveFont = cell.hasCustomFont() ? cell.font() : m_font;
-        QColor effectiveLabelColor = cell.hasCustomLabelColor() ? cell.labelColor() : m_labelColor;
-        QColor effectiveValueColor = cell.hasCustomValueColor() ? cell.valueColor() : m_valueColor;
-
-        // Effective shadow settings (single hasCustomShadow flag covers the group)
-        const bool customShadow = cell.hasCustomShadow();
-        const bool shadowEnabled = customShadow ? cell.shadowEnabled() : m_shadowEnabled;
-        const Unabara::ShadowType shadowType = customShadow ? cell.shadowType() : m_shadowType;
-        QColor shadowColor = customShadow ? cell.shadowColor() : m_shadowColor;
-        const int shadowSize = customShadow ? cell.shadowSize() : m_shadowSize;
-        const double shadowOpacity = customShadow ? cell.shadowOpacity() : m_shadowOpacity;
-
-        // Generate displayText (same format as QML CellModel)
-        QString displayText = generateCellDisplayText(cell.cellType(), dataPoint,
-                                                       cell.tankIndex(), dive,
-                                                       cell.showLabel());
-
-        // Scale font for template resolution (match calculateCellSize behavior)
-        // QML renders at preview size, but C++ renders at full template resolution
-        // then scales down, so we need scaled fonts to match
-        QFont renderFont = effectiveFont;
-        renderFont.setPixelSize(getScaledFontSize(effectiveFont, 1.8));
-
-        // Calculate text size using font metrics (like QML does)
-        painter.setFont(renderFont);
-        QFontMetrics fm(renderFont);
-        QRect textBounds = fm.boundingRect(QRect(0, 0, 1000, 1000),
-                                           Qt::AlignHCenter | Qt::TextWordWrap, displayText);
-
-        // Add padding (QML uses +8 for width and height)
-        int cellWidth = textBounds.width() + 8;
-        int cellHeight = textBounds.height() + 8;
-
-        // Convert normalized position (0-1) to pixel position
-        int pixelX = static_cast<int>(cell.position().x() * width);
-        int pixelY = static_cast<int>(cell.position().y() * height);
-
-        // Create cell rect for text
-        QRect cellRect(pixelX + 4, pixelY + 4, cellWidth - 8, cellHeight - 8);
-
-        // Draw semi-transparent background (like QML's "#80000000" Rectangle)
-        // Only in editor mode, not for export/preview
-        if (m_showCellBackgrounds) {
-            QRect bgRect(pixelX, pixelY, cellWidth, cellHeight);
-            painter.fillRect(bgRect, QColor(0, 0, 0, 128));
-        }
-
-        // Draw the shadow first, if enabled (same 1.8 scale factor as fonts)
-        if (shadowEnabled && !displayText.isEmpty()) {
-            shadowColor.setAlphaF(shadowColor.alphaF() * shadowOpacity);
-            const int spx = qMax(1, qRound(shadowSize * 1.8));
-
-            switch (shadowType) {
-            case Unabara::ShadowType::Offset:
-                painter.setPen(shadowColor);
-                painter.drawText(cellRect.translated(spx, spx),
-                                 Qt::AlignHCenter | Qt::TextDontClip, displayText);
-                break;
-            case Unabara::ShadowType::Outline: {
-                static const QPoint dirs[8] = {{-1,-1},{0,-1},{1,-1},{-1,0},{1,0},{-1,1},{0,1},{1,1}};
-                painter.setPen(shadowColor);
-                for (const QPoint& d : dirs) {
-                    painter.drawText(cellRect.translated(d.x() * spx, d.y() * spx),
-                                     Qt::AlignHCenter | Qt::TextDontClip, displayText);
-                }
-                break;
-            }
-            case Unabara::ShadowType::Blurred: {
-                // Render the text into its own image, blur it, composite offset
-                const int margin = spx * 3;  // room for the blur to spread
-                QImage shadowImg(cellWidth + 2 * margin, cellHeight + 2 * margin,
-                                 QImage::Format_ARGB32_Premultiplied);
-                shadowImg.fill(Qt::transparent);
-                {
-                    QPainter sp(&shadowImg);
-                    sp.setFont(renderFont);
-                    sp.setPen(shadowColor);
-                    sp.drawText(QRect(margin + 4, margin + 4, cellWidth - 8, cellHeight - 8),
-                                Qt::AlignHCenter | Qt::TextDontClip, displayText);
-                }
-                boxBlur(shadowImg, spx);
-                painter.drawImage(QPoint(pixelX - margin + spx, pixelY - margin + spx), shadowImg);
-                break;
+    // Cells whose text changed repaint, over both where they were and where
+    // they will be. Anything overlapping that area would lose pixels to the
+    // restored background, so it repaints too, until nothing more overlaps.
+    // A cell's pixels depend only on its text, so the rest of the previous
+    // frame is already right.
+    QVector<bool> dirty(count, previous.image.isNull() || previous.texts.size() != count);
+    QRegion repaint;
+    for (int i = 0; i < count; ++i) {
+        if (dirty[i] || previous.texts[i] != cells[i].displayText) {
+            dirty[i] = true;
+            repaint += cells[i].extent;
+            if (i < previous.extents.size()) {
+                repaint += previous.extents[i];
             }
+        }
+    }
+    for (bool grew = true; grew;) {
+        grew = false;
+        for (int i = 0; i < count; ++i) {
+            if (!dirty[i] && repaint.intersects(cells[i].extent)) {
+                dirty[i] = true;
+                repaint += cells[i].extent;
+                grew = true;
             }
         }
+    }
 
-        // Draw the text (center-aligned to match QML's Text.AlignHCenter).
-        // The label line and the value line have independent colors: the
-        // combined string is drawn twice with complementary clip bands so the
-        // multi-line layout stays byte-identical to a single drawText (drawing
-        // the lines separately drifts by a pixel for some font sizes).
-        if (displayText.indexOf(QLatin1Char('\n')) < 0) {
-            painter.setPen(effectiveValueColor);
-            painter.drawText(cellRect, Qt::AlignHCenter, displayText);
-        } else {
-            const QRect labelBand(cellRect.x(), cellRect.y(),
-                                  cellRect.width(), fm.lineSpacing());
-            painter.save();
-            painter.setClipRect(labelBand);
-            painter.setPen(effectiveLabelColor);
-            painter.drawText(cellRect, Qt::AlignHCenter, displayText);
-            painter.setClipRect(QRect(labelBand.x(), labelBand.y() + labelBand.height(),
-                                      labelBand.width(),
-                                      cellRect.height() - labelBand.height()));
-            painter.setPen(effectiveValueColor);
-            painter.drawText(cellRect, Qt::AlignHCenter, displayText);
-            painter.restore();
+    // The previous frame (or on a thread's first frame, the background);
+    // detaches from whoever still holds it on first paint
+    QImage result = previous.image.isNull() ? snapshot.background : previous.image;
+    int redrawn = 0;
+    if (!repaint.isEmpty()) {
+        QPainter painter(&result);
+        if (!previous.image.isNull()) {
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+            for (const QRect& rect : repaint & result.rect()) {
+                painter.drawImage(rect.topLeft(), snapshot.background, rect);
+            }
+            painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        }
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setRenderHint(QPainter::TextAntialiasing);
+        for (int i = 0; i < count; ++i) {
+            if (dirty[i]) {
+                paintCell(painter, snapshot, cells[i]);
+                ++redrawn;
+            }
         }
     }
+
+    previous.image = result;
+    previous.texts.resize(count);
+    previous.extents.resize(count);
+    for (int i = 0; i < count; ++i) {
+        previous.texts[i] = cells[i].displayText;
+        previous.extents[i] = cells[i].extent;
+    }
+    snapshot.incremental->countFrame(count, redrawn);
+    return result;
 }
 
 // Frozen legacy path: only reachable with an empty cell list, which cannot
@@ -2257,7 +2525,7 @@ void OverlayGenerator::renderSectionBasedOverlay(QPainter& painter, const QSize&
 QImage OverlayGenerator::generatePreview(DiveData* dive)
 {
     if (!dive) {
-        qWarning() << "No dive data provided for preview generation";
+        qCWarning(lcRender) << "No dive data provided for preview generation";
         return QImage();
     }
 
@@ -2266,7 +2534,7 @@ QImage OverlayGenerator::generatePreview(DiveData* dive)
     return generateOverlay(dive, timePoint);
 }
 
-int OverlayGenerator::getScaledFontSize(const QFont& baseFont, double scale) const {
+int OverlayGenerator::getScaledFontSize(const QFont& baseFont, double scale) {
     int baseSize = baseFont.pointSize();
     if (baseSize <= 0) {
         // Fallback to pixel size if point size is not set
@@ -2465,12 +2733,12 @@ void OverlayGenerator::drawTemperature(QPainter &painter, double temp, const QRe
 void OverlayGenerator::drawPressure(QPainter &painter, double pressure, const QRect &rect, int tankIndex, DiveData* dive) {
     painter.save();
 
-    qDebug() << "Drawing pressure for tank index:" << tankIndex
+    qCDebug(lcRender) << "Drawing pressure for tank index:" << tankIndex
              << "Pressure:" << pressure;
     // Get tank count for adaptive layout
     int tankCount = dive ? dive->cylinderCount() : 1;
 
-    qDebug() << "Tank count:" << tankCount;
+    qCDebug(lcRender) << "Tank count:" << tankCount;
 
     // Proportional positioning
     int padding = qMax(2, rect.height() / 20);
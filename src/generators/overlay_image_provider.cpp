@@ -1,6 +1,6 @@
 #include "include/generators/overlay_image_provider.h"
+#include "include/core/logging.h"
 #include "include/generators/frame_cache.h"
-#include <QDebug>
 
 OverlayImageProvider::OverlayImageProvider(OverlayGenerator* generator)
     : QQuickImageProvider(QQuickImageProvider::Image)
@@ -12,10 +12,10 @@ OverlayImageProvider::OverlayImageProvider(OverlayGenerator* generator)
 
 QImage OverlayImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
-    qDebug() << "OverlayImageProvider::requestImage called with id:" << id;
+    qCDebug(lcRender) << "OverlayImageProvider::requestImage called with id:" << id;
     
     if (!m_generator || !m_currentDive) {
-        qWarning() << "OverlayImageProvider: Generator or dive data not set";
+        qCWarning(lcRender) << "OverlayImageProvider: Generator or dive data not set";
         QImage emptyImage(640, 120, QImage::Format_ARGB32);
         emptyImage.fill(Qt::black);
         
@@ -52,7 +52,7 @@ QImage OverlayImageProvider::requestImage(const QString &id, QSize *size, const
         }
     } else if (id.startsWith("preview/")) {
         // For preview images, use the current time
-        qDebug() << "OverlayImageProvider: Generating preview at time:" << m_currentTime;
+        qCDebug(lcRender) << "OverlayImageProvider: Generating preview at time:" << m_currentTime;
         result = m_generator->generateOverlay(m_currentDive, m_currentTime);
     } else {
         // For specific time points
@@ -70,7 +70,7 @@ QImage OverlayImageProvider::requestImage(const QString &id, QSize *size, const
     m_generator->setShowCellBackgrounds(prevShowCellBg);
     
     if (result.isNull()) {
-        qWarning() << "OverlayImageProvider: Failed to generate overlay image";
+        qCWarning(lcRender) << "OverlayImageProvider: Failed to generate overlay image";
         QImage emptyImage(640, 120, QImage::Format_ARGB32);
         emptyImage.fill(Qt::black);
         result = emptyImage;
@@ -353,20 +353,79 @@ void ProfileGenerator::setGridShowLabels(bool show)
     }
 }
 
+ProfileGenerator::RenderSettings ProfileGenerator::captureSettings() const
+{
+    RenderSettings settings;
+    settings.backgroundColor   = m_backgroundColor;
+    settings.backgroundOpacity = m_backgroundOpacity;
+    settings.curveColor        = m_curveColor;
+    settings.curveWidth        = m_curveWidth;
+    settings.indicatorColor    = m_indicatorColor;
+    settings.indicatorMode     = m_indicatorMode;
+    settings.indicatorRadius   = m_indicatorRadius;
+    settings.pulsePeriodMs     = m_pulsePeriodMs;
+    settings.outputWidth       = m_outputWidth;
+    settings.outputHeight      = m_outputHeight;
+    settings.decoZoneColor     = m_decoZoneColor;
+    settings.decoZoneOpacity   = m_decoZoneOpacity;
+    settings.gridEnabled       = m_gridEnabled;
+    settings.gridDepthInterval = m_gridDepthInterval;
+    settings.gridTimeInterval  = m_gridTimeInterval;
+    settings.gridColor         = m_gridColor;
+    settings.gridOpacity       = m_gridOpacity;
+    settings.gridLineWidth     = m_gridLineWidth;
+    settings.gridShowLabels    = m_gridShowLabels;
+    settings.unitSystem        = Config::instance()->unitSystem();
+    return settings;
+}
+
+void ProfileGenerator::beginExport()
+{
+    m_exportSettings = captureSettings();
+    {
+        QMutexLocker lock(&m_baseCacheMutex);
+        m_exportBaseCache = BaseCache();
+    }
+    m_exporting = true;
+}
+
+void ProfileGenerator::endExport()
+{
+    m_exporting = false;
+    QMutexLocker lock(&m_baseCacheMutex);
+    m_exportBaseCache = BaseCache();
+}
+
 QImage ProfileGenerator::generate(DiveData* dive, double timePoint)
 {
+    // Outside an export pass (frame caches, scripted calls) the live
+    // settings apply, as for renderFrame()
+    const RenderSettings settings = m_exporting ? m_exportSettings : captureSettings();
+
     // Export path: pulse phase is deterministic from the dive-time so a
     // sequence of exported frames advances the pulse predictably.
-    const double pulsePhase01 = (m_pulsePeriodMs > 0)
-        ? std::fmod(timePoint * 1000.0, static_cast<double>(m_pulsePeriodMs)) / m_pulsePeriodMs
+    const double pulsePhase01 = (settings.pulsePeriodMs > 0)
+        ? std::fmod(timePoint * 1000.0, static_cast<double>(settings.pulsePeriodMs)) / settings.pulsePeriodMs
         : 0.0;
-    return renderFrame(dive, timePoint, pulsePhase01);
+    if (m_exporting) {
+        return render(settings, m_exportBaseCache, 0, dive, timePoint, pulsePhase01);
+    }
+    return render(settings, m_baseCache, m_baseCacheGen.load(std::memory_order_relaxed),
+                  dive, timePoint, pulsePhase01);
 }
 
 QImage ProfileGenerator::renderFrame(DiveData* dive, double timePoint, double pulsePhase01)
+{
+    const RenderSettings settings = captureSettings();
+    return render(settings, m_baseCache, m_baseCacheGen.load(std::memory_order_relaxed),
+                  dive, timePoint, pulsePhase01);
+}
+
+QImage ProfileGenerator::render(const RenderSettings& settings, BaseCache& cache, quint64 gen,
+                                DiveData* dive, double timePoint, double pulsePhase01)
 {
     if (!dive) {
-        QImage img(m_outputWidth, m_outputHeight, QImage::Format_ARGB32_Premultiplied);
+        QImage img(settings.outputWidth, settings.outputHeight, QImage::Format_ARGB32_Premultiplied);
         img.fill(Qt::transparent);
         return img;
     }
@@ -374,60 +433,58 @@ QImage ProfileGenerator::renderFrame(DiveData* dive, double timePoint, double pu
     QImage img;
     {
         QMutexLocker lock(&m_baseCacheMutex);
-        const quint64 gen = m_baseCacheGen.load(std::memory_order_relaxed);
-        const int points = dive->allDataPoints().size();
+        const int points = dive->sampleCount();
         // The dive pointer + sample count identify the dive contents well
         // enough: dives are fully populated by the parser before they reach
         // the UI, and the count guards against a recycled allocation.
-        if (m_baseCacheBuiltGen != gen || m_baseCacheDive != dive
-            || m_baseCachePoints != points
-            || m_baseCache.width() != m_outputWidth
-            || m_baseCache.height() != m_outputHeight) {
-            m_baseCache = renderBase(dive);
-            m_baseCacheBuiltGen = gen;
-            m_baseCacheDive = dive;
-            m_baseCachePoints = points;
+        if (cache.image.isNull() || cache.builtGen != gen || cache.dive != dive
+            || cache.points != points
+            || cache.image.width() != settings.outputWidth
+            || cache.image.height() != settings.outputHeight) {
+            cache.image = renderBase(settings, dive);
+            cache.builtGen = gen;
+            cache.dive = dive;
+            cache.points = points;
         }
-        img = m_baseCache; // implicitly shared; detaches on first paint below
+        img = cache.image; // implicitly shared; detaches on first paint below
     }
 
     QPainter painter(&img);
     const QRectF rect(0, 0, img.width(), img.height());
-    ProfileRenderer::drawIndicator(painter, rect, dive, timePoint, m_indicatorColor,
-                                   static_cast<double>(m_indicatorRadius),
-                                   m_indicatorMode == Pulsing, pulsePhase01);
+    ProfileRenderer::drawIndicator(painter, rect, dive, timePoint, settings.indicatorColor,
+                                   static_cast<double>(settings.indicatorRadius),
+                                   settings.indicatorMode == Pulsing, pulsePhase01);
 
     return img;
 }
 
-QImage ProfileGenerator::renderBase(DiveData* dive)
+QImage ProfileGenerator::renderBase(const RenderSettings& settings, DiveData* dive)
 {
-    QImage img(m_outputWidth, m_outputHeight, QImage::Format_ARGB32_Premultiplied);
+    QImage img(settings.outputWidth, settings.outputHeight, QImage::Format_ARGB32_Premultiplied);
     img.fill(Qt::transparent);
 
     QPainter painter(&img);
-    const QRectF rect(0, 0, m_outputWidth, m_outputHeight);
+    const QRectF rect(0, 0, settings.outputWidth, settings.outputHeight);
 
-    ProfileRenderer::drawBackground(painter, rect, m_backgroundColor, m_backgroundOpacity);
-    if (m_gridEnabled) {
+    ProfileRenderer::drawBackground(painter, rect, settings.backgroundColor, settings.backgroundOpacity);
+    if (settings.gridEnabled) {
         ProfileRenderer::GridOptions g;
-        const Units::UnitSystem unitSystem = Config::instance()->unitSystem();
         // depth interval is entered in the user's unit; convert to meters.
-        const double intervalMeters = (unitSystem == Units::UnitSystem::Imperial)
-            ? Units::feetToMeters(static_cast<double>(m_gridDepthInterval))
-            : static_cast<double>(m_gridDepthInterval);
+        const double intervalMeters = (settings.unitSystem == Units::UnitSystem::Imperial)
+            ? Units::feetToMeters(static_cast<double>(settings.gridDepthInterval))
+            : static_cast<double>(settings.gridDepthInterval);
         g.depthIntervalMeters = intervalMeters;
-        g.timeIntervalSec = m_gridTimeInterval;
-        g.color = m_gridColor;
-        g.opacity = m_gridOpacity;
-        g.lineWidth = static_cast<double>(m_gridLineWidth);
-        g.showLabels = m_gridShowLabels;
-        g.unitSystem = unitSystem;
+        g.timeIntervalSec = settings.gridTimeInterval;
+        g.color = settings.gridColor;
+        g.opacity = settings.gridOpacity;
+        g.lineWidth = static_cast<double>(settings.gridLineWidth);
+        g.showLabels = settings.gridShowLabels;
+        g.unitSystem = settings.unitSystem;
         ProfileRenderer::drawGrid(painter, rect, dive, g);
     }
-    ProfileRenderer::drawDecoZone(painter, rect, dive, m_decoZoneColor, m_decoZoneOpacity);
-    ProfileRenderer::drawDepthCurve(painter, rect, dive, m_curveColor,
-                                    static_cast<double>(m_curveWidth));
+    ProfileRenderer::drawDecoZone(painter, rect, dive, settings.decoZoneColor, settings.decoZoneOpacity);
+    ProfileRenderer::drawDepthCurve(painter, rect, dive, settings.curveColor,
+                                    static_cast<double>(settings.curveWidth));
 
     return img;
 }
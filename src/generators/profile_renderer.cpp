@@ -64,8 +64,8 @@ void drawDepthCurve(QPainter& p, const QRectF& rect, DiveData* dive,
     if (!dive) {
         return;
     }
-    const auto& points = dive->allDataPoints();
-    if (points.size() < 2) {
+    const DiveSampleColumns& samples = dive->samples();
+    if (samples.size() < 2) {
         return;
     }
     const double depthMax = depthAxisMax(dive);
@@ -76,8 +76,8 @@ void drawDepthCurve(QPainter& p, const QRectF& rect, DiveData* dive,
 
     QPainterPath path;
     bool first = true;
-    for (const DiveDataPoint& pt : points) {
-        const QPointF pix = samplePoint(rect, pt.timestamp, pt.depth, tMax, depthMax);
+    for (int i = 0; i < samples.size(); ++i) {
+        const QPointF pix = samplePoint(rect, samples.timestamp[i], samples.depth[i], tMax, depthMax);
         if (first) {
             path.moveTo(pix);
             first = false;
@@ -178,8 +178,8 @@ void drawDecoZone(QPainter& p, const QRectF& rect, DiveData* dive,
     if (!dive || opacity <= 0.0) {
         return;
     }
-    const auto& points = dive->allDataPoints();
-    if (points.size() < 2) {
+    const DiveSampleColumns& samples = dive->samples();
+    if (samples.size() < 2) {
         return;
     }
     const double depthMax = depthAxisMax(dive);
@@ -221,15 +221,17 @@ void drawDecoZone(QPainter& p, const QRectF& rect, DiveData* dive,
         path.addPath(poly);
     };
 
-    for (const DiveDataPoint& pt : points) {
-        if (pt.ceiling > 0.0) {
+    for (int i = 0; i < samples.size(); ++i) {
+        const double t = samples.timestamp[i];
+        const double ceiling = samples.ceiling[i];
+        if (ceiling > 0.0) {
             if (!inRun) {
                 inRun = true;
                 ceilingPts.clear();
-                runStartT = pt.timestamp;
+                runStartT = t;
             }
-            ceilingPts.append(samplePoint(rect, pt.timestamp, pt.ceiling, tMax, depthMax));
-            runEndT = pt.timestamp;
+            ceilingPts.append(samplePoint(rect, t, ceiling, tMax, depthMax));
+            runEndT = t;
         } else if (inRun) {
             flushRun();
             inRun = false;
@@ -0,0 +1,79 @@
+#include "include/generators/text_layout_cache.h"
+
+#include <QFontMetrics>
+#include <QThread>
+
+namespace {
+
+// Cells times the distinct values a few hundred frames show
+constexpr qsizetype kMaxLinesPerShard = 1024;
+
+} // namespace
+
+std::shared_ptr<const TextLayoutCache::Line> TextLayoutCache::line(const QFont &font, const QString &text)
+{
+    Shard &shard = shardForCurrentThread();
+    const Key key{font, text};
+    if (auto it = shard.lines.constFind(key); it != shard.lines.cend()) {
+        return it.value();
+    }
+
+    auto line = std::make_shared<Line>();
+    QTextOption option;
+    option.setWrapMode(QTextOption::NoWrap);
+    line->layout.setText(text);
+    line->layout.setFont(font);
+    line->layout.setTextOption(option);
+    line->layout.setCacheEnabled(true);
+    line->layout.beginLayout();
+    QTextLine textLine = line->layout.createLine();
+    if (textLine.isValid()) {
+        textLine.setPosition(QPointF(0.0, 0.0));
+        line->width = textLine.naturalTextWidth();
+    }
+    line->layout.endLayout();
+
+    const QFontMetrics metrics(font);
+    line->height = metrics.height();
+    line->lineSpacing = metrics.lineSpacing();
+
+    if (shard.lines.size() >= kMaxLinesPerShard) {
+        shard.lines.clear();
+    }
+    shard.lines.insert(key, line);
+    return line;
+}
+
+void TextLayoutCache::clear()
+{
+    std::unordered_map<QThread *, std::unique_ptr<Shard>> dropped;
+    QMutexLocker lock(&m_shards->mutex);
+    dropped.swap(m_shards->byThread);
+}
+
+TextLayoutCache::Shard &TextLayoutCache::shardForCurrentThread()
+{
+    QThread *thread = QThread::currentThread();
+    QMutexLocker lock(&m_shards->mutex);
+    std::unique_ptr<Shard> &shard = m_shards->byThread[thread];
+    if (!shard) {
+        shard = std::make_unique<Shard>();
+        // Emitted on the finishing thread, which is done rendering, so its
+        // glyphs are released where they were shaped
+        const std::weak_ptr<Shards> shards = m_shards;
+        shard->threadFinished = QObject::connect(thread, &QThread::finished, [shards, thread]() {
+            const std::shared_ptr<Shards> table = shards.lock();
+            if (!table) {
+                return;
+            }
+            std::unique_ptr<Shard> finished;
+            QMutexLocker lock(&table->mutex);
+            if (auto it = table->byThread.find(thread); it != table->byThread.end()) {
+                finished = std::move(it->second);
+                table->byThread.erase(it);
+            }
+        });
+    }
+    // The shard itself is stable and only used by this thread from here on
+    return *shard;
+}
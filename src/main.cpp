@@ -187,6 +187,10 @@ int main(int argc, char *argv[])
                      &mainWindow, &MainWindow::onDiveImported);
     QObject::connect(&logParser, &LogParser::multipleImported,
                      &mainWindow, &MainWindow::onMultipleDivesImported);
+    QObject::connect(&logParser, &LogParser::diveReplaced,
+                     &mainWindow, &MainWindow::onDiveReplaced);
+    QObject::connect(&logParser, &LogParser::logbookUpdated,
+                     &mainWindow, &MainWindow::onLogbookUpdated);
 
     // Connect signals to update the image providers when the active dive changes
     QObject::connect(&mainWindow, &MainWindow::currentDiveChanged,
@@ -6,6 +6,8 @@
 #include <QCoreApplication>
 #include <QStandardPaths>
 
+#include <algorithm>
+
 MainWindow::MainWindow(QObject *parent)
     : QObject(parent)
     , m_currentDive(nullptr)
@@ -80,6 +82,29 @@ QString MainWindow::urlToLocalFile(const QString &urlString)
     return urlString;
 }
 
+QVariantList MainWindow::diveList() const
+{
+    QVariantList diveVariants;
+    for (int i = 0; i < m_logbookDives.size(); ++i) {
+        DiveData* dive = m_logbookDives[i];
+        if (!dive) {
+            continue;
+        }
+        QVariantMap diveMap;
+        diveMap["index"] = i;  // Store the index instead of pointer
+        diveMap["diveNumber"] = dive->diveNumber();
+        diveMap["diveName"] = dive->diveName();
+        diveMap["startTime"] = dive->startTime();
+        diveMap["location"] = dive->location();
+        diveMap["diveSiteName"] = dive->diveSiteName();
+        diveMap["diveSiteId"] = dive->diveSiteId();
+        diveMap["durationSeconds"] = dive->durationSeconds();
+        diveMap["maxDepth"] = dive->maxDepth();
+        diveVariants.append(diveMap);
+    }
+    return diveVariants;
+}
+
 void MainWindow::onDiveImported(DiveData* dive)
 {
     if (!dive) {
@@ -91,6 +116,8 @@ void MainWindow::onDiveImported(DiveData* dive)
     
     // Add the dive to our list of available dives
     m_availableDives.append(dive);
+    m_logbookDives = {dive};
+    emit diveListChanged();
     
     // Set it as the current dive
     setCurrentDive(dive);
@@ -109,28 +136,13 @@ void MainWindow::onMultipleDivesImported(QList<DiveData*> dives)
     
     qDebug() << "MainWindow::onMultipleDivesImported - Received" << dives.size() << "dives";
     
-    // Store the dives for selection
-    m_pendingDiveSelection = dives;
-    
-    // Convert to QVariantList for QML
-    QVariantList diveVariants;
-    for (int i = 0; i < dives.size(); ++i) {
-        DiveData* dive = dives[i];
-        QVariantMap diveMap;
-        diveMap["index"] = i;  // Store the index instead of pointer
-        diveMap["diveNumber"] = dive->diveNumber();
-        diveMap["diveName"] = dive->diveName();
-        diveMap["startTime"] = dive->startTime();
-        diveMap["location"] = dive->location();
-        diveMap["diveSiteName"] = dive->diveSiteName();
-        diveMap["diveSiteId"] = dive->diveSiteId();
-        diveMap["durationSeconds"] = dive->durationSeconds();
-        diveMap["maxDepth"] = dive->maxDepth();
-        diveVariants.append(diveMap);
-    }
+    // Ours from now on, whichever one gets selected
+    m_availableDives.append(dives);
+    m_logbookDives = dives;
+    emit diveListChanged();
     
     // Signal QML to show the selection dialog
-    emit multipleDivesFound(diveVariants);
+    emit multipleDivesFound(diveList());
 }
 
 void MainWindow::onDiveSelected(DiveData* dive)
@@ -150,21 +162,61 @@ void MainWindow::onDiveSelected(DiveData* dive)
              << "max depth:" << m_currentDive->maxDepth() << "meters";
 }
 
+void MainWindow::onDiveReplaced(DiveData* oldDive, DiveData* newDive)
+{
+    // Take the old dive's place, so list indices the UI holds stay valid
+    for (QList<DiveData*> *dives : {&m_availableDives, &m_logbookDives}) {
+        const qsizetype index = dives->indexOf(oldDive);
+        if (index >= 0) {
+            dives->replace(index, newDive);
+        }
+    }
+    emit diveListChanged();
+
+    if (m_currentDive == oldDive) {
+        qDebug() << "MainWindow::onDiveReplaced - Current dive changed on disk:" << newDive->diveName();
+        setCurrentDive(newDive);
+    }
+}
+
+void MainWindow::onLogbookUpdated(QList<DiveData*> added, QList<DiveData*> removed)
+{
+    qDebug() << "MainWindow::onLogbookUpdated -" << added.size() << "dives added or changed,"
+             << removed.size() << "removed";
+
+    // Replaced dives already took their old version's place
+    for (DiveData* dive : std::as_const(added)) {
+        if (!m_availableDives.contains(dive)) {
+            m_availableDives.append(dive);
+        }
+        if (!m_logbookDives.contains(dive)) {
+            m_logbookDives.append(dive);
+        }
+    }
+
+    for (DiveData* dive : std::as_const(removed)) {
+        m_availableDives.removeAll(dive);
+        // Nulled rather than removed: later entries keep their index
+        std::replace(m_logbookDives.begin(), m_logbookDives.end(), dive, static_cast<DiveData*>(nullptr));
+        if (m_currentDive == dive) {
+            setCurrentDive(nullptr);
+        }
+        // QML bindings may still hold it until the next event loop turn
+        dive->deleteLater();
+    }
+
+    emit diveListChanged();
+}
+
 void MainWindow::selectDiveByIndex(int index)
 {
-    if (index < 0 || index >= m_pendingDiveSelection.size()) {
+    // Null if the dive was removed from the watched log meanwhile
+    DiveData* selectedDive = m_logbookDives.value(index);
+    if (!selectedDive) {
         qDebug() << "MainWindow::selectDiveByIndex - Invalid index:" << index;
         return;
     }
     
-    DiveData* selectedDive = m_pendingDiveSelection[index];
-    
-    // Add all pending dives to available dives list
-    m_availableDives.append(m_pendingDiveSelection);
-    
-    // Clear the pending selection
-    m_pendingDiveSelection.clear();
-    
     // Set the selected dive as current
     onDiveSelected(selectedDive);
 }
\ No newline at end of file
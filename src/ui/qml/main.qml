@@ -19,6 +19,9 @@ ApplicationWindow {
     property url currentVideoUrl: ""
     // UTC seconds since epoch from video file metadata; -1 if unavailable
     property double videoCreationTime: -1
+    // Why the last background re-read of the watched dive log failed;
+    // shown in the toolbar, cleared by the next attempt
+    property string logbookRefreshError: ""
 
     // Template-editor undo/redo.
     // StandardKey resolves the platform-native binding.
@@ -48,6 +51,7 @@ ApplicationWindow {
             if (success) {
                 messageDialog.title = qsTr("Export Completed")
                 messageDialog.message = qsTr("Images exported successfully to:\n") + path
+                                        + "\n\n" + imageExporter.summary
                 messageDialog.open()
             }
         }
@@ -81,6 +85,7 @@ ApplicationWindow {
             if (success) {
                 messageDialog.title = qsTr("Export Completed")
                 messageDialog.message = qsTr("Video exported successfully to:\n") + path
+                                        + "\n\n" + videoExporter.summary
                 messageDialog.open()
             }
         }
@@ -93,6 +98,14 @@ ApplicationWindow {
         }
     }
 
+    // An export renders the current dives from start to finish; changes to
+    // the watched logbook wait until it is done
+    Binding {
+        target: logParser
+        property: "refreshHeld"
+        value: imageExporter.busy || videoExporter.busy
+    }
+
     Connections {
         target: videoExporter
         function onProgressChanged() {
@@ -232,10 +245,37 @@ ApplicationWindow {
         target: mainWindow
         function onMultipleDivesFound(dives) {
             console.log("Multiple dives found, showing selection dialog")
-            diveSelectionDialog.show(dives)
+            diveSelectionDialog.show()
         }
     }
     
+    Connections {
+        target: logParser
+        function onBusyChanged() {
+            if (logParser.busy)
+                importProgressDialog.open()
+            else
+                importProgressDialog.close()
+        }
+        function onErrorOccurred(error) {
+            messageDialog.title = qsTr("Import Error")
+            messageDialog.message = error
+            messageDialog.open()
+        }
+        // Background re-reads of a watched log: a save caught half-way is
+        // retried on the next change, so no dialog for it
+        function onRefreshFailed(error) {
+            window.logbookRefreshError = error
+        }
+        function onRefreshingChanged() {
+            if (logParser.refreshing)
+                window.logbookRefreshError = ""
+        }
+        function onWatchedLogbookChanged() {
+            window.logbookRefreshError = ""
+        }
+    }
+
     Connections {
         target: updateChecker
         function onUpdateAvailable(latestVersion, releaseUrl) {
@@ -296,7 +336,40 @@ ApplicationWindow {
                     id: importMenu
                     MenuItem {
                         text: qsTr("Import Dive Log")
-                        onTriggered: importDiveLogFileDialog.open()
+                        onTriggered: {
+                            importDiveLogFileDialog.watchSelected = false
+                            importDiveLogFileDialog.open()
+                        }
+                    }
+                    MenuItem {
+                        // Re-imports the log whenever it is saved again (e.g.
+                        // from Subsurface); only changed dives are re-parsed.
+                        // Checking it watches the current log, or asks for
+                        // one if none is loaded yet.
+                        id: watchDiveLogItem
+                        text: qsTr("Watch Dive Log for Changes")
+                        checkable: true
+                        checked: logParser.watchedLogbook !== ""
+                        onToggled: {
+                            if (!checked) {
+                                logParser.stopWatching()
+                            } else if (logParser.currentLogbook !== "") {
+                                logParser.watchLogbook(logParser.currentLogbook)
+                            } else {
+                                importDiveLogFileDialog.watchSelected = true
+                                importDiveLogFileDialog.open()
+                            }
+                            // Toggling replaced the binding; the parser's
+                            // state decides whether it is checked
+                            checked = Qt.binding(function() { return logParser.watchedLogbook !== "" })
+                        }
+                    }
+                    MenuItem {
+                        // Pick another dive of the loaded log, including
+                        // ones added to a watched log since
+                        text: qsTr("Select Dive...")
+                        enabled: mainWindow.diveList.length > 1
+                        onTriggered: diveSelectionDialog.show()
                     }
                     MenuItem {
                         text: qsTr("Import Video")
@@ -368,6 +441,27 @@ ApplicationWindow {
                 horizontalAlignment: Qt.AlignHCenter
                 Layout.fillWidth: true
             }
+
+            Label {
+                // Watched dive log status; failures are kept out of the way
+                // of whatever the user is doing
+                visible: logParser.watchedLogbook !== ""
+                text: logParser.refreshing ? qsTr("Reading dive log...")
+                      : window.logbookRefreshError !== "" ? qsTr("Dive log not updated")
+                      : qsTr("Watching dive log")
+                color: window.logbookRefreshError !== "" && !logParser.refreshing
+                       ? "#d04040" : palette.placeholderText
+                font.italic: true
+
+                MouseArea {
+                    id: watchStatusArea
+                    anchors.fill: parent
+                    hoverEnabled: true
+                }
+                ToolTip.visible: watchStatusArea.containsMouse
+                ToolTip.text: window.logbookRefreshError !== "" ? window.logbookRefreshError
+                                                                : logParser.watchedLogbook
+            }
             
             Item { Layout.fillWidth: true }
         }
@@ -827,20 +921,24 @@ ApplicationWindow {
     FileDialog {
         id: importDiveLogFileDialog
         title: qsTr("Import Dive Log")
-        nameFilters: ["Dive log files (*.xml *.ssrf *.uddf *.fit)", "All files (*)"]
+        nameFilters: ["Dive log files (*.xml *.ssrf *.uddf *.fit *.gz *.zst)", "All files (*)"]
+        // Opened from "Watch Dive Log for Changes" with no log loaded
+        property bool watchSelected: false
         onAccepted: {
             console.log("Selected file path:", selectedFile.toString());
             // Use our C++ helper to convert the URL to a local file path
             let filePath = mainWindow.urlToLocalFile(selectedFile.toString());
             console.log("Converted file path:", filePath);
             
-            if (logParser.importFile(filePath)) {
-                // File import will be handled through the LogParser::diveImported signal
-                // which is connected to MainWindow::onDiveImported
+            // Parses on a worker thread; the result arrives through the
+            // LogParser::diveImported signal (connected to MainWindow::onDiveImported)
+            // and failures through onErrorOccurred below
+            // While a log is watched, the newly chosen one is watched instead
+            if (watchSelected || logParser.watchedLogbook !== "") {
+                logParser.watchLogbook(filePath);
             } else {
-                messageDialog.title = qsTr("Import Error");
-                messageDialog.message = logParser.lastError;
-                messageDialog.open();
+                logParser.stopWatching();
+                logParser.importFileAsync(filePath);
             }
         }
     }
@@ -992,6 +1090,7 @@ ApplicationWindow {
                     videoExporter.frameRate = videoFrameRateSpinBox.value;
                     videoExporter.videoBitrate = bitrateSlider.value;
                     videoExporter.videoCodec = codecComboBox.currentText;
+                    videoExporter.streamFrames = streamFramesCheckbox.checked;
 
                     let outputFile = videoExporter.createDefaultExportFile(mainWindow.currentDive, videoFile, contentType);
                     if (outputFile) {
@@ -1272,6 +1371,20 @@ ApplicationWindow {
                         }
                     }
                     
+                    CheckBox {
+                        id: streamFramesCheckbox
+                        text: qsTr("Stream frames to the encoder")
+                        checked: videoExporter.streamFrames
+                        Layout.fillWidth: true
+
+                        ToolTip.visible: hovered
+                        ToolTip.delay: 500
+                        ToolTip.text: qsTr("Encode frames as they render. Turn off to write them to a "
+                                           + "temporary folder first, where a frame that repeats the one "
+                                           + "before it is stored only once; quicker for dives with long "
+                                           + "unchanging stretches.")
+                    }
+
                     // Resolution options
                     CheckBox {
                         id: matchVideoResolutionCheckbox
@@ -1333,24 +1446,21 @@ ApplicationWindow {
         width: 500
         height: 400
         
-        property var diveList: []
+        // Follows the log as a watched logbook gains or loses dives
+        property var diveList: mainWindow.diveList
+        // The selected entry's "index"; unlike its row, it stays put when
+        // the list changes
         property int selectedDiveIndex: -1
         
-        function show(dives) {
-            diveList = dives
+        function show() {
             selectedDiveIndex = -1
-            listView.currentIndex = -1
             open()
         }
         
         onAccepted: {
-            if (selectedDiveIndex >= 0 && selectedDiveIndex < diveList.length) {
-                // Get the selected dive data
-                var selectedDiveData = diveList[selectedDiveIndex]
-                console.log("User selected dive:", selectedDiveData.diveNumber, selectedDiveData.diveName)
-                
-                // Use the index to select the dive
-                mainWindow.selectDiveByIndex(selectedDiveData.index)
+            if (selectedDiveIndex >= 0) {
+                console.log("User selected dive at index:", selectedDiveIndex)
+                mainWindow.selectDiveByIndex(selectedDiveIndex)
             }
         }
         
@@ -1379,7 +1489,7 @@ ApplicationWindow {
                         
                         Rectangle {
                             anchors.fill: parent
-                            color: parent.hovered ? palette.midlight : (listView.currentIndex === index ? palette.highlight : "transparent")
+                            color: parent.hovered ? palette.midlight : (diveSelectionDialog.selectedDiveIndex === modelData.index ? palette.highlight : "transparent")
                             radius: 4
                             
                             ColumnLayout {
@@ -1419,13 +1529,11 @@ ApplicationWindow {
                         }
                         
                         onClicked: {
-                            listView.currentIndex = index
-                            diveSelectionDialog.selectedDiveIndex = index
+                            diveSelectionDialog.selectedDiveIndex = modelData.index
                         }
                         
                         onDoubleClicked: {
-                            listView.currentIndex = index
-                            diveSelectionDialog.selectedDiveIndex = index
+                            diveSelectionDialog.selectedDiveIndex = modelData.index
                             diveSelectionDialog.accept()
                         }
                     }
@@ -1441,6 +1549,35 @@ ApplicationWindow {
         }
     }
     
+    Dialog {
+        id: importProgressDialog
+        title: qsTr("Importing Dive Log")
+        modal: true
+        closePolicy: Popup.NoAutoClose
+        standardButtons: Dialog.Cancel
+        width: 400
+        height: 200
+
+        onRejected: {
+            logParser.cancelImport()
+        }
+
+        ColumnLayout {
+            anchors.fill: parent
+            spacing: 20
+
+            Label {
+                text: qsTr("Reading dive log...")
+                Layout.fillWidth: true
+            }
+
+            ProgressBar {
+                value: logParser.progress / 100
+                Layout.fillWidth: true
+            }
+        }
+    }
+
     Dialog {
         id: exportProgressDialog
         title: qsTr("Exporting Images")
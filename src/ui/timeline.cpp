@@ -1,4 +1,5 @@
 #include "include/ui/timeline.h"
+#include "include/core/logging.h"
 #include "include/generators/overlay_image_provider.h"
 #include "include/generators/profile_image_provider.h"
 #include <QVariantList>
@@ -10,6 +11,7 @@
 Timeline::Timeline(QObject *parent)
     : QObject(parent)
     , m_diveData(nullptr)
+    , m_cursor(nullptr)
     , m_currentTime(0.0)
     , m_startTime(0.0)
     , m_endTime(0.0)
@@ -23,6 +25,7 @@ void Timeline::setDiveData(DiveData* data)
 {
     if (m_diveData != data) {
         m_diveData = data;
+        m_cursor.reset(data);
         
         // Reset timeline view when setting new data
         if (m_diveData) {
@@ -208,18 +211,18 @@ QVariantList Timeline::getTimelineData(int numPoints)
     QVariantList result;
     
     if (!m_diveData || numPoints <= 0) {
-        qDebug() << "Timeline::getTimelineData - No dive data or invalid numPoints:" << numPoints;
+        qCDebug(lcTimeline) << "Timeline::getTimelineData - No dive data or invalid numPoints:" << numPoints;
         return result;
     }
     
-    qDebug() << "Timeline::getTimelineData - Getting data for dive:" << m_diveData->diveName()
+    qCDebug(lcTimeline) << "Timeline::getTimelineData - Getting data for dive:" << m_diveData->diveName()
              << "from" << m_startTime << "to" << m_endTime
              << "with" << numPoints << "points";
     
     // Get data points within the visible time range
     QVector<DiveDataPoint> rangeData = m_diveData->dataInRange(m_startTime, m_endTime);
     
-    qDebug() << "Timeline::getTimelineData - Got" << rangeData.size() << "data points in range";
+    qCDebug(lcTimeline) << "Timeline::getTimelineData - Got" << rangeData.size() << "data points in range";
     
     // If we have fewer points than requested, just return all the points we have
     if (rangeData.size() <= numPoints) {
@@ -261,17 +264,17 @@ QVariantList Timeline::getTimelineData(int numPoints)
     
     // Print the first few points for debugging
     if (!result.isEmpty()) {
-        qDebug() << "Timeline::getTimelineData - First point:" 
+        qCDebug(lcTimeline) << "Timeline::getTimelineData - First point:" 
                  << "time=" << result.first().toMap()["timestamp"].toDouble()
                  << "depth=" << result.first().toMap()["depth"].toDouble();
         
         if (result.size() > 1) {
-            qDebug() << "Timeline::getTimelineData - Last point:" 
+            qCDebug(lcTimeline) << "Timeline::getTimelineData - Last point:" 
                      << "time=" << result.last().toMap()["timestamp"].toDouble()
                      << "depth=" << result.last().toMap()["depth"].toDouble();
         }
     } else {
-        qDebug() << "Timeline::getTimelineData - No data points generated";
+        qCDebug(lcTimeline) << "Timeline::getTimelineData - No data points generated";
     }
     
     return result;
@@ -282,7 +285,7 @@ QVariantMap Timeline::getCurrentDataPoint() const
     QVariantMap result;
     
     if (m_diveData) {
-        DiveDataPoint point = m_diveData->dataAtTime(m_currentTime);
+        DiveDataPoint point = m_cursor.dataAtTime(m_currentTime);
         
         // Add all basic data
         result["timestamp"] = point.timestamp;
@@ -0,0 +1,70 @@
+// Benchmarks for the Blurred shadow's box blur: the original per-channel
+// implementation (box_blur_reference.h) against each box_blur kernel, on
+// shadow images the size of typical overlay cells. box_blur_test checks
+// that the kernels match it.
+
+#include <QtTest>
+
+#include "box_blur_reference.h"
+#include "include/generators/box_blur.h"
+
+namespace {
+
+// Cell shadow images at the sizes the default templates produce: a
+// one-line value, a label and value, and a wide multi-line cell. Radii are
+// shadow sizes 2, 3 and 5 scaled by 1.8, as the renderer does.
+void addCellSizes()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("radius");
+    QTest::newRow("value 180x80 r4") << QSize(180, 80) << 4;
+    QTest::newRow("cell 260x150 r5") << QSize(260, 150) << 5;
+    QTest::newRow("wide 420x230 r9") << QSize(420, 230) << 9;
+}
+
+} // namespace
+
+class BoxBlurBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void reference_data() { addCellSizes(); }
+    void reference()
+    {
+        QFETCH(QSize, size);
+        QFETCH(int, radius);
+        const QImage source = shadowImage(size, 1);
+        QBENCHMARK {
+            QImage image = source;
+            referenceBoxBlur(image, radius);
+        }
+    }
+
+    void scalar_data() { addCellSizes(); }
+    void scalar() { benchmarkKernel(box_blur::Kernel::Scalar); }
+
+    void sse2_data() { addCellSizes(); }
+    void sse2() { benchmarkKernel(box_blur::Kernel::Sse2); }
+
+    void avx2_data() { addCellSizes(); }
+    void avx2() { benchmarkKernel(box_blur::Kernel::Avx2); }
+
+private:
+    void benchmarkKernel(box_blur::Kernel kernel)
+    {
+        if (!box_blur::isSupported(kernel)) {
+            QSKIP("kernel not supported on this CPU");
+        }
+        QFETCH(QSize, size);
+        QFETCH(int, radius);
+        const QImage source = shadowImage(size, 1);
+        QBENCHMARK {
+            QImage image = source;
+            box_blur::blur(image, radius, kernel);
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(BoxBlurBench)
+#include "box_blur_bench.moc"
@@ -0,0 +1,88 @@
+#ifndef BOX_BLUR_REFERENCE_H
+#define BOX_BLUR_REFERENCE_H
+
+// The box blur the Blurred shadow used before box_blur: per-channel sums
+// with clamped taps and a column-major vertical pass. Shared by the kernel
+// test, which holds every box_blur kernel to its bytes, and the benchmark,
+// which times the kernels against it.
+
+#include <QImage>
+#include <QRandomGenerator>
+#include <QVector>
+
+#include <cstring>
+
+// The pre-box_blur pass, as overlay_gen.cpp had it
+inline void referenceBoxBlurPass(QImage &img, int radius)
+{
+    const int w = img.width();
+    const int h = img.height();
+    const int window = 2 * radius + 1;
+    QVector<QRgb> line(qMax(w, h));
+
+    for (int y = 0; y < h; ++y) {
+        QRgb *row = reinterpret_cast<QRgb *>(img.scanLine(y));
+        int sumA = 0, sumR = 0, sumG = 0, sumB = 0;
+        for (int x = -radius; x <= radius; ++x) {
+            QRgb p = row[qBound(0, x, w - 1)];
+            sumA += qAlpha(p); sumR += qRed(p); sumG += qGreen(p); sumB += qBlue(p);
+        }
+        for (int x = 0; x < w; ++x) {
+            line[x] = qRgba(sumR / window, sumG / window, sumB / window, sumA / window);
+            QRgb pOut = row[qBound(0, x - radius, w - 1)];
+            QRgb pIn = row[qBound(0, x + radius + 1, w - 1)];
+            sumA += qAlpha(pIn) - qAlpha(pOut);
+            sumR += qRed(pIn) - qRed(pOut);
+            sumG += qGreen(pIn) - qGreen(pOut);
+            sumB += qBlue(pIn) - qBlue(pOut);
+        }
+        memcpy(row, line.constData(), w * sizeof(QRgb));
+    }
+
+    const qsizetype stride = img.bytesPerLine() / sizeof(QRgb);
+    QRgb *bits = reinterpret_cast<QRgb *>(img.bits());
+    for (int x = 0; x < w; ++x) {
+        int sumA = 0, sumR = 0, sumG = 0, sumB = 0;
+        for (int y = -radius; y <= radius; ++y) {
+            QRgb p = bits[qBound(0, y, h - 1) * stride + x];
+            sumA += qAlpha(p); sumR += qRed(p); sumG += qGreen(p); sumB += qBlue(p);
+        }
+        for (int y = 0; y < h; ++y) {
+            line[y] = qRgba(sumR / window, sumG / window, sumB / window, sumA / window);
+            QRgb pOut = bits[qBound(0, y - radius, h - 1) * stride + x];
+            QRgb pIn = bits[qBound(0, y + radius + 1, h - 1) * stride + x];
+            sumA += qAlpha(pIn) - qAlpha(pOut);
+            sumR += qRed(pIn) - qRed(pOut);
+            sumG += qGreen(pIn) - qGreen(pOut);
+            sumB += qBlue(pIn) - qBlue(pOut);
+        }
+        for (int y = 0; y < h; ++y) {
+            bits[y * stride + x] = line[y];
+        }
+    }
+}
+
+inline void referenceBoxBlur(QImage &img, int radius)
+{
+    for (int i = 0; i < 3; ++i) {
+        referenceBoxBlurPass(img, radius);
+    }
+}
+
+// Premultiplied pixels of random coverage, standing in for shadow text
+inline QImage shadowImage(const QSize &size, quint32 seed)
+{
+    QRandomGenerator random(seed);
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *row = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            const int alpha = random.bounded(256);
+            row[x] = qRgba(random.bounded(alpha + 1), random.bounded(alpha + 1),
+                           random.bounded(alpha + 1), alpha);
+        }
+    }
+    return image;
+}
+
+#endif // BOX_BLUR_REFERENCE_H
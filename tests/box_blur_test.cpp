@@ -0,0 +1,53 @@
+// Tests for box_blur: every kernel the CPU supports must produce the
+// reference blur's bytes, which the Blurred shadow looked like before.
+
+#include <QtTest>
+
+#include "box_blur_reference.h"
+#include "include/generators/box_blur.h"
+
+class BoxBlurTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void kernelsMatchReference()
+    {
+        // Odd sizes and radii wider than the image included
+        const QList<QSize> sizes = {{1, 1}, {7, 3}, {33, 17}, {180, 80}};
+        for (const QSize &size : sizes) {
+            for (int radius : {1, 4, 11, 40}) {
+                QImage expected = shadowImage(size, size.width() * 131 + radius);
+                const QImage source = expected;
+                referenceBoxBlur(expected, radius);
+
+                for (auto kernel : {box_blur::Kernel::Scalar, box_blur::Kernel::Sse2,
+                                    box_blur::Kernel::Avx2}) {
+                    if (!box_blur::isSupported(kernel)) {
+                        continue;
+                    }
+                    QImage actual = source;
+                    box_blur::blur(actual, radius, kernel);
+                    QCOMPARE(actual, expected);
+                }
+            }
+        }
+    }
+
+    void bestKernelIsSupported()
+    {
+        QVERIFY(box_blur::isSupported(box_blur::Kernel::Scalar));
+        QVERIFY(box_blur::isSupported(box_blur::bestKernel()));
+    }
+
+    void zeroRadiusLeavesImageAlone()
+    {
+        QImage image = shadowImage(QSize(20, 10), 7);
+        const QImage original = image;
+        box_blur::blur(image, 0);
+        QCOMPARE(image, original);
+    }
+};
+
+QTEST_GUILESS_MAIN(BoxBlurTest)
+#include "box_blur_test.moc"
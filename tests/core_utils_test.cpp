@@ -26,6 +26,29 @@ private slots:
         QVERIFY(std::isnan(parse_utils::parseLocaleDouble(u"")));
     }
 
+    void scanUnitValueMatchesSubsurfaceAttributes()
+    {
+        QCOMPARE(parse_utils::scanUnitValue(u"12.3 m", u"m"), 12.3);
+        QCOMPARE(parse_utils::scanUnitValue(u"200.0 bar", u"bar"), 200.0);
+        QCOMPARE(parse_utils::scanUnitValue(u"7 m", u"m"), 7.0);
+        QCOMPARE(parse_utils::scanUnitValue(u"32.0%", u"%", false), 32.0);
+        QCOMPARE(parse_utils::scanUnitValue(u"5 %", u"%", false), 5.0);
+        // Unanchored, like the regexes it replaced: the sign is not part of
+        // the number and leading text is skipped
+        QCOMPARE(parse_utils::scanUnitValue(u"-2.5 C", u"C"), 2.5);
+        QCOMPARE(parse_utils::scanUnitValue(u"~ 4.5 l", u"l"), 4.5);
+        QVERIFY(std::isnan(parse_utils::scanUnitValue(u"12.3m", u"m")));
+        QVERIFY(std::isnan(parse_utils::scanUnitValue(u"12.3 bar", u"m")));
+        QVERIFY(std::isnan(parse_utils::scanUnitValue(u"12.3", u"m")));
+        QVERIFY(std::isnan(parse_utils::scanUnitValue(u"", u"m")));
+
+        QCOMPARE(parse_utils::scanMinutesSeconds(u"45:30 min"), 2730.0);
+        QCOMPARE(parse_utils::scanMinutesSeconds(u"0:05 min"), 5.0);
+        QVERIFY(std::isnan(parse_utils::scanMinutesSeconds(u"45:30")));
+        QVERIFY(std::isnan(parse_utils::scanMinutesSeconds(u"45 min")));
+        QVERIFY(std::isnan(parse_utils::scanMinutesSeconds(u"12.5")));
+    }
+
     void parseISO8601Variants()
     {
         const QDateTime plain = parse_utils::parseISO8601(u"2026-02-28T11:04:56");
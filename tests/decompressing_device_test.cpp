@@ -0,0 +1,224 @@
+// Tests for reading compressed dive logs: the decompressing device on its
+// own, and a compressed logbook going through LogParser. Codec tests skip
+// when the build has no support for that codec.
+
+#include <QtTest>
+
+#include "include/core/dive_data.h"
+#include "include/core/format_parsers/decompressing_device.h"
+#include "include/core/log_parser.h"
+
+#ifdef UNABARA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef UNABARA_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+const char kLogbook[] = R"(<divelog program='subsurface' version='3'>
+<dives>
+<dive number='3' date='2026-04-01' time='09:00:00'>
+  <divecomputer model='Test DC'>
+    <sample time='0:00 min' depth='0.0 m' />
+    <sample time='1:00 min' depth='12.0 m' />
+  </divecomputer>
+</dive>
+<dive number='4' date='2026-04-01' time='14:00:00'>
+  <divecomputer model='Test DC'>
+    <sample time='0:00 min' depth='0.0 m' />
+    <sample time='2:00 min' depth='8.0 m' />
+  </divecomputer>
+</dive>
+</dives>
+</divelog>)";
+
+// Repetitive, log-like content spanning many of the device's input chunks
+QByteArray samplePayload()
+{
+    QByteArray out;
+    for (int i = 0; i < 40000; ++i) {
+        out += QByteArray("<sample time='") + QByteArray::number(i) + "' depth='"
+               + QByteArray::number(i % 40) + ".0 m' />\n";
+    }
+    return out;
+}
+
+#ifdef UNABARA_HAVE_ZLIB
+QByteArray gzip(const QByteArray &data)
+{
+    z_stream z = {};
+    deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    QByteArray out(static_cast<qsizetype>(deflateBound(&z, data.size())), Qt::Uninitialized);
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+    z.avail_in = static_cast<uInt>(data.size());
+    z.next_out = reinterpret_cast<Bytef *>(out.data());
+    z.avail_out = static_cast<uInt>(out.size());
+    deflate(&z, Z_FINISH);
+    out.resize(static_cast<qsizetype>(z.total_out));
+    deflateEnd(&z);
+    return out;
+}
+#endif
+
+#ifdef UNABARA_HAVE_ZSTD
+QByteArray zstd(const QByteArray &data)
+{
+    QByteArray out(static_cast<qsizetype>(ZSTD_compressBound(data.size())), Qt::Uninitialized);
+    out.resize(static_cast<qsizetype>(
+        ZSTD_compress(out.data(), out.size(), data.constData(), data.size(), 3)));
+    return out;
+}
+#endif
+
+QByteArray decompressAll(QByteArray compressed, DecompressingDevice::Codec codec, bool *atEnd = nullptr)
+{
+    QBuffer source(&compressed);
+    source.open(QIODevice::ReadOnly);
+    DecompressingDevice device(&source, codec);
+    if (!device.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    const QByteArray out = device.readAll();
+    if (atEnd) {
+        *atEnd = device.atEnd();
+    }
+    return out;
+}
+
+} // namespace
+
+class DecompressingDeviceTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+    void detectsCodecByMagic()
+    {
+        QByteArray gz("\x1f\x8b\x08\x00rest", 8);
+        QByteArray zst("\x28\xb5\x2f\xfd\x00", 5);
+        QByteArray xml("<divelog/>");
+        QBuffer buffer;
+
+        buffer.setBuffer(&gz);
+        buffer.open(QIODevice::ReadOnly);
+        buffer.seek(3);
+        QCOMPARE(DecompressingDevice::detect(&buffer), DecompressingDevice::Gzip);
+        QCOMPARE(buffer.pos(), qint64(3));
+        buffer.close();
+
+        buffer.setBuffer(&zst);
+        buffer.open(QIODevice::ReadOnly);
+        QCOMPARE(DecompressingDevice::detect(&buffer), DecompressingDevice::Zstd);
+        buffer.close();
+
+        buffer.setBuffer(&xml);
+        buffer.open(QIODevice::ReadOnly);
+        QCOMPARE(DecompressingDevice::detect(&buffer), DecompressingDevice::None);
+    }
+
+    void gzipRoundTrip()
+    {
+#ifdef UNABARA_HAVE_ZLIB
+        const QByteArray payload = samplePayload();
+        bool atEnd = false;
+        QCOMPARE(decompressAll(gzip(payload), DecompressingDevice::Gzip, &atEnd), payload);
+        QVERIFY(atEnd);
+
+        // Concatenated members read as one stream, as gzip(1) does
+        const QByteArray joined = gzip(payload.left(1000)) + gzip(payload.mid(1000));
+        QCOMPARE(decompressAll(joined, DecompressingDevice::Gzip), payload);
+#else
+        QSKIP("built without zlib");
+#endif
+    }
+
+    void zstdRoundTrip()
+    {
+#ifdef UNABARA_HAVE_ZSTD
+        const QByteArray payload = samplePayload();
+        bool atEnd = false;
+        QCOMPARE(decompressAll(zstd(payload), DecompressingDevice::Zstd, &atEnd), payload);
+        QVERIFY(atEnd);
+#else
+        QSKIP("built without zstd");
+#endif
+    }
+
+    void seeksByRedecoding()
+    {
+#ifdef UNABARA_HAVE_ZLIB
+        const QByteArray payload = samplePayload();
+        QByteArray compressed = gzip(payload);
+        QBuffer source(&compressed);
+        source.open(QIODevice::ReadOnly);
+        DecompressingDevice device(&source, DecompressingDevice::Gzip);
+        QVERIFY(device.open(QIODevice::ReadOnly));
+
+        const qint64 far = payload.size() / 2;
+        QVERIFY(device.seek(far));
+        QCOMPARE(device.read(64), payload.mid(far, 64));
+        QVERIFY(device.seek(10)); // backwards: restarts the stream
+        QCOMPARE(device.read(64), payload.mid(10, 64));
+        QCOMPARE(device.pos(), qint64(74));
+        QVERIFY(!device.seek(payload.size() + 1));
+#else
+        QSKIP("built without zlib");
+#endif
+    }
+
+    void truncatedStreamIsNotAtEnd()
+    {
+#ifdef UNABARA_HAVE_ZLIB
+        const QByteArray payload = samplePayload();
+        const QByteArray compressed = gzip(payload);
+        bool atEnd = true;
+        const QByteArray out =
+            decompressAll(compressed.left(compressed.size() / 2), DecompressingDevice::Gzip, &atEnd);
+        QVERIFY(out.size() < payload.size());
+        QVERIFY(payload.startsWith(out));
+        QVERIFY(!atEnd);
+#else
+        QSKIP("built without zlib");
+#endif
+    }
+
+    void logParserImportsCompressedLog()
+    {
+#ifdef UNABARA_HAVE_ZLIB
+        QTemporaryFile tmp(QDir::tempPath() + QStringLiteral("/logbookXXXXXX.ssrf.gz"));
+        QVERIFY(tmp.open());
+        tmp.write(gzip(kLogbook));
+        tmp.close();
+
+        LogParser parser;
+        QCOMPARE(parser.getDiveList(tmp.fileName()).size(), 2);
+
+        DiveData *single = nullptr;
+        QList<DiveData *> all;
+        connect(&parser, &LogParser::diveImported, this, [&](DiveData *dive) { single = dive; });
+        connect(&parser, &LogParser::multipleImported, this,
+                [&](const QList<DiveData *> &dives) { all = dives; });
+
+        QVERIFY(parser.importDive(tmp.fileName(), 4));
+        QVERIFY(single);
+        QCOMPARE(single->maxDepth(), 8.0);
+        delete single;
+
+        QVERIFY(parser.importFile(tmp.fileName()));
+        QCOMPARE(all.size(), 2);
+        qDeleteAll(all);
+#else
+        QSKIP("built without zlib");
+#endif
+    }
+};
+
+QTEST_GUILESS_MAIN(DecompressingDeviceTest)
+#include "decompressing_device_test.moc"
@@ -0,0 +1,204 @@
+// Tests for the binary dive cache: a stored dive must come back field for
+// field, and anything stale, damaged or from another build must read as a
+// miss.
+
+#include <QtTest>
+
+#include <memory>
+
+#include "include/core/dive_cache.h"
+#include "include/core/dive_data.h"
+
+namespace {
+
+DiveDataPoint point(double t, double depth)
+{
+    DiveDataPoint p;
+    p.timestamp = t;
+    p.depth = depth;
+    return p;
+}
+
+DiveData *makeDive()
+{
+    auto *dive = new DiveData();
+    dive->setDiveName(QStringLiteral("Dive #12"));
+    dive->setDiveNumber(12);
+    dive->setStartTime(QDateTime(QDate(2026, 3, 1), QTime(10, 0)));
+    dive->setLocation(QStringLiteral("Blue Hole"));
+    dive->setDiveSiteId(QStringLiteral("a1"));
+    dive->setDiveSiteName(QStringLiteral("Blue Hole"));
+    dive->setDiveMode(DiveData::ClosedCircuit);
+    dive->setMeanDepth(14.5);
+
+    CylinderInfo diluent;
+    diluent.description = QStringLiteral("D3");
+    diluent.size = 3.0;
+    diluent.startPressure = 200.0;
+    diluent.endPressure = 150.0;
+    dive->addCylinder(diluent);
+    CylinderInfo bailout;
+    bailout.o2Percent = 50.0;
+    dive->addCylinder(bailout);
+    dive->addGasSwitch(300.0, 1);
+
+    QVector<DiveDataPoint> samples;
+    for (int i = 0; i < 50; ++i) {
+        DiveDataPoint p = point(i * 10.0, i < 25 ? i : 50 - i);
+        p.cns = i;
+        p.addPressure(200.0 - i, 0);
+        if (i % 2) {
+            p.addPressure(180.0, 1); // second channel on some samples only
+        }
+        p.addPO2Sensor(1.2, 0);
+        p.addPO2Sensor(1.3, 2);
+        samples.append(p);
+    }
+    dive->appendDataPoints(samples);
+    return dive;
+}
+
+// Every cache file written so far
+QFileInfoList cacheFiles()
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                        + QStringLiteral("/dives");
+    return QDir(dir).entryInfoList(QDir::Files);
+}
+
+} // namespace
+
+class DiveCacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        QVERIFY(m_source.open());
+        m_source.write("source log content");
+        m_source.flush();
+        m_hash = dive_cache::contentHash(m_source);
+        QCOMPARE(m_hash.size(), 20);
+    }
+
+    void roundTripsEveryField()
+    {
+        std::unique_ptr<DiveData> original(makeDive());
+        dive_cache::store(m_source.fileName(), m_hash, {original.get()});
+
+        QList<DiveData *> loaded = dive_cache::load(m_source.fileName(), m_hash);
+        QCOMPARE(loaded.size(), 1);
+        const DiveData *dive = loaded.first();
+
+        QCOMPARE(dive->diveName(), original->diveName());
+        QCOMPARE(dive->diveNumber(), 12);
+        QCOMPARE(dive->startTime(), original->startTime());
+        QCOMPARE(dive->location(), original->location());
+        QCOMPARE(dive->diveSiteId(), original->diveSiteId());
+        QCOMPARE(dive->diveMode(), DiveData::ClosedCircuit);
+        QCOMPARE(dive->loggedMeanDepth(), 14.5);
+
+        QCOMPARE(dive->cylinderCount(), 2);
+        QCOMPARE(dive->cylinderInfo(0).description, QStringLiteral("D3"));
+        QCOMPARE(dive->cylinderInfo(0).endPressure, 150.0);
+        QCOMPARE(dive->cylinderInfo(1).o2Percent, 50.0);
+        QCOMPARE(dive->activeCylinderAtTime(400.0), 1);
+
+        QCOMPARE(dive->sampleCount(), original->sampleCount());
+        const auto &expected = original->allDataPoints();
+        const auto &actual = dive->allDataPoints();
+        for (int i = 0; i < expected.size(); ++i) {
+            QCOMPARE(actual[i].timestamp, expected[i].timestamp);
+            QCOMPARE(actual[i].depth, expected[i].depth);
+            QCOMPARE(actual[i].cns, expected[i].cns);
+            QCOMPARE(actual[i].pressures, expected[i].pressures);
+            QCOMPARE(actual[i].po2Sensors, expected[i].po2Sensors);
+        }
+        qDeleteAll(loaded);
+    }
+
+    void changedContentMisses()
+    {
+        std::unique_ptr<DiveData> original(makeDive());
+        dive_cache::store(m_source.fileName(), m_hash, {original.get()});
+
+        QByteArray otherHash = m_hash;
+        otherHash[0] = char(otherHash[0] ^ 0x01);
+        QVERIFY(dive_cache::load(m_source.fileName(), otherHash).isEmpty());
+    }
+
+    void damagedCacheMisses()
+    {
+        std::unique_ptr<DiveData> original(makeDive());
+        dive_cache::store(m_source.fileName(), m_hash, {original.get()});
+
+        // Truncate whatever was written: sizes no longer add up
+        const QFileInfoList entries = cacheFiles();
+        QVERIFY(!entries.isEmpty());
+        for (const QFileInfo &entry : entries) {
+            QFile cache(entry.absoluteFilePath());
+            QVERIFY(cache.open(QIODevice::ReadWrite));
+            QVERIFY(cache.resize(cache.size() - 8));
+        }
+        QVERIFY(dive_cache::load(m_source.fileName(), m_hash).isEmpty());
+    }
+
+    void otherVersionMisses()
+    {
+        std::unique_ptr<DiveData> original(makeDive());
+        dive_cache::store(m_source.fileName(), m_hash, {original.get()});
+        QVERIFY(!dive_cache::recordedHash(m_source.fileName()).isEmpty());
+
+        // The application version closes the 96-byte header
+        for (const QFileInfo &entry : cacheFiles()) {
+            QFile cache(entry.absoluteFilePath());
+            QVERIFY(cache.open(QIODevice::ReadWrite));
+            QVERIFY(cache.seek(80));
+            QVERIFY(cache.write("0.0.0-other", 12) == 12);
+        }
+        QVERIFY(dive_cache::recordedHash(m_source.fileName()).isEmpty());
+        QVERIFY(dive_cache::load(m_source.fileName(), m_hash).isEmpty());
+    }
+
+    void recordedHashNeedsUnchangedSizeAndTime()
+    {
+        QTemporaryFile source;
+        QVERIFY(source.open());
+        source.write("another log");
+        source.flush();
+        QVERIFY(source.setFileTime(QDateTime(QDate(2026, 3, 1), QTime(10, 0)),
+                                   QFileDevice::FileModificationTime));
+        const QByteArray hash = dive_cache::contentHash(source);
+        QVERIFY(dive_cache::recordedHash(source.fileName()).isEmpty());
+
+        std::unique_ptr<DiveData> original(makeDive());
+        dive_cache::store(source.fileName(), hash, {original.get()});
+        QCOMPARE(dive_cache::recordedHash(source.fileName()), hash);
+
+        // Touched: the content may have changed, so it has to be hashed
+        QVERIFY(source.setFileTime(QDateTime(QDate(2026, 3, 2), QTime(10, 0)),
+                                   QFileDevice::FileModificationTime));
+        QVERIFY(dive_cache::recordedHash(source.fileName()).isEmpty());
+        // ...and then it is still found by its hash
+        QList<DiveData *> loaded = dive_cache::load(source.fileName(), hash);
+        QCOMPARE(loaded.size(), 1);
+        qDeleteAll(loaded);
+
+        // Grown, with the recorded time put back
+        QVERIFY(source.seek(source.size()));
+        source.write(" and more");
+        source.flush();
+        QVERIFY(source.setFileTime(QDateTime(QDate(2026, 3, 1), QTime(10, 0)),
+                                   QFileDevice::FileModificationTime));
+        QVERIFY(dive_cache::recordedHash(source.fileName()).isEmpty());
+    }
+
+private:
+    QTemporaryFile m_source;
+    QByteArray m_hash;
+};
+
+QTEST_GUILESS_MAIN(DiveCacheTest)
+#include "dive_cache_test.moc"
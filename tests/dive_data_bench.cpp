@@ -0,0 +1,121 @@
+// Benchmarks for DiveData time lookup: the original linear scan (kept here
+// as a reference), the binary-search dataAtTime(), the sequential
+// DiveSampleCursor and the batch resample(), each driven the way export drives them — a monotonic
+// sweep at a fixed frame rate over a densely sampled rebreather dive.
+// dive_data_test checks that the lookups agree with the linear scan.
+
+#include <QtTest>
+#include <cmath>
+
+#include "include/core/dive_data.h"
+
+namespace {
+
+// 4 h at 1 s sampling
+constexpr int kSamples = 4 * 3600;
+// Frames per run; enough to dominate setup
+constexpr int kFrames = 2000;
+
+void fillDive(DiveData &d)
+{
+    for (int i = 0; i < kSamples; ++i) {
+        DiveDataPoint p;
+        p.timestamp = i;
+        p.depth = 30.0 + 10.0 * std::sin(i / 300.0);
+        p.temperature = 12.0;
+        d.addDataPoint(p);
+    }
+}
+
+// The pre-binary-search lookup: scan from the first sample every call
+int linearSampleIndexAt(const QVector<DiveDataPoint> &points, double time)
+{
+    int index = 0;
+    while (index < points.size() && points[index].timestamp < time) {
+        index++;
+    }
+    return index;
+}
+
+} // namespace
+
+class DiveDataBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        fillDive(m_dive);
+        // Sweep the whole dive so late frames pay the full linear cost
+        m_step = static_cast<double>(kSamples - 1) / kFrames;
+    }
+
+    void linearScan()
+    {
+        const auto &points = m_dive.allDataPoints();
+        qint64 sum = 0;
+        QBENCHMARK {
+            for (int f = 0; f < kFrames; ++f) {
+                sum += linearSampleIndexAt(points, f * m_step);
+            }
+        }
+        QVERIFY(sum > 0);
+    }
+
+    void binarySearch()
+    {
+        qint64 sum = 0;
+        QBENCHMARK {
+            for (int f = 0; f < kFrames; ++f) {
+                sum += m_dive.sampleIndexAt(f * m_step);
+            }
+        }
+        QVERIFY(sum > 0);
+    }
+
+    void cursor()
+    {
+        qint64 sum = 0;
+        QBENCHMARK {
+            DiveSampleCursor cursor(&m_dive);
+            for (int f = 0; f < kFrames; ++f) {
+                sum += cursor.sampleIndexAt(f * m_step);
+            }
+        }
+        QVERIFY(sum > 0);
+    }
+
+    void cursorDataAtTime()
+    {
+        double sum = 0.0;
+        QBENCHMARK {
+            DiveSampleCursor cursor(&m_dive);
+            for (int f = 0; f < kFrames; ++f) {
+                sum += cursor.dataAtTime(f * m_step).depth;
+            }
+        }
+        QVERIFY(sum > 0.0);
+    }
+
+    void resampleBatch()
+    {
+        QVector<double> times(kFrames);
+        for (int f = 0; f < kFrames; ++f) {
+            times[f] = f * m_step;
+        }
+        double sum = 0.0;
+        QBENCHMARK {
+            const DiveSampleColumns frames = m_dive.resample(times);
+            sum += frames.depth.last();
+        }
+        QVERIFY(sum > 0.0);
+    }
+
+private:
+    DiveData m_dive;
+    double m_step = 1.0;
+};
+
+QTEST_GUILESS_MAIN(DiveDataBench)
+#include "dive_data_bench.moc"
@@ -50,6 +50,95 @@ private slots:
         QCOMPARE(pts[2].timestamp, 10.0);
     }
 
+    void equalTimestampsKeepArrivalOrder()
+    {
+        // Both entry points must agree on where a repeated timestamp lands
+        const QVector<DiveDataPoint> arrivals = {point(0.0, 1.0), point(10.0, 2.0),
+                                                 point(10.0, 3.0), point(20.0, 4.0),
+                                                 point(10.0, 5.0)};
+        DiveData added;
+        for (const DiveDataPoint &p : arrivals) {
+            added.addDataPoint(p);
+        }
+        DiveData appended;
+        appended.appendDataPoints(arrivals);
+
+        const QVector<double> expectedDepths = {1.0, 2.0, 3.0, 5.0, 4.0};
+        const auto &a = added.allDataPoints();
+        const auto &b = appended.allDataPoints();
+        QCOMPARE(a.size(), expectedDepths.size());
+        QCOMPARE(b.size(), expectedDepths.size());
+        for (int i = 0; i < expectedDepths.size(); ++i) {
+            QCOMPARE(a[i].depth, expectedDepths[i]);
+            QCOMPARE(b[i].depth, expectedDepths[i]);
+        }
+        QCOMPARE(added.dataAtTime(10.0).depth, appended.dataAtTime(10.0).depth);
+    }
+
+    void appendDataPointsSortsAndNotifiesOnce()
+    {
+        DiveData d;
+        d.addDataPoint(point(20.0, 4.0));
+        QSignalSpy changed(&d, &DiveData::dataChanged);
+
+        // Batch overlaps the existing sample, so the seam check must catch it
+        d.appendDataPoints({point(0.0, 1.0), point(10.0, 3.0), point(5.0, 2.0)});
+
+        QCOMPARE(changed.count(), 1);
+        const auto &pts = d.allDataPoints();
+        QCOMPARE(pts.size(), 4);
+        QCOMPARE(pts[0].timestamp, 0.0);
+        QCOMPARE(pts[1].timestamp, 5.0);
+        QCOMPARE(pts[2].timestamp, 10.0);
+        QCOMPARE(pts[3].timestamp, 20.0);
+        QCOMPARE(d.maxDepth(), 4.0);
+
+        // Already-ordered batches are taken as-is
+        d.appendDataPoints({point(30.0, 5.0), point(40.0, 6.0)});
+        QCOMPARE(changed.count(), 2);
+        QCOMPARE(d.allDataPoints().size(), 6);
+        QCOMPARE(d.durationSeconds(), 40);
+        QCOMPARE(d.maxDepth(), 6.0);
+
+        d.appendDataPoints({});
+        QCOMPARE(changed.count(), 2);
+    }
+
+    void columnsRoundTripChannels()
+    {
+        DiveData d;
+        DiveDataPoint a = point(0.0, 5.0);
+        a.addPressure(200.0, 0);
+        DiveDataPoint b = point(10.0, 6.0);
+        b.addPressure(190.0, 0);
+        b.addPressure(180.0, 2);
+        b.addPO2Sensor(1.2, 1);
+        d.appendDataPoints({a, b});
+        // Inserted at the front: widens nothing, shifts every column
+        d.addDataPoint(point(-5.0, 1.0));
+
+        const DiveSampleColumns &s = d.samples();
+        QCOMPARE(s.size(), 3);
+        QCOMPARE(s.pressures.size(), 3);
+        QCOMPARE(s.po2Sensors.size(), 2);
+        for (const auto &column : s.pressures) {
+            QCOMPARE(column.size(), 3);
+        }
+        QCOMPARE(s.depth[1], 5.0);
+        QCOMPARE(s.pressureAt(2, 2), 180.0);
+        QCOMPARE(s.pressureAt(1, 2), 0.0);
+
+        // The row view reports exactly the channels each sample carried
+        const auto &pts = d.allDataPoints();
+        QCOMPARE(pts[0].tankCount(), 0);
+        QCOMPARE(pts[1].tankCount(), 1);
+        QCOMPARE(pts[2].tankCount(), 3);
+        QCOMPARE(pts[2].getPressure(1), 0.0);
+        QCOMPARE(pts[2].po2SensorCount(), 2);
+        QCOMPARE(pts[2].getPO2Sensor(1), 1.2);
+        QCOMPARE(pts[1].cns, -1.0);
+    }
+
     void ceilingIsNotInterpolated()
     {
         // Ceiling is a state that persists until changed — blending two stop
@@ -158,6 +247,36 @@ private slots:
         QCOMPARE(d.dataAtTime(5.0).getPressure(0), 150.0);
     }
 
+    void cylinderRampIsOrderIndependent()
+    {
+        // Two cylinders without pressure samples, switching at 300 s. An
+        // idle cylinder holds the pressure it was left at (or stays full),
+        // whatever was looked up before.
+        DiveData d;
+        CylinderInfo back;
+        back.startPressure = 200.0;
+        back.endPressure = 100.0;
+        d.addCylinder(back);
+        CylinderInfo deco;
+        deco.startPressure = 200.0;
+        deco.endPressure = 150.0;
+        d.addCylinder(deco);
+        d.addDataPoint(point(0.0, 10.0));
+        d.addDataPoint(point(600.0, 10.0));
+        d.addGasSwitch(300.0, 1);
+
+        // Fresh dive, first lookup is after the switch
+        DiveDataPoint late = d.dataAtTime(450.0);
+        QCOMPARE(late.getPressure(0), 150.0);
+        QCOMPARE(late.getPressure(1), 175.0);
+
+        QCOMPARE(d.dataAtTime(100.0).getPressure(1), 200.0);
+        late = d.dataAtTime(450.0);
+        QCOMPARE(late.getPressure(0), 150.0);
+        QCOMPARE(late.getPressure(1), 175.0);
+        QCOMPARE(d.cylinderPressureAt(0, 599.0), 150.0);
+    }
+
     void gasSwitchesResolveDeterministically()
     {
         DiveData d;
@@ -196,6 +315,24 @@ private slots:
         QCOMPARE(d.maxDepthUntil(5.0), 15.0);
         QCOMPARE(d.maxDepthUntil(10.0), 20.0);
         QCOMPARE(d.maxDepthUntil(20.0), 20.0);
+        QCOMPARE(d.maxDepthUntil(-1.0), 0.0);
+
+        // The cached index follows later samples
+        d.addDataPoint(point(30.0, 40.0));
+        QCOMPARE(d.maxDepth(), 40.0);
+        QCOMPARE(d.maxDepthUntil(20.0), 20.0);
+        QCOMPARE(d.maxDepthUntil(25.0), 27.5);
+    }
+
+    void meanDepthIsTimeWeighted()
+    {
+        DiveData d;
+        d.addDataPoint(point(0.0, 0.0));
+        d.addDataPoint(point(10.0, 10.0));
+        d.addDataPoint(point(20.0, 10.0));
+
+        // 50 m*s over the ramp plus 100 m*s at 10 m, over 20 s
+        QCOMPARE(d.meanDepth(), 150.0 / 20.0);
     }
 
     void meanDepthExplicitBeatsDerived()
@@ -210,6 +347,135 @@ private slots:
         d.setMeanDepth(12.5);
         QCOMPARE(d.meanDepth(), 12.5);
     }
+
+    void lookupHitsExactSamples()
+    {
+        DiveData d;
+        d.addDataPoint(point(0.0, 1.0));
+        d.addDataPoint(point(4.0, 2.0));
+        d.addDataPoint(point(9.0, 3.0));
+        d.addDataPoint(point(15.0, 4.0));
+
+        QCOMPARE(d.sampleIndexAt(-1.0), 0);
+        QCOMPARE(d.sampleIndexAt(4.0), 1);
+        QCOMPARE(d.sampleIndexAt(4.5), 2);
+        QCOMPARE(d.sampleIndexAt(99.0), 4);
+        QCOMPARE(d.dataAtTime(9.0).depth, 3.0);
+        QCOMPARE(d.dataAtTime(12.0).depth, 3.5);
+    }
+
+    void sampleIndexMatchesLinearScan()
+    {
+        // The first sample at or after t, as a scan from the start finds it
+        DiveData d;
+        double t = 0.0;
+        for (int i = 0; i < 200; ++i) {
+            d.addDataPoint(point(t, 10.0));
+            t += 1.0 + (i % 3) * 0.5;
+        }
+        const auto &points = d.allDataPoints();
+
+        DiveSampleCursor cursor(&d);
+        for (double q = -2.0; q < t + 2.0; q += 0.37) {
+            int expected = 0;
+            while (expected < points.size() && points[expected].timestamp < q) {
+                expected++;
+            }
+            QCOMPARE(d.sampleIndexAt(q), expected);
+            QCOMPARE(cursor.sampleIndexAt(q), expected);
+        }
+    }
+
+    void cursorMatchesRandomAccessLookup()
+    {
+        // Irregular sampling so segment boundaries don't line up with the
+        // sweep step
+        DiveData d;
+        double t = 0.0;
+        for (int i = 0; i < 200; ++i) {
+            d.addDataPoint(point(t, 10.0 + (i % 17)));
+            t += 1.0 + (i % 3) * 0.5;
+        }
+
+        DiveSampleCursor cursor(&d);
+        // Monotonic sweep, including the clamped ends
+        for (double q = -2.0; q < t + 2.0; q += 0.37) {
+            QCOMPARE(cursor.dataAtTime(q).depth, d.dataAtTime(q).depth);
+        }
+        // Backward seeks and long jumps
+        for (double q : {250.0, 3.0, 180.5, 180.4, 12.0, 260.0, 0.0}) {
+            QCOMPARE(cursor.sampleIndexAt(q), d.sampleIndexAt(q));
+            QCOMPARE(cursor.dataAtTime(q).depth, d.dataAtTime(q).depth);
+        }
+    }
+
+    void resampleMatchesDataAtTime()
+    {
+        DiveData d;
+        CylinderInfo cyl;
+        cyl.startPressure = 200.0;
+        cyl.endPressure = 100.0;
+        d.addCylinder(cyl);
+
+        QVector<DiveDataPoint> samples;
+        for (int i = 0; i < 12; ++i) {
+            DiveDataPoint p = point(i * 10.0, 5.0 + i);
+            p.temperature = 20.0 - i * 0.5;
+            p.ndl = (i % 4 == 3) ? -1.0 : 30.0 - i;  // sentinel gaps
+            p.cns = (i < 2) ? -1.0 : i * 1.5;
+            p.ceiling = (i > 6) ? 3.0 * (i - 6) : 0.0;
+            p.stopTime = (i > 8) ? i : 0.0;
+            if (i % 3 != 0) {
+                p.addPressure(150.0 - i, 1);         // sample-only second tank
+            }
+            if (i > 1) {
+                p.addPO2Sensor(1.0 + i * 0.01, i % 2);
+            }
+            samples.append(p);
+        }
+        d.appendDataPoints(samples);
+
+        // Clamped ends, exact samples, mid-segment, and one backward step
+        const QVector<double> times = {-5.0, 0.0, 3.3, 10.0, 27.5, 29.9, 30.0,
+                                       64.2, 12.0, 99.0, 110.0, 140.0};
+        const DiveSampleColumns out = d.resample(times);
+        QCOMPARE(out.size(), times.size());
+
+        for (int k = 0; k < times.size(); ++k) {
+            const DiveDataPoint batch = out.point(k);
+            const DiveDataPoint single = d.dataAtTime(times[k]);
+            const QByteArray where = QByteArray::number(times[k]);
+            const char *at = where.constData();
+            QVERIFY2(batch.timestamp == single.timestamp, at);
+            QVERIFY2(batch.depth == single.depth, at);
+            QVERIFY2(batch.temperature == single.temperature, at);
+            QVERIFY2(batch.ndl == single.ndl, at);
+            QVERIFY2(batch.cns == single.cns, at);
+            QVERIFY2(batch.ceiling == single.ceiling, at);
+            QVERIFY2(batch.stopTime == single.stopTime, at);
+            QVERIFY2(batch.tts == single.tts, at);
+            QVERIFY2(batch.pressures == single.pressures, at);
+            QVERIFY2(batch.po2Sensors == single.po2Sensors, at);
+        }
+    }
+
+    void resampleRestartsAfterClampedTime()
+    {
+        DiveData d;
+        for (int i = 0; i < 5; ++i) {
+            d.addDataPoint(point(i * 10.0, 5.0 + i));
+        }
+
+        // 35 moves the merge to the last segment; -5 is clamped and must not
+        // hide that 15 steps backwards from there
+        const QVector<double> times = {35.0, -5.0, 15.0};
+        const DiveSampleColumns out = d.resample(times);
+        QCOMPARE(out.size(), times.size());
+        for (int k = 0; k < times.size(); ++k) {
+            QCOMPARE(out.point(k).depth, d.dataAtTime(times[k]).depth);
+        }
+        QCOMPARE(out.point(2).depth, 6.5);
+    }
 };
 
 QTEST_GUILESS_MAIN(DiveDataTest)
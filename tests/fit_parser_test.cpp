@@ -390,6 +390,72 @@ private slots:
         qDeleteAll(dives);
     }
 
+    void filterSkipsUnwantedMessagesAndFields()
+    {
+        FitBuilder b;
+        b.definition(0, 20, {{{253, 4, 0x86}, {92, 4, 0x86}, {13, 1, 0x01}}}); // ts, depth, temp
+        b.dataRecord(0, FitBuilder::u32(1000) + FitBuilder::u32(5000) + QByteArrayLiteral("\x12"));
+        b.definition(1, 78, {{{253, 4, 0x86}, {0, 2, 0x84}}}); // HRV: never wanted
+        b.dataRecord(1, FitBuilder::u32(1010) + QByteArrayLiteral("\x10\x02"));
+        b.definition(2, 20, {{{92, 4, 0x86}}});
+        // Compressed timestamp (local 2, offset 20) relative to the skipped
+        // HRV message's timestamp: 1010 -> 1012
+        b.dataRecord(0xC0 | 20, FitBuilder::u32(6000));
+
+        QTemporaryFile tmp;
+        tmp.open();
+        tmp.write(b.build());
+        tmp.flush();
+
+        FitDecoder decoder;
+        decoder.setFilter(FitFieldFilter{{20, {253, 92}}});
+        QString err;
+        QVERIFY2(decoder.decode(&tmp, err), qPrintable(err));
+        QCOMPARE(decoder.messageCount(), 2);
+
+        const FitMessage first = decoder.message(0);
+        QCOMPARE(first.globalId, quint16(20));
+        QCOMPARE(first.value(253), 1000.0);
+        QCOMPARE(first.value(92), 5000.0);
+        QVERIFY(!first.has(13));
+
+        const FitMessage second = decoder.message(1);
+        QCOMPARE(second.value(253), 1012.0);
+        QCOMPARE(second.value(92), 6000.0);
+    }
+
+    void visitorStreamsNonFileDevices()
+    {
+        // Large enough that a buffer device is read through several
+        // refills of the decoder's input window
+        constexpr int kRecords = 60000;
+        FitBuilder b;
+        b.definition(0, 20, {{{253, 4, 0x86}, {92, 4, 0x86}}});
+        for (int i = 0; i < kRecords; ++i) {
+            b.dataRecord(0, FitBuilder::u32(1000 + i) + FitBuilder::u32(i));
+        }
+        QByteArray bytes = b.build();
+        QBuffer buffer(&bytes);
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+        int visited = 0;
+        bool inOrder = true;
+        FitDecoder decoder;
+        QString err;
+        const bool ok = decoder.decode(
+            &buffer,
+            [&](const FitMessage &message) {
+                inOrder = inOrder && message.value(253) == 1000.0 + visited
+                          && message.value(92) == double(visited);
+                visited++;
+            },
+            err);
+        QVERIFY2(ok, qPrintable(err));
+        QCOMPARE(visited, kRecords);
+        QVERIFY(inOrder);
+        QCOMPARE(decoder.messageCount(), 0); // nothing kept
+    }
+
     // ---- Local-only tier (skipped when sample logs are absent) ----
 
     void realFitFiles()
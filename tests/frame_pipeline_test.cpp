@@ -0,0 +1,194 @@
+// Tests for FramePipeline: frames reach the sink in order however the pool
+// finishes them, a concurrent run matches a serial one, a stopped run waits
+// for its workers, and repeated content keeps its id.
+
+#include <QtTest>
+
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+
+#include "include/export/frame_pipeline.h"
+#include "include/generators/i_frame_generator.h"
+
+namespace {
+
+constexpr double kFps = 4.0;
+
+// Frames whose pixels change once a second, so each run of kFps frames is
+// identical. Every fourth frame is slow, so the ones after it finish first.
+class StubGenerator : public IFrameGenerator
+{
+public:
+    explicit StubGenerator(bool concurrent) : m_concurrent(concurrent) {}
+
+    QImage generate(DiveData *, double timePoint) override
+    {
+        ++m_running;
+        const int frame = qRound(timePoint * kFps);
+        if (frame % 4 == 0) {
+            QThread::msleep(30);
+        }
+        QImage image(8, 8, QImage::Format_ARGB32);
+        image.fill(qRgba(int(timePoint) * 20 % 256, 40, 200, 180));
+        {
+            QMutexLocker lock(&m_mutex);
+            m_finished.append(frame);
+        }
+        --m_running;
+        return image;
+    }
+
+    bool supportsConcurrentGenerate() const override { return m_concurrent; }
+
+    QList<int> finished() const
+    {
+        QMutexLocker lock(&m_mutex);
+        return m_finished;
+    }
+
+    std::atomic<int> m_running{0};
+
+private:
+    bool m_concurrent;
+    mutable QMutex m_mutex;
+    QList<int> m_finished;
+};
+
+QList<FramePipeline::Frame> runAll(bool concurrent, FramePipeline::Encoding encoding,
+                                   QList<int> *finished = nullptr)
+{
+    StubGenerator generator(concurrent);
+    FramePipeline pipeline(nullptr, &generator);
+    pipeline.setEncoding(encoding);
+    pipeline.setMaxInFlight(8);
+
+    QList<FramePipeline::Frame> frames;
+    pipeline.run(FramePipeline::frameTimes(0.0, 6.0, kFps), [&](const FramePipeline::Frame &frame) {
+        frames.append(frame);
+        return true;
+    });
+    if (finished) {
+        *finished = generator.finished();
+    }
+    return frames;
+}
+
+} // namespace
+
+Q_DECLARE_METATYPE(FramePipeline::Encoding)
+
+class FramePipelineTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        // Enough workers for frames to overtake each other on any machine
+        QThreadPool::globalInstance()->setMaxThreadCount(4);
+    }
+
+    void framesReachTheSinkInOrder()
+    {
+        QList<int> finished;
+        const QList<FramePipeline::Frame> frames =
+            runAll(true, FramePipeline::Encoding::None, &finished);
+
+        QCOMPARE(frames.size(), 25);
+        for (qsizetype i = 0; i < frames.size(); ++i) {
+            QCOMPARE(frames[i].index, int(i));
+            QCOMPARE(frames[i].time, i / kFps);
+        }
+        // ... although the pool finished them out of order
+        QList<int> sorted = finished;
+        std::sort(sorted.begin(), sorted.end());
+        QVERIFY(finished != sorted);
+    }
+
+    void concurrentRunMatchesSerial_data()
+    {
+        QTest::addColumn<FramePipeline::Encoding>("encoding");
+        QTest::newRow("none") << FramePipeline::Encoding::None;
+        QTest::newRow("png") << FramePipeline::Encoding::Png;
+        QTest::newRow("raw bgra") << FramePipeline::Encoding::RawBgra;
+    }
+
+    void concurrentRunMatchesSerial()
+    {
+        QFETCH(FramePipeline::Encoding, encoding);
+        const QList<FramePipeline::Frame> serial = runAll(false, encoding);
+        const QList<FramePipeline::Frame> concurrent = runAll(true, encoding);
+
+        QCOMPARE(concurrent.size(), serial.size());
+        for (qsizetype i = 0; i < serial.size(); ++i) {
+            QCOMPARE(concurrent[i].index, serial[i].index);
+            QCOMPARE(concurrent[i].image, serial[i].image);
+            QCOMPARE(concurrent[i].data, serial[i].data);
+        }
+    }
+
+    void frameTimesIncludeBothEnds()
+    {
+        // 10 s at 29.97 fps: 299.7 frame intervals, so the last frame falls
+        // short of the end
+        QVector<double> times = FramePipeline::frameTimes(0.0, 10.0, 29.97);
+        QCOMPARE(times.size(), 300);
+        QCOMPARE(times.first(), 0.0);
+        QVERIFY(times.last() < 10.0);
+        QVERIFY(qFuzzyCompare(times.last(), 299 / 29.97));
+
+        // An end exactly 100 intervals on is a frame of its own, despite
+        // the representation error in 100 / 29.97 * 29.97
+        const double end = 5.0 + 100 / 29.97;
+        times = FramePipeline::frameTimes(5.0, end, 29.97);
+        QCOMPARE(times.size(), 101);
+        QCOMPARE(times.first(), 5.0);
+        QVERIFY(qFuzzyCompare(times.last(), end));
+
+        QCOMPARE(FramePipeline::frameTimes(3.0, 3.0, 29.97), QVector<double>{3.0});
+        QVERIFY(FramePipeline::frameTimes(3.0, 2.0, 29.97).isEmpty());
+        QVERIFY(FramePipeline::frameTimes(0.0, 10.0, 0.0).isEmpty());
+    }
+
+    void stoppedRunWaitsForWorkers()
+    {
+        StubGenerator generator(true);
+        FramePipeline pipeline(nullptr, &generator);
+        pipeline.setMaxInFlight(8);
+
+        int delivered = 0;
+        const bool ran = pipeline.run(FramePipeline::frameTimes(0.0, 60.0, kFps),
+                                      [&](const FramePipeline::Frame &) {
+            return ++delivered < 6;
+        });
+        QVERIFY(!ran);
+        QCOMPARE(delivered, 6);
+        // Nothing renders once run() has returned, and nothing was started
+        // beyond the frames in flight when the sink said stop
+        QCOMPARE(generator.m_running.load(), 0);
+        QVERIFY(generator.finished().size() <= 6 + pipeline.maxInFlight());
+    }
+
+    void identicalFramesShareTheirContentId()
+    {
+        for (bool concurrent : {false, true}) {
+            const QList<FramePipeline::Frame> frames =
+                runAll(concurrent, FramePipeline::Encoding::Png);
+            for (qsizetype i = 0; i < frames.size(); ++i) {
+                QVERIFY(frames[i].contentId >= 0);
+                const bool sameSecond = i > 0 && int(frames[i].time) == int(frames[i - 1].time);
+                if (sameSecond) {
+                    // The repeat is the earlier frame's encoding, not a new one
+                    QCOMPARE(frames[i].contentId, frames[i - 1].contentId);
+                    QCOMPARE(frames[i].data, frames[i - 1].data);
+                } else if (i > 0) {
+                    QVERIFY(frames[i].contentId != frames[i - 1].contentId);
+                }
+            }
+        }
+    }
+};
+
+QTEST_MAIN(FramePipelineTest)
+#include "frame_pipeline_test.moc"
@@ -0,0 +1,136 @@
+// Tests for LabelLayerCache: a label is rasterised once per key, any change
+// to its font, colour, shadow or sub-pixel position renders it anew, and a
+// full cache starts over.
+
+#include <QtTest>
+
+#include "include/generators/label_layer_cache.h"
+
+namespace {
+
+// Capacity, as label_layer_cache.cpp sets it
+constexpr int kMaxLayers = 256;
+
+LabelLayerCache::Key labelKey(const QString &text = QStringLiteral("DEPTH"))
+{
+    LabelLayerCache::Key key;
+    key.font = QFont(QStringLiteral("Sans"));
+    key.font.setPixelSize(24);
+    key.text = text;
+    key.color = qRgb(255, 255, 255);
+    key.shadowEnabled = true;
+    key.shadowType = 1;
+    key.shadowColor = qRgba(0, 0, 0, 178);
+    key.shadowPixels = 5;
+    return key;
+}
+
+} // namespace
+
+Q_DECLARE_METATYPE(LabelLayerCache::Key)
+
+class LabelLayerCacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init() { m_renders = 0; }
+
+    void repeatedLabelIsRenderedOnce()
+    {
+        LabelLayerCache cache;
+        const LabelLayerCache::Layer first = cache.layer(labelKey(), render());
+        QCOMPARE(m_renders, 1);
+
+        const LabelLayerCache::Layer again = cache.layer(labelKey(), render());
+        QCOMPARE(m_renders, 1);
+        QCOMPARE(again.image, first.image);
+        QCOMPARE(again.textOrigin, first.textOrigin);
+    }
+
+    void anyChangeRendersAgain_data()
+    {
+        QTest::addColumn<LabelLayerCache::Key>("key");
+
+        LabelLayerCache::Key key = labelKey(QStringLiteral("TEMP"));
+        QTest::newRow("text") << key;
+        key = labelKey();
+        key.font.setFamily(QStringLiteral("Serif"));
+        QTest::newRow("font family") << key;
+        key = labelKey();
+        key.font.setPixelSize(36);
+        QTest::newRow("font size") << key;
+        key = labelKey();
+        key.font.setBold(true);
+        QTest::newRow("font weight") << key;
+        key = labelKey();
+        key.color = qRgb(255, 220, 0);
+        QTest::newRow("colour") << key;
+        key = labelKey();
+        key.shadowEnabled = false;
+        QTest::newRow("shadow off") << key;
+        key = labelKey();
+        key.shadowType = 2;
+        QTest::newRow("shadow type") << key;
+        key = labelKey();
+        key.shadowColor = qRgba(0, 0, 80, 178);
+        QTest::newRow("shadow colour") << key;
+        key = labelKey();
+        key.shadowPixels = 7;
+        QTest::newRow("shadow size") << key;
+        key = labelKey();
+        key.subpixelX = 32;
+        QTest::newRow("sub-pixel position") << key;
+    }
+
+    void anyChangeRendersAgain()
+    {
+        QFETCH(LabelLayerCache::Key, key);
+        LabelLayerCache cache;
+        cache.layer(labelKey(), render());
+        QCOMPARE(m_renders, 1);
+
+        cache.layer(key, render());
+        QCOMPARE(m_renders, 2);
+        // Both stay cached side by side
+        cache.layer(labelKey(), render());
+        cache.layer(key, render());
+        QCOMPARE(m_renders, 2);
+    }
+
+    void fullCacheStartsOver()
+    {
+        LabelLayerCache cache;
+        cache.layer(labelKey(QStringLiteral("0")), render());
+        for (int i = 1; i < kMaxLayers; ++i) {
+            cache.layer(labelKey(QString::number(i)), render());
+        }
+        cache.layer(labelKey(QStringLiteral("0")), render());
+        QCOMPARE(m_renders, kMaxLayers);
+
+        // One layer more empties the cache
+        cache.layer(labelKey(QString::number(kMaxLayers)), render());
+        cache.layer(labelKey(QStringLiteral("0")), render());
+        QCOMPARE(m_renders, kMaxLayers + 2);
+    }
+
+private:
+    // A stand-in rasteriser that counts its calls; each layer it makes is
+    // distinct, so a cache hit is told apart from a fresh render
+    std::function<LabelLayerCache::Layer()> render()
+    {
+        return [this]() {
+            ++m_renders;
+            LabelLayerCache::Layer layer;
+            layer.image = QImage(4, 4, QImage::Format_ARGB32_Premultiplied);
+            layer.image.fill(qRgba(m_renders, 0, 0, 255));
+            layer.textOrigin = QPoint(m_renders, 1);
+            return layer;
+        };
+    }
+
+    int m_renders = 0;
+};
+
+QTEST_MAIN(LabelLayerCacheTest)
+#include "label_layer_cache_test.moc"
@@ -0,0 +1,143 @@
+// Tests for OverlayGenerator's export rendering: a frame repainted
+// incrementally over the previous one must come out exactly as a full
+// render of the same sample would.
+
+#include <QtTest>
+
+#include <memory>
+
+#include "include/core/dive_data.h"
+#include "include/generators/overlay_gen.h"
+
+using Unabara::CellData;
+using Unabara::CellType;
+using Unabara::ShadowType;
+
+namespace {
+
+// Two minutes down to 15 m and back: depth and time change at different
+// rates, the temperature once
+std::unique_ptr<DiveData> makeDive()
+{
+    auto dive = std::make_unique<DiveData>();
+    QVector<DiveDataPoint> samples;
+    for (int i = 0; i <= 120; ++i) {
+        DiveDataPoint p(i, i < 60 ? i * 0.25 : (120 - i) * 0.25, i < 40 ? 24.0 : 22.0);
+        p.ndl = 99 - i / 20;
+        samples.append(p);
+    }
+    dive->appendDataPoints(samples);
+    return dive;
+}
+
+// Detail everywhere, so any pixel restored from the wrong place shows
+QImage background(const QSize &size)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *row = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            row[x] = qPremultiply(qRgba((x * 7) & 0xFF, (y * 5) & 0xFF, (x + y) & 0xFF,
+                                        128 + (x ^ y) % 128));
+        }
+    }
+    return image;
+}
+
+CellData makeCell(const QString &id, CellType type, const QPointF &position)
+{
+    CellData cell(id, type);
+    cell.setPosition(position);
+    return cell;
+}
+
+// Blurred shadows throughout, one cell outlined; depth and time overlap,
+// so a change in either repaints the other
+OverlayGenerator::RenderSnapshot makeSnapshot()
+{
+    OverlayGenerator::RenderSnapshot snapshot;
+    snapshot.background = background(QSize(480, 320));
+    snapshot.font = QFont(QStringLiteral("Sans"), 12);
+    snapshot.labelColor = QColor(Qt::white);
+    snapshot.valueColor = QColor(255, 220, 0);
+    snapshot.shadowEnabled = true;
+    snapshot.shadowType = ShadowType::Blurred;
+    snapshot.shadowColor = QColor(Qt::black);
+    snapshot.shadowSize = 3;
+    snapshot.shadowOpacity = 0.7;
+    snapshot.cellBased = true;
+
+    snapshot.cells = {
+        makeCell(QStringLiteral("depth"), CellType::Depth, {0.05, 0.05}),
+        makeCell(QStringLiteral("time"), CellType::Time, {0.12, 0.12}),
+        makeCell(QStringLiteral("temp"), CellType::Temperature, {0.6, 0.05}),
+        makeCell(QStringLiteral("ndl"), CellType::NDL, {0.6, 0.5}),
+        makeCell(QStringLiteral("max"), CellType::MaxDepth, {0.08, 0.7}),
+    };
+    CellData &outlined = snapshot.cells[3];
+    outlined.setShadowEnabled(true);
+    outlined.setShadowType(ShadowType::Outline);
+    return snapshot;
+}
+
+} // namespace
+
+class OverlayGenTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void incrementalFramesMatchFullRenders_data()
+    {
+        QTest::addColumn<QList<double>>("times");
+
+        // Export order at 3 fps: most frames repeat their predecessor's text
+        QList<double> inOrder;
+        for (int frame = 0; frame < 360; ++frame) {
+            inOrder.append(frame / 3.0);
+        }
+        QTest::newRow("in order") << inOrder;
+        // A worker's next frame needn't follow its last one
+        QTest::newRow("out of order") << QList<double>{0.0, 50.0, 3.0, 3.0, 110.0, 20.0, 20.5, 0.0};
+    }
+
+    void incrementalFramesMatchFullRenders()
+    {
+        QFETCH(QList<double>, times);
+        const auto dive = makeDive();
+        const OverlayGenerator::RenderSnapshot full = makeSnapshot();
+        OverlayGenerator::RenderSnapshot incremental = full;
+        incremental.incremental = std::make_shared<IncrementalFrames>();
+
+        for (qsizetype i = 0; i < times.size(); ++i) {
+            const QImage expected = OverlayGenerator::renderSnapshot(full, dive.get(), times[i]);
+            const QImage actual = OverlayGenerator::renderSnapshot(incremental, dive.get(), times[i]);
+            QVERIFY2(actual == expected,
+                     qPrintable(QStringLiteral("frame %1 at %2 s").arg(i).arg(times[i])));
+        }
+        QCOMPARE(incremental.incremental->frames(), qint64(times.size()));
+        QCOMPARE(incremental.incremental->cells(), qint64(times.size() * full.cells.size()));
+    }
+
+    void unchangedCellsAreNotRedrawn()
+    {
+        const auto dive = makeDive();
+        OverlayGenerator::RenderSnapshot snapshot = makeSnapshot();
+        snapshot.incremental = std::make_shared<IncrementalFrames>();
+        const IncrementalFrames &counts = *snapshot.incremental;
+
+        // The first frame paints everything, a repeat of it nothing
+        OverlayGenerator::renderSnapshot(snapshot, dive.get(), 10.0);
+        QCOMPARE(counts.cellsRedrawn(), qint64(snapshot.cells.size()));
+        OverlayGenerator::renderSnapshot(snapshot, dive.get(), 10.0);
+        QCOMPARE(counts.cellsRedrawn(), qint64(snapshot.cells.size()));
+
+        // A second later depth, time and the running maximum change; none
+        // of them reaches temperature or NDL, which stay as they were
+        OverlayGenerator::renderSnapshot(snapshot, dive.get(), 11.0);
+        QCOMPARE(counts.cellsRedrawn(), qint64(snapshot.cells.size() + 3));
+    }
+};
+
+QTEST_MAIN(OverlayGenTest)
+#include "overlay_gen_test.moc"
@@ -0,0 +1,85 @@
+// Benchmarks for preview frames: what the overlay image provider returns
+// as the timeline moves, with render debug logging off (the default) and
+// with it enabled but discarded, which is what every preview frame paid
+// for its messages before they moved onto logging categories.
+
+#include <QtTest>
+#include <cmath>
+
+#include "include/core/dive_data.h"
+#include "include/generators/overlay_gen.h"
+#include "include/generators/overlay_image_provider.h"
+
+namespace {
+
+constexpr int kFrames = 50;
+
+void discardMessage(QtMsgType, const QMessageLogContext &, const QString &) {}
+
+} // namespace
+
+class OverlayImageProviderBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        QVERIFY(m_dir.isValid());
+
+        // A dive-computer face the size of the bundled ones
+        QImage face(800, 800, QImage::Format_ARGB32);
+        face.fill(QColor(0, 40, 80, 200));
+        m_templatePath = m_dir.filePath(QStringLiteral("face.png"));
+        QVERIFY(face.save(m_templatePath));
+
+        QVector<DiveDataPoint> samples;
+        for (int s = 0; s <= 3000; s += 10) {
+            DiveDataPoint p(s, 20.0 + 8.0 * std::sin(s / 400.0), 18.0 - s * 0.0005);
+            p.ndl = qMax(0, 60 - s / 60);
+            p.addPressure(200.0 - s * 0.045, 0);
+            samples.append(p);
+        }
+        m_dive.appendDataPoints(samples);
+    }
+
+    void requestImage_data()
+    {
+        QTest::addColumn<bool>("debugLogging");
+        QTest::newRow("debug off") << false;
+        QTest::newRow("debug discarded") << true;
+    }
+
+    void requestImage()
+    {
+        QFETCH(bool, debugLogging);
+        QLoggingCategory::setFilterRules(debugLogging ? QStringLiteral("unabara.*.debug=true")
+                                                      : QStringLiteral("unabara.*.debug=false"));
+        const QtMessageHandler previousHandler = qInstallMessageHandler(discardMessage);
+
+        OverlayGenerator generator;
+        generator.setTemplatePath(m_templatePath);
+        OverlayImageProvider provider(&generator);
+        provider.setCurrentDive(&m_dive);
+
+        QSize size;
+        QBENCHMARK {
+            for (int frame = 0; frame < kFrames; ++frame) {
+                provider.setCurrentTime(frame * 7.0);
+                provider.requestImage(QStringLiteral("preview/%1").arg(frame), &size, QSize());
+            }
+        }
+        qInstallMessageHandler(previousHandler);
+        QLoggingCategory::setFilterRules(QString());
+        QCOMPARE(size, QSize(800, 800));
+    }
+
+private:
+    QTemporaryDir m_dir;
+    QString m_templatePath;
+    DiveData m_dive;
+};
+
+QTEST_MAIN(OverlayImageProviderBench)
+#include "overlay_image_provider_bench.moc"
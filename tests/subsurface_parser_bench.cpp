@@ -0,0 +1,144 @@
+// Benchmarks for Subsurface import: the per-attribute QRegularExpression
+// matching the parser used to do (kept here as a reference) against the
+// parse_utils unit-value scanners, and a full parse of a synthetic
+// multi-year logbook, with parse debug logging off (the default) and with
+// it enabled but discarded, as every import paid for it before the
+// logging categories.
+
+#include <QtTest>
+#include <QRegularExpression>
+#include <cmath>
+
+#include "include/core/dive_data.h"
+#include "include/core/format_parsers/parse_utils.h"
+#include "include/core/format_parsers/subsurface_parser.h"
+
+namespace {
+
+// Five years of weekend diving, one sample every 10 s over ~50 min
+constexpr int kDives = 500;
+constexpr int kSamplesPerDive = 300;
+
+QByteArray makeLogbook()
+{
+    QByteArray xml;
+    xml.reserve(kDives * kSamplesPerDive * 120);
+    xml += "<divelog program='subsurface' version='3'>\n<dives>\n";
+    for (int d = 0; d < kDives; ++d) {
+        xml += QStringLiteral("<dive number='%1' date='20%2-%3-%4' time='10:00:00'>\n")
+                   .arg(d + 1)
+                   .arg(20 + d / 100)
+                   .arg(1 + d % 12, 2, 10, QLatin1Char('0'))
+                   .arg(1 + d % 28, 2, 10, QLatin1Char('0'))
+                   .toUtf8();
+        xml += "  <cylinder size='12.0 l' workpressure='232.0 bar' o2='32.0%' "
+               "start='200.0 bar' end='60.0 bar' />\n";
+        xml += "  <divecomputer model='Bench DC'>\n";
+        for (int s = 0; s < kSamplesPerDive; ++s) {
+            const int t = s * 10;
+            const double depth = 20.0 + 8.0 * std::sin(s / 40.0);
+            xml += QStringLiteral("    <sample time='%1:%2 min' depth='%3 m' temp='%4 C' "
+                                  "pressure0='%5 bar' ndl='%6:00 min' cns='%7%' />\n")
+                       .arg(t / 60)
+                       .arg(t % 60, 2, 10, QLatin1Char('0'))
+                       .arg(depth, 0, 'f', 1)
+                       .arg(18.0 - s * 0.005, 0, 'f', 1)
+                       .arg(200.0 - s * 0.45, 0, 'f', 1)
+                       .arg(qMax(0, 60 - s / 6))
+                       .arg(s / 30)
+                       .toUtf8();
+        }
+        xml += "  </divecomputer>\n</dive>\n";
+    }
+    xml += "</dives>\n</divelog>\n";
+    return xml;
+}
+
+// The attribute values the per-sample path sees most
+const QString kDepth = QStringLiteral("23.4 m");
+const QString kPressure = QStringLiteral("187.5 bar");
+const QString kTime = QStringLiteral("45:30 min");
+
+void discardMessage(QtMsgType, const QMessageLogContext &, const QString &) {}
+
+} // namespace
+
+class SubsurfaceParserBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        QVERIFY(m_logbook.open());
+        m_logbook.write(makeLogbook());
+        m_logbook.flush();
+    }
+
+    void regexUnitValues()
+    {
+        double sum = 0.0;
+        QBENCHMARK {
+            for (int i = 0; i < 1000; ++i) {
+                // Constructed per attribute, exactly as the parser did
+                QRegularExpression depthRe("(\\d+\\.?\\d*)\\s+m");
+                sum += depthRe.match(kDepth).captured(1).toDouble();
+                QRegularExpression pressureRe("(\\d+\\.?\\d*)\\s+bar");
+                sum += pressureRe.match(kPressure).captured(1).toDouble();
+                QRegularExpression timeRe("(\\d+):(\\d+)\\s+min");
+                const QRegularExpressionMatch m = timeRe.match(kTime);
+                sum += m.captured(1).toInt() * 60 + m.captured(2).toInt();
+            }
+        }
+        QVERIFY(sum > 0.0);
+    }
+
+    void scannedUnitValues()
+    {
+        double sum = 0.0;
+        QBENCHMARK {
+            for (int i = 0; i < 1000; ++i) {
+                sum += parse_utils::scanUnitValue(kDepth, u"m");
+                sum += parse_utils::scanUnitValue(kPressure, u"bar");
+                sum += parse_utils::scanMinutesSeconds(kTime);
+            }
+        }
+        QVERIFY(sum > 0.0);
+    }
+
+    void parseLogbook_data()
+    {
+        QTest::addColumn<bool>("debugLogging");
+        QTest::newRow("debug off") << false;
+        QTest::newRow("debug discarded") << true;
+    }
+
+    void parseLogbook()
+    {
+        QFETCH(bool, debugLogging);
+        QLoggingCategory::setFilterRules(debugLogging ? QStringLiteral("unabara.parse.debug=true")
+                                                      : QStringLiteral("unabara.parse.debug=false"));
+        const QtMessageHandler previousHandler = qInstallMessageHandler(discardMessage);
+
+        int samples = 0;
+        QBENCHMARK_ONCE {
+            m_logbook.seek(0);
+            SubsurfaceParser parser;
+            QString err;
+            const QList<DiveData *> dives = parser.parse(m_logbook, -1, err);
+            QVERIFY2(err.isEmpty(), qPrintable(err));
+            QCOMPARE(dives.size(), kDives);
+            samples = dives.first()->sampleCount();
+            qDeleteAll(dives);
+        }
+        qInstallMessageHandler(previousHandler);
+        QLoggingCategory::setFilterRules(QString());
+        QCOMPARE(samples, kSamplesPerDive);
+    }
+
+private:
+    QTemporaryFile m_logbook;
+};
+
+QTEST_GUILESS_MAIN(SubsurfaceParserBench)
+#include "subsurface_parser_bench.moc"
@@ -3,9 +3,13 @@
 
 #include <QtTest>
 
+#include <atomic>
+
 #include "include/core/dive_data.h"
 #include "include/core/log_parser.h"
 #include "include/core/format_parsers/subsurface_parser.h"
+#include "include/export/frame_pipeline.h"
+#include "include/generators/i_frame_generator.h"
 
 namespace {
 
@@ -32,6 +36,79 @@ const char kTwoDives[] = R"(<divelog program='subsurface' version='3'>
 </dives>
 </divelog>)";
 
+// kTwoDives after another save: dive 8 gained a sample, dive 9 is new
+QByteArray threeDives()
+{
+    QByteArray xml(kTwoDives);
+    xml.replace("    <sample time='0:30 min' depth='5.0 m' />\n",
+                "    <sample time='0:30 min' depth='5.0 m' />\n"
+                "    <sample time='1:30 min' depth='6.0 m' />\n");
+    xml.replace("</dives>",
+                "<dive number='9' date='2026-03-03' time='09:00:00'>\n"
+                "  <divecomputer model='Test DC'>\n"
+                "    <sample time='0:00 min' depth='0.0 m' />\n"
+                "    <sample time='1:00 min' depth='9.0 m' />\n"
+                "  </divecomputer>\n"
+                "</dive>\n"
+                "</dives>");
+    return xml;
+}
+
+// Frames shaded by depth, rendered on the pool like the overlay's
+class DepthFrames : public IFrameGenerator
+{
+public:
+    QImage generate(DiveData *dive, double timePoint) override
+    {
+        QImage image(4, 4, QImage::Format_ARGB32);
+        image.fill(qRgb(qBound(0, int(dive->dataAtTime(timePoint).depth * 10), 255), 0, 0));
+        return image;
+    }
+    bool supportsConcurrentGenerate() const override { return true; }
+};
+
+// kTwoDives with dive 7 at a site from the log's site table
+QByteArray withSites(const QByteArray &sites)
+{
+    QByteArray xml(kTwoDives);
+    xml.replace("<dives>", "<divesites>\n" + sites + "</divesites>\n<dives>");
+    xml.replace("<dive number='7'", "<dive number='7' divesiteid='1a2b'");
+    return xml;
+}
+
+QList<QByteArray> changedHashes(const QByteArray &xml)
+{
+    QTemporaryFile tmp;
+    tmp.open();
+    tmp.write(xml);
+    tmp.flush();
+    QString err;
+    SubsurfaceParser parser;
+    QList<QByteArray> hashes;
+    QList<DiveData *> dives;
+    parser.parseChanged(tmp, {}, hashes, dives, err);
+    qDeleteAll(dives);
+    return hashes;
+}
+
+// 'count' one-sample dives, all at the same site
+QByteArray manyDives(int count)
+{
+    QByteArray xml("<divelog program='subsurface' version='3'>\n<divesites>\n"
+                   "<site uuid='a1' name='House Reef' />\n</divesites>\n<dives>\n");
+    for (int n = 1; n <= count; ++n) {
+        xml += QStringLiteral("<dive number='%1' divesiteid='a1'><divecomputer>"
+                              "<sample time='0:00 min' depth='0.0 m' />"
+                              "<sample time='1:00 min' depth='%2.0 m' />"
+                              "</divecomputer></dive>\n")
+                   .arg(n)
+                   .arg(n % 40)
+                   .toUtf8();
+    }
+    xml += "</dives>\n</divelog>\n";
+    return xml;
+}
+
 QList<DiveData *> parseXml(const QByteArray &xml, int specificDive, QString &err)
 {
     QTemporaryFile tmp;
@@ -145,6 +222,93 @@ private slots:
         QVERIFY(err.isEmpty());
     }
 
+    void unnumberedDiveMatchesAnyNumber()
+    {
+        // The streaming parse only ever skipped dives numbered otherwise;
+        // the index keeps that, and the first candidate wins
+        QByteArray xml(kTwoDives);
+        xml.replace("<dive number='7' ", "<dive ");
+        QString err;
+        for (int number : {8, 99}) {
+            auto dives = parseXml(xml, number, err);
+            QVERIFY2(err.isEmpty(), qPrintable(err));
+            QCOMPARE(dives.size(), 1);
+            QCOMPARE(dives.first()->location(), QStringLiteral("Test Reef"));
+            qDeleteAll(dives);
+        }
+
+        // A number that isn't one matches nothing
+        xml = QByteArray(kTwoDives);
+        xml.replace("<dive number='7' ", "<dive number='seven' ");
+        auto only8 = parseXml(xml, 8, err);
+        QCOMPARE(only8.size(), 1);
+        QCOMPARE(only8.first()->diveNumber(), 8);
+        qDeleteAll(only8);
+        QVERIFY(parseXml(xml, 99, err).isEmpty());
+    }
+
+    void parallelParseKeepsDocumentOrder()
+    {
+        // Enough dives to spread over the pool
+        constexpr int kDives = 64;
+        QString err;
+        auto dives = parseXml(manyDives(kDives), -1, err);
+        QVERIFY2(err.isEmpty(), qPrintable(err));
+        QCOMPARE(dives.size(), kDives);
+        for (int i = 0; i < kDives; ++i) {
+            QCOMPARE(dives[i]->diveNumber(), i + 1);
+            QCOMPARE(dives[i]->location(), QStringLiteral("House Reef"));
+            QCOMPARE(dives[i]->thread(), QThread::currentThread());
+        }
+        qDeleteAll(dives);
+    }
+
+    void parallelParseReportsDivesAndStopsWhenCancelled()
+    {
+        constexpr int kDives = 256;
+        QTemporaryFile tmp;
+        tmp.open();
+        tmp.write(manyDives(kDives));
+        tmp.flush();
+
+        bool readingWholeLog = false;
+        QList<qsizetype> parsedCounts;
+        std::atomic<bool> cancel{false};
+        IDiveLogFormatParser::Observer observer;
+        observer.readingWholeLog = [&]() { readingWholeLog = true; };
+        observer.divesParsed = [&](qsizetype parsed, qsizetype total) {
+            parsedCounts.append(total == kDives ? parsed : -1);
+        };
+        observer.cancelled = [&]() { return cancel.load(); };
+
+        SubsurfaceParser parser;
+        parser.setObserver(observer);
+        QString err;
+        auto dives = parser.parse(tmp, -1, err);
+        QVERIFY2(err.isEmpty(), qPrintable(err));
+        QCOMPARE(dives.size(), kDives);
+        QVERIFY(readingWholeLog);
+        // Once per dive, counting up
+        QCOMPARE(parsedCounts.size(), kDives);
+        for (int i = 0; i < kDives; ++i) {
+            QCOMPARE(parsedCounts[i], qsizetype(i + 1));
+        }
+        qDeleteAll(dives);
+
+        // Cancelled as the first dive is done: dives not yet started are
+        // skipped and nothing is returned
+        parsedCounts.clear();
+        observer.divesParsed = [&](qsizetype parsed, qsizetype) {
+            parsedCounts.append(parsed);
+            cancel = true;
+        };
+        parser.setObserver(observer);
+        dives = parser.parse(tmp, -1, err);
+        QVERIFY(dives.isEmpty());
+        QVERIFY(!err.isEmpty());
+        QVERIFY(parsedCounts.size() < kDives);
+    }
+
     void listDivesEntries()
     {
         QTemporaryFile tmp;
@@ -159,6 +323,92 @@ private slots:
                  QStringLiteral("Dive #7 - 2026-03-01 10:00:00 at Test Reef"));
     }
 
+    void indexedImportFollowsFileChanges()
+    {
+        QTemporaryFile tmp;
+        tmp.open();
+        tmp.write(QByteArray(kTwoDives));
+        tmp.flush();
+
+        QString err;
+        SubsurfaceParser parser;
+        // Listing builds (and caches) the index; selecting a dive seeks to it
+        QCOMPARE(parser.listDives(tmp, err).size(), 2);
+        auto first = parser.parse(tmp, 7, err);
+        QVERIFY2(err.isEmpty(), qPrintable(err));
+        QCOMPARE(first.size(), 1);
+        QCOMPARE(first.first()->location(), QStringLiteral("Test Reef"));
+        QCOMPARE(first.first()->sampleCount(), 4);
+        qDeleteAll(first);
+
+        // A rewritten file must not be served from the stale index
+        QByteArray changed(kTwoDives);
+        changed.replace("<location>Test Reef</location>", "<location>Other Reef, far away</location>");
+        tmp.resize(0);
+        tmp.write(changed);
+        tmp.flush();
+        auto second = parser.parse(tmp, 7, err);
+        QVERIFY2(err.isEmpty(), qPrintable(err));
+        QCOMPARE(second.size(), 1);
+        QCOMPARE(second.first()->location(), QStringLiteral("Other Reef, far away"));
+        qDeleteAll(second);
+    }
+
+    void parseChangedSkipsKnownDives()
+    {
+        QTemporaryFile tmp;
+        tmp.open();
+        tmp.write(QByteArray(kTwoDives));
+        tmp.flush();
+
+        QString err;
+        SubsurfaceParser parser;
+        QList<QByteArray> hashes;
+        QList<DiveData *> dives;
+        QVERIFY(parser.parseChanged(tmp, {}, hashes, dives, err));
+        QVERIFY2(err.isEmpty(), qPrintable(err));
+        QCOMPARE(hashes.size(), 2);
+        QCOMPARE(dives.size(), 2);
+        QVERIFY(dives[0] && dives[1]);
+        QCOMPARE(dives[1]->diveNumber(), 8);
+        qDeleteAll(dives);
+
+        tmp.resize(0);
+        tmp.write(threeDives());
+        tmp.flush();
+        const QSet<QByteArray> known(hashes.cbegin(), hashes.cend());
+        QList<QByteArray> newHashes;
+        QVERIFY(parser.parseChanged(tmp, known, newHashes, dives, err));
+        QVERIFY2(err.isEmpty(), qPrintable(err));
+        QCOMPARE(newHashes.size(), 3);
+        QCOMPARE(newHashes[0], hashes[0]);
+        QVERIFY(newHashes[1] != hashes[1]);
+        QCOMPARE(dives.size(), 3);
+        QVERIFY(!dives[0]); // unchanged: not parsed again
+        QCOMPARE(dives[1]->sampleCount(), 3);
+        QCOMPARE(dives[2]->diveNumber(), 9);
+        qDeleteAll(dives);
+    }
+
+    void diveHashesCoverOnlyReferencedSites()
+    {
+        const QByteArray reef("<site uuid='1a2b' name='Test Reef'><geo cords='1.0 2.0'/></site>\n");
+        const QList<QByteArray> hashes = changedHashes(withSites(reef));
+        QCOMPARE(hashes.size(), 2);
+
+        // Another site in the table changes no dive
+        const QByteArray wreck("<site uuid='3c4d' name='Wreck' />\n");
+        QCOMPARE(changedHashes(withSites(reef + wreck)), hashes);
+
+        // Editing dive 7's site changes dive 7 only
+        QByteArray renamed = reef;
+        renamed.replace("Test Reef", "House Reef");
+        const QList<QByteArray> edited = changedHashes(withSites(renamed + wreck));
+        QCOMPARE(edited.size(), 2);
+        QVERIFY(edited[0] != hashes[0]);
+        QCOMPARE(edited[1], hashes[1]);
+    }
+
     void malformedXmlReportsError()
     {
         QString err;
@@ -212,11 +462,250 @@ private slots:
         QCOMPARE(errors.count(), 1);
         QVERIFY(!lp.lastError().isEmpty());
     }
+
+    void asyncImportDeliversDivesOnCallerThread()
+    {
+        QTemporaryFile tmp;
+        tmp.open();
+        tmp.write(QByteArray(kTwoDives));
+        tmp.flush();
+
+        LogParser lp;
+        QList<DiveData *> received;
+        connect(&lp, &LogParser::multipleImported, this,
+                [&](const QList<DiveData *> &dives) { received = dives; });
+        QSignalSpy errors(&lp, &LogParser::errorOccurred);
+        QVERIFY(lp.importFileAsync(tmp.fileName()));
+        QVERIFY(lp.isBusy());
+        // A second import is refused while the first is running
+        QVERIFY(!lp.importFileAsync(tmp.fileName()));
+        QCOMPARE(errors.count(), 1);
+
+        QTRY_VERIFY(!lp.isBusy());
+        QCOMPARE(received.size(), 2);
+        QCOMPARE(lp.progress(), 100);
+        for (DiveData *dive : std::as_const(received)) {
+            QCOMPARE(dive->thread(), QThread::currentThread());
+        }
+        qDeleteAll(received);
+    }
+
+    void watchedLogbookReimportsChangedDives()
+    {
+        QTemporaryFile tmp;
+        tmp.open();
+        tmp.write(QByteArray(kTwoDives));
+        tmp.flush();
+
+        LogParser lp;
+        QList<DiveData *> imported;
+        QList<DiveData *> added;
+        QList<DiveData *> removed;
+        QList<QPair<DiveData *, DiveData *>> replaced;
+        int updates = 0;
+        connect(&lp, &LogParser::multipleImported, this,
+                [&](const QList<DiveData *> &dives) { imported = dives; });
+        connect(&lp, &LogParser::diveReplaced, this,
+                [&](DiveData *oldDive, DiveData *newDive) { replaced.append({oldDive, newDive}); });
+        connect(&lp, &LogParser::logbookUpdated, this,
+                [&](const QList<DiveData *> &a, const QList<DiveData *> &r) {
+                    added = a;
+                    removed = r;
+                    ++updates;
+                });
+
+        QVERIFY(lp.watchLogbook(tmp.fileName()));
+        QCOMPARE(lp.watchedLogbook(), tmp.fileName());
+        QTRY_VERIFY(!lp.isBusy());
+        QCOMPARE(imported.size(), 2);
+
+        // Refreshes run in the background: never 'busy', and a failed one
+        // is not an import error
+        QSignalSpy busyChanges(&lp, &LogParser::busyChanged);
+        QSignalSpy errors(&lp, &LogParser::errorOccurred);
+        QSignalSpy refreshFailures(&lp, &LogParser::refreshFailed);
+        tmp.resize(0);
+        tmp.write(threeDives());
+        tmp.flush();
+        QTRY_COMPARE_WITH_TIMEOUT(updates, 1, 10000);
+        QTRY_VERIFY(!lp.isRefreshing());
+        QCOMPARE(busyChanges.count(), 0);
+
+        // Dive 7 is untouched and keeps its object; dive 8 is replaced
+        QCOMPARE(added.size(), 2);
+        QCOMPARE(removed.size(), 1);
+        QCOMPARE(removed[0], imported[1]);
+        QCOMPARE(replaced.size(), 1);
+        QCOMPARE(replaced[0].first, imported[1]);
+        QCOMPARE(replaced[0].second, added[0]);
+        QCOMPARE(added[0]->sampleCount(), 3);
+        QCOMPARE(added[1]->diveNumber(), 9);
+
+        tmp.resize(0);
+        tmp.write(QByteArrayLiteral("<divelog><dives><dive number='1'"));
+        tmp.flush();
+        QTRY_COMPARE_WITH_TIMEOUT(refreshFailures.count(), 1, 10000);
+        QTRY_VERIFY(!lp.isRefreshing());
+        QCOMPARE(errors.count(), 0);
+        QCOMPARE(busyChanges.count(), 0);
+        QCOMPARE(updates, 1);
+        QCOMPARE(lp.watchedLogbook(), tmp.fileName());
+
+        lp.stopWatching();
+        QVERIFY(lp.watchedLogbook().isEmpty());
+        delete imported[0];
+        qDeleteAll(removed);
+        qDeleteAll(added);
+    }
+
+    void watchingCurrentLogbookTakesOverItsDives()
+    {
+        QTemporaryFile tmp;
+        tmp.open();
+        tmp.write(QByteArray(kTwoDives));
+        tmp.flush();
+
+        LogParser lp;
+        QList<DiveData *> imported;
+        int importSignals = 0;
+        connect(&lp, &LogParser::multipleImported, this, [&](const QList<DiveData *> &dives) {
+            imported = dives;
+            ++importSignals;
+        });
+        QSignalSpy updates(&lp, &LogParser::logbookUpdated);
+        QVERIFY(lp.importFile(tmp.fileName()));
+        QCOMPARE(lp.currentLogbook(), tmp.fileName());
+
+        // Same log, unchanged: the imported dives are the watched ones
+        QSignalSpy busyChanges(&lp, &LogParser::busyChanged);
+        QVERIFY(lp.watchLogbook(tmp.fileName()));
+        QVERIFY(lp.isRefreshing());
+        QTRY_VERIFY(!lp.isRefreshing());
+        QCOMPARE(importSignals, 1);
+        QCOMPARE(updates.count(), 0);
+        QCOMPARE(busyChanges.count(), 0);
+
+        // ... so a change replaces them like any other refresh
+        QList<DiveData *> removed;
+        QList<DiveData *> added;
+        connect(&lp, &LogParser::logbookUpdated, this,
+                [&](const QList<DiveData *> &a, const QList<DiveData *> &r) {
+                    added = a;
+                    removed = r;
+                });
+        tmp.resize(0);
+        tmp.write(threeDives());
+        tmp.flush();
+        QTRY_COMPARE_WITH_TIMEOUT(updates.count(), 1, 10000);
+        QCOMPARE(removed, QList<DiveData *>{imported[1]});
+        QCOMPARE(added.size(), 2);
+
+        lp.stopWatching();
+        QTRY_VERIFY(!lp.isRefreshing());
+        delete imported[0];
+        qDeleteAll(removed);
+        qDeleteAll(added);
+    }
+
+    void refreshDuringExportIsHeld()
+    {
+        QTemporaryFile tmp;
+        tmp.open();
+        tmp.write(QByteArray(kTwoDives));
+        tmp.flush();
+
+        LogParser lp;
+        QList<DiveData *> imported;
+        connect(&lp, &LogParser::multipleImported, this,
+                [&](const QList<DiveData *> &dives) { imported = dives; });
+        QList<DiveData *> removed;
+        QList<DiveData *> added;
+        int updates = 0;
+        connect(&lp, &LogParser::logbookUpdated, this,
+                [&](const QList<DiveData *> &a, const QList<DiveData *> &r) {
+                    added = a;
+                    removed = r;
+                    ++updates;
+                });
+        QSignalSpy replaced(&lp, &LogParser::diveReplaced);
+        QVERIFY(lp.watchLogbook(tmp.fileName()));
+        QTRY_VERIFY(!lp.isBusy());
+        QCOMPARE(imported.size(), 2);
+
+        // The log changes while dive 8, which the change replaces, is being
+        // exported; the pipeline's event loops let the refresh run to the end
+        QPointer<DiveData> exported = imported[1];
+        DepthFrames generator;
+        FramePipeline pipeline(exported, &generator);
+        QSignalSpy refreshing(&lp, &LogParser::refreshingChanged);
+        lp.setRefreshHeld(true);
+        int frames = 0;
+        const bool ran = pipeline.run(FramePipeline::frameTimes(0.0, 30.0, 2.0),
+                                      [&](const FramePipeline::Frame &frame) {
+            if (frame.index == 0) {
+                tmp.resize(0);
+                tmp.write(threeDives());
+                tmp.flush();
+            } else if (frame.index == 1) {
+                QElapsedTimer timer;
+                timer.start();
+                while (refreshing.count() < 2 && timer.elapsed() < 10000) {
+                    QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+                }
+            }
+            ++frames;
+            return !exported.isNull() && !frame.image.isNull();
+        });
+        QVERIFY(ran);
+        QCOMPARE(frames, 61);
+        QCOMPARE(refreshing.count(), 2);
+        QCOMPARE(updates, 0);
+        QCOMPARE(replaced.count(), 0);
+
+        // Released once the export is done: the held refresh goes through
+        lp.setRefreshHeld(false);
+        QCOMPARE(updates, 1);
+        QCOMPARE(replaced.count(), 1);
+        QCOMPARE(removed, QList<DiveData *>{imported[1]});
+        QCOMPARE(added.size(), 2);
+        QCOMPARE(added[0]->sampleCount(), 3);
+
+        lp.stopWatching();
+        delete imported[0];
+        qDeleteAll(removed);
+        qDeleteAll(added);
+    }
+
+    void cancelledImportDiscardsResult()
+    {
+        QTemporaryFile tmp;
+        tmp.open();
+        tmp.write(QByteArray(kTwoDives));
+        tmp.flush();
+
+        LogParser lp;
+        int importSignals = 0;
+        connect(&lp, &LogParser::diveImported, this, [&](DiveData *) { ++importSignals; });
+        connect(&lp, &LogParser::multipleImported, this,
+                [&](const QList<DiveData *> &) { ++importSignals; });
+        QSignalSpy cancelled(&lp, &LogParser::importCancelled);
+        QSignalSpy errors(&lp, &LogParser::errorOccurred);
+        QVERIFY(lp.importFileAsync(tmp.fileName()));
+        // Even if the worker already finished, the result must be dropped
+        lp.cancelImport();
+
+        QTRY_VERIFY(!lp.isBusy());
+        QCOMPARE(cancelled.count(), 1);
+        QCOMPARE(importSignals, 0);
+        QCOMPARE(errors.count(), 0);
+    }
 };
 
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
+    // Dive indexes are cached under the test-mode cache location
+    QStandardPaths::setTestModeEnabled(true);
     int status = 0;
     {
         SubsurfaceParserTest t1;
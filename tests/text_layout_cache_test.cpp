@@ -0,0 +1,148 @@
+// Tests for TextLayoutCache: a line is shaped once per font and thread,
+// any change to the font shapes it anew, a full shard starts over and a
+// finished thread's shard is dropped.
+
+#include <QtTest>
+
+#include <QSemaphore>
+#include <QThread>
+
+#include "include/generators/text_layout_cache.h"
+
+namespace {
+
+// Shard capacity, as text_layout_cache.cpp sets it
+constexpr int kMaxLinesPerShard = 1024;
+
+QFont pixelFont(int pixelSize)
+{
+    QFont font(QStringLiteral("Sans"));
+    font.setPixelSize(pixelSize);
+    return font;
+}
+
+} // namespace
+
+class TextLayoutCacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void repeatedLineIsShapedOnce()
+    {
+        TextLayoutCache cache;
+        const auto first = cache.line(pixelFont(24), QStringLiteral("DEPTH"));
+        QVERIFY(first->width > 0.0);
+        QVERIFY(first->height > 0);
+        QVERIFY(first->lineSpacing >= first->height);
+
+        QVERIFY(cache.line(pixelFont(24), QStringLiteral("DEPTH")) == first);
+        QVERIFY(cache.line(pixelFont(24), QStringLiteral("TEMP")) != first);
+    }
+
+    void fontChangeShapesAgain()
+    {
+        TextLayoutCache cache;
+        const QString text = QStringLiteral("12.3 m");
+        const auto base = cache.line(pixelFont(24), text);
+
+        const auto larger = cache.line(pixelFont(36), text);
+        QVERIFY(larger != base);
+        QVERIFY(larger->width > base->width);
+        QVERIFY(larger->height > base->height);
+
+        QFont bold = pixelFont(24);
+        bold.setBold(true);
+        QVERIFY(cache.line(bold, text) != base);
+
+        QFont italic = pixelFont(24);
+        italic.setItalic(true);
+        QVERIFY(cache.line(italic, text) != base);
+
+        // The original font still finds its own entry
+        QVERIFY(cache.line(pixelFont(24), text) == base);
+    }
+
+    void colourIsNotPartOfTheShape()
+    {
+        // Colour is applied when the cached glyphs are drawn, so a cell
+        // recoloured in the editor keeps its shaped lines
+        TextLayoutCache cache;
+        const auto line = cache.line(pixelFont(24), QStringLiteral("NDL"));
+        QVERIFY(line->layout.formats().isEmpty());
+        QVERIFY(cache.line(pixelFont(24), QStringLiteral("NDL")) == line);
+    }
+
+    void fullShardStartsOver()
+    {
+        TextLayoutCache cache;
+        const QFont font = pixelFont(24);
+        const auto first = cache.line(font, QStringLiteral("0"));
+        for (int i = 1; i < kMaxLinesPerShard; ++i) {
+            cache.line(font, QString::number(i));
+        }
+        QVERIFY(cache.line(font, QStringLiteral("0")) == first);
+
+        // One line more empties the shard
+        cache.line(font, QString::number(kMaxLinesPerShard));
+        QVERIFY(cache.line(font, QStringLiteral("0")) != first);
+    }
+
+    void clearDropsEveryLine()
+    {
+        TextLayoutCache cache;
+        const auto line = cache.line(pixelFont(24), QStringLiteral("TIME"));
+        cache.clear();
+        QVERIFY(cache.line(pixelFont(24), QStringLiteral("TIME")) != line);
+    }
+
+    void threadsShapeIntoTheirOwnShards()
+    {
+        TextLayoutCache cache;
+        const auto here = cache.line(pixelFont(24), QStringLiteral("GAS"));
+
+        std::shared_ptr<const TextLayoutCache::Line> there;
+        std::unique_ptr<QThread> thread(QThread::create([&]() {
+            there = cache.line(pixelFont(24), QStringLiteral("GAS"));
+        }));
+        thread->start();
+        QVERIFY(thread->wait(5000));
+
+        QVERIFY(there);
+        QVERIFY(there != here);
+        QCOMPARE(there->width, here->width);
+        QVERIFY(cache.line(pixelFont(24), QStringLiteral("GAS")) == here);
+    }
+
+    void finishedThreadDropsItsShard()
+    {
+        // Its lines go with the thread, so a later thread at the same
+        // address never draws glyphs another thread shaped
+        TextLayoutCache cache;
+        std::weak_ptr<const TextLayoutCache::Line> shaped;
+        std::unique_ptr<QThread> thread(QThread::create([&]() {
+            shaped = cache.line(pixelFont(24), QStringLiteral("CNS"));
+        }));
+        thread->start();
+        QVERIFY(thread->wait(5000));
+        QVERIFY(shaped.expired());
+
+        // ... and a thread may finish after the cache is gone
+        auto shortLived = std::make_unique<TextLayoutCache>();
+        QSemaphore shapedOne;
+        QSemaphore cacheGone;
+        std::unique_ptr<QThread> late(QThread::create([&]() {
+            shortLived->line(pixelFont(24), QStringLiteral("CNS"));
+            shapedOne.release();
+            cacheGone.acquire();
+        }));
+        late->start();
+        shapedOne.acquire();
+        shortLived.reset();
+        cacheGone.release();
+        QVERIFY(late->wait(5000));
+    }
+};
+
+QTEST_MAIN(TextLayoutCacheTest)
+#include "text_layout_cache_test.moc"
@@ -143,10 +143,11 @@ int main(int argc, char* argv[])
     }
 
     DiveData* dive = makeSyntheticDive();
-    // Same path as the real exporters: beginExport() disables the editor-only
-    // cell backgrounds so the output matches what users actually export.
+    // Same path as the real exporters: beginExport() snapshots the render
+    // state with the editor-only cell backgrounds disabled, so the output
+    // matches what users actually export.
     generator.beginExport();
-    const QImage overlay = generator.generateOverlay(dive, timePoint);
+    const QImage overlay = generator.generate(dive, timePoint);
     generator.endExport();
     if (overlay.isNull() || !overlay.save(args[2], "PNG")) {
         fprintf(stderr, "Failed to render/save overlay to %s\n", qPrintable(args[2]));